@@ -4,102 +4,239 @@
 #include "apf.h"
 #include "apfNumbering.h"
 #include <map>
+#include <vector>
+#include <algorithm>
 
 namespace apf {
 
-typedef int Gid;
+/* an open addressing table from the downward entities of a
+   side, in any order, to the side itself.
+   it replaces the upward adjacency searches of apf::makeOrFind
+   while elements are built, which get slow around high
+   degree vertices and walk scattered memory */
+class SideTable
+{
+  public:
+    SideTable(size_t expected)
+    {
+      size_t capacity = 16;
+      while (capacity < expected * 2)
+        capacity *= 2;
+      slots.resize(capacity);
+      count = 0;
+    }
+    MeshEntity*& lookup(MeshEntity** down, int n)
+    {
+      Slot key;
+      makeKey(down, n, key);
+      if ((count + 1) * 2 > slots.size())
+        grow();
+      Slot& s = findSlot(key);
+      if (!s.entity) {
+        s = key;
+        ++count;
+      }
+      return s.entity;
+    }
+  private:
+    struct Slot
+    {
+      Slot():entity(0) {}
+      MeshEntity* down[4];
+      MeshEntity* entity;
+    };
+    /* an insertion sort over the fixed four slots, the unused ones
+       stay null and keep to the end since they are never moved */
+    static void makeKey(MeshEntity** down, int n, Slot& key)
+    {
+      for (int i = 0; i < 4; ++i)
+        key.down[i] = i < n ? down[i] : 0;
+      for (int i = 1; i < 4 && i < n; ++i) {
+        MeshEntity* e = key.down[i];
+        int j = i;
+        for (; j > 0 && e < key.down[j - 1]; --j)
+          key.down[j] = key.down[j - 1];
+        key.down[j] = e;
+      }
+    }
+    static size_t hash(Slot const& key)
+    {
+      size_t h = 0;
+      for (int i = 0; i < 4; ++i) {
+        h ^= reinterpret_cast<size_t>(key.down[i]);
+        h *= 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+      }
+      return h;
+    }
+    static bool same(Slot const& a, Slot const& b)
+    {
+      for (int i = 0; i < 4; ++i)
+        if (a.down[i] != b.down[i])
+          return false;
+      return true;
+    }
+    Slot& findSlot(Slot const& key)
+    {
+      size_t mask = slots.size() - 1;
+      size_t i = hash(key) & mask;
+      while (slots[i].entity && !same(slots[i], key))
+        i = (i + 1) & mask;
+      return slots[i];
+    }
+    void grow()
+    {
+      std::vector<Slot> old;
+      old.swap(slots);
+      slots.resize(old.size() * 2);
+      for (size_t i = 0; i < old.size(); ++i)
+        if (old[i].entity)
+          findSlot(old[i]) = old[i];
+    }
+    std::vector<Slot> slots;
+    size_t count;
+};
 
-static void constructVerts(
-    Mesh2* m, const Gid* conn, int nelem, int etype,
-    GlobalToVert& result)
+/* the same traversal as apf::buildElement, so entities are
+   created in the same order and with the same orientations,
+   but existing sides are found in a SideTable */
+class ElementConstructor : public ElementVertOp
 {
-  ModelEntity* interior = m->findModelEntity(m->getDimension(), 0);
-  int end = nelem * apf::Mesh::adjacentCount[etype][0];
-  for (int i = 0; i < end; ++i)
-    if ( ! result.count(conn[i]))
-      result[conn[i]] = m->createVert_(interior);
-}
+  public:
+    ElementConstructor(Mesh2* m, ModelEntity* c, size_t expected):
+      table(expected)
+    {
+      mesh = m;
+      interior = c;
+      dim = m->getDimension();
+      /* sides the table did not make itself may already exist */
+      hadSides = false;
+      for (int d = 1; d < dim; ++d)
+        if (m->count(d))
+          hadSides = true;
+    }
+    virtual MeshEntity* apply(int type, MeshEntity** down)
+    {
+      int d = Mesh::typeDimension[type];
+      if (d == dim)
+        return mesh->createEntity(type, interior, down);
+      MeshEntity*& e = table.lookup(down, Mesh::adjacentCount[type][d - 1]);
+      if (!e && hadSides)
+        e = findUpward(mesh, type, down);
+      if (!e)
+        e = mesh->createEntity(type, interior, down);
+      return e;
+    }
+  private:
+    Mesh2* mesh;
+    ModelEntity* interior;
+    int dim;
+    bool hadSides;
+    SideTable table;
+};
 
-static void constructElements(
-    Mesh2* m, const Gid* conn, int nelem, int etype,
-    GlobalToVert& globalToVert)
+/* the unique global ids of conn are sorted once and their
+   vertices created in that order; every entry of conn then
+   finds its vertex by binary search instead of a map lookup */
+template <class T>
+static void constructVerts(
+    Mesh2* m, const T* conn, size_t end,
+    GlobalToVert& result, std::vector<MeshEntity*>& verts)
 {
   ModelEntity* interior = m->findModelEntity(m->getDimension(), 0);
-  int nev = apf::Mesh::adjacentCount[etype][0];
-  for (int i = 0; i < nelem; ++i) {
-    Downward verts;
-    int offset = i * nev;
-    for (int j = 0; j < nev; ++j)
-      verts[j] = globalToVert[conn[j + offset]];
-    buildElement(m, interior, etype, verts);
+  std::vector<Gid> gids(conn, conn + end);
+  std::sort(gids.begin(), gids.end());
+  gids.erase(std::unique(gids.begin(), gids.end()), gids.end());
+  std::vector<MeshEntity*> unique(gids.size());
+  for (size_t i = 0; i < gids.size(); ++i) {
+    GlobalToVert::iterator it = result.lower_bound(gids[i]);
+    if (it == result.end() || it->first != gids[i])
+      it = result.insert(it,
+          std::make_pair(gids[i], m->createVert_(interior)));
+    unique[i] = it->second;
+  }
+  verts.resize(end);
+  for (size_t i = 0; i < end; ++i) {
+    Gid gid = conn[i];
+    size_t j = std::lower_bound(gids.begin(), gids.end(), gid) - gids.begin();
+    verts[i] = unique[j];
   }
 }
 
-static Gid getMax(const GlobalToVert& globalToVert)
+static void constructElements(Mesh2* m, std::vector<MeshEntity*>& verts,
+    const int* nelem, const int* etype, int ntypes)
 {
-  Gid max = -1;
-  APF_CONST_ITERATE(GlobalToVert, globalToVert, it)
-    max = std::max(max, it->first);
-  return PCU_Max_Int(max); // this is type-dependent
+  ModelEntity* interior = m->findModelEntity(m->getDimension(), 0);
+  int dim = m->getDimension();
+  /* roughly the number of sides of all dimensions */
+  size_t expected = 0;
+  for (int t = 0; t < ntypes; ++t)
+    for (int d = 1; d < dim; ++d)
+      expected += size_t(nelem[t]) * apf::Mesh::adjacentCount[etype[t]][d] / 2;
+  ElementConstructor c(m, interior, expected);
+  size_t offset = 0;
+  for (int t = 0; t < ntypes; ++t) {
+    int nev = apf::Mesh::adjacentCount[etype[t]][0];
+    for (int i = 0; i < nelem[t]; ++i) {
+      c.run(etype[t], &verts[offset]);
+      offset += nev;
+    }
+  }
 }
 
-
 /* algorithm courtesy of Sebastian Rettenberger:
    use brokers/routers for the vertex global ids.
    Although we have used this trick before (see mpas/apfMPAS.cc),
-   I didn't think to use it here, so credit is given. */
+   I didn't think to use it here, so credit is given.
+   The broker of a global id is its value modulo the number
+   of parts, so sparse 64-bit ids need no dense arrays,
+   and brokers group the requests by sorting them. */
 static void constructResidence(Mesh2* m, GlobalToVert& globalToVert)
 {
-  Gid max = getMax(globalToVert);
-  Gid total = max + 1;
   int peers = PCU_Comm_Peers();
-  int quotient = total / peers;
-  int remainder = total % peers;
-  int mySize = quotient;
-  int self = PCU_Comm_Self();
-  if (self == (peers - 1))
-    mySize += remainder;
-  typedef std::vector< std::vector<int> > TmpParts;
-  TmpParts tmpParts(mySize);
   /* if we have a vertex, send its global id to the
      broker for that global id */
   PCU_Comm_Begin();
   APF_ITERATE(GlobalToVert, globalToVert, it) {
-    int gid = it->first;
-    int to = std::min(peers - 1, gid / quotient);
+    Gid gid = it->first;
+    int to = gid % peers;
     PCU_COMM_PACK(to, gid);
   }
   PCU_Comm_Send();
-  int myOffset = self * quotient;
   /* brokers store all the part ids that sent messages
      for each global id */
+  typedef std::pair<Gid, int> Request;
+  std::vector<Request> requests;
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
-    int from = PCU_Comm_Sender();
-    tmpParts.at(gid - myOffset).push_back(from);
+    requests.push_back(Request(gid, PCU_Comm_Sender()));
   }
+  std::sort(requests.begin(), requests.end());
   /* for each global id, send all associated part ids
      to all associated parts */
   PCU_Comm_Begin();
-  for (int i = 0; i < mySize; ++i) {
-    std::vector<int>& parts = tmpParts[i];
-    for (size_t j = 0; j < parts.size(); ++j) {
-      int to = parts[j];
-      int gid = i + myOffset;
-      int nparts = parts.size();
+  for (size_t i = 0; i < requests.size();) {
+    size_t j = i;
+    while (j < requests.size() && requests[j].first == requests[i].first)
+      ++j;
+    Gid gid = requests[i].first;
+    int nparts = j - i;
+    for (size_t k = i; k < j; ++k) {
+      int to = requests[k].second;
       PCU_COMM_PACK(to, gid);
       PCU_COMM_PACK(to, nparts);
-      for (size_t k = 0; k < parts.size(); ++k)
-        PCU_COMM_PACK(to, parts[k]);
+      for (size_t l = i; l < j; ++l)
+        PCU_COMM_PACK(to, requests[l].second);
     }
+    i = j;
   }
   PCU_Comm_Send();
   /* receiving a global id and associated parts,
      lookup the vertex and classify it on the partition
      model entity for that set of parts */
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     int nparts;
     PCU_COMM_UNPACK(nparts);
@@ -122,7 +259,7 @@ static void constructRemotes(Mesh2* m, GlobalToVert& globalToVert)
   int self = PCU_Comm_Self();
   PCU_Comm_Begin();
   APF_ITERATE(GlobalToVert, globalToVert, it) {
-    int gid = it->first;
+    Gid gid = it->first;
     MeshEntity* vert = it->second;
     Parts residence;
     m->getResidence(vert, residence);
@@ -134,7 +271,7 @@ static void constructRemotes(Mesh2* m, GlobalToVert& globalToVert)
   }
   PCU_Comm_Send();
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     MeshEntity* remote;
     PCU_COMM_UNPACK(remote);
@@ -144,50 +281,82 @@ static void constructRemotes(Mesh2* m, GlobalToVert& globalToVert)
   }
 }
 
-void construct(Mesh2* m, const int* conn, int nelem, int etype,
-    GlobalToVert& globalToVert)
+template <class T>
+static void constructFrom(Mesh2* m, const T* conn, const int* nelem,
+    const int* etype, int ntypes, GlobalToVert& globalToVert)
 {
-  constructVerts(m, conn, nelem, etype, globalToVert);
-  constructElements(m, conn, nelem, etype, globalToVert);
+  size_t end = 0;
+  for (int t = 0; t < ntypes; ++t)
+    end += size_t(nelem[t]) * apf::Mesh::adjacentCount[etype[t]][0];
+  std::vector<MeshEntity*> verts;
+  constructVerts(m, conn, end, globalToVert, verts);
+  constructElements(m, verts, nelem, etype, ntypes);
   constructResidence(m, globalToVert);
   constructRemotes(m, globalToVert);
   stitchMesh(m);
   m->acceptChanges();
 }
 
+void construct(Mesh2* m, const int* conn, int nelem, int etype,
+    GlobalToVert& globalToVert)
+{
+  constructFrom(m, conn, &nelem, &etype, 1, globalToVert);
+}
+
+void construct(Mesh2* m, const Gid* conn, int nelem, int etype,
+    GlobalToVert& globalToVert)
+{
+  constructFrom(m, conn, &nelem, &etype, 1, globalToVert);
+}
+
+void construct(Mesh2* m, const Gid* conn, const int* nelem,
+    const int* etype, int ntypes, GlobalToVert& globalToVert)
+{
+  constructFrom(m, conn, nelem, etype, ntypes, globalToVert);
+}
+
+static Gid getMax(const GlobalToVert& globalToVert)
+{
+  Gid max = -1;
+  if (!globalToVert.empty())
+    max = globalToVert.rbegin()->first;
+  return static_cast<Gid>(PCU_Max_SizeT(max + 1)) - 1;
+}
+
 void setCoords(Mesh2* m, const double* coords, int nverts,
     GlobalToVert& globalToVert)
 {
   Gid max = getMax(globalToVert);
   Gid total = max + 1;
   int peers = PCU_Comm_Peers();
-  int quotient = total / peers;
-  int remainder = total % peers;
-  int mySize = quotient;
+  Gid quotient = total / peers;
+  Gid remainder = total % peers;
+  Gid mySize = quotient;
   int self = PCU_Comm_Self();
   if (self == (peers - 1))
     mySize += remainder;
-  int myOffset = self * quotient;
+  Gid myOffset = self * quotient;
 
   /* Force each peer to have exactly mySize verts.
      This means we might need to send and recv some coords */
   double* c = new double[mySize*3];
 
-  int start = PCU_Exscan_Int(nverts);
+  Gid start = PCU_Exscan_Long(nverts);
 
   PCU_Comm_Begin();
-  int to = std::min(peers - 1, start / quotient);
-  int n = std::min((to+1)*quotient-start, nverts);
-  while (nverts > 0) {
+  int to = std::min(Gid(peers - 1), start / quotient);
+  Gid n = std::min((to+1)*quotient-start, Gid(nverts));
+  Gid left = nverts;
+  while (left > 0) {
     PCU_COMM_PACK(to, start);
     PCU_COMM_PACK(to, n);
     PCU_Comm_Pack(to, coords, n*3*sizeof(double));
 
-    nverts -= n;
+    left -= n;
     start += n;
     coords += n*3;
     to = std::min(peers - 1, to + 1);
-    n = std::min(quotient, nverts);
+    n = std::min(quotient, left);
   }
   PCU_Comm_Send();
   while (PCU_Comm_Receive()) {
@@ -201,13 +370,13 @@ void setCoords(Mesh2* m, const double* coords, int nverts,
   TmpParts tmpParts(mySize);
   PCU_Comm_Begin();
   APF_CONST_ITERATE(GlobalToVert, globalToVert, it) {
-    int gid = it->first;
-    int to = std::min(peers - 1, gid / quotient);
+    Gid gid = it->first;
+    int to = std::min(Gid(peers - 1), gid / quotient);
     PCU_COMM_PACK(to, gid);
   }
   PCU_Comm_Send();
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     int from = PCU_Comm_Sender();
     tmpParts.at(gid - myOffset).push_back(from);
@@ -215,18 +384,18 @@ void setCoords(Mesh2* m, const double* coords, int nverts,
   
   /* Send the coords to everybody who want them */
   PCU_Comm_Begin();
-  for (int i = 0; i < mySize; ++i) {
+  for (Gid i = 0; i < mySize; ++i) {
     std::vector<int>& parts = tmpParts[i];
     for (size_t j = 0; j < parts.size(); ++j) {
       int to = parts[j];
-      int gid = i + myOffset;
+      Gid gid = i + myOffset;
       PCU_COMM_PACK(to, gid);
       PCU_Comm_Pack(to, &c[i*3], 3*sizeof(double));
     }
   }
   PCU_Comm_Send();
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     double v[3];
     PCU_Comm_Unpack(v, sizeof(v));
@@ -252,7 +421,7 @@ void destruct(Mesh2* m, int*& conn, int& nelem, int &etype)
     Downward verts;
     int nverts = m->getDownward(e, 0, verts);
     if (!conn)
-      conn = new Gid[nelem * nverts];
+      conn = new int[nelem * nverts];
     for (int j = 0; j < nverts; ++j)
       conn[i++] = getNumber(global, Node(verts[j], 0));
   }
@@ -28,8 +28,11 @@ class MeshEntity;
 void convert(Mesh *in, Mesh2 *out,
              MeshEntity** nodes=NULL, MeshEntity** elems=NULL, bool copy_data=true);
 
+/** \brief a global vertex id, 64 bits wide on LP64 systems */
+typedef long Gid;
+
 /** \brief a map from global ids to vertex objects */
-typedef std::map<int, MeshEntity*> GlobalToVert;
+typedef std::map<Gid, MeshEntity*> GlobalToVert;
 
 /** \brief construct a mesh from just a connectivity array
   \details this function is here to interface with very
@@ -48,6 +51,20 @@ typedef std::map<int, MeshEntity*> GlobalToVert;
 void construct(Mesh2* m, const int* conn, int nelem, int etype,
     GlobalToVert& globalToVert);
 
+/** \brief construct a mesh from 64-bit global vertex ids
+  \details the same as the int version, for meshes with more
+  than 2^31 vertices. The ids do not need to be contiguous,
+  although apf::setCoords does expect them to be. */
+void construct(Mesh2* m, const Gid* conn, int nelem, int etype,
+    GlobalToVert& globalToVert);
+
+/** \brief construct a mesh with several element types
+  \details conn holds nelem[0] elements of type etype[0],
+  followed by nelem[1] elements of type etype[1] and so on
+  for ntypes types, all of the mesh dimension. */
+void construct(Mesh2* m, const Gid* conn, const int* nelem,
+    const int* etype, int ntypes, GlobalToVert& globalToVert);
+
 /** \brief Assign coordinates to the mesh
   * \details
   * Each peer provides a set of the coordinates. The coords most be ordered
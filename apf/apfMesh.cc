@@ -15,6 +15,7 @@
 #include <pcu_util.h>
 #include <lionPrint.h>
 #include <algorithm>
+#include <vector>
 
 namespace apf {
 
@@ -191,6 +192,21 @@ void Mesh::snapToModel(ModelEntity* m, Vector3 const& p, Vector3& x)
   gmi_eval(getModel(), (gmi_ent*)m, &p[0], &x[0]);
 }
 
+void Mesh::snapToModel(ModelEntity* m, int n, Vector3 const* p, Vector3* x)
+{
+  if (!n)
+    return;
+  std::vector<double> params(2 * n);
+  std::vector<double> points(3 * n);
+  for (int i = 0; i < n; ++i) {
+    params[2 * i] = p[i][0];
+    params[2 * i + 1] = p[i][1];
+  }
+  gmi_eval_batch(getModel(), (gmi_ent*)m, n, &params[0], &points[0]);
+  for (int i = 0; i < n; ++i)
+    x[i] = Vector3(&points[3 * i]);
+}
+
 void Mesh::getParamOn(ModelEntity* g, MeshEntity* e, Vector3& p)
 {
   ModelEntity* from_g = toModel(e);
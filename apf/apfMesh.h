@@ -191,9 +191,16 @@ class Mesh
                array if the size is known, otherwise use apf::Downward */
     virtual int getDownward(MeshEntity* e, int dimension,
         MeshEntity** adjacent) = 0;
-    /** \brief Return the number of one-level upward adjacent entities. */
+    /** \brief Return the number of one-level upward adjacent entities.
+      \details upward queries are not always read-only: an MDS mesh
+                rebuilds the upward adjacency freed by
+                apf::dropMdsUpward on the first one, which also applies
+                to getUpward, getUp, hasUp and upward getAdjacent.
+                See apf::restoreMdsUpward and apf::prepareThreadedReads
+                before querying from several threads. */
     virtual int countUpward(MeshEntity* e) = 0;
-    /** \brief Get the i'th one-level upward adjacent entity. */
+    /** \brief Get the i'th one-level upward adjacent entity.
+      \details may rebuild dropped upward adjacency, see countUpward */
     virtual MeshEntity* getUpward(MeshEntity* e, int i) = 0;
     /** \brief Get the unordered set of one-level upward entities. */
     virtual void getUp(MeshEntity* e, Up& up) = 0;
@@ -293,6 +300,9 @@ class Mesh
     bool canGetModelNormal();
     /** \brief evaluate parametric coordinate (p) as a spatial point (x) */
     void snapToModel(ModelEntity* m, Vector3 const& p, Vector3& x);
+    /** \brief evaluate (n) parametric coordinates on one model entity
+      \details one batched model query instead of (n) calls */
+    void snapToModel(ModelEntity* m, int n, Vector3 const* p, Vector3* x);
     /** \brief reparameterize mesh vertex (e) onto model entity (g) */
     void getParamOn(ModelEntity* g, MeshEntity* e, Vector3& p);
     /** \brief get the periodic properties of a model entity
@@ -401,6 +411,28 @@ class Mesh
   Other implementations may define their own. */
 void verify(Mesh* m, bool abort_on_error=true);
 
+/** \brief run the checks of apf::verify with one exchange
+  \details the copy, ghost, match, alignment, coordinate and tag data
+  checks share a single communication phase, and the local adjacency
+  and volume checks run on up to the given number of threads.
+  With sample > 1, only every sample-th entity of each dimension
+  is checked, which is cheap enough for production runs.
+  \returns the global number of copies, coordinates and tags that
+  disagree across parts. Copies that disagree fail when
+  abort_on_error is set, the others are only reported, as in
+  apf::verify. */
+long verifyFast(Mesh* m, int threads = 1, int sample = 1,
+    bool abort_on_error = true);
+
+/** \brief run apf::verifyFast on some entities and their closure
+  \details this is meant for the entities created or changed since
+  the mesh was last verified, for example those collected by an
+  apf::BuildCallback such as ma::NewEntities.
+  It is collective, parts with nothing to check pass count = 0.
+  \returns the same count as apf::verifyFast */
+long verifyEntities(Mesh* m, MeshEntity* const* entities, int count,
+    int threads = 1, bool abort_on_error = true);
+
 long verifyVolumes(Mesh* m, bool printVolumes = true);
 
 /** \brief get the dimension of a mesh entity */
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2026 Scientific Computation Research Center
+ *
+ * This work is open source software, licensed under the terms of the
+ * BSD license as described in the LICENSE file in the top-level directory.
+ */
+
+#include <PCU.h>
+#include "apfSyncPlan.h"
+#include "apfField.h"
+#include "apfFieldData.h"
+#include "apfShape.h"
+#include <pcu_util.h>
+#include <map>
+#include <vector>
+
+namespace apf {
+
+/* the entities exchanged with each peer, in message order.
+   the entities for peers[i] are entities[offsets[i]] ...
+   entities[offsets[i+1]-1] and they hold nodes[i] nodes in total */
+struct Exchange
+{
+  std::vector<int> peers;
+  std::vector<int> offsets;
+  std::vector<MeshEntity*> entities;
+  std::vector<int> nodes;
+};
+
+struct SyncPlanData
+{
+  Mesh* mesh;
+  FieldShape* shape;
+  MPI_Comm comm;
+  Exchange syncSend;
+  Exchange syncRecv;
+  Exchange reduceSend;
+  Exchange reduceRecv;
+  /* shared ghosts, which start a reduction from the neutral element */
+  std::vector<MeshEntity*> neutral;
+  /* the exchange in flight */
+  Exchange* recv;
+  std::vector<Field*> fields;
+  std::vector<double> sendBuffer;
+  std::vector<double> recvBuffer;
+  std::vector<size_t> recvStart;
+  std::vector<MPI_Request> requests;
+};
+
+typedef std::map<int, std::vector<MeshEntity*> > EntityLists;
+
+static void flatten(Mesh* m, FieldShape* s, EntityLists& lists, Exchange& x)
+{
+  x.offsets.push_back(0);
+  APF_ITERATE(EntityLists, lists, it) {
+    x.peers.push_back(it->first);
+    int nodes = 0;
+    for (size_t i = 0; i < it->second.size(); ++i)
+      nodes += s->countNodesOn(m->getType(it->second[i]));
+    x.nodes.push_back(nodes);
+    x.entities.insert(x.entities.end(), it->second.begin(), it->second.end());
+    x.offsets.push_back(x.entities.size());
+  }
+}
+
+/* each sender packs the pointers of the receiving copies in its send
+   order, so the receivers learn the order values will arrive in */
+static void finishBuild(SyncPlanData* d, EntityLists& sending,
+    EntityLists& remote, Exchange& send, Exchange& recv)
+{
+  PCU_Comm_Begin();
+  APF_ITERATE(EntityLists, remote, it)
+    PCU_Comm_Pack(it->first, &(it->second[0]),
+        it->second.size() * sizeof(MeshEntity*));
+  PCU_Comm_Send();
+  EntityLists receiving;
+  while (PCU_Comm_Receive()) {
+    MeshEntity* e;
+    PCU_COMM_UNPACK(e);
+    receiving[PCU_Comm_Sender()].push_back(e);
+  }
+  flatten(d->mesh, d->shape, sending, send);
+  flatten(d->mesh, d->shape, receiving, recv);
+}
+
+static void addCopy(EntityLists& sending, EntityLists& remote,
+    MeshEntity* e, int peer, MeshEntity* copy)
+{
+  sending[peer].push_back(e);
+  remote[peer].push_back(copy);
+}
+
+/* the same messages as synchronizeFieldData */
+static void buildSync(SyncPlanData* d, Sharing* shr)
+{
+  Mesh* m = d->mesh;
+  EntityLists sending;
+  EntityLists remote;
+  for (int dim = 0; dim < 4; ++dim) {
+    if ( ! d->shape->hasNodesIn(dim))
+      continue;
+    MeshIterator* it = m->begin(dim);
+    MeshEntity* e;
+    while ((e = m->iterate(it))) {
+      if ( ! shr->isOwned(e))
+        continue;
+      CopyArray copies;
+      shr->getCopies(e, copies);
+      for (size_t i = 0; i < copies.getSize(); ++i)
+        addCopy(sending, remote, e, copies[i].peer, copies[i].entity);
+      Copies ghosts;
+      if (m->getGhosts(e, ghosts))
+        APF_ITERATE(Copies, ghosts, git)
+          addCopy(sending, remote, e, git->first, git->second);
+    }
+    m->end(it);
+  }
+  finishBuild(d, sending, remote, d->syncSend, d->syncRecv);
+}
+
+/* the same messages as reduceFieldData */
+static void buildReduce(SyncPlanData* d, Sharing* shr)
+{
+  Mesh* m = d->mesh;
+  EntityLists sending;
+  EntityLists remote;
+  for (int dim = 0; dim < 4; ++dim) {
+    if ( ! d->shape->hasNodesIn(dim))
+      continue;
+    MeshIterator* it = m->begin(dim);
+    MeshEntity* e;
+    while ((e = m->iterate(it))) {
+      if (m->isGhost(e) && shr->isShared(e)) {
+        d->neutral.push_back(e);
+        continue;
+      }
+      CopyArray copies;
+      shr->getCopies(e, copies);
+      for (size_t i = 0; i < copies.getSize(); ++i)
+        addCopy(sending, remote, e, copies[i].peer, copies[i].entity);
+      Copies ghosts;
+      if (copies.getSize() && m->getGhosts(e, ghosts))
+        APF_ITERATE(Copies, ghosts, git)
+          addCopy(sending, remote, e, git->first, git->second);
+    }
+    m->end(it);
+  }
+  finishBuild(d, sending, remote, d->reduceSend, d->reduceRecv);
+}
+
+SyncPlan::SyncPlan(Mesh* m, FieldShape* s, Sharing* shr)
+{
+  data = new SyncPlanData();
+  data->mesh = m;
+  data->shape = s;
+  data->recv = 0;
+  MPI_Comm_dup(PCU_Get_Comm(), &data->comm);
+  bool deleteSharing = false;
+  if (!shr) {
+    shr = getSharing(m);
+    deleteSharing = true;
+  }
+  buildSync(data, shr);
+  buildReduce(data, shr);
+  if (deleteSharing)
+    delete shr;
+}
+
+SyncPlan::~SyncPlan()
+{
+  PCU_ALWAYS_ASSERT(!data->recv);
+  MPI_Comm_free(&data->comm);
+  delete data;
+}
+
+static int countComponents(SyncPlanData* d)
+{
+  int n = 0;
+  for (size_t i = 0; i < d->fields.size(); ++i)
+    n += d->fields[i]->countComponents();
+  return n;
+}
+
+static void begin(SyncPlanData* d, Exchange& send, Exchange& recv,
+    Field* const* fields, int count)
+{
+  PCU_ALWAYS_ASSERT(!d->recv);
+  d->recv = &recv;
+  d->fields.assign(fields, fields + count);
+  for (int i = 0; i < count; ++i)
+    PCU_ALWAYS_ASSERT(fields[i]->getShape() == d->shape);
+  int components = countComponents(d);
+  size_t recvSize = 0;
+  d->recvStart.resize(recv.peers.size());
+  for (size_t i = 0; i < recv.peers.size(); ++i) {
+    d->recvStart[i] = recvSize;
+    recvSize += recv.nodes[i] * components;
+  }
+  size_t sendSize = 0;
+  for (size_t i = 0; i < send.peers.size(); ++i)
+    sendSize += send.nodes[i] * components;
+  d->recvBuffer.resize(recvSize);
+  d->sendBuffer.resize(sendSize);
+  d->requests.resize(recv.peers.size() + send.peers.size());
+  MPI_Request* request = d->requests.empty() ? 0 : &d->requests[0];
+  double* received = d->recvBuffer.empty() ? 0 : &d->recvBuffer[0];
+  for (size_t i = 0; i < recv.peers.size(); ++i) {
+    int size = recv.nodes[i] * components;
+    MPI_Irecv(received + d->recvStart[i], size, MPI_DOUBLE,
+        recv.peers[i], 0, d->comm, request++);
+  }
+  double* values = d->sendBuffer.empty() ? 0 : &d->sendBuffer[0];
+  for (size_t i = 0; i < send.peers.size(); ++i) {
+    double* start = values;
+    for (int j = 0; j < count; ++j) {
+      FieldDataOf<double>* fd = fields[j]->getData();
+      for (int k = send.offsets[i]; k < send.offsets[i + 1]; ++k) {
+        MeshEntity* e = send.entities[k];
+        fd->get(e, values);
+        values += fields[j]->countValuesOn(e);
+      }
+    }
+    MPI_Isend(start, static_cast<int>(values - start), MPI_DOUBLE,
+        send.peers[i], 0, d->comm, request++);
+  }
+}
+
+/* unpack the received values, either setting them or applying op */
+static void end(SyncPlanData* d, const ReductionOp<double>* op)
+{
+  PCU_ALWAYS_ASSERT(d->recv);
+  Exchange& recv = *(d->recv);
+  if (!d->requests.empty())
+    MPI_Waitall(static_cast<int>(d->requests.size()), &d->requests[0],
+        MPI_STATUSES_IGNORE);
+  std::vector<double> current;
+  if (op) {
+    for (size_t j = 0; j < d->fields.size(); ++j) {
+      FieldDataOf<double>* fd = d->fields[j]->getData();
+      for (size_t k = 0; k < d->neutral.size(); ++k) {
+        int n = d->fields[j]->countValuesOn(d->neutral[k]);
+        if (!n)
+          continue;
+        current.assign(n, op->getNeutralElement());
+        fd->set(d->neutral[k], &current[0]);
+      }
+    }
+  }
+  double* received = d->recvBuffer.empty() ? 0 : &d->recvBuffer[0];
+  for (size_t i = 0; i < recv.peers.size(); ++i) {
+    double* values = received + d->recvStart[i];
+    for (size_t j = 0; j < d->fields.size(); ++j) {
+      FieldDataOf<double>* fd = d->fields[j]->getData();
+      for (int k = recv.offsets[i]; k < recv.offsets[i + 1]; ++k) {
+        MeshEntity* e = recv.entities[k];
+        int n = d->fields[j]->countValuesOn(e);
+        if (op && n) {
+          current.resize(n);
+          fd->get(e, &current[0]);
+          for (int l = 0; l < n; ++l)
+            current[l] = op->apply(current[l], values[l]);
+          fd->set(e, &current[0]);
+        } else {
+          fd->set(e, values);
+        }
+        values += n;
+      }
+    }
+  }
+  d->recv = 0;
+  d->fields.clear();
+}
+
+void SyncPlan::synchronize(Field* f)
+{
+  synchronize(&f, 1);
+}
+
+void SyncPlan::synchronize(Field* const* fields, int count)
+{
+  beginSynchronize(fields, count);
+  endSynchronize();
+}
+
+void SyncPlan::beginSynchronize(Field* const* fields, int count)
+{
+  begin(data, data->syncSend, data->syncRecv, fields, count);
+}
+
+void SyncPlan::endSynchronize()
+{
+  end(data, 0);
+}
+
+void SyncPlan::accumulate(Field* f)
+{
+  reduce(&f, 1);
+}
+
+void SyncPlan::reduce(Field* const* fields, int count,
+    const ReductionOp<double>& op)
+{
+  beginReduce(fields, count);
+  endReduce(op);
+}
+
+void SyncPlan::beginReduce(Field* const* fields, int count)
+{
+  begin(data, data->reduceSend, data->reduceRecv, fields, count);
+}
+
+void SyncPlan::endReduce(const ReductionOp<double>& op)
+{
+  end(data, &op);
+}
+
+int SyncPlan::countSendPeers()
+{
+  return static_cast<int>(data->syncSend.peers.size());
+}
+
+}
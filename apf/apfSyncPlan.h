@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 Scientific Computation Research Center
+ *
+ * This work is open source software, licensed under the terms of the
+ * BSD license as described in the LICENSE file in the top-level directory.
+ */
+
+#ifndef APFSYNCPLAN_H
+#define APFSYNCPLAN_H
+
+/** \file apfSyncPlan.h
+  \brief Reusable communication plans for field synchronization */
+
+#include "apf.h"
+
+namespace apf {
+
+struct SyncPlanData;
+
+/** \brief A precomputed exchange of field values between entity copies.
+  \details apf::synchronize and apf::accumulate find the copies of every
+  entity and send an entity pointer with each value on every call.
+  A SyncPlan does that once for a field shape and an apf::Sharing:
+  it keeps an ordered list of entities per neighbor part on both sides,
+  so each exchange only moves packed values, optionally for several
+  fields at once.
+
+  The begin and end calls split an exchange so that work on interior
+  entities can overlap the communication. Values of the fields on shared
+  and ghost nodes must not change between them. The plan is only valid
+  until the mesh changes, and its fields need values on every node.
+
+  Construction and destruction are collective. */
+class SyncPlan
+{
+  public:
+    /** \brief build the plan for fields with shape s.
+      \details shr defaults to apf::getSharing(m) and is not kept */
+    SyncPlan(Mesh* m, FieldShape* s, Sharing* shr = 0);
+    ~SyncPlan();
+    /** \brief same as apf::synchronize */
+    void synchronize(Field* f);
+    /** \brief synchronize several fields with one message per neighbor */
+    void synchronize(Field* const* fields, int count);
+    /** \brief send owned values to the copies */
+    void beginSynchronize(Field* const* fields, int count);
+    /** \brief receive the owned values started by beginSynchronize */
+    void endSynchronize();
+    /** \brief same as apf::accumulate */
+    void accumulate(Field* f);
+    /** \brief same as apf::sharedReduction for several fields */
+    void reduce(Field* const* fields, int count,
+        const ReductionOp<double>& op = ReductionSum<double>());
+    /** \brief send the local values of shared nodes to their copies */
+    void beginReduce(Field* const* fields, int count);
+    /** \brief apply op to the values started by beginReduce
+      \details ghost copies of shared entities start from the
+      neutral element of op, like in apf::sharedReduction */
+    void endReduce(const ReductionOp<double>& op = ReductionSum<double>());
+    /** \brief the number of parts this part sends values to */
+    int countSendPeers();
+  private:
+    SyncPlan(SyncPlan const&);
+    SyncPlan& operator=(SyncPlan const&);
+    SyncPlanData* data;
+};
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 Scientific Computation Research Center
+ *
+ * This work is open source software, licensed under the terms of the
+ * BSD license as described in the LICENSE file in the top-level directory.
+ */
+
+#include "apfThreads.h"
+#include "apfMesh.h"
+#include <algorithm>
+#ifdef APF_THREADS
+#include <atomic>
+#include <thread>
+#include <vector>
+#endif
+
+namespace apf {
+
+int countThreads(int threads, int count, int batch)
+{
+#ifdef APF_THREADS
+  int batches = (count + batch - 1) / batch;
+  return std::max(1, std::min(threads, batches));
+#else
+  (void)threads;
+  (void)count;
+  (void)batch;
+  return 1;
+#endif
+}
+
+#ifdef APF_THREADS
+struct SharedLoop
+{
+  ThreadWork* work;
+  int count;
+  int batch;
+  std::atomic<int> next;
+};
+
+static void runLoop(SharedLoop* l, int thread)
+{
+  int first;
+  while ((first = l->next.fetch_add(l->batch)) < l->count)
+    l->work->run(thread, first, std::min(first + l->batch, l->count));
+}
+#endif
+
+void runThreads(ThreadWork* work, int count, int threads, int batch)
+{
+  threads = countThreads(threads, count, batch);
+#ifdef APF_THREADS
+  SharedLoop l;
+  l.work = work;
+  l.count = count;
+  l.batch = batch;
+  l.next = 0;
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threads; ++i)
+    pool.push_back(std::thread(runLoop, &l, i));
+  runLoop(&l, 0);
+  for (size_t i = 0; i < pool.size(); ++i)
+    pool[i].join();
+#else
+  (void)threads;
+  for (int first = 0; first < count; first += batch)
+    work->run(0, first, std::min(first + batch, count));
+#endif
+}
+
+void prepareThreadedReads(Mesh* m)
+{
+  for (int d = 0; d < m->getDimension(); ++d) {
+    MeshIterator* it = m->begin(d);
+    MeshEntity* e = m->iterate(it);
+    m->end(it);
+    if (e)
+      m->countUpward(e);
+  }
+}
+
+}
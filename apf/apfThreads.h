@@ -0,0 +1,54 @@
+/*
+ * Copyright 2026 Scientific Computation Research Center
+ *
+ * This work is open source software, licensed under the terms of the
+ * BSD license as described in the LICENSE file in the top-level directory.
+ */
+
+#ifndef APFTHREADS_H
+#define APFTHREADS_H
+
+/** \file apfThreads.h
+  \brief Shared-memory loops over independent items */
+
+namespace apf {
+
+class Mesh;
+
+/** \brief the body of a loop run by apf::runThreads */
+class ThreadWork
+{
+  public:
+    virtual ~ThreadWork() {}
+    /** \brief process items [first, last)
+      \details (thread) is in [0, threads) and is the same for every
+      call made by one thread, so it can select per-thread scratch
+      space. Calls may run at the same time and must only write
+      memory that belongs to their own items or thread. */
+    virtual void run(int thread, int first, int last) = 0;
+};
+
+/** \brief the number of threads apf::runThreads will use
+  \details at most (threads), at most one per batch, and 1 when
+  the library was built without ENABLE_THREADS */
+int countThreads(int threads, int count, int batch);
+
+/** \brief run (work) over items [0, count) in batches of (batch)
+  \details batches are handed out from a shared counter, so threads
+  that get cheap items take more of them. The calling thread is
+  thread zero. Without ENABLE_THREADS the batches run in order on
+  the calling thread. */
+void runThreads(ThreadWork* work, int count, int threads, int batch);
+
+/** \brief build lazily stored mesh data before threads read the mesh
+  \details some meshes build data on the first query that needs it,
+  which is a data race if that query comes from several threads.
+  MDS, for example, rebuilds the upward adjacency freed by
+  apf::dropMdsUpward on the first upward query. This makes those
+  queries once, serially. Only reads of the mesh are then safe
+  from threads; tags and fields must not be given to new entities. */
+void prepareThreadedReads(Mesh* m);
+
+}
+
+#endif
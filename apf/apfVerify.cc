@@ -1,6 +1,7 @@
 #include <PCU.h>
 #include "apfMesh.h"
 #include "apf.h"
+#include "apfVerify.h"
 #include <gmi.h>
 #include <sstream>
 #include <apfGeometry.h>
@@ -61,10 +62,9 @@ static void verifyDown(Mesh* m, MeshEntity* e, int gd, int ed)
   PCU_ALWAYS_ASSERT(isSubset(r, getCandidateParts(m, e)));
 }
 
-typedef std::map<ModelEntity*, int> UpwardCounts;
 typedef std::map<ModelEntity*, bool> SideManifoldness;
 
-static void getUpwardCounts(gmi_model* gm, int meshDimension, UpwardCounts& uc)
+void getUpwardCounts(gmi_model* gm, int meshDimension, UpwardCounts& uc)
 {
   for (int d = 0; d < meshDimension; ++d) {
     gmi_iter* it = gmi_begin(gm, d);
@@ -100,7 +100,9 @@ static void verifyUp(Mesh* m, UpwardCounts& guc,
   PCU_ALWAYS_ASSERT(difference);
   ModelEntity* ge = m->toModel(e);
   int modelDimension = m->getModelType(ge);
-  int modelUpwardCount = guc[ge];
+  /* a lookup, not operator[], since threads share the counts */
+  UpwardCounts::iterator guci = guc.find(ge);
+  int modelUpwardCount = (guci == guc.end()) ? 0 : guci->second;
   bool isOnNonManifoldFace = (modelDimension == meshDimension - 1) &&
                              (modelUpwardCount > 1);
   bool isOnManifoldBoundary = ( ! isOnNonManifoldFace) &&
@@ -194,7 +196,7 @@ static void verifyResidence(Mesh* m, MeshEntity* e)
     PCU_ALWAYS_ASSERT(p.count(it->first));
 }
 
-static void verifyEntity(Mesh* m, UpwardCounts& guc, MeshEntity* e, bool abort_on_error)
+void verifyEntity(Mesh* m, UpwardCounts& guc, MeshEntity* e, bool abort_on_error)
 {
   int ed = getDimension(m, e);
   int md = m->getDimension();
@@ -208,7 +210,7 @@ static void verifyEntity(Mesh* m, UpwardCounts& guc, MeshEntity* e, bool abort_o
   verifyResidence(m, e);
 }
 
-static Copies getAllCopies(Mesh* m, MeshEntity* e)
+Copies getAllCopies(Mesh* m, MeshEntity* e)
 {
   Copies c;
   m->getRemotes(e, c);
@@ -216,7 +218,7 @@ static Copies getAllCopies(Mesh* m, MeshEntity* e)
   return c;
 }
 
-static void verifyAllCopies(Copies& a)
+void verifyAllCopies(Copies& a)
 {
   APF_ITERATE(Copies, a, it)
   {
@@ -225,7 +227,7 @@ static void verifyAllCopies(Copies& a)
   }
 }
 
-static void packCopies(
+void packCopies(
     int to,
     Copies& copies)
 {
@@ -238,7 +240,7 @@ static void packCopies(
   }
 }
 
-static void unpackCopies(
+void unpackCopies(
     Copies& copies)
 {
   int n;
@@ -309,7 +311,7 @@ static void sendGhostCopies(Mesh* m, MeshEntity* e)
   }
 }
 
-static void receiveGhostCopies(Mesh* m)
+MeshEntity* receiveGhostCopies(Mesh* m)
 {
   int from = PCU_Comm_Sender();
   MeshEntity* e;
@@ -327,6 +329,7 @@ static void receiveGhostCopies(Mesh* m)
   {
     PCU_ALWAYS_ASSERT(ghosts.size()==1);
   }
+  return e;
 }
 
 static void verifyGhostCopies(Mesh* m)
@@ -346,7 +349,7 @@ static void verifyGhostCopies(Mesh* m)
     receiveGhostCopies(m);
 }
 
-static bool hasMatch(
+bool hasMatch(
     Matches& matches,
     int peer,
     MeshEntity* entity)
@@ -380,7 +383,7 @@ static void receiveMatches(Mesh* m)
   PCU_ALWAYS_ASSERT(hasMatch(matches, PCU_Comm_Sender(), source));
 }
 
-static bool hasDuplicates(Matches const& matches) {
+bool hasDuplicates(Matches const& matches) {
   for (size_t i = 0; i < matches.getSize(); ++i)
   for (size_t j = 0; j < matches.getSize(); ++j)
     if (i != j && matches[i].peer == matches[j].peer &&
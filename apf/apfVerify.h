@@ -0,0 +1,35 @@
+/*
+ * Copyright 2026 Scientific Computation Research Center
+ *
+ * This work is open source software, licensed under the terms of the
+ * BSD license as described in the LICENSE file in the top-level directory.
+ */
+
+#ifndef APFVERIFY_H
+#define APFVERIFY_H
+
+/* the checks of apf::verify that apf::verifyFast reuses */
+
+#include "apfMesh.h"
+#include <map>
+
+namespace apf {
+
+typedef std::map<ModelEntity*, int> UpwardCounts;
+
+void getUpwardCounts(gmi_model* gm, int meshDimension, UpwardCounts& uc);
+void verifyEntity(Mesh* m, UpwardCounts& guc, MeshEntity* e,
+    bool abort_on_error);
+Copies getAllCopies(Mesh* m, MeshEntity* e);
+void verifyAllCopies(Copies& a);
+void packCopies(int to, Copies& copies);
+void unpackCopies(Copies& copies);
+MeshEntity* receiveGhostCopies(Mesh* m);
+bool hasMatch(Matches& matches, int peer, MeshEntity* entity);
+bool hasDuplicates(Matches const& matches);
+void packFieldInfo(Field* f, int to);
+void unpackFieldInfo(std::string& name, int& type, int& size);
+
+}
+
+#endif
@@ -0,0 +1,527 @@
+/*
+ * Copyright 2026 Scientific Computation Research Center
+ *
+ * This work is open source software, licensed under the terms of the
+ * BSD license as described in the LICENSE file in the top-level directory.
+ */
+
+#include <PCU.h>
+#include "apfMesh.h"
+#include "apf.h"
+#include "apfVerify.h"
+#include "apfThreads.h"
+#include <gmi.h>
+#include <sstream>
+#include <apfGeometry.h>
+#include <pcu_util.h>
+#include <lionPrint.h>
+#include <algorithm>
+
+namespace apf {
+
+/* apf::verifyFast and apf::verifyEntities run the checks of
+   apf::verify, but each checked entity packs one record per copy into
+   a single PCU phase instead of one phase per kind of check, and the
+   local checks run in threads over a flat array of entities.
+   Mismatches between copies are counted rather than asserted, so the
+   caller can see how many there were. */
+
+enum { REMOTE_RECORD, GHOST_RECORD, MATCH_RECORD, INFO_RECORD };
+
+static int countTagBytes(Mesh* m, MeshTag* t)
+{
+  int size = m->getTagSize(t);
+  switch (m->getTagType(t)) {
+    case Mesh::DOUBLE: return size * sizeof(double);
+    case Mesh::INT: return size * sizeof(int);
+    case Mesh::LONG: return size * sizeof(long);
+    default: break;
+  }
+  return 0;
+}
+
+static void getTagValues(Mesh* m, MeshEntity* e, MeshTag* t, void* data)
+{
+  switch (m->getTagType(t)) {
+    case Mesh::DOUBLE: m->getDoubleTag(e, t, static_cast<double*>(data));
+                       break;
+    case Mesh::INT: m->getIntTag(e, t, static_cast<int*>(data));
+                    break;
+    case Mesh::LONG: m->getLongTag(e, t, static_cast<long*>(data));
+                     break;
+    default: break;
+  }
+}
+
+template <class T>
+static bool areSame(const void* a, const void* b, int n)
+{
+  const T* x = static_cast<const T*>(a);
+  const T* y = static_cast<const T*>(b);
+  for (int i = 0; i < n; ++i)
+    if (x[i] != y[i])
+      return false;
+  return true;
+}
+
+static bool haveSameValues(Mesh* m, MeshTag* t, const void* a, const void* b)
+{
+  int n = m->getTagSize(t);
+  switch (m->getTagType(t)) {
+    case Mesh::DOUBLE: return areSame<double>(a, b, n);
+    case Mesh::INT: return areSame<int>(a, b, n);
+    case Mesh::LONG: return areSame<long>(a, b, n);
+    default: break;
+  }
+  return true;
+}
+
+struct FastVerify
+{
+  Mesh* mesh;
+  DynamicArray<MeshTag*> tags;
+  /* the tags not sent to remote copies and to ghost copies */
+  std::vector<bool> skipRemote;
+  std::vector<bool> skipGhost;
+  std::vector<char> sent;
+  std::vector<char> local;
+  std::set<MeshTag*> mismatchTags;
+  long copyMismatches;
+  long coordMismatches;
+};
+
+static void setupTags(FastVerify* v)
+{
+  Mesh* m = v->mesh;
+  m->getTags(v->tags);
+  size_t n = v->tags.getSize();
+  v->skipRemote.resize(n);
+  v->skipGhost.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    std::string name = m->getTagName(v->tags[i]);
+    v->skipRemote[i] = (name == "ghost_tag");
+    v->skipGhost[i] = (name == "ghost_tag" || name == "ghosted_tag");
+  }
+  if (n && !PCU_Comm_Self()) {
+    lion_oprint(1,"  - verifying tags: ");
+    for (size_t i = 0; i < n; ++i) {
+      lion_oprint(1,"%s", m->getTagName(v->tags[i]));
+      if (i + 1 < n) lion_oprint(1,", ");
+    }
+    lion_oprint(1,"\n");
+  }
+}
+
+/* the tag and field names go to the previous part, as in
+   verifyTags and verifyFields */
+static void packInfo(FastVerify* v)
+{
+  int self = PCU_Comm_Self();
+  if (!self)
+    return;
+  Mesh* m = v->mesh;
+  int to = self - 1;
+  int kind = INFO_RECORD;
+  PCU_COMM_PACK(to, kind);
+  int n = v->tags.getSize();
+  PCU_COMM_PACK(to, n);
+  for (int i = 0; i < n; ++i)
+    packTagInfo(m, v->tags[i], to);
+  n = m->countFields();
+  PCU_COMM_PACK(to, n);
+  for (int i = 0; i < n; ++i)
+    packFieldInfo(m->getField(i), to);
+}
+
+static void unpackInfo(FastVerify* v)
+{
+  Mesh* m = v->mesh;
+  int n;
+  PCU_COMM_UNPACK(n);
+  PCU_ALWAYS_ASSERT(v->tags.getSize() == (size_t)n);
+  for (int i = 0; i < n; ++i) {
+    std::string name;
+    int type;
+    int size;
+    unpackTagInfo(name, type, size);
+    PCU_ALWAYS_ASSERT(name == m->getTagName(v->tags[i]));
+    PCU_ALWAYS_ASSERT(type == m->getTagType(v->tags[i]));
+    PCU_ALWAYS_ASSERT(size == m->getTagSize(v->tags[i]));
+  }
+  PCU_COMM_UNPACK(n);
+  PCU_ALWAYS_ASSERT(m->countFields() == n);
+  for (int i = 0; i < n; ++i) {
+    std::string name;
+    int type;
+    int size;
+    unpackFieldInfo(name, type, size);
+    Field* f = m->getField(i);
+    PCU_ALWAYS_ASSERT(name == getName(f));
+    PCU_ALWAYS_ASSERT(type == getValueType(f));
+    PCU_ALWAYS_ASSERT(size == countComponents(f));
+  }
+}
+
+static void packTags(FastVerify* v, MeshEntity* e, int to,
+    bool withTags, std::vector<bool>& skip)
+{
+  Mesh* m = v->mesh;
+  int n = 0;
+  if (withTags)
+    for (size_t i = 0; i < v->tags.getSize(); ++i)
+      if (!skip[i] && m->hasTag(e, v->tags[i]))
+        ++n;
+  PCU_COMM_PACK(to, n);
+  if (!n)
+    return;
+  for (size_t i = 0; i < v->tags.getSize(); ++i) {
+    if (skip[i] || !m->hasTag(e, v->tags[i]))
+      continue;
+    int index = i;
+    PCU_COMM_PACK(to, index);
+    int bytes = countTagBytes(m, v->tags[i]);
+    v->sent.resize(bytes + 1);
+    getTagValues(m, e, v->tags[i], &v->sent[0]);
+    PCU_Comm_Pack(to, &v->sent[0], bytes);
+  }
+}
+
+static void unpackTags(FastVerify* v, MeshEntity* e)
+{
+  Mesh* m = v->mesh;
+  int n;
+  PCU_COMM_UNPACK(n);
+  for (int j = 0; j < n; ++j) {
+    int index;
+    PCU_COMM_UNPACK(index);
+    PCU_ALWAYS_ASSERT(index < (int)v->tags.getSize());
+    MeshTag* t = v->tags[index];
+    int bytes = countTagBytes(m, t);
+    v->sent.resize(bytes + 1);
+    PCU_Comm_Unpack(&v->sent[0], bytes);
+    if (v->mismatchTags.count(t))
+      continue;
+    if (!m->hasTag(e, t)) {
+      v->mismatchTags.insert(t);
+      continue;
+    }
+    v->local.resize(bytes + 1);
+    getTagValues(m, e, t, &v->local[0]);
+    if (!haveSameValues(m, t, &v->sent[0], &v->local[0]))
+      v->mismatchTags.insert(t);
+  }
+}
+
+/* one record per remote copy with the copies, the downward remotes
+   and the coordinates, followed by the owner's tag data. the sender's
+   downward count is packed so that a wrong remote copy, which may
+   even have another dimension, is counted instead of misreading
+   the rest of the message */
+static void packRemotes(FastVerify* v, MeshEntity* e, bool isOwned)
+{
+  Mesh* m = v->mesh;
+  int self = PCU_Comm_Self();
+  Copies r;
+  m->getRemotes(e, r);
+  PCU_ALWAYS_ASSERT(!r.count(self));
+  int hasCopies = !m->isGhost(e);
+  Copies a;
+  if (hasCopies) {
+    a = getAllCopies(m, e);
+    verifyAllCopies(a);
+  }
+  int d = getDimension(m, e);
+  Downward down;
+  int nd = d ? m->getDownward(e, d - 1, down) : 0;
+  Copies downRemotes[12];
+  for (int i = 0; i < nd; ++i)
+    m->getRemotes(down[i], downRemotes[i]);
+  Vector3 x;
+  Vector3 p(0,0,0);
+  if (!d) {
+    m->getPoint(e, 0, x);
+    m->getParam(e, p);
+  }
+  APF_ITERATE(Copies, r, it) {
+    int to = it->first;
+    int kind = REMOTE_RECORD;
+    PCU_COMM_PACK(to, kind);
+    PCU_COMM_PACK(to, it->second);
+    PCU_COMM_PACK(to, hasCopies);
+    if (hasCopies)
+      packCopies(to, a);
+    PCU_COMM_PACK(to, d);
+    PCU_COMM_PACK(to, nd);
+    for (int i = 0; i < nd; ++i) {
+      MeshEntity* dr = downRemotes[i][to];
+      PCU_COMM_PACK(to, dr);
+    }
+    if (!d) {
+      PCU_COMM_PACK(to, x);
+      PCU_COMM_PACK(to, p);
+    }
+    packTags(v, e, to, isOwned, v->skipRemote);
+  }
+}
+
+static void unpackRemote(FastVerify* v)
+{
+  Mesh* m = v->mesh;
+  MeshEntity* e;
+  PCU_COMM_UNPACK(e);
+  bool same = true;
+  int hasCopies;
+  PCU_COMM_UNPACK(hasCopies);
+  if (hasCopies) {
+    Copies a;
+    unpackCopies(a);
+    same = (a == getAllCopies(m, e));
+  }
+  int od;
+  PCU_COMM_UNPACK(od);
+  int ond;
+  PCU_COMM_UNPACK(ond);
+  int d = getDimension(m, e);
+  Downward down;
+  int nd = d ? m->getDownward(e, d - 1, down) : 0;
+  same = same && (od == d) && (ond == nd);
+  for (int i = 0; i < ond; ++i) {
+    MeshEntity* dr;
+    PCU_COMM_UNPACK(dr);
+    same = same && (down[i] == dr);
+  }
+  if (!od) {
+    Vector3 ox;
+    Vector3 op;
+    PCU_COMM_UNPACK(ox);
+    PCU_COMM_UNPACK(op);
+    Vector3 x;
+    Vector3 p(0,0,0);
+    if (!d) {
+      m->getPoint(e, 0, x);
+      m->getParam(e, p);
+    }
+    if (!(areClose(x, ox, 0.0) && areClose(p, op, 0.0)))
+      ++v->coordMismatches;
+  }
+  if (!same)
+    ++v->copyMismatches;
+  unpackTags(v, e);
+}
+
+static void packGhosts(FastVerify* v, MeshEntity* e, bool isOwned)
+{
+  Mesh* m = v->mesh;
+  Copies g;
+  m->getGhosts(e, g);
+  PCU_ALWAYS_ASSERT(g.size());
+  bool withTags = isOwned && m->isGhosted(e);
+  APF_ITERATE(Copies, g, it) {
+    int to = it->first;
+    int kind = GHOST_RECORD;
+    PCU_COMM_PACK(to, kind);
+    PCU_COMM_PACK(to, it->second);
+    PCU_COMM_PACK(to, e);
+    packTags(v, e, to, withTags, v->skipGhost);
+  }
+}
+
+static void unpackGhost(FastVerify* v)
+{
+  unpackTags(v, receiveGhostCopies(v->mesh));
+}
+
+static void packMatches(FastVerify* v, MeshEntity* e)
+{
+  Matches matches;
+  v->mesh->getMatches(e, matches);
+  PCU_ALWAYS_ASSERT(!hasDuplicates(matches));
+  APF_ITERATE(Matches, matches, it) {
+    PCU_ALWAYS_ASSERT(!((it->peer == PCU_Comm_Self())&&(it->entity == e)));
+    int kind = MATCH_RECORD;
+    PCU_COMM_PACK(it->peer, kind);
+    PCU_COMM_PACK(it->peer, e);
+    PCU_COMM_PACK(it->peer, it->entity);
+  }
+}
+
+static void unpackMatch(FastVerify* v)
+{
+  MeshEntity* source;
+  PCU_COMM_UNPACK(source);
+  MeshEntity* e;
+  PCU_COMM_UNPACK(e);
+  Matches matches;
+  v->mesh->getMatches(e, matches);
+  if (!hasMatch(matches, PCU_Comm_Sender(), source))
+    ++v->copyMismatches;
+}
+
+static void packEntity(FastVerify* v, MeshEntity* e)
+{
+  Mesh* m = v->mesh;
+  bool isOwned = (m->getOwner(e) == PCU_Comm_Self());
+  if (m->isShared(e))
+    packRemotes(v, e, isOwned);
+  if (m->isGhosted(e) || m->isGhost(e))
+    packGhosts(v, e, isOwned);
+  if (m->hasMatching())
+    packMatches(v, e);
+}
+
+static void unpackRecord(FastVerify* v)
+{
+  int kind;
+  PCU_COMM_UNPACK(kind);
+  switch (kind) {
+    case REMOTE_RECORD: unpackRemote(v); break;
+    case GHOST_RECORD: unpackGhost(v); break;
+    case MATCH_RECORD: unpackMatch(v); break;
+    case INFO_RECORD: unpackInfo(v); break;
+    default: fail("apf::verify: unknown record\n");
+  }
+}
+
+/* entities are handed out by apf::runThreads in batches */
+static int const verifyBatch = 256;
+
+struct LocalWork : public ThreadWork
+{
+  Mesh* mesh;
+  UpwardCounts* guc;
+  std::vector<MeshEntity*>* entities;
+  bool abortOnError;
+  /* negative simplices found by each thread */
+  std::vector<long> negative;
+  void run(int thread, int first, int last)
+  {
+    int dim = mesh->getDimension();
+    for (int i = first; i < last; ++i) {
+      MeshEntity* e = (*entities)[i];
+      verifyEntity(mesh, *guc, e, abortOnError);
+      if (getDimension(mesh, e) != dim || !isSimplex(mesh->getType(e)))
+        continue;
+      double v = measure(mesh, e);
+      if (v < 0) {
+        std::stringstream ss;
+        ss << "warning: element volume " << v
+          << " at " << getLinearCentroid(mesh, e) << '\n';
+        std::string s = ss.str();
+        lion_oprint(1, "%s", s.c_str());
+        ++negative[thread];
+      }
+    }
+  }
+};
+
+/* returns the global number of mismatches and sets (checked) to
+   the global number of entities checked */
+static long verifyChosen(Mesh* m, std::vector<MeshEntity*>& chosen,
+    int threads, bool abort_on_error, long& checked)
+{
+  FastVerify v;
+  v.mesh = m;
+  v.copyMismatches = 0;
+  v.coordMismatches = 0;
+  setupTags(&v);
+  UpwardCounts guc;
+  getUpwardCounts(m->getModel(), m->getDimension(), guc);
+  int count = chosen.size();
+  threads = countThreads(threads, count, verifyBatch);
+  if (threads > 1)
+    prepareThreadedReads(m);
+  LocalWork w;
+  w.mesh = m;
+  w.guc = &guc;
+  w.entities = &chosen;
+  w.abortOnError = abort_on_error;
+  w.negative.assign(threads, 0);
+  runThreads(&w, count, threads, verifyBatch);
+  long negative = 0;
+  for (int i = 0; i < threads; ++i)
+    negative += w.negative[i];
+  PCU_Comm_Begin();
+  packInfo(&v);
+  for (size_t i = 0; i < chosen.size(); ++i)
+    packEntity(&v, chosen[i]);
+  PCU_Comm_Send();
+  while (PCU_Comm_Receive())
+    unpackRecord(&v);
+  long counts[5] = {v.copyMismatches, v.coordMismatches,
+    (long)v.mismatchTags.size(), negative, (long)chosen.size()};
+  PCU_Add_Longs(counts, 5);
+  checked = counts[4];
+  if (!PCU_Comm_Self()) {
+    if (counts[2])
+      APF_ITERATE(std::set<MeshTag*>, v.mismatchTags, it)
+        lion_oprint(1,"  - tag \"%s\" data mismatch over "
+            "remote/ghost copies\n", m->getTagName(*it));
+    if (counts[0])
+      lion_eprint(1,"apf::verify fail: %ld copy mismatches\n",
+          counts[0]);
+    if (counts[1])
+      lion_eprint(1,"apf::verify fail: %ld coordinate mismatches\n",
+          counts[1]);
+    if (counts[3])
+      lion_eprint(1,"apf::verify warning: %ld negative simplex elements\n",
+          counts[3]);
+  }
+  if (counts[0] && abort_on_error)
+    fail("apf::verify: remote, ghost or matched copies disagree\n");
+  return counts[0] + counts[1] + counts[2];
+}
+
+long verifyFast(Mesh* m, int threads, int sample, bool abort_on_error)
+{
+  double t0 = PCU_Time();
+  PCU_ALWAYS_ASSERT(sample > 0);
+  std::vector<MeshEntity*> chosen;
+  for (int d = 0; d <= 3; ++d)
+  {
+    MeshIterator* it = m->begin(d);
+    MeshEntity* e;
+    size_t n = 0;
+    while ((e = m->iterate(it)))
+    {
+      if (!(n % sample))
+        chosen.push_back(e);
+      ++n;
+    }
+    m->end(it);
+    PCU_ALWAYS_ASSERT(n == m->count(d));
+    if (d > m->getDimension())
+      PCU_ALWAYS_ASSERT(!n);
+  }
+  long n;
+  long failures = verifyChosen(m, chosen, threads, abort_on_error, n);
+  double t1 = PCU_Time();
+  if (!PCU_Comm_Self())
+    lion_oprint(1,"mesh verified (%ld entities) in %f seconds\n",
+        n, t1 - t0);
+  return failures;
+}
+
+long verifyEntities(Mesh* m, MeshEntity* const* entities, int count,
+    int threads, bool abort_on_error)
+{
+  double t0 = PCU_Time();
+  std::vector<MeshEntity*> chosen(entities, entities + count);
+  for (int i = 0; i < count; ++i) {
+    int ed = getDimension(m, entities[i]);
+    for (int d = 0; d < ed; ++d) {
+      Downward down;
+      int nd = m->getDownward(entities[i], d, down);
+      chosen.insert(chosen.end(), down, down + nd);
+    }
+  }
+  std::sort(chosen.begin(), chosen.end());
+  chosen.erase(std::unique(chosen.begin(), chosen.end()), chosen.end());
+  long n;
+  long failures = verifyChosen(m, chosen, threads, abort_on_error, n);
+  double t1 = PCU_Time();
+  if (!PCU_Comm_Self())
+    lion_oprint(1,"%ld entities verified in %f seconds\n", n, t1 - t0);
+  return failures;
+}
+
+}
@@ -42,13 +42,16 @@ set(APF_SOURCES
   apfArrayData.cc
   apfUserData.cc
   apfPartition.cc
+  apfSyncPlan.cc
   apfConvert.cc
   apfConstruct.cc
   apfVerify.cc
+  apfVerifyFast.cc
   apfGeometry.cc
   apfBoundaryToElementXi.cc
   apfSimplexAngleCalcs.cc
   apfFile.cc
+  apfThreads.cc
 )
 
 set(APF_HEADERS
@@ -67,9 +70,11 @@ set(APF_HEADERS
   apfNumbering.h
   apfMixedNumbering.h
   apfPartition.h
+  apfSyncPlan.h
   apfConvert.h
   apfGeometry.h
   apf2mth.h
+  apfThreads.h
 )
 
 set(APF_SOURCES
@@ -94,10 +99,18 @@ set(APF_HEADERS
 # THIS IS WHERE TRIBITS GETS HEADERS
 include_directories(${APF_INCLUDE_DIRS})
 
+# apf::runThreads uses std::thread only when enabled
+if(ENABLE_THREADS)
+  find_package(Threads REQUIRED)
+  add_definitions(-DAPF_THREADS)
+  set(APF_THREAD_LIBS ${CMAKE_THREAD_LIBS_INIT})
+endif()
+
 #Library
 tribits_add_library(
    apf
    HEADERS ${APF_HEADERS}
-   SOURCES ${APF_SOURCES})
+   SOURCES ${APF_SOURCES}
+   IMPORTEDLIBS ${APF_THREAD_LIBS})
 
 tribits_package_postprocess()
@@ -164,9 +164,21 @@ int countNumberInvalidElements(apf::Mesh2* m)
     }
   } else {
     Quality* qual = makeQuality(m,2);
-    while ((e = m->iterate(it))) {
-      n += (qual->checkValidity(e) > 1);
-    }
+    const int batch = 64;
+    apf::MeshEntity* elems[batch];
+    int validity[batch];
+    int k = 0;
+    do {
+      e = m->iterate(it);
+      if (e)
+        elems[k++] = e;
+      if (k == batch || (!e && k)) {
+        qual->checkBatchValidity(elems,k,validity);
+        for (int i = 0; i < k; ++i)
+          n += (validity[i] > 1);
+        k = 0;
+      }
+    } while (e);
     delete qual;
   }
   m->end(it);
@@ -169,6 +169,11 @@ public:
   virtual double getQuality(apf::MeshEntity* e) = 0;
   /** \brief check the validity (det(Jacobian) > eps) of an element */
   virtual int checkValidity(apf::MeshEntity* e) = 0;
+  /** \brief checkValidity of count elements, written to validity
+    \details in 3D the Bezier coefficients of the whole batch are
+    computed with one matrix product */
+  virtual void checkBatchValidity(apf::MeshEntity* const* e, int count,
+      int* validity);
 protected:
   apf::Mesh* mesh;
   int algorithm;
@@ -177,6 +182,17 @@ protected:
 /** \brief use this to make a quality object with the correct dimension */
 Quality* makeQuality(apf::Mesh* m, int algorithm = 2);
 
+/** \brief checkValidity of count elements with up to threads threads
+  \details each thread has its own Quality and takes batches of
+  elements until none are left. The mesh is only read, so it must
+  not be changed by other threads meanwhile */
+void checkValidities(apf::Mesh* m, apf::MeshEntity* const* e, int count,
+    int* validity, int threads = 1);
+/** \brief Quality::getQuality of count elements,
+  threaded like checkValidities */
+void getQualities(apf::Mesh* m, apf::MeshEntity* const* e, int count,
+    double* quality, int threads = 1);
+
 /** \brief computes interpolation error of a curved entity on a mesh
   \details this computes the Hausdorff distance by sampling
    n points per dimension of the entity through uniform
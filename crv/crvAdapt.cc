@@ -17,6 +17,7 @@
 #include <maLayer.h>
 #include <PCU.h>
 #include <pcu_util.h>
+#include <vector>
 
 namespace crv {
 
@@ -114,24 +115,31 @@ int markInvalidEntities(Adapt* a)
   int count = 0;
   ma::Mesh* m = a->mesh;
   int dimension = m->getDimension();
+  /* the untagged elements are gathered first so their
+     validity can be checked by several threads */
+  std::vector<ma::Entity*> elems;
   ma::Iterator* it = m->begin(dimension);
-  Quality* qual = makeQuality(m,2);
   while ((e = m->iterate(it)))
   {
     /* this skip conditional is powerful: it affords us a
        3X speedup of the entire adaptation in some cases */
-    int qualityTag = crv::getTag(a,e);
-    if (qualityTag) continue;
-    qualityTag = qual->checkValidity(e);
-    if (qualityTag >= 2)
+    if (!crv::getTag(a,e))
+      elems.push_back(e);
+  }
+  m->end(it);
+  int n = elems.size();
+  std::vector<int> validity(n);
+  if (n)
+    checkValidities(m,&elems[0],n,&validity[0],a->input->shapeThreads);
+  for (int i = 0; i < n; ++i)
+  {
+    if (validity[i] >= 2)
     {
-      crv::setTag(a,e,qualityTag);
-      if (m->isOwned(e))
+      crv::setTag(a,elems[i],validity[i]);
+      if (m->isOwned(elems[i]))
         ++count;
     }
   }
-  m->end(it);
-  delete qual;
   return PCU_Add_Int(count);
 }
 
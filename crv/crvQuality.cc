@@ -10,6 +10,10 @@
 #include "crvMath.h"
 #include "crvTables.h"
 #include "crvQuality.h"
+#include <apfThreads.h>
+
+#include <algorithm>
+#include <vector>
 
 namespace crv {
 
@@ -48,6 +52,38 @@ public:
   apf::NewArray<double> subdivisionCoeffs[3];
 };
 
+/* the xi points where the 3D Jacobian determinant is sampled and the
+   matrix taking the samples to its Bezier coefficients. inverting the
+   matrix dominates the cost of making a Quality, so it is done once per
+   order */
+struct TetJacDet
+{
+  apf::NewArray<apf::Vector3> xi;
+  apf::NewArray<double> transformation;
+};
+
+static TetJacDet* getTetJacDet(int order)
+{
+  static TetJacDet table[MAX_ORDER+1];
+  TetJacDet& t = table[order];
+  if (!t.transformation.allocated()){
+    int P = 3*(order-1);
+    int n = getNumControlPoints(apf::Mesh::TET,P);
+    t.xi.allocate(n);
+    collectNodeXi(apf::Mesh::TET,apf::Mesh::TET,P,
+        elem_vert_xi[apf::Mesh::TET],t.xi);
+    mth::Matrix<double> A(n,n), Ai(n,n);
+    getBezierTransformationMatrix(apf::Mesh::TET,P,A,
+        elem_vert_xi[apf::Mesh::TET]);
+    invertMatrixWithPLU(n,A,Ai);
+    t.transformation.allocate(n*n);
+    for (int i = 0; i < n; ++i)
+      for (int j = 0; j < n; ++j)
+        t.transformation[i*n+j] = Ai(i,j);
+  }
+  return &t;
+}
+
 class Quality3D : public Quality
 {
 public:
@@ -59,28 +95,26 @@ public:
           3*(order-1),apf::Mesh::simplexTypes[d],subdivisionCoeffs[d]);
     }
     n = getNumControlPoints(apf::Mesh::TET,3*(order-1));
-    xi.allocate(n);
-    transformationMatrix.resize(n,n);
-    mth::Matrix<double> A(n,n);
-    collectNodeXi(apf::Mesh::TET,apf::Mesh::TET,3*(order-1),
-        elem_vert_xi[apf::Mesh::TET],xi);
-    getBezierTransformationMatrix(apf::Mesh::TET,3*(order-1),A,
-        elem_vert_xi[apf::Mesh::TET]);
-    invertMatrixWithPLU(n,A,transformationMatrix);
+    jacDet = getTetJacDet(order);
   }
   virtual ~Quality3D() {};
   double getQuality(apf::MeshEntity* e);
   int checkValidity(apf::MeshEntity* e);
+  void checkBatchValidity(apf::MeshEntity* const* e, int count,
+      int* validity);
   // 3D uses an alternate method of computing these
   // returns a validity tag so both quality and validity can
   // quit early if this function thinks they should
   // if validity = true, quit if its obvious the element is invalid
   int computeJacDetNodes(apf::MeshEntity* e,
       apf::NewArray<double>& nodes, bool validity);
+  // the samples of the above at jacDet->xi, before the transformation
+  int sampleJacDet(apf::MeshEntity* e, double* samples, bool validity);
+  // validity from the Bezier coefficients of the Jacobian determinant
+  int checkJacDetNodes(apf::NewArray<double>& nodes);
   int n;
   apf::NewArray<double> subdivisionCoeffs[4];
-  apf::NewArray<apf::Vector3> xi;
-  mth::Matrix<double> transformationMatrix;
+  TetJacDet* jacDet;
 };
 
 Quality* makeQuality(apf::Mesh* m, int algorithm)
@@ -100,6 +134,13 @@ Quality::Quality(apf::Mesh* m, int algorithm_) :
   PCU_ALWAYS_ASSERT(order >= 1);
 };
 
+void Quality::checkBatchValidity(apf::MeshEntity* const* e, int count,
+    int* validity)
+{
+  for (int i = 0; i < count; ++i)
+    validity[i] = checkValidity(e[i]);
+}
+
 /* This work is based on the approach of Geometric Validity of high-order
  * lagrange finite elements, theory and practical guidance,
  * by George, Borouchaki, and Barral. (2014)
@@ -334,6 +375,10 @@ static void getJacDetBySubdivisionMatrices(int type, int P,
     int iter, apf::NewArray<double>& c,apf::NewArray<double>& nodes,
     double& minJ, double& maxJ, bool& done, bool& quality)
 {
+  // quality only needs one subdivision and no limit, these are not
+  // changed in the statics so that threads can evaluate qualities
+  int maxIter = quality ? 1 : maxAdaptiveIter;
+  double limit = quality ? -1e10 : minAcceptable;
   int n = getNumControlPoints(type,P);
   double change = minJ;
   if(!done){
@@ -342,7 +387,7 @@ static void getJacDetBySubdivisionMatrices(int type, int P,
     change = minJ - change;
   }
 
-  if(!done && iter < maxAdaptiveIter && (quality || minJ/maxJ < minAcceptable)
+  if(!done && iter < maxIter && (quality || minJ/maxJ < limit)
       && std::fabs(change) > convergenceTolerance){
 
     iter++;
@@ -352,6 +397,19 @@ static void getJacDetBySubdivisionMatrices(int type, int P,
 
     subdivideBezierEntityJacobianDet(P,type,c,nodes,subNodes);
 
+    // the vertex coefficients are values of the determinant, so one
+    // below the limit proves the entity invalid
+    if (!quality){
+      int nv = apf::Mesh::adjacentCount[type][0];
+      for (int i = 0; i < numSplits[type]; ++i)
+        for (int j = 0; j < nv; ++j)
+          if (subNodes[i][j] < minAcceptable){
+            minJ = subNodes[i][j];
+            done = true;
+            return;
+          }
+    }
+
     apf::NewArray<double> newMinJ(numSplits[type]);
     apf::NewArray<double> newMaxJ(numSplits[type]);
     for (int i = 0; i < numSplits[type]; ++i){
@@ -359,7 +417,7 @@ static void getJacDetBySubdivisionMatrices(int type, int P,
       newMaxJ[i] = -1e10;
     }
 
-    for (int i = 0; i < numSplits[type]; ++i)
+    for (int i = 0; i < numSplits[type] && (quality || !done); ++i)
       getJacDetBySubdivisionMatrices(type,P,iter,c,subNodes[i],
           newMinJ[i],newMaxJ[i],done,quality);
 
@@ -369,7 +427,7 @@ static void getJacDetBySubdivisionMatrices(int type, int P,
       minJ = std::min(newMinJ[i],minJ);
       maxJ = std::max(newMaxJ[i],maxJ);
     }
-  } else if (minJ/maxJ < minAcceptable){
+  } else if (minJ/maxJ < limit){
     done = true;
   }
 }
@@ -464,27 +522,62 @@ int Quality2D::checkValidity(apf::MeshEntity* e)
 
 int Quality3D::checkValidity(apf::MeshEntity* e)
 {
-
   apf::NewArray<double> nodes(n);
-//  apf::Element* elem = apf::createElement(mesh->getCoordinateField(),e);
-//  apf::NewArray<apf::Vector3> elemNodes;
-//  apf::getVectorNodes(elem,elemNodes);
-//  apf::destroyElement(elem);
-//  getTetJacDetNodes(order,elemNodes,nodes);
   int validityTag = computeJacDetNodes(e,nodes,true);
   if (validityTag > 1)
     return validityTag;
-// check verts
-  apf::Downward verts;
-  mesh->getDownward(e,0,verts);
+  return checkJacDetNodes(nodes);
+}
+
+void Quality3D::checkBatchValidity(apf::MeshEntity* const* e, int count,
+    int* validity)
+{
+  std::vector<double> samples(n*count);
+  std::vector<int> kept;
+  for (int i = 0; i < count; ++i){
+    validity[i] = sampleJacDet(e[i],&samples[i*n],true);
+    if (validity[i] == 1)
+      kept.push_back(i);
+  }
+  int k = kept.size();
+  if (!k)
+    return;
+  // the coefficients of all kept elements with one matrix product,
+  // one column per element so the inner loop is contiguous
+  std::vector<double> S(n*k);
+  for (int c = 0; c < k; ++c)
+    for (int j = 0; j < n; ++j)
+      S[j*k+c] = samples[kept[c]*n+j];
+  std::vector<double> C(n*k,0.);
+  double const* T = &jacDet->transformation[0];
+  for (int r = 0; r < n; ++r)
+    for (int j = 0; j < n; ++j){
+      double t = T[r*n+j];
+      double const* Sj = &S[j*k];
+      double* Cr = &C[r*k];
+      for (int c = 0; c < k; ++c)
+        Cr[c] += t*Sj[c];
+    }
+  apf::NewArray<double> nodes(n);
+  for (int c = 0; c < k; ++c){
+    for (int r = 0; r < n; ++r)
+      nodes[r] = C[r*k+c];
+    validity[kept[c]] = checkJacDetNodes(nodes);
+  }
+}
+
+int Quality3D::checkJacDetNodes(apf::NewArray<double>& nodes)
+{
+  // by the convex hull property, positive coefficients prove validity
+  if (calcMinJacDet(n,nodes) >= minAcceptable)
+    return 1;
+  // check verts
   for (int i = 0; i < 4; ++i){
     if(nodes[i] < minAcceptable){
       return 2+i;
     }
   }
 
-  apf::MeshEntity* edges[6];
-  mesh->getDownward(e,1,edges);
   double minJ = 0, maxJ = 0;
   // Vertices will already be flagged in the first check
   for (int edge = 0; edge < 6; ++edge){
@@ -524,8 +617,6 @@ int Quality3D::checkValidity(apf::MeshEntity* e)
       }
     }
   }
-  apf::MeshEntity* faces[4];
-  mesh->getDownward(e,2,faces);
   for (int face = 0; face < 4; ++face){
     double minJ = -1e10;
     for (int i = 0; i < (3*order-4)*(3*order-5)/2; ++i){
@@ -618,6 +709,22 @@ int Quality3D::computeJacDetNodes(apf::MeshEntity* e,
     apf::NewArray<double>& nodes, bool validity)
 {
   apf::NewArray<double> interNodes(n);
+  int validityTag = sampleJacDet(e,&interNodes[0],validity);
+  if (validityTag > 1)
+    return validityTag;
+  double const* T = &jacDet->transformation[0];
+  for( int i = 0; i < n; ++i){
+    nodes[i] = 0.;
+    for( int j = 0; j < n; ++j)
+      nodes[i] += interNodes[j]*T[i*n+j];
+  }
+  return 1;
+}
+
+int Quality3D::sampleJacDet(apf::MeshEntity* e, double* interNodes,
+    bool validity)
+{
+  apf::NewArray<apf::Vector3>& xi = jacDet->xi;
   apf::MeshElement* me = apf::createMeshElement(mesh,e);
   if (validity == false)
   {
@@ -661,13 +768,6 @@ int Quality3D::computeJacDetNodes(apf::MeshEntity* e,
     }
   }
   apf::destroyMeshElement(me);
-
-  for( int i = 0; i < n; ++i){
-    nodes[i] = 0.;
-    for( int j = 0; j < n; ++j)
-      nodes[i] += interNodes[j]*transformationMatrix(i,j);
-  }
-
   return 1;
 }
 
@@ -690,16 +790,10 @@ double Quality2D::getQuality(apf::MeshEntity* e)
   bool done = false;
   double minJ = -1e10, maxJ = -1e10;
 
-  double oldAcceptable = minAcceptable;
-  int oldIter = maxAdaptiveIter;
-  maxAdaptiveIter = 1;
-  minAcceptable = -1e10;
   bool quality = true;
   getJacDetBySubdivisionMatrices(apf::Mesh::TRIANGLE,2*(order-1),
       0,subdivisionCoeffs[2],nodes,minJ,maxJ,done,quality);
   done = false;
-  minAcceptable = oldAcceptable;
-  maxAdaptiveIter = oldIter;
   if(std::fabs(maxJ) > 1e-8)
     return minJ/maxJ;
   else return minJ;
@@ -737,16 +831,10 @@ double Quality3D::getQuality(apf::MeshEntity* e)
   bool done = false;
   double minJ = -1e10, maxJ = -1e10;
 
-  double oldAcceptable = minAcceptable;
-  int oldIter = maxAdaptiveIter;
-  maxAdaptiveIter = 1; // just do one interation, thats enough
-  minAcceptable = -1e10;
   bool quality = true;
   getJacDetBySubdivisionMatrices(apf::Mesh::TET,3*(order-1),
       0,subdivisionCoeffs[3],nodes,minJ,maxJ,done,quality);
   done = false;
-  minAcceptable = oldAcceptable;
-  maxAdaptiveIter = oldIter;
   if(std::fabs(maxJ) > 1e-8)
     return minJ/maxJ;
   else return minJ;
@@ -769,4 +857,61 @@ double getQuality(apf::Mesh* m, apf::MeshEntity* e)
   return quality;
 }
 
+/* elements are handed out in batches, so threads
+   that get cheap elements take more of them */
+static int const qualityBatch = 64;
+
+struct QualityWork : public apf::ThreadWork
+{
+  apf::MeshEntity* const* elements;
+  int* validity;
+  double* quality;
+  std::vector<Quality*> quals;
+  void run(int thread, int first, int last)
+  {
+    Quality* qual = quals[thread];
+    if (validity)
+      qual->checkBatchValidity(elements + first, last - first,
+          validity + first);
+    else
+      for (int i = first; i < last; ++i)
+        quality[i] = qual->getQuality(elements[i]);
+  }
+};
+
+static void runQualityWork(apf::Mesh* m, QualityWork* w, int count,
+    int threads)
+{
+  threads = apf::countThreads(threads, count, qualityBatch);
+  // the constructors fill the static tables the threads share,
+  // so all of them run here first
+  w->quals.resize(threads);
+  for (int i = 0; i < threads; ++i)
+    w->quals[i] = makeQuality(m,2);
+  apf::prepareThreadedReads(m);
+  apf::runThreads(w, count, threads, qualityBatch);
+  for (int i = 0; i < threads; ++i)
+    delete w->quals[i];
+}
+
+void checkValidities(apf::Mesh* m, apf::MeshEntity* const* e, int count,
+    int* validity, int threads)
+{
+  QualityWork w;
+  w.elements = e;
+  w.validity = validity;
+  w.quality = 0;
+  runQualityWork(m, &w, count, threads);
+}
+
+void getQualities(apf::Mesh* m, apf::MeshEntity* const* e, int count,
+    double* quality, int threads)
+{
+  QualityWork w;
+  w.elements = e;
+  w.validity = 0;
+  w.quality = quality;
+  runQualityWork(m, &w, count, threads);
+}
+
 }
@@ -19,6 +19,7 @@
 #include <maShape.h>
 #include <pcu_util.h>
 #include <iostream>
+#include <vector>
 
 /* This is similar to maShape.cc, conceptually, but different enough
  * that some duplicate code makes sense */
@@ -571,9 +572,10 @@ static void swapInvalidEdges(Adapt* a)
   double t0 = PCU_Time();
   EdgeSwapper es(a);
   ma::applyOperator(a,&es);
+  int successCount = PCU_Add_Int(es.ns);
   double t1 = PCU_Time();
   ma::print("Swapped %d bad edges "
-      "in %f seconds",es.ns, t1-t0);
+      "in %f seconds",successCount, t1-t0);
 }
 
 static void repositionInvalidEdges(Adapt* a)
@@ -581,9 +583,10 @@ static void repositionInvalidEdges(Adapt* a)
   double t0 = PCU_Time();
   EdgeReshaper es(a);
   ma::applyOperator(a,&es);
+  int successCount = PCU_Add_Int(es.nr);
   double t1 = PCU_Time();
   ma::print("Repositioned %d bad edges "
-      "in %f seconds",es.nr, t1-t0);
+      "in %f seconds",successCount, t1-t0);
 }
 
 int fixInvalidEdges(Adapt* a)
@@ -601,52 +604,88 @@ int fixInvalidEdges(Adapt* a)
 }
 
 
-struct IsBadCrvQuality : public ma::Predicate
+double measureCurvedQuality(ma::Mesh* m, ma::SizeField* sf,
+    ma::Entity* e, double curved)
 {
-  IsBadCrvQuality(Adapt* a_):a(a_)
-  {
-    sh = crv::getShapeHandler(a);
-  }
-  ~IsBadCrvQuality()
+  double lq;
+  if (m->getType(e) == apf::Mesh::TRIANGLE)
+    lq = ma::measureTriQuality(m, sf, e);
+  else if (m->getType(e) == apf::Mesh::TET)
+    lq = ma::measureTetQuality(m, sf, e);
+  else
+    return -1;
+  if (lq < 0)
+    return lq;
+  return lq*curved;
+}
+
+/* like ma::markEntities with the curved shape handler, but the
+   Jacobian quality of all unchecked elements is computed first
+   by a->input->shapeThreads threads */
+int markCrvBadQuality(Adapt* a)
+{
+  ma::Mesh* m = a->mesh;
+  ma::Entity* e;
+  std::vector<ma::Entity*> elems;
+  ma::Iterator* it = m->begin(m->getDimension());
+  while ((e = m->iterate(it)))
   {
-    delete sh;
+    PCU_ALWAYS_ASSERT( ! ma::getFlag(a,e,ma::BAD_QUALITY));
+    if ( ! ma::getFlag(a,e,ma::OK_QUALITY))
+      elems.push_back(e);
   }
-  bool operator()(apf::MeshEntity* e)
+  m->end(it);
+  int n = elems.size();
+  std::vector<double> curved(n);
+  if (n)
+    getQualities(m,&elems[0],n,&curved[0],a->input->shapeThreads);
+  long count = 0;
+  for (int i = 0; i < n; ++i)
   {
-    return sh->getQuality(e) < a->input->goodQuality;
+    if (measureCurvedQuality(m,a->sizeField,elems[i],curved[i]) <
+        a->input->goodQuality)
+    {
+      ma::setFlag(a,elems[i],ma::BAD_QUALITY);
+      if (m->isOwned(elems[i]))
+        ++count;
+    }
+    else
+      ma::setFlag(a,elems[i],ma::OK_QUALITY);
   }
-  Adapt* a;
-  ma::ShapeHandler* sh;
-};
-
-int markCrvBadQuality(Adapt* a)
-{
-  IsBadCrvQuality p(a);
-  return ma::markEntities(a, a->mesh->getDimension(), p,
-      ma::BAD_QUALITY, ma::OK_QUALITY);
+  return PCU_Add_Long(count);
 }
 
-
 int fixLargeAngles(Adapt *a)
 {
+  double t0 = PCU_Time();
+  int successCount;
   if (a->mesh->getDimension() == 3) {
     CrvLargeAngleTetFixer tetFixer(a);
     applyOperator(a, &tetFixer);
-    /* return tetFixer.getSuccessCount(); */
+    successCount = tetFixer.getSuccessCount();
   }
   else {
     CrvLargeAngleTriFixer triFixer(a);
     applyOperator(a, &triFixer);
-    /* return triFixer.getSuccessCount(); */
+    successCount = triFixer.getSuccessCount();
   }
-  return 0;
+  successCount = PCU_Add_Int(successCount);
+  double t1 = PCU_Time();
+  ma::print("Fixed %d large angle elements "
+      "in %f seconds",successCount, t1-t0);
+  return successCount;
 }
 
 static int fixShortEdgeElements(Adapt* a)
 {
+  double t0 = PCU_Time();
   CrvShortEdgeFixer fixer(a);
   applyOperator(a,&fixer);
-  return fixer.nr;
+  int successCount = PCU_Add_Int(fixer.nr);
+  double t1 = PCU_Time();
+  ma::print("Removed %d short edges "
+      "in %f seconds",successCount, t1-t0);
+  return successCount;
 }
 
 void fixCrvElementShapes(Adapt* a)
@@ -663,17 +702,9 @@ void fixCrvElementShapes(Adapt* a)
     if ( ! count)
       break;
     prev_count = count;
-    fixLargeAngles(a); // update this
-    /* int numOpSuccess = fixLargeAngles(a); // update this */
-    /* PCU_Add_Ints(&numOpSuccess,1); */
-    /* if (PCU_Comm_Self() == 0) */
-    /*   lion_oprint(1,"==> %d large angle fix operations succeeded.\n", numOpSuccess); */
+    fixLargeAngles(a);
     markCrvBadQuality(a);
-    fixShortEdgeElements(a); // update this
-    /* int numEdgeRemoved = fixShortEdgeElements(a); // update this */
-    /* PCU_Add_Ints(&numEdgeRemoved,1); */
-    /* if (PCU_Comm_Self() == 0) */
-    /*   lion_oprint(1,"==> %d edges removal operations succeeded.\n", numEdgeRemoved); */
+    fixShortEdgeElements(a);
     count = markCrvBadQuality(a);
     ++i;
   } while(count < prev_count && i < 6); // the second conditions is to make sure this does not take long
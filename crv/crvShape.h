@@ -63,6 +63,14 @@ int fixInvalidEdges(Adapt* a);
     elements in a same manner as ma::fixElementShape */
 void fixCrvElementShapes(Adapt* a);
 
+/** \brief the quality the bezier shape handler gives an element
+    \details the linear quality in the size field times the given
+    Jacobian quality of the curved element, or the linear quality
+    if that is negative. Only triangles and tets have one,
+    others get -1 */
+double measureCurvedQuality(ma::Mesh* m, ma::SizeField* sf,
+    ma::Entity* e, double curved);
+
 /** \brief get bezier shape handler */
 ma::ShapeHandler* getShapeHandler(ma::Adapt* a);
 
@@ -232,7 +232,7 @@ void CrvLargeAngleTetFixer::apply()
 
 int CrvLargeAngleTetFixer::getSuccessCount()
 {
-  return fixer->getSuccessCount();
+  return edgeEdgeFixer.getSuccessCount() + faceVertFixer.getSuccessCount();
 }
 
 CrvLargeAngleTriFixer::CrvLargeAngleTriFixer(Adapt* a):
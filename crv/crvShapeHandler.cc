@@ -264,18 +264,13 @@ class BezierHandler : public ma::ShapeHandler
     }
     virtual double getQuality(apf::MeshEntity* e)
     {
-      if (mesh->getType(e) == apf::Mesh::TRIANGLE){
-	double lq = ma::measureTriQuality(mesh, sizeField, e);
-        if (lq < 0)
-          return lq;
-        else return lq*crv::getQuality(mesh,e);
-      }
-      if (mesh->getType(e) == apf::Mesh::TET){
-        double lq = ma::measureTetQuality(mesh, sizeField, e);
-        if (lq < 0)
-          return lq;
-        else return lq*qual->getQuality(e);
-      }
+      int type = mesh->getType(e);
+      if (type == apf::Mesh::TRIANGLE)
+        return measureCurvedQuality(mesh, sizeField, e,
+            crv::getQuality(mesh,e));
+      if (type == apf::Mesh::TET)
+        return measureCurvedQuality(mesh, sizeField, e,
+            qual->getQuality(e));
       return -1;
     }
     virtual bool hasNodesOn(int dimension)
@@ -0,0 +1,419 @@
+#include "dspSmoothers.h"
+#include <apf.h>
+#include <apfMesh.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace dsp {
+
+/* the rows of the mesh Laplacian on this part in compressed sparse row
+   form, one row per local vertex with its diagonal first. rows of
+   shared vertices only hold the contributions of local edges or
+   elements, so products are summed over the copies afterwards */
+struct Laplacian
+{
+  std::vector<int> offsets;
+  std::vector<int> columns;
+  std::vector<double> values;
+};
+
+/* the rows shared with each peer, in the order this part packs them
+   (send) and the order the peer packs them (recv) */
+struct Halo
+{
+  std::vector<int> peers;
+  std::vector<int> offsets;
+  std::vector<int> send;
+  std::vector<int> recv;
+};
+
+typedef std::vector<double> Vector;
+
+static int const maxIterations = 10000;
+
+class ConjugateGradientSmoother : public Smoother
+{
+public:
+  ConjugateGradientSmoother(bool s, bool w, double t):
+    stiffen(s), warmStart(w), tolerance(t), mesh(0), warmTag(0)
+  {
+  }
+  ~ConjugateGradientSmoother()
+  {
+    if (warmTag) {
+      apf::removeTagFromDimension(mesh, warmTag, 0);
+      mesh->destroyTag(warmTag);
+    }
+  }
+  void preprocess(apf::Mesh* m, Boundary& fixed, Boundary& moving)
+  {
+    if (mesh != m && warmTag) {
+      apf::removeTagFromDimension(mesh, warmTag, 0);
+      mesh->destroyTag(warmTag);
+      warmTag = 0;
+    }
+    mesh = m;
+    verts.clear();
+    owned.clear();
+    dirichlet.clear();
+    apf::MeshTag* rowTag = m->createIntTag("dsp_row", 1);
+    apf::MeshIterator* it = m->begin(0);
+    apf::MeshEntity* v;
+    while ((v = m->iterate(it))) {
+      int row = verts.size();
+      m->setIntTag(v, rowTag, &row);
+      verts.push_back(v);
+      owned.push_back(m->isOwned(v));
+      apf::ModelEntity* me = m->toModel(v);
+      dirichlet.push_back(fixed.count(me) || moving.count(me));
+    }
+    m->end(it);
+    buildStructure(rowTag);
+    buildHalo(rowTag);
+    apf::removeTagFromDimension(m, rowTag, 0);
+    m->destroyTag(rowTag);
+    if (!stiffen)
+      assembleGraph();
+  }
+  void smooth(apf::Field* df, Boundary& fixed, Boundary& moving)
+  {
+    (void)fixed;
+    (void)moving;
+    PCU_ALWAYS_ASSERT(apf::getMesh(df) == mesh);
+    double t0 = PCU_Time();
+    if (stiffen)
+      assembleStiffened();
+    int n = verts.size();
+    Vector x(3 * n, 0.0);
+    for (int i = 0; i < n; ++i) {
+      apf::Vector3 d(0,0,0);
+      if (dirichlet[i])
+        apf::getVector(df, verts[i], 0, d);
+      d.toArray(&x[3 * i]);
+    }
+    /* the residual of the zero guess is the right hand side */
+    Vector r(3 * n);
+    multiply(x, r);
+    scale(-1, r);
+    double bb = dot(r, r);
+    if (warmStart && warmTag && bb > 0) {
+      for (int i = 0; i < n; ++i)
+        if (!dirichlet[i] && mesh->hasTag(verts[i], warmTag))
+          mesh->getDoubleTag(verts[i], warmTag, &x[3 * i]);
+      multiply(x, r);
+      scale(-1, r);
+    }
+    int iterations = solve(x, r, bb);
+    for (int i = 0; i < n; ++i)
+      if (!dirichlet[i])
+        apf::setVector(df, verts[i], 0, apf::Vector3(&x[3 * i]));
+    if (warmStart) {
+      if (!warmTag)
+        warmTag = mesh->createDoubleTag("dsp_warm_start", 3);
+      for (int i = 0; i < n; ++i)
+        if (!dirichlet[i])
+          mesh->setDoubleTag(verts[i], warmTag, &x[3 * i]);
+    }
+    double t1 = PCU_Time();
+    if (!PCU_Comm_Self())
+      lion_oprint(1, "dsp: conjugate gradient took %d iterations "
+          "in %f seconds\n", iterations, t1 - t0);
+  }
+  void cleanup()
+  {
+  }
+private:
+  void buildStructure(apf::MeshTag* rowTag)
+  {
+    A.offsets.assign(1, 0);
+    A.columns.clear();
+    for (size_t i = 0; i < verts.size(); ++i) {
+      A.columns.push_back(i);
+      apf::Adjacent edges;
+      mesh->getAdjacent(verts[i], 1, edges);
+      for (size_t j = 0; j < edges.getSize(); ++j) {
+        apf::MeshEntity* o =
+          apf::getEdgeVertOppositeVert(mesh, edges[j], verts[i]);
+        int col;
+        mesh->getIntTag(o, rowTag, &col);
+        A.columns.push_back(col);
+      }
+      A.offsets.push_back(A.columns.size());
+    }
+    A.values.assign(A.columns.size(), 0.0);
+  }
+  /* each part lists the remote copies of its shared vertices per peer,
+     and sending them tells the peer the order values will come in */
+  void buildHalo(apf::MeshTag* rowTag)
+  {
+    std::map<int, std::vector<int> > rows;
+    PCU_Comm_Begin();
+    for (size_t i = 0; i < verts.size(); ++i) {
+      if (!mesh->isShared(verts[i]))
+        continue;
+      apf::Copies remotes;
+      mesh->getRemotes(verts[i], remotes);
+      APF_ITERATE(apf::Copies, remotes, rit) {
+        rows[rit->first].push_back(i);
+        PCU_COMM_PACK(rit->first, rit->second);
+      }
+    }
+    PCU_Comm_Send();
+    std::map<int, std::vector<int> > received;
+    while (PCU_Comm_Receive()) {
+      apf::MeshEntity* v;
+      PCU_COMM_UNPACK(v);
+      int row;
+      mesh->getIntTag(v, rowTag, &row);
+      received[PCU_Comm_Sender()].push_back(row);
+    }
+    halo.peers.clear();
+    halo.offsets.assign(1, 0);
+    halo.send.clear();
+    halo.recv.clear();
+    typedef std::map<int, std::vector<int> > Rows;
+    APF_ITERATE(Rows, rows, it) {
+      std::vector<int>& in = received[it->first];
+      PCU_ALWAYS_ASSERT(in.size() == it->second.size());
+      halo.peers.push_back(it->first);
+      halo.send.insert(halo.send.end(), it->second.begin(), it->second.end());
+      halo.recv.insert(halo.recv.end(), in.begin(), in.end());
+      halo.offsets.push_back(halo.send.size());
+    }
+  }
+  /* sum the partial rows of shared vertices over their copies */
+  void accumulate(Vector& y)
+  {
+    PCU_Comm_Begin();
+    for (size_t p = 0; p < halo.peers.size(); ++p)
+      for (int j = halo.offsets[p]; j < halo.offsets[p + 1]; ++j)
+        PCU_Comm_Pack(halo.peers[p], &y[3 * halo.send[j]],
+            3 * sizeof(double));
+    PCU_Comm_Send();
+    while (PCU_Comm_Receive()) {
+      int from = PCU_Comm_Sender();
+      size_t p = std::lower_bound(halo.peers.begin(), halo.peers.end(), from)
+        - halo.peers.begin();
+      PCU_ALWAYS_ASSERT(p < halo.peers.size() && halo.peers[p] == from);
+      for (int j = halo.offsets[p]; j < halo.offsets[p + 1]; ++j) {
+        double values[3];
+        PCU_Comm_Unpack(values, sizeof(values));
+        for (int k = 0; k < 3; ++k)
+          y[3 * halo.recv[j] + k] += values[k];
+      }
+    }
+  }
+  /* y = A x on the rows of unknowns, zero on the boundary rows */
+  void multiply(Vector const& x, Vector& y)
+  {
+    int n = verts.size();
+    for (int i = 0; i < n; ++i) {
+      double s[3] = {0,0,0};
+      for (int j = A.offsets[i]; j < A.offsets[i + 1]; ++j) {
+        double a = A.values[j];
+        double const* xj = &x[3 * A.columns[j]];
+        for (int k = 0; k < 3; ++k)
+          s[k] += a * xj[k];
+      }
+      for (int k = 0; k < 3; ++k)
+        y[3 * i + k] = s[k];
+    }
+    accumulate(y);
+    for (int i = 0; i < n; ++i)
+      if (dirichlet[i])
+        for (int k = 0; k < 3; ++k)
+          y[3 * i + k] = 0;
+  }
+  void scale(double a, Vector& x)
+  {
+    for (size_t i = 0; i < x.size(); ++i)
+      x[i] *= a;
+  }
+  /* the global dot products of the three components,
+     each unknown counted once by its owner */
+  void dots(Vector const& a, Vector const& b, double* out)
+  {
+    out[0] = out[1] = out[2] = 0;
+    for (size_t i = 0; i < verts.size(); ++i)
+      if (owned[i])
+        for (int k = 0; k < 3; ++k)
+          out[k] += a[3 * i + k] * b[3 * i + k];
+  }
+  double dot(Vector const& a, Vector const& b)
+  {
+    double d[3];
+    dots(a, b, d);
+    PCU_Add_Doubles(d, 3);
+    return d[0] + d[1] + d[2];
+  }
+  void getDiagonal(Vector& d)
+  {
+    int n = verts.size();
+    d.assign(3 * n, 0.0);
+    for (int i = 0; i < n; ++i)
+      for (int k = 0; k < 3; ++k)
+        d[3 * i + k] = A.values[A.offsets[i]];
+    accumulate(d);
+  }
+  /* Jacobi preconditioned conjugate gradient on the three components
+     at once, with one step length per component */
+  int solve(Vector& x, Vector& r, double bb)
+  {
+    int n = verts.size();
+    Vector d;
+    getDiagonal(d);
+    Vector z(3 * n);
+    for (int i = 0; i < 3 * n; ++i)
+      z[i] = r[i] / d[i];
+    Vector p(z);
+    Vector q(3 * n);
+    double sums[6];
+    dots(r, z, sums);
+    dots(r, r, sums + 3);
+    PCU_Add_Doubles(sums, 6);
+    double rz[3] = {sums[0], sums[1], sums[2]};
+    double rr = sums[3] + sums[4] + sums[5];
+    double limit = tolerance * tolerance * bb;
+    int iteration = 0;
+    while (rr > limit && iteration < maxIterations) {
+      multiply(p, q);
+      double pq[3];
+      dots(p, q, pq);
+      PCU_Add_Doubles(pq, 3);
+      double alpha[3];
+      for (int k = 0; k < 3; ++k)
+        alpha[k] = pq[k] > 0 ? rz[k] / pq[k] : 0;
+      for (int i = 0; i < n; ++i)
+        for (int k = 0; k < 3; ++k) {
+          x[3 * i + k] += alpha[k] * p[3 * i + k];
+          r[3 * i + k] -= alpha[k] * q[3 * i + k];
+        }
+      for (int i = 0; i < 3 * n; ++i)
+        z[i] = r[i] / d[i];
+      dots(r, z, sums);
+      dots(r, r, sums + 3);
+      PCU_Add_Doubles(sums, 6);
+      for (int k = 0; k < 3; ++k) {
+        double beta = rz[k] > 0 ? sums[k] / rz[k] : 0;
+        rz[k] = sums[k];
+        for (int i = 0; i < n; ++i)
+          p[3 * i + k] = z[3 * i + k] + beta * p[3 * i + k];
+      }
+      rr = sums[3] + sums[4] + sums[5];
+      ++iteration;
+    }
+    return iteration;
+  }
+  /* graph Laplacian: unit edge weights, split between the copies of
+     shared edges so the accumulated rows are exact */
+  void assembleGraph()
+  {
+    for (size_t i = 0; i < verts.size(); ++i) {
+      apf::Adjacent edges;
+      mesh->getAdjacent(verts[i], 1, edges);
+      int first = A.offsets[i];
+      A.values[first] = 0;
+      for (size_t j = 0; j < edges.getSize(); ++j) {
+        double w = 1;
+        if (mesh->isShared(edges[j])) {
+          apf::Copies remotes;
+          mesh->getRemotes(edges[j], remotes);
+          w /= remotes.size() + 1;
+        }
+        A.values[first] += w;
+        A.values[first + 1 + j] = -w;
+      }
+    }
+  }
+  int findColumn(int row, int col)
+  {
+    for (int j = A.offsets[row]; j < A.offsets[row + 1]; ++j)
+      if (A.columns[j] == col)
+        return j;
+    return -1;
+  }
+  /* the linear finite element Laplacian with the stiffness of each
+     element divided by its volume, so small elements near the moving
+     boundary deform less than large ones away from it */
+  void assembleStiffened()
+  {
+    std::fill(A.values.begin(), A.values.end(), 0.0);
+    int dim = mesh->getDimension();
+    apf::MeshTag* rowTag = mesh->createIntTag("dsp_row", 1);
+    for (size_t i = 0; i < verts.size(); ++i) {
+      int row = i;
+      mesh->setIntTag(verts[i], rowTag, &row);
+    }
+    apf::MeshIterator* it = mesh->begin(dim);
+    apf::MeshEntity* e;
+    while ((e = mesh->iterate(it))) {
+      PCU_ALWAYS_ASSERT_VERBOSE(apf::isSimplex(mesh->getType(e)),
+          "stiffened dsp smoothing needs simplex elements");
+      apf::Downward vs;
+      int nv = mesh->getDownward(e, 0, vs);
+      apf::Vector3 g[4];
+      getGradients(vs, dim, g);
+      int rows[4];
+      for (int a = 0; a < nv; ++a)
+        mesh->getIntTag(vs[a], rowTag, &rows[a]);
+      for (int a = 0; a < nv; ++a)
+        for (int b = 0; b < nv; ++b) {
+          int j = findColumn(rows[a], rows[b]);
+          PCU_ALWAYS_ASSERT(j >= 0);
+          A.values[j] += g[a] * g[b];
+        }
+    }
+    mesh->end(it);
+    apf::removeTagFromDimension(mesh, rowTag, 0);
+    mesh->destroyTag(rowTag);
+  }
+  /* the gradients of the linear shape functions of a simplex. the
+     volume scaling of the stiffness cancels the element volume,
+     leaving only their dot products */
+  void getGradients(apf::MeshEntity** vs, int dim, apf::Vector3* g)
+  {
+    apf::Vector3 x[4];
+    for (int a = 0; a <= dim; ++a)
+      mesh->getPoint(vs[a], 0, x[a]);
+    if (dim == 3) {
+      apf::Matrix3x3 J;
+      for (int a = 0; a < 3; ++a)
+        J[a] = x[a + 1] - x[0];
+      apf::Matrix3x3 Ji = apf::invert(J);
+      for (int a = 0; a < 3; ++a)
+        g[a + 1] = apf::Vector3(Ji[0][a], Ji[1][a], Ji[2][a]);
+    } else {
+      apf::Vector3 e1 = x[1] - x[0];
+      apf::Vector3 e2 = x[2] - x[0];
+      double det = e1[0] * e2[1] - e1[1] * e2[0];
+      g[1] = apf::Vector3(e2[1], -e2[0], 0) / det;
+      g[2] = apf::Vector3(-e1[1], e1[0], 0) / det;
+    }
+    g[0] = apf::Vector3(0,0,0);
+    for (int a = 1; a <= dim; ++a)
+      g[0] = g[0] - g[a];
+  }
+  bool stiffen;
+  bool warmStart;
+  double tolerance;
+  apf::Mesh* mesh;
+  apf::MeshTag* warmTag;
+  std::vector<apf::MeshEntity*> verts;
+  std::vector<bool> owned;
+  std::vector<bool> dirichlet;
+  Laplacian A;
+  Halo halo;
+};
+
+Smoother* Smoother::makeConjugateGradient(bool stiffen, bool warmStart,
+    double tolerance)
+{
+  return new ConjugateGradientSmoother(stiffen, warmStart, tolerance);
+}
+
+}
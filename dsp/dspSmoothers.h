@@ -16,6 +16,14 @@ class Smoother {
     virtual void cleanup();
     static Smoother* makeLaplacian();
     static Smoother* makeEmpty();
+    /* solves the graph Laplacian (or the finite element one with the
+       stiffness of each element divided by its volume) once assembled
+       into sparse rows, with Jacobi preconditioned conjugate gradient
+       until the residual drops by tolerance. with warmStart the
+       previous solution, kept in a vertex tag until the smoother is
+       deleted, starts the next solve */
+    static Smoother* makeConjugateGradient(bool stiffen = false,
+        bool warmStart = true, double tolerance = 1e-6);
 };
 
 }
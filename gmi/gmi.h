@@ -76,6 +76,10 @@ struct gmi_model_ops {
    \details if omitted then gmi_can_eval returns false */
   void (*eval)(struct gmi_model* m, struct gmi_ent* e,
       double const p[2], double x[3]);
+  /** \brief implement gmi_eval_batch
+   \details if omitted then gmi_eval_batch calls gmi_eval per point */
+  void (*eval_batch)(struct gmi_model* m, struct gmi_ent* e, int n,
+      double const* p, double* x);
   /** \brief implement gmi_reparam */
   void (*reparam)(struct gmi_model* m, struct gmi_ent* from,
       double const from_p[2], struct gmi_ent* to, double to_p[2]);
@@ -87,6 +91,11 @@ struct gmi_model_ops {
   /** \brief implement gmi_closest_point */
   void (*closest_point)(struct gmi_model* m, struct gmi_ent* e,
       double const from[3], double to[3], double to_p[2]);
+  /** \brief implement gmi_closest_point_batch
+   \details if omitted then gmi_closest_point_batch calls
+            gmi_closest_point per point */
+  void (*closest_point_batch)(struct gmi_model* m, struct gmi_ent* e, int n,
+      double const* from, double* to, double* to_p);
   /** \brief implement gmi_normal */
   void (*normal)(struct gmi_model* m, struct gmi_ent* e,
     double const p[2], double n[3]);
@@ -159,6 +168,13 @@ int gmi_has_normal(struct gmi_model* m);
   \param x the resulting point in space */
 void gmi_eval(struct gmi_model* m, struct gmi_ent* e,
     double const p[2], double x[3]);
+/** \brief evaluate (n) points on the same model entity
+  \details same as calling gmi_eval for each point, but
+           models may implement it without per-point overhead
+  \param p 2 parametric coordinates per point
+  \param x 3 spatial coordinates per point */
+void gmi_eval_batch(struct gmi_model* m, struct gmi_ent* e, int n,
+    double const* p, double* x);
 /** \brief re-parameterize from one model entity to another
   \param from the model entity to start from
   \param from_p the parametric coordinates on entity (from),
@@ -176,6 +192,10 @@ void gmi_range(struct gmi_model* m, struct gmi_ent* e, int dim,
 /** \brief return closest point and its parameter*/
 void gmi_closest_point(struct gmi_model* m, struct gmi_ent* e,
     double const from[3], double to[3], double to_p[2]);
+/** \brief gmi_closest_point for (n) points on the same model entity
+  \details from, to and to_p hold 3, 3 and 2 values per point */
+void gmi_closest_point_batch(struct gmi_model* m, struct gmi_ent* e, int n,
+    double const* from, double* to, double* to_p);
 /** \brief return normal vector at a parameter*/
 void gmi_normal(struct gmi_model* m, struct gmi_ent* e,
     double const p[2], double n[3]);
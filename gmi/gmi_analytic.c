@@ -10,11 +10,17 @@
 #include "gmi_analytic.h"
 #include "gmi_null.h"
 #include "gmi_base.h"
+#include "gmi_bvh.h"
+#include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pcu_util.h>
 
+/* parametric samples per direction of each entity in the
+   tessellation used for closest point and inside/outside queries */
+#define BVH_RESOLUTION 32
+
 typedef uint8_t periodic_t[2];
 typedef double ranges_t[2][2];
 
@@ -27,6 +33,7 @@ struct gmi_analytic
   struct agm_tag* data;
   struct agm_tag* reparam;
   struct agm_tag* reparam_data;
+  struct gmi_bvh* bvh;
 };
 
 static gmi_analytic_fun* f_of(struct gmi_analytic* m, struct agm_ent e)
@@ -88,6 +95,10 @@ struct gmi_ent* gmi_add_analytic(struct gmi_model* m, int dim, int tag,
     (*rp)[i][1] = 0;
   }
   *(data_of(m2, e)) = user_data;
+  if (m2->bvh) {
+    gmi_bvh_free(m2->bvh);
+    m2->bvh = 0;
+  }
   return gmi_from_agm(e);
 }
 
@@ -105,6 +116,23 @@ static void eval(struct gmi_model* m, struct gmi_ent* e,
   (*f)(p, x, u);
 }
 
+/* one lookup of the function for all the points */
+static void eval_batch(struct gmi_model* m, struct gmi_ent* e, int n,
+    double const* p, double* x)
+{
+  struct gmi_analytic* m2;
+  struct agm_ent a;
+  void* u;
+  gmi_analytic_fun f;
+  int i;
+  m2 = to_model(m);
+  a = agm_from_gmi(e);
+  u = *(data_of(m2, a));
+  f = *(f_of(m2, a));
+  for (i = 0; i < n; ++i)
+    (*f)(p + 2 * i, x + 3 * i, u);
+}
+
 static void reparam_across(struct gmi_analytic* m, struct agm_use u,
     double const from_p[2], double to_p[2])
 {
@@ -172,8 +200,8 @@ static void first_derivative(struct gmi_model* m, struct gmi_ent* e,
     range(m, e, 1, r1);
     PCU_ALWAYS_ASSERT(r0[1] > r0[0]);
     PCU_ALWAYS_ASSERT(r1[1] > r1[0]);
-    double delta0 = abs(r0[1] - r0[0]) / denum;
-    double delta1 = abs(r1[1] - r1[0]) / denum;
+    double delta0 = fabs(r0[1] - r0[0]) / denum;
+    double delta1 = fabs(r1[1] - r1[0]) / denum;
 
     double x1[3];
     double x2[3];
@@ -248,7 +276,7 @@ static void first_derivative(struct gmi_model* m, struct gmi_ent* e,
     double r0[2];
     range(m, e, 0, r0);
     PCU_ALWAYS_ASSERT(r0[1] > r0[0]);
-    double delta0 = abs(r0[1] - r0[0]) / denum;
+    double delta0 = fabs(r0[1] - r0[0]) / denum;
 
     double x1[3];
     double x2[3];
@@ -289,11 +317,51 @@ static void first_derivative(struct gmi_model* m, struct gmi_ent* e,
   }
 }
 
+struct gmi_bvh* gmi_analytic_bvh(struct gmi_model* m)
+{
+  struct gmi_analytic* m2 = to_model(m);
+  struct gmi_set* ents;
+  struct gmi_iter* it;
+  struct gmi_ent* e;
+  int d, n;
+  if (m2->bvh)
+    return m2->bvh;
+  n = 0;
+  for (d = 1; d <= 2; ++d)
+    n += m->n[d];
+  ents = gmi_make_set(n);
+  ents->n = 0;
+  for (d = 1; d <= 2; ++d) {
+    it = gmi_begin(m, d);
+    while ((e = gmi_next(m, it)))
+      if (*(f_of(m2, agm_from_gmi(e))))
+        ents->e[ents->n++] = e;
+    gmi_end(m, it);
+  }
+  m2->bvh = gmi_bvh_build(m, ents, BVH_RESOLUTION);
+  gmi_free_set(ents);
+  return m2->bvh;
+}
+
+static void closest_point(struct gmi_model* m, struct gmi_ent* e,
+    double const from[3], double to[3], double to_p[2])
+{
+  gmi_bvh_closest_point(gmi_analytic_bvh(m), e, from, to, to_p);
+}
+
+static void closest_point_batch(struct gmi_model* m, struct gmi_ent* e,
+    int n, double const* from, double* to, double* to_p)
+{
+  gmi_bvh_closest_points(gmi_analytic_bvh(m), e, n, from, to, to_p);
+}
+
 static void bbox(struct gmi_model* m, struct gmi_ent* e,
     double bmin[3], double bmax[3])
 {
-  (void) m;
-  (void) e;
+  struct gmi_analytic* m2 = to_model(m);
+  if (*(f_of(m2, agm_from_gmi(e))) &&
+      gmi_bvh_bbox(gmi_analytic_bvh(m), e, bmin, bmax))
+    return;
   bmin[0] = 0.0;
   bmin[1] = 0.0;
   bmin[2] = 0.0;
@@ -302,13 +370,21 @@ static void bbox(struct gmi_model* m, struct gmi_ent* e,
   bmax[2] = 1.0;
 }
 
+/* regions bounded by no parametric faces count as containing
+   every point, as before the tessellation existed */
 static int is_point_in_region(struct gmi_model* m, struct gmi_ent* e,
     double point[3])
 {
-  (void) m;
-  (void) e;
-  (void) point;
-  return 1;
+  int inside = gmi_bvh_is_point_in_region(gmi_analytic_bvh(m), e, point);
+  return inside < 0 ? 1 : inside;
+}
+
+static void destroy(struct gmi_model* m)
+{
+  struct gmi_analytic* m2 = to_model(m);
+  if (m2->bvh)
+    gmi_bvh_free(m2->bvh);
+  gmi_base_destroy(m);
 }
 
 static struct gmi_model_ops ops = {
@@ -320,13 +396,37 @@ static struct gmi_model_ops ops = {
   .find     = gmi_base_find,
   .adjacent = gmi_base_adjacent,
   .eval     = eval,
+  .eval_batch = eval_batch,
   .reparam  = reparam,
   .periodic = periodic,
   .range    = range,
   .first_derivative = first_derivative,
+  .is_point_in_region = is_point_in_region,
   .bbox = bbox,
+  .destroy  = destroy
+};
+
+/* the same with closest point queries on the tessellation, which
+   gmi_analytic_enable_closest_point switches a model to */
+static struct gmi_model_ops closest_ops = {
+  .begin    = gmi_base_begin,
+  .next     = gmi_base_next,
+  .end      = gmi_base_end,
+  .dim      = gmi_base_dim,
+  .tag      = gmi_base_tag,
+  .find     = gmi_base_find,
+  .adjacent = gmi_base_adjacent,
+  .eval     = eval,
+  .eval_batch = eval_batch,
+  .reparam  = reparam,
+  .periodic = periodic,
+  .range    = range,
+  .closest_point = closest_point,
+  .closest_point_batch = closest_point_batch,
+  .first_derivative = first_derivative,
   .is_point_in_region = is_point_in_region,
-  .destroy  = gmi_base_destroy
+  .bbox = bbox,
+  .destroy  = destroy
 };
 
 struct gmi_model* gmi_make_analytic(void)
@@ -373,3 +473,8 @@ void gmi_add_analytic_region(struct gmi_model* m, int tag)
 {
   gmi_add_analytic_cell(m, 3, tag);
 }
+
+void gmi_analytic_enable_closest_point(struct gmi_model* m)
+{
+  m->ops = &closest_ops;
+}
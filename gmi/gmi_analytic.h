@@ -14,6 +14,7 @@
   \brief GMI analytic model interface */
 
 #include "gmi_base.h"
+#include "gmi_bvh.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +56,19 @@ void* gmi_analytic_data(struct gmi_model* m, struct gmi_ent* e);
 
 #define gmi_analytic_topo gmi_base_topo
 
+/** \brief get the tessellation tree of the analytic model
+  \details the tree covers the edges and faces with analytic functions.
+  It is built on the first closest point, bounding box or
+  inside/outside query and rebuilt after entities are added.
+  Use it directly for batch queries such as gmi_bvh_closest_points. */
+struct gmi_bvh* gmi_analytic_bvh(struct gmi_model* m);
+/** \brief answer gmi_closest_point from the tessellation tree
+  \details analytic models have no closest point queries by default,
+  so gmi_can_get_closest_point is false for them. After this call it
+  is true, and the queries are answered for edges and faces that have
+  analytic functions. Querying any other entity is an error. */
+void gmi_analytic_enable_closest_point(struct gmi_model* m);
+
 /** \brief add a re-parameterization to the model
   \details given a use (u) which is a piece of a boundary,
   define the map between the parametric space of the used
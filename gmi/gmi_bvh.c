@@ -0,0 +1,707 @@
+/******************************************************************************
+
+  Copyright 2026 Scientific Computation Research Center,
+      Rensselaer Polytechnic Institute. All rights reserved.
+
+  This work is open source software, licensed under the terms of the
+  BSD license as described in the LICENSE file in the top-level directory.
+
+*******************************************************************************/
+#include "gmi_bvh.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pcu_util.h>
+
+enum { LEAF_SIZE = 4, STACK_SIZE = 256, NEWTON_STEPS = 32, HALVINGS = 12 };
+
+/* a segment (n = 2) or triangle (n = 3) of the tessellation */
+struct prim {
+  struct gmi_ent* e;
+  int n;
+  double x[3][3];
+  double p[3][2];
+  double c[3];
+};
+
+/* leaves have left = -1 and point at items[first] ... items[first+count-1] */
+struct node {
+  double lo[3];
+  double hi[3];
+  int left;
+  int right;
+  int first;
+  int count;
+};
+
+struct entry {
+  struct gmi_ent* e;
+  int dim;
+  int root;
+};
+
+struct gmi_bvh {
+  struct gmi_model* model;
+  struct prim* prims;
+  int nprims;
+  int* items;
+  struct node* nodes;
+  int nnodes;
+  int capnodes;
+  /* sorted by entity pointer */
+  struct entry* ents;
+  int nents;
+  /* trees over all the edges and all the faces, -1 if there are none */
+  int roots[3];
+};
+
+struct hit {
+  int prim;
+  double d2;
+  double x[3];
+  double p[2];
+};
+
+static double dot(double const a[3], double const b[3])
+{
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void sub(double const a[3], double const b[3], double c[3])
+{
+  c[0] = a[0] - b[0];
+  c[1] = a[1] - b[1];
+  c[2] = a[2] - b[2];
+}
+
+static double ratio(double a, double b)
+{
+  return b != 0 ? a / b : 0;
+}
+
+static int compare_entries(const void* a, const void* b)
+{
+  struct gmi_ent* ea = ((struct entry const*)a)->e;
+  struct gmi_ent* eb = ((struct entry const*)b)->e;
+  return (ea > eb) - (ea < eb);
+}
+
+static struct entry* find_entry(struct gmi_bvh* b, struct gmi_ent* e)
+{
+  struct entry key;
+  key.e = e;
+  return bsearch(&key, b->ents, b->nents, sizeof(struct entry),
+      compare_entries);
+}
+
+static void set_point(struct gmi_model* m, struct gmi_ent* e,
+    double u, double v, double x[3], double p[2])
+{
+  p[0] = u;
+  p[1] = v;
+  gmi_eval(m, e, p, x);
+}
+
+static void finish_prim(struct prim* pr, struct gmi_ent* e, int n)
+{
+  int i, j;
+  pr->e = e;
+  pr->n = n;
+  for (j = 0; j < 3; ++j) {
+    pr->c[j] = 0;
+    for (i = 0; i < n; ++i)
+      pr->c[j] += pr->x[i][j] / n;
+  }
+}
+
+static int tessellate(struct gmi_model* m, struct gmi_ent* e, int res,
+    struct prim* prims)
+{
+  double r0[2];
+  double r1[2] = {0, 0};
+  double du, dv;
+  int i, j, n = 0;
+  int dim = gmi_dim(m, e);
+  PCU_ALWAYS_ASSERT(dim == 1 || dim == 2);
+  gmi_range(m, e, 0, r0);
+  du = (r0[1] - r0[0]) / res;
+  if (dim == 1) {
+    for (i = 0; i < res; ++i) {
+      struct prim* pr = prims + n++;
+      set_point(m, e, r0[0] + i * du, 0, pr->x[0], pr->p[0]);
+      set_point(m, e, r0[0] + (i + 1) * du, 0, pr->x[1], pr->p[1]);
+      finish_prim(pr, e, 2);
+    }
+    return n;
+  }
+  gmi_range(m, e, 1, r1);
+  dv = (r1[1] - r1[0]) / res;
+  for (j = 0; j < res; ++j)
+  for (i = 0; i < res; ++i) {
+    double u0 = r0[0] + i * du;
+    double u1 = r0[0] + (i + 1) * du;
+    double v0 = r1[0] + j * dv;
+    double v1 = r1[0] + (j + 1) * dv;
+    struct prim* pr = prims + n++;
+    set_point(m, e, u0, v0, pr->x[0], pr->p[0]);
+    set_point(m, e, u1, v0, pr->x[1], pr->p[1]);
+    set_point(m, e, u1, v1, pr->x[2], pr->p[2]);
+    finish_prim(pr, e, 3);
+    pr = prims + n++;
+    set_point(m, e, u0, v0, pr->x[0], pr->p[0]);
+    set_point(m, e, u1, v1, pr->x[1], pr->p[1]);
+    set_point(m, e, u0, v1, pr->x[2], pr->p[2]);
+    finish_prim(pr, e, 3);
+  }
+  return n;
+}
+
+static double center(struct gmi_bvh* b, int item, int axis)
+{
+  return b->prims[item].c[axis];
+}
+
+/* move the k-th smallest center along axis to items[k] */
+static void select_items(struct gmi_bvh* b, int* items, int n, int k,
+    int axis)
+{
+  int lo = 0;
+  int hi = n - 1;
+  while (lo < hi) {
+    double pivot = center(b, items[(lo + hi) / 2], axis);
+    int i = lo;
+    int j = hi;
+    while (i <= j) {
+      while (center(b, items[i], axis) < pivot)
+        ++i;
+      while (center(b, items[j], axis) > pivot)
+        --j;
+      if (i <= j) {
+        int tmp = items[i];
+        items[i] = items[j];
+        items[j] = tmp;
+        ++i;
+        --j;
+      }
+    }
+    if (k <= j)
+      hi = j;
+    else if (k >= i)
+      lo = i;
+    else
+      break;
+  }
+}
+
+static int new_node(struct gmi_bvh* b)
+{
+  if (b->nnodes == b->capnodes) {
+    b->capnodes = b->capnodes ? 2 * b->capnodes : 64;
+    b->nodes = realloc(b->nodes, b->capnodes * sizeof(struct node));
+  }
+  return b->nnodes++;
+}
+
+static int build_node(struct gmi_bvh* b, int first, int count)
+{
+  int i, j, k, axis, mid, left, right;
+  double clo[3], chi[3];
+  struct node* nd;
+  int id = new_node(b);
+  nd = b->nodes + id;
+  for (j = 0; j < 3; ++j) {
+    nd->lo[j] = clo[j] = DBL_MAX;
+    nd->hi[j] = chi[j] = -DBL_MAX;
+  }
+  for (i = first; i < first + count; ++i) {
+    struct prim* pr = b->prims + b->items[i];
+    for (j = 0; j < 3; ++j) {
+      for (k = 0; k < pr->n; ++k) {
+        if (pr->x[k][j] < nd->lo[j]) nd->lo[j] = pr->x[k][j];
+        if (pr->x[k][j] > nd->hi[j]) nd->hi[j] = pr->x[k][j];
+      }
+      if (pr->c[j] < clo[j]) clo[j] = pr->c[j];
+      if (pr->c[j] > chi[j]) chi[j] = pr->c[j];
+    }
+  }
+  nd->left = nd->right = -1;
+  nd->first = first;
+  nd->count = count;
+  if (count <= LEAF_SIZE)
+    return id;
+  axis = 0;
+  for (j = 1; j < 3; ++j)
+    if (chi[j] - clo[j] > chi[axis] - clo[axis])
+      axis = j;
+  mid = count / 2;
+  select_items(b, b->items + first, count, mid, axis);
+  /* recursion may move the node array */
+  left = build_node(b, first, mid);
+  right = build_node(b, first + mid, count - mid);
+  b->nodes[id].left = left;
+  b->nodes[id].right = right;
+  return id;
+}
+
+static int build_tree(struct gmi_bvh* b, int first, int count)
+{
+  if (!count)
+    return -1;
+  return build_node(b, first, count);
+}
+
+struct gmi_bvh* gmi_bvh_build(struct gmi_model* m, struct gmi_set* ents,
+    int resolution)
+{
+  struct gmi_bvh* b;
+  int i, d, n, per, nitems;
+  int* starts;
+  int dimStart[4];
+  PCU_ALWAYS_ASSERT(resolution > 0);
+  b = calloc(1, sizeof(*b));
+  b->model = m;
+  b->nents = ents->n;
+  b->ents = malloc(ents->n * sizeof(struct entry));
+  starts = malloc((ents->n + 1) * sizeof(int));
+  per = 2 * resolution * resolution;
+  b->prims = malloc(ents->n * per * sizeof(struct prim));
+  /* edges first, then faces, so each dimension is one range */
+  n = 0;
+  for (d = 1; d <= 2; ++d) {
+    dimStart[d] = n;
+    for (i = 0; i < ents->n; ++i) {
+      if (gmi_dim(m, ents->e[i]) != d)
+        continue;
+      b->ents[n].e = ents->e[i];
+      b->ents[n].dim = d;
+      ++n;
+    }
+  }
+  dimStart[3] = n;
+  PCU_ALWAYS_ASSERT(n == ents->n);
+  starts[0] = 0;
+  for (i = 0; i < n; ++i)
+    starts[i + 1] = starts[i] +
+      tessellate(m, b->ents[i].e, resolution, b->prims + starts[i]);
+  b->nprims = starts[n];
+  /* the per-entity trees and the per-dimension trees
+     each order their own copy of the primitive indices */
+  nitems = 2 * b->nprims;
+  b->items = malloc((nitems ? nitems : 1) * sizeof(int));
+  for (i = 0; i < b->nprims; ++i)
+    b->items[i] = b->items[b->nprims + i] = i;
+  for (i = 0; i < n; ++i)
+    b->ents[i].root = build_tree(b, starts[i], starts[i + 1] - starts[i]);
+  b->roots[0] = -1;
+  for (d = 1; d <= 2; ++d)
+    b->roots[d] = build_tree(b, b->nprims + starts[dimStart[d]],
+        starts[dimStart[d + 1]] - starts[dimStart[d]]);
+  free(starts);
+  qsort(b->ents, n, sizeof(struct entry), compare_entries);
+  return b;
+}
+
+void gmi_bvh_free(struct gmi_bvh* b)
+{
+  free(b->prims);
+  free(b->items);
+  free(b->nodes);
+  free(b->ents);
+  free(b);
+}
+
+static double box_distance2(struct node* nd, double const x[3])
+{
+  double d2 = 0;
+  int j;
+  for (j = 0; j < 3; ++j) {
+    double d = 0;
+    if (x[j] < nd->lo[j])
+      d = nd->lo[j] - x[j];
+    else if (x[j] > nd->hi[j])
+      d = x[j] - nd->hi[j];
+    d2 += d * d;
+  }
+  return d2;
+}
+
+static void closest_on_segment(struct prim* pr, double const q[3],
+    double w[3])
+{
+  double ab[3], aq[3];
+  double t;
+  sub(pr->x[1], pr->x[0], ab);
+  sub(q, pr->x[0], aq);
+  t = ratio(dot(aq, ab), dot(ab, ab));
+  if (t < 0) t = 0;
+  if (t > 1) t = 1;
+  w[0] = 1 - t;
+  w[1] = t;
+  w[2] = 0;
+}
+
+/* barycentric weights of the closest point, after Ericson's
+   Real-Time Collision Detection, section 5.1.5 */
+static void closest_on_triangle(struct prim* pr, double const q[3],
+    double w[3])
+{
+  double ab[3], ac[3], ap[3], bp[3], cp[3];
+  double d1, d2, d3, d4, d5, d6, va, vb, vc, v, t, denom;
+  sub(pr->x[1], pr->x[0], ab);
+  sub(pr->x[2], pr->x[0], ac);
+  sub(q, pr->x[0], ap);
+  d1 = dot(ab, ap);
+  d2 = dot(ac, ap);
+  w[0] = 1; w[1] = 0; w[2] = 0;
+  if (d1 <= 0 && d2 <= 0)
+    return;
+  sub(q, pr->x[1], bp);
+  d3 = dot(ab, bp);
+  d4 = dot(ac, bp);
+  w[0] = 0; w[1] = 1; w[2] = 0;
+  if (d3 >= 0 && d4 <= d3)
+    return;
+  vc = d1 * d4 - d3 * d2;
+  if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+    v = ratio(d1, d1 - d3);
+    w[0] = 1 - v; w[1] = v; w[2] = 0;
+    return;
+  }
+  sub(q, pr->x[2], cp);
+  d5 = dot(ab, cp);
+  d6 = dot(ac, cp);
+  w[0] = 0; w[1] = 0; w[2] = 1;
+  if (d6 >= 0 && d5 <= d6)
+    return;
+  vb = d5 * d2 - d1 * d6;
+  if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+    t = ratio(d2, d2 - d6);
+    w[0] = 1 - t; w[1] = 0; w[2] = t;
+    return;
+  }
+  va = d3 * d6 - d5 * d4;
+  if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+    t = ratio(d4 - d3, (d4 - d3) + (d5 - d6));
+    w[0] = 0; w[1] = 1 - t; w[2] = t;
+    return;
+  }
+  denom = va + vb + vc;
+  v = ratio(vb, denom);
+  t = ratio(vc, denom);
+  w[0] = 1 - v - t; w[1] = v; w[2] = t;
+}
+
+static void try_prim(struct gmi_bvh* b, int item, double const q[3],
+    struct hit* h)
+{
+  struct prim* pr = b->prims + item;
+  double w[3], x[3], p[2], d[3], d2;
+  int i, j;
+  if (pr->n == 2)
+    closest_on_segment(pr, q, w);
+  else
+    closest_on_triangle(pr, q, w);
+  for (j = 0; j < 3; ++j) {
+    x[j] = 0;
+    for (i = 0; i < pr->n; ++i)
+      x[j] += w[i] * pr->x[i][j];
+  }
+  for (j = 0; j < 2; ++j) {
+    p[j] = 0;
+    for (i = 0; i < pr->n; ++i)
+      p[j] += w[i] * pr->p[i][j];
+  }
+  sub(x, q, d);
+  d2 = dot(d, d);
+  if (d2 < h->d2) {
+    h->prim = item;
+    h->d2 = d2;
+    memcpy(h->x, x, sizeof(x));
+    memcpy(h->p, p, sizeof(p));
+  }
+}
+
+static void nearest(struct gmi_bvh* b, int root, double const q[3],
+    struct hit* h)
+{
+  int stack[STACK_SIZE];
+  int top = 0;
+  h->prim = -1;
+  h->d2 = DBL_MAX;
+  if (root < 0)
+    return;
+  stack[top++] = root;
+  while (top) {
+    struct node* nd = b->nodes + stack[--top];
+    int i, near, far;
+    double dn, df;
+    if (box_distance2(nd, q) >= h->d2)
+      continue;
+    if (nd->left < 0) {
+      for (i = nd->first; i < nd->first + nd->count; ++i)
+        try_prim(b, b->items[i], q, h);
+      continue;
+    }
+    near = nd->left;
+    far = nd->right;
+    dn = box_distance2(b->nodes + near, q);
+    df = box_distance2(b->nodes + far, q);
+    if (df < dn) {
+      int tmp = near; near = far; far = tmp;
+      dn = df; df = box_distance2(b->nodes + far, q);
+    }
+    PCU_ALWAYS_ASSERT(top + 2 <= STACK_SIZE);
+    if (df < h->d2)
+      stack[top++] = far;
+    if (dn < h->d2)
+      stack[top++] = near;
+  }
+}
+
+/* periodic directions wrap around, the others are clamped */
+static void clamp_param(double r[2][2], int const periodic[2], int dim,
+    double p[2])
+{
+  int j;
+  for (j = 0; j < dim; ++j) {
+    double period = r[j][1] - r[j][0];
+    if (periodic[j] && period > 0 && fabs(p[j]) < DBL_MAX) {
+      p[j] = fmod(p[j] - r[j][0], period);
+      if (p[j] < 0)
+        p[j] += period;
+      p[j] += r[j][0];
+    }
+    if (p[j] < r[j][0]) p[j] = r[j][0];
+    if (p[j] > r[j][1]) p[j] = r[j][1];
+  }
+}
+
+static double distance2(struct gmi_model* m, struct gmi_ent* e,
+    double const p[2], double const q[3], double x[3])
+{
+  double d[3];
+  gmi_eval(m, e, p, x);
+  sub(x, q, d);
+  return dot(d, d);
+}
+
+/* Gauss-Newton steps on |x(p) - q|^2 from the tessellated guess.
+   far from the surface the full step overshoots, so each step is
+   the best of the halvings of the Gauss-Newton step.
+   parameters stay inside their range, wrapping if periodic */
+static void refine(struct gmi_bvh* b, struct gmi_ent* e,
+    double const q[3], double to[3], double to_p[2])
+{
+  struct gmi_model* m = b->model;
+  int dim = gmi_dim(m, e);
+  double r[2][2] = {{0, 0}, {0, 0}};
+  int periodic[2] = {0, 0};
+  double x[3], t0[3], t1[3], d[3], dp[2], np[2], nx[3], bp[2], bx[3];
+  double d2, nd2, scale;
+  int i, j, k, best;
+  for (j = 0; j < dim; ++j) {
+    gmi_range(m, e, j, r[j]);
+    periodic[j] = gmi_periodic(m, e, j);
+  }
+  /* interpolated parameters may round past the range */
+  clamp_param(r, periodic, dim, to_p);
+  d2 = distance2(m, e, to_p, q, x);
+  if (!m->ops->first_derivative) {
+    memcpy(to, x, sizeof(x));
+    return;
+  }
+  for (i = 0; i < NEWTON_STEPS; ++i) {
+    double a00, a01, a11, g0, g1, det;
+    sub(x, q, d);
+    gmi_first_derivative(m, e, to_p, t0, t1);
+    a00 = dot(t0, t0);
+    g0 = dot(t0, d);
+    dp[1] = 0;
+    if (dim == 1) {
+      if (!(a00 > 0))
+        break;
+      dp[0] = -g0 / a00;
+    } else {
+      a01 = dot(t0, t1);
+      a11 = dot(t1, t1);
+      g1 = dot(t1, d);
+      det = a00 * a11 - a01 * a01;
+      if (!(det > 0))
+        break;
+      dp[0] = -(a11 * g0 - a01 * g1) / det;
+      dp[1] = -(a00 * g1 - a01 * g0) / det;
+    }
+    best = -1;
+    for (k = 0, scale = 1; k < HALVINGS; ++k, scale /= 2) {
+      np[0] = to_p[0] + scale * dp[0];
+      np[1] = to_p[1] + scale * dp[1];
+      clamp_param(r, periodic, dim, np);
+      nd2 = distance2(m, e, np, q, nx);
+      if (nd2 < d2) {
+        d2 = nd2;
+        best = k;
+        memcpy(bp, np, sizeof(np));
+        memcpy(bx, nx, sizeof(nx));
+      } else if (best >= 0) {
+        break;
+      }
+    }
+    if (best < 0)
+      break;
+    memcpy(to_p, bp, sizeof(bp));
+    memcpy(x, bx, sizeof(bx));
+  }
+  memcpy(to, x, sizeof(x));
+}
+
+static void closest_in_tree(struct gmi_bvh* b, int root,
+    double const from[3], double to[3], double to_p[2], struct hit* h)
+{
+  nearest(b, root, from, h);
+  if (h->prim < 0)
+    gmi_fail("gmi_bvh: closest point query on an empty tree");
+  to_p[0] = h->p[0];
+  to_p[1] = h->p[1];
+  refine(b, b->prims[h->prim].e, from, to, to_p);
+}
+
+void gmi_bvh_closest_point(struct gmi_bvh* b, struct gmi_ent* e,
+    double const from[3], double to[3], double to_p[2])
+{
+  struct hit h;
+  struct entry* en = find_entry(b, e);
+  if (!en)
+    gmi_fail("gmi_bvh: entity was not tessellated");
+  closest_in_tree(b, en->root, from, to, to_p, &h);
+}
+
+void gmi_bvh_closest_points(struct gmi_bvh* b, struct gmi_ent* e, int n,
+    double const* from, double* to, double* to_p)
+{
+  struct hit h;
+  int i;
+  struct entry* en = find_entry(b, e);
+  if (!en)
+    gmi_fail("gmi_bvh: entity was not tessellated");
+  for (i = 0; i < n; ++i)
+    closest_in_tree(b, en->root, from + 3 * i, to + 3 * i, to_p + 2 * i, &h);
+}
+
+struct gmi_ent* gmi_bvh_closest(struct gmi_bvh* b, int dim,
+    double const from[3], double to[3], double to_p[2])
+{
+  struct hit h;
+  PCU_ALWAYS_ASSERT(dim == 1 || dim == 2);
+  closest_in_tree(b, b->roots[dim], from, to, to_p, &h);
+  return b->prims[h.prim].e;
+}
+
+static int ray_hits_box(struct node* nd, double const o[3],
+    double const inv[3])
+{
+  double tmin = 0;
+  double tmax = DBL_MAX;
+  int j;
+  for (j = 0; j < 3; ++j) {
+    double t1 = (nd->lo[j] - o[j]) * inv[j];
+    double t2 = (nd->hi[j] - o[j]) * inv[j];
+    if (t1 > t2) {
+      double tmp = t1; t1 = t2; t2 = tmp;
+    }
+    if (t1 > tmin) tmin = t1;
+    if (t2 < tmax) tmax = t2;
+  }
+  return tmin <= tmax;
+}
+
+/* Moller-Trumbore, counting only hits in front of the origin */
+static int ray_hits_triangle(struct prim* pr, double const o[3],
+    double const dir[3])
+{
+  double e1[3], e2[3], pv[3], tv[3], qv[3];
+  double det, u, v, t;
+  sub(pr->x[1], pr->x[0], e1);
+  sub(pr->x[2], pr->x[0], e2);
+  pv[0] = dir[1] * e2[2] - dir[2] * e2[1];
+  pv[1] = dir[2] * e2[0] - dir[0] * e2[2];
+  pv[2] = dir[0] * e2[1] - dir[1] * e2[0];
+  det = dot(e1, pv);
+  if (det == 0)
+    return 0;
+  sub(o, pr->x[0], tv);
+  u = dot(tv, pv) / det;
+  if (u < 0 || u > 1)
+    return 0;
+  qv[0] = tv[1] * e1[2] - tv[2] * e1[1];
+  qv[1] = tv[2] * e1[0] - tv[0] * e1[2];
+  qv[2] = tv[0] * e1[1] - tv[1] * e1[0];
+  v = dot(dir, qv) / det;
+  if (v < 0 || u + v > 1)
+    return 0;
+  t = dot(e2, qv) / det;
+  return t > 0;
+}
+
+static int is_in_set(struct gmi_set* s, struct gmi_ent* e)
+{
+  int i;
+  for (i = 0; i < s->n; ++i)
+    if (s->e[i] == e)
+      return 1;
+  return 0;
+}
+
+int gmi_bvh_is_point_in_region(struct gmi_bvh* b, struct gmi_ent* r,
+    double const p[3])
+{
+  /* an arbitrary direction, unlikely to graze tessellation edges */
+  static double const dir[3] = {0.5377, 0.7011, 0.4684};
+  double inv[3];
+  int stack[STACK_SIZE];
+  int top = 0;
+  int crossings = 0;
+  int i, j, bounded = 0;
+  struct gmi_set* faces = gmi_adjacent(b->model, r, 2);
+  for (i = 0; i < faces->n; ++i)
+    if (find_entry(b, faces->e[i]))
+      bounded = 1;
+  if (!bounded || b->roots[2] < 0) {
+    gmi_free_set(faces);
+    return -1;
+  }
+  for (j = 0; j < 3; ++j)
+    inv[j] = 1.0 / dir[j];
+  stack[top++] = b->roots[2];
+  while (top) {
+    struct node* nd = b->nodes + stack[--top];
+    if (!ray_hits_box(nd, p, inv))
+      continue;
+    if (nd->left < 0) {
+      for (i = nd->first; i < nd->first + nd->count; ++i) {
+        struct prim* pr = b->prims + b->items[i];
+        if (is_in_set(faces, pr->e) && ray_hits_triangle(pr, p, dir))
+          ++crossings;
+      }
+      continue;
+    }
+    PCU_ALWAYS_ASSERT(top + 2 <= STACK_SIZE);
+    stack[top++] = nd->left;
+    stack[top++] = nd->right;
+  }
+  gmi_free_set(faces);
+  return crossings % 2;
+}
+
+int gmi_bvh_bbox(struct gmi_bvh* b, struct gmi_ent* e,
+    double bmin[3], double bmax[3])
+{
+  struct node* nd;
+  struct entry* en = find_entry(b, e);
+  if (!en || en->root < 0)
+    return 0;
+  nd = b->nodes + en->root;
+  memcpy(bmin, nd->lo, sizeof(nd->lo));
+  memcpy(bmax, nd->hi, sizeof(nd->hi));
+  return 1;
+}
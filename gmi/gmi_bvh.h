@@ -0,0 +1,70 @@
+/******************************************************************************
+
+  Copyright 2026 Scientific Computation Research Center,
+      Rensselaer Polytechnic Institute. All rights reserved.
+
+  This work is open source software, licensed under the terms of the
+  BSD license as described in the LICENSE file in the top-level directory.
+
+*******************************************************************************/
+#ifndef GMI_BVH_H
+#define GMI_BVH_H
+
+/** \file gmi_bvh.h
+  \brief bounding volume hierarchy over a tessellated model boundary
+
+  \details models defined only by gmi_eval, such as analytic models,
+  have no closest point or inside/outside queries of their own.
+  A gmi_bvh samples the parametric ranges of model edges and faces
+  into segments and triangles and keeps a tree of bounding boxes over
+  them, one per entity and one per dimension, so those queries take
+  O(log n) box tests instead of a search over the whole boundary. */
+
+#include "gmi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct gmi_bvh;
+
+/** \brief tessellate model entities and build their trees
+  \param m the model, which must implement gmi_eval and gmi_range
+  \param ents model edges and faces to tessellate
+  \param resolution each edge becomes (resolution) segments and each
+         face (2 * resolution * resolution) triangles of its
+         parametric range */
+struct gmi_bvh* gmi_bvh_build(struct gmi_model* m, struct gmi_set* ents,
+    int resolution);
+/** \brief free a tree made by gmi_bvh_build */
+void gmi_bvh_free(struct gmi_bvh* b);
+/** \brief closest point on a tessellated entity
+  \details the closest point of the tessellation is refined with
+  Gauss-Newton steps on gmi_eval when the model implements
+  gmi_first_derivative. the arguments are as in gmi_closest_point */
+void gmi_bvh_closest_point(struct gmi_bvh* b, struct gmi_ent* e,
+    double const from[3], double to[3], double to_p[2]);
+/** \brief gmi_bvh_closest_point for (n) points on the same entity
+  \details from, to and to_p hold 3, 3 and 2 values per point */
+void gmi_bvh_closest_points(struct gmi_bvh* b, struct gmi_ent* e, int n,
+    double const* from, double* to, double* to_p);
+/** \brief find the tessellated entity of dimension (dim) closest to
+  a point, and the closest point on it */
+struct gmi_ent* gmi_bvh_closest(struct gmi_bvh* b, int dim,
+    double const from[3], double to[3], double to_p[2]);
+/** \brief check whether a point is inside a model region
+  \details counts the crossings of a ray with the tessellated faces
+  bounding (r). returns 1 inside, 0 outside and -1 when none of the
+  faces of (r) were tessellated */
+int gmi_bvh_is_point_in_region(struct gmi_bvh* b, struct gmi_ent* r,
+    double const p[3]);
+/** \brief the bounding box of the tessellation of an entity
+  \returns 0 if the entity was not tessellated */
+int gmi_bvh_bbox(struct gmi_bvh* b, struct gmi_ent* e,
+    double bmin[3], double bmax[3]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,7 +22,8 @@ set(SOURCES
    gmi_lookup.c
    gmi_mesh.c
    gmi_null.c
-   gmi_analytic.c)
+   gmi_analytic.c
+   gmi_bvh.c)
 
 set(HEADERS
    gmi.h
@@ -31,7 +32,8 @@ set(HEADERS
    gmi_lookup.h
    gmi_mesh.h
    gmi_null.h
-   gmi_analytic.h)
+   gmi_analytic.h
+   gmi_bvh.h)
 
 #Library
 tribits_add_library(
@@ -36,6 +36,7 @@ void adapt(Input* in)
     midBalance(a);
     refine(a);
     snap(a);
+    compactMesh(a);
   }
   allowSplitCollapseOutsideLayer(a);
   fixElementShapes(a);
@@ -75,6 +76,7 @@ void adaptVerbose(Input* in, bool verbose)
     fixElementShapes(a);
     if (verbose && in->shouldFixShape)
       ma_dbg::dumpMeshWithQualities(a,i,"after_fix");
+    compactMesh(a);
   }
   allowSplitCollapseOutsideLayer(a);
   fixElementShapes(a);
@@ -19,6 +19,7 @@
 #include "maShapeHandler.h"
 #include "maLayer.h"
 #include <apf.h>
+#include <apfMDS.h>
 #include <cfloat>
 #include <pcu_util.h>
 #include <stdarg.h>
@@ -460,6 +461,18 @@ void clearBuildCallback(Adapt* a)
   a->buildCallback = 0;
 }
 
+void compactMesh(Adapt* a)
+{
+  Mesh* m = a->mesh;
+  if (a->input->minimumMdsFill <= 0 || !apf::isMdsMesh(m))
+    return;
+  double fill = PCU_Min_Double(apf::getMdsFill(m));
+  if (fill >= a->input->minimumMdsFill)
+    return;
+  print("compacting mesh storage, fill ratio %f", fill);
+  apf::compactMdsMesh(m);
+}
+
 void print(const char* format, ...)
 {
   if (PCU_Comm_Self())
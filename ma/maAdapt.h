@@ -160,6 +160,10 @@ Entity* rebuildElement(
 void setBuildCallback(Adapt* a, apf::BuildCallback* cb);
 void clearBuildCallback(Adapt* a);
 
+/* compacts MDS meshes whose fill ratio fell below
+   Input::minimumMdsFill, see apf::compactMdsMesh */
+void compactMesh(Adapt* a);
+
 void print(const char* format, ...) __attribute__((format(printf,1,2)));
 
 void setFlagOnClosure(Adapt* a, Entity* e, int flag);
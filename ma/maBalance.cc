@@ -90,15 +90,55 @@ Tag* getElementWeights(Adapt* a)
   return weights;
 }
 
-static void runBalancer(Adapt* a, apf::Balancer* b)
+/* the memory an element is expected to take at the peak of the next
+   refinement. elements that will be coarsened are still there then */
+static double getPeakBytes(Adapt* a, Entity* e)
 {
   Mesh* m = a->mesh;
-  Input* in = a->input;
-  Tag* weights = getElementWeights(a);
-  b->balance(weights,in->maximumImbalance);
+  double count = std::max(1.0, getElementWeight(a, e));
+  return m->getElementBytes(m->getType(e)) * count;
+}
+
+static Tag* getPeakMemoryWeights(Adapt* a)
+{
+  Mesh* m = a->mesh;
+  Tag* weights = m->createDoubleTag("ma_peak_bytes",1);
+  Entity* e;
+  Iterator* it = m->begin(m->getDimension());
+  while ((e = m->iterate(it)))
+  {
+    double bytes = getPeakBytes(a,e);
+    m->setDoubleTag(e,weights,&bytes);
+  }
+  m->end(it);
+  return weights;
+}
+
+static void printMigration(Mesh* m, apf::Balancer* b)
+{
+  std::vector<Parma_StepInfo> steps;
+  if ( ! Parma_GetBalancerSteps(b, steps))
+    return;
+  long moved = 0;
+  for (size_t i = 0; i < steps.size(); ++i)
+    moved += steps[i].elements;
+  long total = PCU_Add_Long(m->count(m->getDimension()));
+  print("balancing migrated %ld elements, %.1f%% of the mesh",
+      moved, 100.0 * moved / total);
+}
+
+static void runBalancer(Adapt* a, apf::Balancer* b, Tag* weights)
+{
+  b->balance(weights,a->input->maximumImbalance);
+  printMigration(a->mesh, b);
   delete b;
-  removeTagFromDimension(m,weights,m->getDimension());
-  m->destroyTag(weights);
+  removeTagFromDimension(a->mesh,weights,a->mesh->getDimension());
+  a->mesh->destroyTag(weights);
+}
+
+static void runBalancer(Adapt* a, apf::Balancer* b)
+{
+  runBalancer(a, b, getElementWeights(a));
 }
 
 void runZoltan(Adapt* a, int method=apf::GRAPH)
@@ -108,9 +148,53 @@ void runZoltan(Adapt* a, int method=apf::GRAPH)
         /* debug = */ false));
 }
 
+static apf::Balancer* makeParma(Adapt* a)
+{
+  if (a->input->shouldRunIncrementalParma)
+    return Parma_MakeIncrementalElmBalancer(a->mesh);
+  return Parma_MakeElmBalancer(a->mesh);
+}
+
 void runParma(Adapt* a)
 {
-  runBalancer(a, Parma_MakeElmBalancer(a->mesh));
+  runBalancer(a, makeParma(a));
+}
+
+static void destroyWeights(Mesh* m, Tag* weights)
+{
+  removeTagFromDimension(m,weights,m->getDimension());
+  m->destroyTag(weights);
+}
+
+double getPredictedImbalance(Adapt* a)
+{
+  Mesh* m = a->mesh;
+  Tag* weights = getPeakMemoryWeights(a);
+  double imbalance =
+    Parma_GetWeightedEntImbalance(m, weights, m->getDimension());
+  destroyWeights(m, weights);
+  return imbalance;
+}
+
+/* balance the memory each part will need during the next refinement,
+   so that parts with regions of heavy refinement do not run out of
+   memory before the post balance */
+void runPredictive(Adapt* a)
+{
+  Mesh* m = a->mesh;
+  Tag* weights = getPeakMemoryWeights(a);
+  double imbalance =
+    Parma_GetWeightedEntImbalance(m, weights, m->getDimension());
+  print("predicted peak memory imbalance %.0f%% of average",
+      (imbalance-1)*100);
+  if (imbalance > a->input->maximumImbalance)
+  {
+    runBalancer(a, makeParma(a), weights);
+    print("predicted peak memory imbalance %.0f%% after balancing",
+        (getPredictedImbalance(a)-1)*100);
+  }
+  else
+    destroyWeights(m, weights);
 }
 
 void printEntityImbalance(Mesh* m)
@@ -132,6 +216,8 @@ void preBalance(Adapt* a)
     runZoltan(a,apf::RIB);
   if (in->shouldRunPreParma)
     runParma(a);
+  if (in->shouldRunPredictiveParma)
+    runPredictive(a);
 }
 
 void midBalance(Adapt* a)
@@ -143,6 +229,8 @@ void midBalance(Adapt* a)
     runZoltan(a);
   if (in->shouldRunMidParma)
     runParma(a);
+  if (in->shouldRunPredictiveParma)
+    runPredictive(a);
 }
 
 void postBalance(Adapt* a)
@@ -9,6 +9,11 @@ void preBalance(Adapt* a);
 void midBalance(Adapt* a);
 void postBalance(Adapt* a);
 
+/* the peak memory imbalance predicted for the next refinement */
+double getPredictedImbalance(Adapt* a);
+/* balances that prediction if it is above the maximum imbalance */
+void runPredictive(Adapt* a);
+
 }
 
 #endif
@@ -54,6 +54,7 @@ void setDefaultValues(Input* in)
   in->shouldCheckQualityForDoubleSplits = false;
   in->validQuality = 1e-10;
   in->maximumImbalance = 1.10;
+  in->minimumMdsFill = 0.0;
   in->shouldRunPreZoltan = false;
   in->shouldRunPreZoltanRib = false;
   in->shouldRunPreParma = false;
@@ -62,6 +63,9 @@ void setDefaultValues(Input* in)
   in->shouldRunPostZoltan = false;
   in->shouldRunPostZoltanRib = false;
   in->shouldRunPostParma = false;
+  in->shouldRunIncrementalParma = false;
+  in->shouldRunPredictiveParma = false;
+  in->shapeThreads = 1;
   in->shouldTurnLayerToTets = false;
   in->shouldCleanupLayer = false;
   in->shouldRefineLayer = false;
@@ -118,6 +122,10 @@ void validateInput(Input* in)
     rejectInput("negative minimum element quality");
   if (in->maximumImbalance < 1.0)
     rejectInput("maximum imbalance less than 1.0");
+  if (in->minimumMdsFill > 1.0)
+    rejectInput("minimum MDS fill ratio greater than one");
+  if (in->shapeThreads < 1)
+    rejectInput("fewer than one shape correction thread");
   if (in->maximumEdgeRatio < 1.0)
     rejectInput("maximum tet edge ratio less than one");
 }
@@ -74,6 +74,9 @@ class Input
     double validQuality;
 /** \brief imbalance target for all load balancing tools (default 1.10) */
     double maximumImbalance;
+/** \brief compact MDS storage between iterations once the fraction of
+    live entity slots drops below this (default 0.0, never) */
+    double minimumMdsFill;
 /** \brief whether to run zoltan predictive load balancing (default false) */
     bool shouldRunPreZoltan;
 /** \brief whether to run zoltan predictive load balancing using RIB (default false) */
@@ -90,6 +93,18 @@ class Input
     bool shouldRunPostZoltanRib;
 /** \brief whether to run parma after adapting (default false) */
     bool shouldRunPostParma;
+/** \brief whether the parma runs keep the current partition and migrate
+   as few elements as possible (default false)
+   \details see Parma_MakeIncrementalElmBalancer */
+    bool shouldRunIncrementalParma;
+/** \brief whether to run parma before each refinement on the memory the
+   parts are predicted to need during it (default false)
+   \details elements are weighed by Mesh::getElementBytes times the
+   number of elements the size field will turn them into */
+    bool shouldRunPredictiveParma;
+/** \brief number of threads the shape correction of curved (crv) meshes
+   uses to check element validity and quality (default 1) */
+    int shapeThreads;
 /** \brief the ratio between longest and shortest edges that differentiates a
    "short edge" element from a "large angle" element. */
     double maximumEdgeRatio;
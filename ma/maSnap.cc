@@ -21,6 +21,8 @@
 #include <lionPrint.h>
 #include <iostream>
 #include <algorithm>
+#include <map>
+#include <vector>
 
 namespace ma {
 
@@ -681,15 +683,6 @@ void transferToClosestPointOnQuadSplit(
   (void) targetPt;
 }
 
-static void getSnapPoint(Mesh* m, Entity* v, Vector& x)
-{
-  m->getPoint(v,0,x);
-  Vector p;
-  m->getParam(v,p);
-  Model* g = m->toModel(v);
-  m->snapToModel(g,p,x);
-}
-
 class SnapAll : public Operator
 {
   public:
@@ -796,23 +789,39 @@ long tagVertsToSnap(Adapt* a, Tag*& t)
   Mesh* m = a->mesh;
   int dim = m->getDimension();
   t = m->createDoubleTag("ma_snap", 3);
+  /* group the vertices by model entity so that each
+     model entity is evaluated in one batch */
+  std::map<Model*, std::vector<Entity*> > groups;
   Entity* v;
-  long n = 0;
   Iterator* it = m->begin(0);
   while ((v = m->iterate(it))) {
-    int md = m->getModelType(m->toModel(v));
-    if (dim == 3 && md == 3)
+    Model* g = m->toModel(v);
+    if (dim == 3 && m->getModelType(g) == 3)
       continue;
-    Vector s;
-    getSnapPoint(m, v, s);
-    Vector x = getPosition(m, v);
-    if (apf::areClose(s, x, 1e-12))
-      continue;
-    m->setDoubleTag(v, t, &s[0]);
-    if (m->isOwned(v))
-      ++n;
+    groups[g].push_back(v);
   }
   m->end(it);
+  long n = 0;
+  std::vector<Vector> p;
+  std::vector<Vector> s;
+  std::map<Model*, std::vector<Entity*> >::iterator gi;
+  for (gi = groups.begin(); gi != groups.end(); ++gi) {
+    std::vector<Entity*>& verts = gi->second;
+    int nv = verts.size();
+    p.resize(nv);
+    s.resize(nv);
+    for (int i = 0; i < nv; ++i)
+      m->getParam(verts[i], p[i]);
+    m->snapToModel(gi->first, nv, &p[0], &s[0]);
+    for (int i = 0; i < nv; ++i) {
+      Vector x = getPosition(m, verts[i]);
+      if (apf::areClose(s[i], x, 1e-12))
+        continue;
+      m->setDoubleTag(verts[i], t, &s[i][0]);
+      if (m->isOwned(verts[i]))
+        ++n;
+    }
+  }
   return PCU_Add_Long(n);
 }
 
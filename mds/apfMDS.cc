@@ -20,6 +20,7 @@
 #include <apfPartition.h>
 #include <apfFile.h>
 #include <cstring>
+#include <cstdio>
 #include <pcu_util.h>
 #include <cstdlib>
 #include <stdint.h>
@@ -56,20 +57,20 @@ static int getFaceIdInRegion(apf::Mesh* mesh, apf::MeshEntity* region,
 {
   apf::Downward verts;
   apf::MeshTag* vIDTag = mesh->findTag("_vert_id");
-  int vID;
+  long vID;
   mesh->getDownward(region, 0, verts);
   // Go through all vertices. What vertex is not on the face can be used to determine the face id.
   // TODO: Good way to assert that the rest of the 3 actually exist?
-  mesh->getIntTag(verts[0], vIDTag, &vID);
+  mesh->getLongTag(verts[0], vIDTag, &vID);
   if (vID != bface_data[2] && vID != bface_data[3] && vID != bface_data[4])
     return 2;
-  mesh->getIntTag(verts[1], vIDTag, &vID);
+  mesh->getLongTag(verts[1], vIDTag, &vID);
   if (vID != bface_data[2] && vID != bface_data[3] && vID != bface_data[4])
     return 3;
-  mesh->getIntTag(verts[2], vIDTag, &vID);
+  mesh->getLongTag(verts[2], vIDTag, &vID);
   if (vID != bface_data[2] && vID != bface_data[3] && vID != bface_data[4])
     return 1;
-  mesh->getIntTag(verts[3], vIDTag, &vID);
+  mesh->getLongTag(verts[3], vIDTag, &vID);
   if (vID != bface_data[2] && vID != bface_data[3] && vID != bface_data[4])
     return 0;
   return 12; // Should give segmentation fault
@@ -80,12 +81,13 @@ static int getEdgeIdInFace(apf::Mesh* mesh, apf::MeshEntity* face,
 {
   apf::Downward verts, edges;
   apf::MeshTag* vIDTag = mesh->findTag("_vert_id");
-  int vID[2], eID;
+  long vID[2];
+  int eID;
   mesh->getDownward(face, 1, edges);
   for (eID = 0; eID < 3; ++eID) {
     mesh->getDownward(edges[eID], 0, verts);
-    mesh->getIntTag(verts[0], vIDTag, &vID[0]);
-    mesh->getIntTag(verts[1], vIDTag, &vID[1]);
+    mesh->getLongTag(verts[0], vIDTag, &vID[0]);
+    mesh->getLongTag(verts[1], vIDTag, &vID[1]);
     if((vID[0] == bedge_data[2] && vID[1] == bedge_data[3]) ||
        (vID[0] == bedge_data[3] && vID[1] == bedge_data[2])) {
       return eID;
@@ -158,6 +160,26 @@ static int apf2mds(int t_apf)
   return table[t_apf];
 }
 
+/* whether a model entity is in the closure of a model entity of
+   dimension dim - 1 between two model regions. ph::cutInterface
+   only makes DG copies there, while periodic matches pair entities
+   on the model boundary, whose faces bound a single region */
+static bool isOnInterface(gmi_model* g, gmi_ent* ge, int dim)
+{
+  int d = gmi_dim(g, ge);
+  if (d >= dim)
+    return false;
+  gmi_set* s = gmi_adjacent(g, ge, d + 1);
+  bool out = false;
+  if (d == dim - 1)
+    out = s->n == 2;
+  else
+    for (int i = 0; !out && i < s->n; ++i)
+      out = isOnInterface(g, s->e[i], dim);
+  gmi_free_set(s);
+  return out;
+}
+
 class MeshMDS : public Mesh2
 {
   public:
@@ -729,10 +751,25 @@ class MeshMDS : public Mesh2
     }
     void getDgCopies(MeshEntity* e, DgCopies& dgCopies, ModelEntity* me)
     {
-      (void) e;
-      (void) dgCopies;
-      (void) me;
-      PCU_ALWAYS_ASSERT_VERBOSE(false, "error: getDgCopies for MDS is not implemented yet! ");
+      /* ph::cutInterface records the copies it makes on either side
+         of an interface as matches, all classified on the same model
+         entity. only the matches of interface entities are DG copies,
+         and of the matches on this part only those on the same model
+         entity. a vertex or edge where an interface meets a periodic
+         boundary still reports its remote periodic matches */
+      dgCopies.setSize(0);
+      ModelEntity* c = toModel(e);
+      if (!me)
+        me = c;
+      gmi_model* g = static_cast<gmi_model*>(mesh->user_model);
+      if (!isOnInterface(g, reinterpret_cast<gmi_ent*>(me), getDimension()))
+        return;
+      Matches matches;
+      getMatches(e, matches);
+      for (size_t i = 0; i < matches.getSize(); ++i)
+        if (matches[i].peer != PCU_Comm_Self() ||
+            toModel(matches[i].entity) == c)
+          dgCopies.append(matches[i]);
     }
     void addMatch(MeshEntity* e, int peer, MeshEntity* match)
     {
@@ -962,6 +999,196 @@ void reorderMdsMesh(Mesh2* mesh, MeshTag* t)
     lion_oprint(1,"mesh reordered in %f seconds\n", PCU_Time()-t0);
 }
 
+MeshTag* numberMdsMesh(Mesh2* mesh, int ordering, bool elements)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(mesh);
+  mds_tag* t = 0;
+  int curve = MDS_HILBERT;
+  switch (ordering) {
+    case MDS_BFS_ORDER:
+      t = mds_number_verts_bfs(m->mesh);
+      break;
+    case MDS_RCM_ORDER:
+      t = mds_number_verts_rcm(m->mesh);
+      if (elements)
+        mds_number_elems_rcm(m->mesh, t);
+      break;
+    case MDS_MORTON_ORDER:
+      curve = MDS_MORTON;
+      /* fall through */
+    case MDS_HILBERT_ORDER:
+      t = mds_number_verts_sfc(m->mesh, curve);
+      if (elements)
+        mds_number_elems_sfc(m->mesh, t, curve);
+      break;
+    default:
+      fail("apf::numberMdsMesh: unknown ordering\n");
+  }
+  return reinterpret_cast<MeshTag*>(t);
+}
+
+void compactMdsMesh(Mesh2* mesh, MeshTag* t)
+{
+  double t0 = PCU_Time();
+  MeshMDS* m = static_cast<MeshMDS*>(mesh);
+  mds_tag* vert_nums = 0;
+  if (t) {
+    PCU_ALWAYS_ASSERT(mesh->getTagType(t) == Mesh::INT);
+    vert_nums = reinterpret_cast<mds_tag*>(t);
+  }
+  mds_apf_compact(m->mesh, vert_nums);
+  if (!PCU_Comm_Self())
+    lion_oprint(1,"mesh compacted in %f seconds\n", PCU_Time()-t0);
+}
+
+double getMdsFill(Mesh2* mesh)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(mesh);
+  long n = 0;
+  long end = 0;
+  for (int t = 0; t < MDS_TYPES; ++t) {
+    n += m->mesh->mds.n[t];
+    end += m->mesh->mds.end[t];
+  }
+  if (!end)
+    return 1;
+  return double(n) / end;
+}
+
+bool isMdsMesh(Mesh* mesh)
+{
+  return dynamic_cast<MeshMDS*>(mesh) != 0;
+}
+
+static size_t getNetMemory(mds_net* net, mds* m)
+{
+  size_t bytes = 0;
+  for (int t = 0; t < MDS_TYPES; ++t) {
+    if (!net->data[t])
+      continue;
+    bytes += m->cap[t] * sizeof(mds_copies*);
+    for (mds_id i = 0; i < m->cap[t]; ++i)
+      if (net->data[t][i])
+        bytes += sizeof(mds_copies) +
+          (net->data[t][i]->n - 1) * sizeof(mds_copy);
+  }
+  return bytes;
+}
+
+static bool isTagOf(mds_tag* t, const char* name)
+{
+  size_t l = strlen(name);
+  return !strncmp(t->name, name, l) && t->name[l] == '_';
+}
+
+static bool isFieldTag(Mesh* m, mds_tag* t)
+{
+  for (int i = 0; i < m->countFields(); ++i)
+    if (isTagOf(t, getName(m->getField(i))))
+      return true;
+  for (int i = 0; i < m->countNumberings(); ++i)
+    if (isTagOf(t, getName(m->getNumbering(i))))
+      return true;
+  for (int i = 0; i < m->countGlobalNumberings(); ++i)
+    if (isTagOf(t, getName(m->getGlobalNumbering(i))))
+      return true;
+  return false;
+}
+
+void getMdsMemory(Mesh2* mesh, MdsMemory& mem)
+{
+  mds_apf* m = static_cast<MeshMDS*>(mesh)->mesh;
+  mds* s = &m->mds;
+  memset(&mem, 0, sizeof(mem));
+  for (int t = 0; t < MDS_TYPES; ++t) {
+    size_t per = sizeof(mds_id) + sizeof(*m->model[t]) + sizeof(*m->parts[t]);
+    if (t == MDS_VERTEX)
+      per += sizeof(*m->point) + sizeof(*m->param);
+    mem.entities[mds2apf(t)] = s->cap[t] * per;
+  }
+  for (int from = 0; from <= 3; ++from)
+  for (int to = 0; to <= 3; ++to) {
+    if (!s->mrm[from][to])
+      continue;
+    size_t bytes = 0;
+    for (int t = 0; t < MDS_TYPES; ++t) {
+      if (from > to && mds_dim[t] == from)
+        bytes += s->cap[t] * mds_degree[t][to];
+      if (from < to && mds_dim[t] == to)
+        bytes += s->cap[t] * mds_degree[t][from];
+      if (from < to && mds_dim[t] == from)
+        bytes += s->cap[t];
+    }
+    mem.adjacency[from][to] = bytes * sizeof(mds_id);
+  }
+  for (mds_tag* tag = m->tags.first; tag; tag = tag->next) {
+    size_t bytes = 0;
+    for (int t = 0; t < MDS_TYPES; ++t)
+      if (tag->has[t])
+        bytes += s->cap[t] * tag->bytes + s->cap[t] / 8 + 1;
+    if (isFieldTag(mesh, tag))
+      mem.fields += bytes;
+    else
+      mem.tags += bytes;
+  }
+  mem.remotes = getNetMemory(&m->remotes, s);
+  mem.ghosts = getNetMemory(&m->ghosts, s);
+  mem.matches = getNetMemory(&m->matches, s);
+}
+
+size_t getMdsMemoryTotal(MdsMemory const& mem)
+{
+  size_t total = 0;
+  for (int t = 0; t < Mesh::TYPES; ++t)
+    total += mem.entities[t];
+  for (int from = 0; from <= 3; ++from)
+  for (int to = 0; to <= 3; ++to)
+    total += mem.adjacency[from][to];
+  return total + mem.fields + mem.tags
+               + mem.remotes + mem.ghosts + mem.matches;
+}
+
+static void printMemoryLine(const char* what, size_t bytes)
+{
+  double mb = double(bytes) / (1024 * 1024);
+  double max = PCU_Max_Double(mb);
+  double sum = PCU_Add_Double(mb);
+  if (!PCU_Comm_Self() && sum > 0)
+    lion_oprint(1,"  %-16s max %12.3f MB total %12.3f MB\n", what, max, sum);
+}
+
+void printMdsMemory(Mesh2* mesh)
+{
+  MdsMemory mem;
+  getMdsMemory(mesh, mem);
+  if (!PCU_Comm_Self())
+    lion_oprint(1,"MDS memory:\n");
+  for (int t = 0; t < Mesh::TYPES; ++t)
+    printMemoryLine(Mesh::typeName[t], mem.entities[t]);
+  for (int from = 0; from <= 3; ++from)
+  for (int to = 0; to <= 3; ++to) {
+    char what[32];
+    sprintf(what, "adjacency %d->%d", from, to);
+    printMemoryLine(what, mem.adjacency[from][to]);
+  }
+  printMemoryLine("fields", mem.fields);
+  printMemoryLine("tags", mem.tags);
+  printMemoryLine("remotes", mem.remotes);
+  printMemoryLine("ghosts", mem.ghosts);
+  printMemoryLine("matches", mem.matches);
+  printMemoryLine("total", getMdsMemoryTotal(mem));
+}
+
+void dropMdsUpward(Mesh2* mesh)
+{
+  mds_drop_up(&static_cast<MeshMDS*>(mesh)->mesh->mds);
+}
+
+void restoreMdsUpward(Mesh2* mesh)
+{
+  mds_restore_up(&static_cast<MeshMDS*>(mesh)->mesh->mds);
+}
+
 Mesh2* expandMdsMesh(Mesh2* m, gmi_model* g, int inputPartCount)
 {
   double t0 = PCU_Time();
@@ -1052,10 +1279,11 @@ void deriveMdlFromManifold(Mesh2* mesh, bool* isModelVert,
 
   PCU_ALWAYS_ASSERT_VERBOSE(!mesh->findTag("_vert_id"),
           "MeshTag name \"_vert_id\" is used internally in this method\n");
-  apf::MeshTag* vIDTag = mesh->createIntTag("_vert_id", 1);
+  apf::MeshTag* vIDTag = mesh->createLongTag("_vert_id", 1);
   for (apf::GlobalToVert::iterator vit = globalToVert.begin();
        vit != globalToVert.end(); vit++) {
-    mesh->setIntTag(vit->second, vIDTag, &(vit->first));
+    long vid = vit->first;
+    mesh->setLongTag(vit->second, vIDTag, &vid);
   }
 
   // Reserve tags used for model faces
@@ -1168,10 +1396,11 @@ void derive2DMdlFromManifold(Mesh2* mesh, bool* isModelVert,
 
   PCU_ALWAYS_ASSERT_VERBOSE(!mesh->findTag("_vert_id"),
           "MeshTag name \"_vert_id\" is used internally in this method\n");
-  apf::MeshTag* vIDTag = mesh->createIntTag("_vert_id", 1);
+  apf::MeshTag* vIDTag = mesh->createLongTag("_vert_id", 1);
   for (apf::GlobalToVert::iterator vit = globalToVert.begin();
        vit != globalToVert.end(); vit++) {
-    mesh->setIntTag(vit->second, vIDTag, &(vit->first));
+    long vid = vit->first;
+    mesh->setLongTag(vit->second, vIDTag, &vid);
   }
 
   // Reserve tags used for model edges
@@ -1275,6 +1504,18 @@ MeshEntity* getMdsEntity(Mesh2* in, int dimension, int index)
   return 0;
 }
 
+/* the internals apfMDSArrays.cc reads and fills */
+mds_apf* getMdsApf(Mesh* in)
+{
+  MeshMDS* m = dynamic_cast<MeshMDS*>(in);
+  return m ? m->mesh : 0;
+}
+
+PM& getMdsPartModel(Mesh2* in)
+{
+  return static_cast<MeshMDS*>(in)->pmodel;
+}
+
 void disownMdsModel(Mesh2* in)
 {
   MeshMDS* m = static_cast<MeshMDS*>(in);
@@ -31,19 +31,22 @@
   \brief Interface to the compact Mesh Data Structure */
 
 #include <map>
+#include <apfMesh.h>
 
 struct gmi_model;
 
 namespace apf {
 
-class Mesh;
 class Mesh2;
 class MeshTag;
 class MeshEntity;
 class Migration;
 
+/** \brief a global vertex id, see apfConvert.h */
+typedef long Gid;
+
 /** \brief a map from global ids to vertex objects */
-typedef std::map<int, MeshEntity*> GlobalToVert;
+typedef std::map<Gid, MeshEntity*> GlobalToVert;
 
 /** \brief create an empty MDS part
   \param model the geometric model interface
@@ -94,6 +97,8 @@ Mesh2* createMdsMesh(gmi_model* model, Mesh* from, bool reorder=false, bool copy
            in the range [0, #vertices).
            this will indicate the order in which they appear
            after reordering.
+           If the elements also carry a numbering
+           (see apf::numberMdsMesh), it is kept as well.
   \details similar to the algorithm for apf::reorder,
            this function will traverse adjacencies to reorder
            each topological type.
@@ -102,6 +107,89 @@ Mesh2* createMdsMesh(gmi_model* model, Mesh* from, bool reorder=false, bool copy
            there are no gaps in the MDS arrays after this */
 void reorderMdsMesh(Mesh2* mesh, MeshTag* t = 0);
 
+/** \brief orderings available through apf::numberMdsMesh */
+enum MdsOrdering {
+  /** \brief breadth-first vertex traversal, the reorderMdsMesh default */
+  MDS_BFS_ORDER,
+  /** \brief reverse Cuthill-McKee over the vertex and element graphs */
+  MDS_RCM_ORDER,
+  /** \brief Hilbert curve through vertices and element centroids */
+  MDS_HILBERT_ORDER,
+  /** \brief Morton (Z-order) curve through vertices and element centroids */
+  MDS_MORTON_ORDER
+};
+
+/** \brief compute an ordering tag for apf::reorderMdsMesh
+  \param ordering one of apf::MdsOrdering
+  \param elements if true, elements are numbered by the same method
+         instead of following their vertices (ignored for MDS_BFS_ORDER)
+  \details the returned tag is consumed by apf::reorderMdsMesh.
+            edges and faces are still ordered by traversal
+            from the sorted vertices. */
+MeshTag* numberMdsMesh(Mesh2* mesh, int ordering, bool elements = true);
+
+/** \brief remove the gaps left in MDS arrays by destroyed entities
+  \param t Optional ordering tag, as accepted by apf::reorderMdsMesh.
+           Set this to NULL to keep the current relative order.
+  \details unlike apf::reorderMdsMesh, the arrays are renumbered in place
+           without building a second mesh, and ghost copies are kept.
+           Tags, fields, remote copies and matches follow their entities.
+           All MeshEntity pointers held by the caller become invalid. */
+void compactMdsMesh(Mesh2* mesh, MeshTag* t = 0);
+
+/** \brief fraction of allocated MDS entity slots that hold live entities
+  \details this is 1 right after loading, reordering or compacting,
+            and drops as entities are destroyed. */
+double getMdsFill(Mesh2* mesh);
+
+/** \brief returns true if this mesh is backed by MDS */
+bool isMdsMesh(Mesh* mesh);
+
+/** \brief bytes allocated by one part of an MDS mesh */
+struct MdsMemory
+{
+  /** \brief free lists, classification, part pointers and
+      (for vertices) coordinates, indexed by apf::Mesh::Type */
+  size_t entities[Mesh::TYPES];
+  /** \brief stored adjacency arrays, indexed by [from][to] dimension */
+  size_t adjacency[4][4];
+  /** \brief tags holding apf::Field and apf::Numbering data */
+  size_t fields;
+  /** \brief all other tags */
+  size_t tags;
+  size_t remotes;
+  size_t ghosts;
+  size_t matches;
+};
+
+/** \brief measure the storage of this part of an MDS mesh
+  \details counts allocated capacity, so gaps left by destroyed
+            entities are included (see apf::compactMdsMesh) */
+void getMdsMemory(Mesh2* mesh, MdsMemory& mem);
+
+/** \brief sum of all categories in an MdsMemory */
+size_t getMdsMemoryTotal(MdsMemory const& mem);
+
+/** \brief print the maximum and total over all parts of each category */
+void printMdsMemory(Mesh2* mesh);
+
+/** \brief free one-level upward adjacency storage
+  \details each upward adjacency is rebuilt from the downward
+            adjacency the first time it is needed, e.g. by
+            Mesh::getUp, Mesh::getAdjacent or Mesh::hasUp.
+            Meshes that are only read through downward
+            adjacency (e.g. by solvers) save close to half of
+            their adjacency memory this way. Note that the
+            first upward query then writes to the mesh. */
+void dropMdsUpward(Mesh2* mesh);
+
+/** \brief rebuild the upward adjacency freed by apf::dropMdsUpward
+  \details call this to choose when the rebuild happens, for
+            example before the mesh is read from several threads
+            or while it must not change. Nothing is done for
+            upward adjacency that is already there. */
+void restoreMdsUpward(Mesh2* mesh);
+
 Mesh2* repeatMdsMesh(Mesh2* m, gmi_model* g, Migration* plan, int factor);
 Mesh2* expandMdsMesh(Mesh2* m, gmi_model* g, int inputPartCount);
 
@@ -192,10 +280,61 @@ int getMdsIndex(Mesh2* in, MeshEntity* e);
   so call apf::reorderMdsMesh after any mesh modification. */
 MeshEntity* getMdsEntity(Mesh2* in, int dimension, int index);
 
+/** \brief check whether the array functions below apply
+  \details they move whole dimensions of a simplex mesh through
+  flat arrays without per-entity apf calls. This needs an MDS mesh
+  of simplices without gaps in its arrays, see apf::compactMdsMesh.
+  Entities are indexed as getMdsIndex does. */
+bool hasMdsArrays(Mesh* in);
+/** \brief copy all vertex coordinates out of a compact MDS mesh
+  \details (x) gets 3 values per vertex */
+void getMdsCoordinates(Mesh2* in, double* x);
+/** \brief overwrite all vertex coordinates of a compact MDS mesh */
+void setMdsCoordinates(Mesh2* in, double const* x);
+/** \brief get the downward adjacent indices of all simplices
+  of one dimension
+  \details (down) gets the indices of the entities of dimension
+  (down_dimension) of each entity, in the canonical order of
+  apf::Mesh::getDownward. down_dimension 0 gives the vertex
+  connectivity */
+void getMdsDownward(Mesh2* in, int dimension, int down_dimension,
+    int* down);
+/** \brief get the model dimension and tag of all entities of
+  one dimension */
+void getMdsClassification(Mesh2* in, int dimension,
+    int* model_dim, int* model_tag);
+/** \brief create (n) simplices of one dimension at once
+  \details vertices are made at the origin, use setMdsCoordinates.
+  for higher dimensions, (down) holds (dimension + 1) indices per
+  entity into the entities one dimension down, in the canonical
+  order of apf::Mesh::getDownward. No duplicate checks are done.
+  The new entities reside on this part only, so parallel meshes
+  still need their remote copies and apf::initResidence. */
+void createMdsEntities(Mesh2* in, int dimension, int n, int const* down,
+    int const* model_dim, int const* model_tag);
+/** \brief copy the values of a tag on all entities of one dimension
+  \details (data) gets the tag size times the size of its type
+  per entity
+  \returns false, copying nothing, if an entity lacks the tag */
+bool getMdsTagArray(Mesh2* in, MeshTag* tag, int dimension, void* data);
+/** \brief set a tag on all entities of one dimension from an array */
+void setMdsTagArray(Mesh2* in, MeshTag* tag, int dimension,
+    void const* data);
+
 Mesh2* loadMdsFromGmsh(gmi_model* g, const char* filename);
 
 Mesh2* loadMdsFromUgrid(gmi_model* g, const char* filename);
 
+/** \brief load an MDS mesh from a UGRID file on all parts at once
+  \details collective. Every part reads an equal share of each
+  element block and of the coordinates, then the mesh is built by
+  apf::construct and apf::setCoords, so no part ever holds the whole
+  mesh. The parts are contiguous ranges of the file's elements, so
+  a partitioner should usually follow. Vertices get the
+  "ugrid-vtx-ids" tag like loadMdsFromUgrid, but the boundary face
+  tags are not read. */
+Mesh2* loadMdsDistributedFromUgrid(gmi_model* g, const char* filename);
+
 void printUgridPtnStats(gmi_model* g, const char* ugridfile, const char* ptnfile,
     const double elmWeights[]);
 
@@ -0,0 +1,178 @@
+/******************************************************************************
+
+  Copyright 2026 Scientific Computation Research Center,
+      Rensselaer Polytechnic Institute. All rights reserved.
+
+  This work is open source software, licensed under the terms of the
+  BSD license as described in the LICENSE file in the top-level directory.
+
+*******************************************************************************/
+
+#include "apfMDS.h"
+#include "mds_apf.h"
+#include "apfPM.h"
+#include <apfMesh2.h>
+#include <pcu_util.h>
+#include <cstring>
+
+namespace apf {
+
+/* defined in apfMDS.cc */
+mds_apf* getMdsApf(Mesh* in);
+PM& getMdsPartModel(Mesh2* in);
+
+static int const mdsSimplices[4] =
+{MDS_VERTEX, MDS_EDGE, MDS_TRIANGLE, MDS_TETRAHEDRON};
+
+/* the simplex type of a dimension, which has to be the only
+   type of that dimension and stored without gaps */
+static int getCompactSimplexType(mds* m, int dimension)
+{
+  int type = mdsSimplices[dimension];
+  for (int t = 0; t < MDS_TYPES; ++t)
+    if (t != type && mds_dim[t] == dimension)
+      PCU_ALWAYS_ASSERT(!m->n[t]);
+  PCU_ALWAYS_ASSERT(m->n[type] == m->end[type]);
+  return type;
+}
+
+bool hasMdsArrays(Mesh* in)
+{
+  mds_apf* m = getMdsApf(in);
+  if (!m)
+    return false;
+  mds* mds = &(m->mds);
+  for (int t = 0; t < MDS_TYPES; ++t) {
+    if (mds_dim[t] > mds->d)
+      continue;
+    if (t == mdsSimplices[mds_dim[t]]) {
+      if (mds->n[t] != mds->end[t])
+        return false;
+    } else if (mds->n[t]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void getMdsCoordinates(Mesh2* in, double* x)
+{
+  mds_apf* m = getMdsApf(in);
+  mds* mds = &(m->mds);
+  getCompactSimplexType(mds, 0);
+  memcpy(x, m->point, 3 * mds->n[MDS_VERTEX] * sizeof(double));
+}
+
+void setMdsCoordinates(Mesh2* in, double const* x)
+{
+  mds_apf* m = getMdsApf(in);
+  mds* mds = &(m->mds);
+  getCompactSimplexType(mds, 0);
+  memcpy(m->point, x, 3 * mds->n[MDS_VERTEX] * sizeof(double));
+}
+
+void getMdsDownward(Mesh2* in, int dimension, int down_dimension,
+    int* down)
+{
+  mds_apf* m = getMdsApf(in);
+  mds* mds = &(m->mds);
+  PCU_ALWAYS_ASSERT(down_dimension < dimension);
+  getCompactSimplexType(mds, down_dimension);
+  int type = getCompactSimplexType(mds, dimension);
+  int deg = mds_degree[type][down_dimension];
+  mds_set s;
+  for (mds_id i = 0; i < mds->n[type]; ++i) {
+    mds_get_adjacent(mds, mds_identify(type, i), down_dimension, &s);
+    for (int j = 0; j < deg; ++j)
+      down[i * deg + j] = mds_index(s.e[j]);
+  }
+}
+
+void getMdsClassification(Mesh2* in, int dimension,
+    int* model_dim, int* model_tag)
+{
+  mds_apf* m = getMdsApf(in);
+  mds* mds = &(m->mds);
+  int type = getCompactSimplexType(mds, dimension);
+  gmi_model* model = in->getModel();
+  gmi_ent** classification = m->model[type];
+  /* neighbors are mostly classified on the same model entity */
+  gmi_ent* last = 0;
+  int last_dim = -1;
+  int last_tag = -1;
+  for (mds_id i = 0; i < mds->n[type]; ++i) {
+    if (classification[i] != last) {
+      last = classification[i];
+      last_dim = gmi_dim(model, last);
+      last_tag = gmi_tag(model, last);
+    }
+    model_dim[i] = last_dim;
+    model_tag[i] = last_tag;
+  }
+}
+
+void createMdsEntities(Mesh2* in, int dimension, int n, int const* down,
+    int const* model_dim, int const* model_tag)
+{
+  if (!n)
+    return;
+  mds_apf* m = getMdsApf(in);
+  mds* mds = &(m->mds);
+  PCU_ALWAYS_ASSERT(dimension <= mds->d);
+  int type = getCompactSimplexType(mds, dimension);
+  int down_type = dimension ? getCompactSimplexType(mds, dimension - 1) : 0;
+  int deg = dimension + 1;
+  gmi_model* model = in->getModel();
+  gmi_ent* last = 0;
+  int last_dim = -1;
+  int last_tag = -1;
+  /* one partition model entity shared by all the new entities */
+  Parts residence;
+  residence.insert(in->getId());
+  PME* part = getPME(getMdsPartModel(in), residence);
+  part->refs += n - 1;
+  mds_id from[4];
+  for (int i = 0; i < n; ++i) {
+    if (model_dim[i] != last_dim || model_tag[i] != last_tag) {
+      last_dim = model_dim[i];
+      last_tag = model_tag[i];
+      last = gmi_find(model, last_dim, last_tag);
+    }
+    if (dimension)
+      for (int j = 0; j < deg; ++j) {
+        PCU_ALWAYS_ASSERT(down[i * deg + j] < mds->n[down_type]);
+        from[j] = mds_identify(down_type, down[i * deg + j]);
+      }
+    mds_id id = mds_apf_create_entity(m, type, last, from);
+    mds_set_part(m, id, part);
+  }
+}
+
+bool getMdsTagArray(Mesh2* in, MeshTag* tag, int dimension, void* data)
+{
+  mds_apf* m = getMdsApf(in);
+  mds_tag* t = reinterpret_cast<mds_tag*>(tag);
+  int type = getCompactSimplexType(&(m->mds), dimension);
+  mds_id n = m->mds.n[type];
+  for (mds_id i = 0; i < n; ++i)
+    if (!mds_has_tag(t, mds_identify(type, i)))
+      return false;
+  if (n)
+    memcpy(data, t->data[type], size_t(n) * t->bytes);
+  return true;
+}
+
+void setMdsTagArray(Mesh2* in, MeshTag* tag, int dimension,
+    void const* data)
+{
+  mds_apf* m = getMdsApf(in);
+  mds_tag* t = reinterpret_cast<mds_tag*>(tag);
+  int type = getCompactSimplexType(&(m->mds), dimension);
+  mds_id n = m->mds.n[type];
+  for (mds_id i = 0; i < n; ++i)
+    mds_give_tag(t, &(m->mds), mds_identify(type, i));
+  if (n)
+    memcpy(t->data[type], data, size_t(n) * t->bytes);
+}
+
+}
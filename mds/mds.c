@@ -391,10 +391,18 @@ static void unrelate_back_up(struct mds* m, mds_id* from, mds_id to)
   }
 }
 
+/* upward links are skipped while that adjacency is dropped,
+   mds_add_adjacency recovers them from the downward ones */
+static int has_up(struct mds* m, int from_dim)
+{
+  return m->mrm[from_dim][from_dim + 1];
+}
+
 static void relate_both(struct mds* m, mds_id* down, mds_id up)
 {
   relate_down(m,up,down);
-  relate_back_up(m,down,up);
+  if (has_up(m,mds_dim[TYPE(up)] - 1))
+    relate_back_up(m,down,up);
 }
 
 static void look_up(struct mds* m, mds_id const e, int d, struct mds_set* s)
@@ -599,6 +607,8 @@ static void check_ent(struct mds* m, mds_id e)
 static void unrelate_ent(struct mds* m, mds_id e)
 {
   struct mds_set down;
+  if (!has_up(m,mds_dim[TYPE(e)] - 1))
+    return;
   look_down(m,e,mds_dim[TYPE(e)] - 1,&down);
   unrelate_back_up(m,down.e,e);
 }
@@ -627,9 +637,11 @@ void mds_hack_adjacent(struct mds* m, mds_id up, int i, mds_id down)
   deg = mds_degree[ut][dd];
   x = ID(ut, ui * deg + i);
   od = *at_id(m->down[dd], x);
-  unrelate_up(m, od, x);
+  if (has_up(m, dd))
+    unrelate_up(m, od, x);
   *at_id(m->down[dd], x) = down;
-  relate_up(m, down, x);
+  if (has_up(m, dd))
+    relate_up(m, down, x);
 }
 
 static void step_down(struct mds* m,
@@ -724,6 +736,15 @@ static void get_down(struct mds* m, mds_id e, int d, struct mds_set* out)
   convert_down(m,&in,from_dim - 1,out,d,t);
 }
 
+static void restore_up(struct mds* m, int from_dim, int to_dim)
+{
+  for (; from_dim < to_dim; ++from_dim)
+    if (!has_up(m,from_dim))
+      mds_add_adjacency(m,from_dim,from_dim + 1);
+}
+
+/* an upward query rebuilds the upward adjacency mds_drop_up freed,
+   so it writes to the mesh the first time. see mds_restore_up */
 void mds_get_adjacent(struct mds* m, mds_id e, int d, struct mds_set* s)
 {
   int e_dim;
@@ -733,6 +754,8 @@ void mds_get_adjacent(struct mds* m, mds_id e, int d, struct mds_set* s)
   }
   check_ent(m,e);
   e_dim = mds_dim[TYPE(e)];
+  if (d > e_dim && !m->mrm[e_dim][d])
+    restore_up(m,e_dim,d);
   if ((e_dim == d) || m->mrm[e_dim][d]) {
     look(m,e,d,s);
     return;
@@ -799,15 +822,30 @@ void mds_add_adjacency(struct mds* m, int from_dim, int to_dim)
   m->mrm[from_dim][to_dim] = 1;
 }
 
+/* rebuilds dropped upward adjacency like mds_get_adjacent */
 int mds_has_up(struct mds* m, mds_id e)
 {
   int d;
   d = mds_dim[TYPE(e)];
   if (d == m->d)
     return 0;
+  restore_up(m,d,d + 1);
   return *at_id(m->first_up[d + 1],e) != MDS_NONE;
 }
 
+void mds_drop_up(struct mds* m)
+{
+  int d;
+  for (d = 0; d < m->d; ++d)
+    if (has_up(m,d))
+      mds_remove_adjacency(m,d,d + 1);
+}
+
+void mds_restore_up(struct mds* m)
+{
+  restore_up(m,0,m->d);
+}
+
 static void increase_dimension(struct mds* m)
 {
   int old_d;
@@ -838,3 +876,116 @@ void mds_change_dimension(struct mds* m, int d)
   while (m->d > d)
     decrease_dimension(m);
 }
+
+static int keeps_order(mds_id end, mds_id const* new_of)
+{
+  mds_id i;
+  mds_id last = -1;
+  for (i = 0; i < end; ++i)
+    if (new_of[i] != MDS_NONE) {
+      if (new_of[i] <= last)
+        return 0;
+      last = new_of[i];
+    }
+  return 1;
+}
+
+void mds_permute(void* data, int bytes, mds_id end, mds_id const* new_of)
+{
+  char* a = data;
+  char* tmp;
+  mds_id i;
+  if (!a)
+    return;
+  /* an order-preserving map only moves rows down,
+     so it can be applied without scratch space */
+  if (keeps_order(end, new_of)) {
+    for (i = 0; i < end; ++i)
+      if (new_of[i] != MDS_NONE && new_of[i] != i)
+        memcpy(a + new_of[i] * bytes, a + i * bytes, bytes);
+    return;
+  }
+  tmp = malloc(end * bytes);
+  for (i = 0; i < end; ++i)
+    if (new_of[i] != MDS_NONE)
+      memcpy(tmp + new_of[i] * bytes, a + i * bytes, bytes);
+  memcpy(a, tmp, end * bytes);
+  free(tmp);
+}
+
+void mds_compact_map(struct mds* m, mds_id* new_of[MDS_TYPES])
+{
+  int t;
+  mds_id i;
+  mds_id n;
+  for (t = 0; t < MDS_TYPES; ++t) {
+    new_of[t] = malloc(m->end[t] * sizeof(mds_id));
+    n = 0;
+    for (i = 0; i < m->end[t]; ++i)
+      if (m->free[t][i] == MDS_LIVE)
+        new_of[t][i] = n++;
+      else
+        new_of[t][i] = MDS_NONE;
+    PCU_ALWAYS_ASSERT(n == m->n[t]);
+  }
+}
+
+static mds_id renumber(mds_id* new_of[MDS_TYPES], mds_id e)
+{
+  return ID(TYPE(e), new_of[TYPE(e)][INDEX(e)]);
+}
+
+static void compact_down(struct mds* m, int from, int to,
+    mds_id* new_of[MDS_TYPES])
+{
+  int t;
+  int deg;
+  mds_id i;
+  mds_id* a;
+  for (t = 0; t < MDS_TYPES; ++t) {
+    if (mds_dim[t] != from)
+      continue;
+    deg = mds_degree[t][to];
+    a = m->down[to][t];
+    mds_permute(a, deg * sizeof(mds_id), m->end[t], new_of[t]);
+    for (i = 0; i < m->n[t] * deg; ++i)
+      a[i] = renumber(new_of, a[i]);
+  }
+}
+
+static void rebuild_up(struct mds* m, int from, int to)
+{
+  int t;
+  mds_id i;
+  mds_id e;
+  struct mds_set adj;
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (mds_dim[t] == from)
+      for (i = 0; i < m->cap[t]; ++i)
+        m->first_up[to][t][i] = MDS_NONE;
+  for (e = mds_begin(m, to); e != MDS_NONE; e = mds_next(m, e)) {
+    mds_get_adjacent(m, e, from, &adj);
+    relate_back_up(m, adj.e, e);
+  }
+}
+
+void mds_compact(struct mds* m, mds_id* new_of[MDS_TYPES])
+{
+  int i, j;
+  int t;
+  mds_id k;
+  for (i = 0; i <= 3; ++i)
+  for (j = 0; j < i; ++j)
+    if (m->mrm[i][j])
+      compact_down(m, i, j, new_of);
+  for (t = 0; t < MDS_TYPES; ++t) {
+    for (k = 0; k < m->n[t]; ++k)
+      m->free[t][k] = MDS_LIVE;
+    m->end[t] = m->n[t];
+    m->first_free[t] = MDS_NONE;
+  }
+  for (i = 0; i <= 3; ++i)
+  for (j = i + 1; j <= 3; ++j)
+    if (m->mrm[i][j])
+      rebuild_up(m, i, j);
+}
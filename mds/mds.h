@@ -67,9 +67,15 @@ void mds_add_adjacency(struct mds* m, int from_dim, int to_dim);
 void mds_remove_adjacency(struct mds* m, int from_dim, int to_dim);
 
 int mds_has_up(struct mds* m, mds_id e);
+void mds_drop_up(struct mds* m);
+void mds_restore_up(struct mds* m);
 
 void mds_change_dimension(struct mds* m, int d);
 
 void mds_hack_adjacent(struct mds* m, mds_id up, int i, mds_id down);
 
+void mds_permute(void* data, int bytes, mds_id end, mds_id const* new_of);
+void mds_compact_map(struct mds* m, mds_id* new_of[MDS_TYPES]);
+void mds_compact(struct mds* m, mds_id* new_of[MDS_TYPES]);
+
 #endif
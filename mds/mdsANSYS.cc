@@ -3,7 +3,9 @@
 #include <apfMesh2.h>
 #include <apfShape.h>
 #include <apfNumbering.h>
-#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 #include <gmi.h>
 #include <pcu_util.h>
 #include <cstdlib>
@@ -26,51 +28,128 @@ static void ansys2apf(int ansysType, int& apfType, apf::FieldShape*& shape)
   };
 }
 
-static void parseElemInt(std::string const& line, int at, int& out)
+/* the files are read into memory whole and parsed in place,
+   one line at a time, instead of through std::getline and
+   a std::stringstream per field */
+struct Lines
 {
-  PCU_ALWAYS_ASSERT(line.length() >= ((size_t)at + 1) * 6);
-  std::string field = line.substr(at * 6, 6);
-  if (field != "      ") {
-    std::stringstream ss(field);
-    ss >> out;
+  Lines(const char* filename, const char* what)
+  {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+      lion_eprint(1, "couldn't open ANSYS %s file \"%s\"\n", what, filename);
+      abort();
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    PCU_ALWAYS_ASSERT(size >= 0);
+    fseek(f, 0, SEEK_SET);
+    buffer.resize(size + 1);
+    size_t got = fread(&buffer[0], 1, size, f);
+    PCU_ALWAYS_ASSERT(got == (size_t)size);
+    buffer[size] = '\0';
+    fclose(f);
+    next = &buffer[0];
+  }
+  /* the next line without its end of line, false at the end of
+     the file or at an empty line */
+  bool get(const char*& line, size_t& length)
+  {
+    line = next;
+    const char* end = strchr(line, '\n');
+    if (!end)
+      end = line + strlen(line);
+    length = end - line;
+    if (length && line[length - 1] == '\r')
+      --length;
+    next = *end ? end + 1 : end;
+    return length > 0;
   }
+  std::vector<char> buffer;
+  const char* next;
+};
+
+static void parseElemInt(const char* line, size_t length, int at, int& out)
+{
+  PCU_ALWAYS_ASSERT(length >= ((size_t)at + 1) * 6);
+  const char* c = line + at * 6;
+  const char* end = c + 6;
+  while (c < end && *c == ' ')
+    ++c;
+  if (c == end)
+    return;
+  bool negative = (*c == '-');
+  if (negative)
+    ++c;
+  int x = 0;
+  for (; c < end && '0' <= *c && *c <= '9'; ++c)
+    x = x * 10 + (*c - '0');
+  out = negative ? -x : x;
 }
 
-static bool parseElem(std::istream& f, int nodes[MAX_ELEM_NODES],
+static bool parseElem(Lines& f, int nodes[MAX_ELEM_NODES],
     int& apfType, int& id, apf::FieldShape*& shape)
 {
-  std::string line;
-  std::getline(f, line);
-  if (!line.length())
+  const char* line;
+  size_t length;
+  if (!f.get(line, length))
     return false;
   for (int i = 0; i < 8; ++i)
-    parseElemInt(line, i, nodes[i]);
+    parseElemInt(line, length, i, nodes[i]);
   int ansysType;
-  parseElemInt(line,  9, ansysType);
-  parseElemInt(line, 13, id);
+  parseElemInt(line, length,  9, ansysType);
+  parseElemInt(line, length, 13, id);
   ansys2apf(ansysType, apfType, shape);
   int nnodes = shape->getEntityShape(apfType)->countNodes();
   if (nnodes <= 8)
     return true;
-  std::getline(f, line);
+  f.get(line, length);
   for (int i = 0; i < (nnodes - 8); ++i)
-    parseElemInt(line, i, nodes[i + 8]);
+    parseElemInt(line, length, i, nodes[i + 8]);
   return true;
 }
 
-typedef std::map<int, apf::Vector3> Nodes;
+/* node points indexed by id, ANSYS ids are nearly contiguous */
+struct Nodes
+{
+  bool count(int id)
+  {
+    return id >= 0 && (size_t)id < has.size() && has[id];
+  }
+  Vector3 const& operator[](int id)
+  {
+    return points[id];
+  }
+  void insert(int id, Vector3 const& p)
+  {
+    PCU_ALWAYS_ASSERT(id >= 0);
+    if ((size_t)id >= has.size()) {
+      has.resize(id + 1, false);
+      points.resize(id + 1);
+    }
+    has[id] = true;
+    points[id] = p;
+  }
+  std::vector<bool> has;
+  std::vector<Vector3> points;
+};
 
-static bool parseNode(std::istream& f, int& id, apf::Vector3& p)
+static bool parseNode(Lines& f, int& id, apf::Vector3& p)
 {
-  std::string line;
-  std::getline(f, line);
-  if (!line.length())
+  const char* line;
+  size_t length;
+  if (!f.get(line, length))
     return false;
-  std::stringstream ss(line);
-  ss >> id;
+  std::string copy(line, length);
+  char* c = &copy[0];
+  char* end;
+  id = strtol(c, &end, 10);
   int i = 0;
-  while (ss >> p[i])
-    ++i;
+  for (c = end; i < 3; ++i, c = end) {
+    p[i] = strtod(c, &end);
+    if (end == c)
+      break;
+  }
   for (; i < 3; ++i)
     p[i] = 0;
   return true;
@@ -78,27 +157,18 @@ static bool parseNode(std::istream& f, int& id, apf::Vector3& p)
 
 static void parseNodes(const char* nodefile, Nodes& nodes)
 {
-  std::ifstream f(nodefile);
-  if (!f.is_open()) {
-    lion_eprint(1, "couldn't open ANSYS node file \"%s\"\n", nodefile);
-    abort();
-  }
-  std::pair<int, apf::Vector3> entry;
-  while (parseNode(f, entry.first, entry.second))
-    nodes.insert(entry);
+  Lines f(nodefile, "node");
+  int id;
+  apf::Vector3 p;
+  while (parseNode(f, id, p))
+    nodes.insert(id, p);
 }
 
-typedef std::map<int, MeshEntity*> Vertices;
-
 static Mesh2* parseElems(const char* elemfile, Nodes& nodes)
 {
   Mesh2* m = 0;
-  std::ifstream f(elemfile);
-  if (!f.is_open()) {
-    lion_eprint(1, "couldn't open ANSYS elem file \"%s\"\n", elemfile);
-    abort();
-  }
-  Vertices verts;
+  Lines f(elemfile, "elem");
+  std::vector<MeshEntity*> verts(nodes.has.size(), 0);
   int en[MAX_ELEM_NODES];
   int type;
   int id;
@@ -125,7 +195,7 @@ static Mesh2* parseElems(const char* elemfile, Nodes& nodes)
       }
     int i = 0;
     for (i = 0; i < nev; ++i) {
-      if (!verts.count(en[i])) {
+      if (!verts[en[i]]) {
         MeshEntity* v = m->createVert(0);
         m->setPoint(v, 0, nodes[en[i]]);
         verts[en[i]] = v;
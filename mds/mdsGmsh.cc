@@ -2,13 +2,14 @@
 #include "apfMDS.h"
 #include "apfMesh2.h"
 #include "apfShape.h"
-#include "gmi.h" /* this is for gmi_getline... */
 #include <lionPrint.h>
 
 #include <cstdio>
 #include <cstring>
 #include <pcu_util.h>
 #include <cstdlib>
+#include <algorithm>
+#include <vector>
 
 namespace {
 
@@ -46,61 +47,94 @@ struct Node {
   apf::Vector3 point;
 };
 
+/* the whole file is read into memory with one call and
+   parsed in place, which is much faster than a getline
+   and sscanf per line on large meshes */
 struct Reader {
   apf::Mesh2* mesh;
-  FILE* file;
+  std::vector<char> buffer;
   char* line;
   char* word;
-  size_t linecap;
   bool isQuadratic;
-  std::map<long, Node> nodeMap;
+  /* nodes in file order, their ids, and the order of
+     increasing ids when the ids are not consecutive */
+  std::vector<Node> nodes;
+  std::vector<long> nodeIds;
+  std::vector<long> sortedNodes;
+  long firstNodeId;
+  bool consecutiveNodeIds;
   std::map<long, apf::MeshEntity*> entMap[4];
 };
 
 void initReader(Reader* r, apf::Mesh2* m, const char* filename)
 {
   r->mesh = m;
-  r->file = fopen(filename, "r");
-  if (!r->file) {
+  FILE* file = fopen(filename, "rb");
+  if (!file) {
     lion_eprint(1,"couldn't open Gmsh file \"%s\"\n",filename);
     abort();
   }
-  r->line = static_cast<char*>(malloc(1));
-  r->line[0] = '\0';
-  r->linecap = 1;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  PCU_ALWAYS_ASSERT(size >= 0);
+  fseek(file, 0, SEEK_SET);
+  r->buffer.resize(size + 1);
+  size_t got = fread(&r->buffer[0], 1, size, file);
+  PCU_ALWAYS_ASSERT(got == (size_t)size);
+  r->buffer[size] = '\0';
+  fclose(file);
+  r->line = &r->buffer[0];
+  r->word = r->line;
   r->isQuadratic = false;
 }
 
+void rewindReader(Reader* r)
+{
+  r->line = &r->buffer[0];
+  r->word = r->line;
+}
+
 void freeReader(Reader* r)
 {
-  free(r->line);
-  fclose(r->file);
+  std::vector<char>().swap(r->buffer);
 }
 
 void getLine(Reader* r)
 {
-  ssize_t ret = gmi_getline(&r->line, &r->linecap, r->file);
-  PCU_ALWAYS_ASSERT(ret != -1);
+  char* end = strchr(r->line, '\n');
+  PCU_ALWAYS_ASSERT(end);
+  r->line = end + 1;
   r->word = r->line;
 }
 
 long getLong(Reader* r)
 {
-  long x;
-  int nchars;
-  int ret = sscanf(r->word, "%ld%n", &x, &nchars);
-  PCU_ALWAYS_ASSERT(ret == 1);
-  r->word += nchars;
+  char* c = r->word;
+  while (*c == ' ' || *c == '\t' || *c == '\r')
+    ++c;
+  bool negative = (*c == '-');
+  if (*c == '-' || *c == '+')
+    ++c;
+  PCU_ALWAYS_ASSERT('0' <= *c && *c <= '9');
+  long x = 0;
+  for (; '0' <= *c && *c <= '9'; ++c)
+    x = x * 10 + (*c - '0');
+  r->word = c;
+  return negative ? -x : x;
+}
+
+double getDouble(Reader* r)
+{
+  char* end;
+  double x = strtod(r->word, &end);
+  PCU_ALWAYS_ASSERT(end != r->word);
+  r->word = end;
   return x;
 }
 
 bool startsWith(char const* prefix, char const* s)
 {
-  int ls = strlen(s);
-  int lp = strlen(prefix);
-  if (ls < lp)
-    return false;
-  return strncmp(s, prefix, lp) == 0;
+  return strncmp(s, prefix, strlen(prefix)) == 0;
 }
 
 void seekMarker(Reader* r, char const* marker)
@@ -117,28 +151,68 @@ void checkMarker(Reader* r, char const* marker)
 
 void readNode(Reader* r)
 {
-  long id;
   Node n;
-  apf::Vector3& p = n.point;
-  sscanf(r->line, "%ld %lf %lf %lf", &id, &p[0], &p[1], &p[2]);
-  r->nodeMap[id] = n;
+  r->nodeIds.push_back(getLong(r));
+  for (int i = 0; i < 3; ++i)
+    n.point[i] = getDouble(r);
+  r->nodes.push_back(n);
   getLine(r);
 }
 
+struct IdLess {
+  IdLess(std::vector<long> const& i):ids(i) {}
+  bool operator()(long a, long id) const { return ids[a] < id; }
+  std::vector<long> const& ids;
+};
+
+struct IdOrder {
+  IdOrder(std::vector<long> const& i):ids(i) {}
+  bool operator()(long a, long b) const { return ids[a] < ids[b]; }
+  std::vector<long> const& ids;
+};
+
 void readNodes(Reader* r)
 {
   seekMarker(r, "$Nodes");
   long n = getLong(r);
   getLine(r);
+  r->nodes.reserve(n);
+  r->nodeIds.reserve(n);
   for (long i = 0; i < n; ++i)
     readNode(r);
   checkMarker(r, "$EndNodes");
+  r->firstNodeId = n ? r->nodeIds[0] : 0;
+  r->consecutiveNodeIds = true;
+  for (long i = 0; i < n; ++i)
+    if (r->nodeIds[i] != r->firstNodeId + i)
+      r->consecutiveNodeIds = false;
+  if (!r->consecutiveNodeIds) {
+    r->sortedNodes.resize(n);
+    for (long i = 0; i < n; ++i)
+      r->sortedNodes[i] = i;
+    std::sort(r->sortedNodes.begin(), r->sortedNodes.end(),
+        IdOrder(r->nodeIds));
+  }
+}
+
+Node& findNode(Reader* r, long nodeId)
+{
+  long i = nodeId - r->firstNodeId;
+  if (!r->consecutiveNodeIds) {
+    std::vector<long>::iterator it = std::lower_bound(
+        r->sortedNodes.begin(), r->sortedNodes.end(), nodeId,
+        IdLess(r->nodeIds));
+    PCU_ALWAYS_ASSERT(it != r->sortedNodes.end());
+    i = *it;
+  }
+  PCU_ALWAYS_ASSERT(0 <= i && i < (long)r->nodes.size());
+  PCU_ALWAYS_ASSERT(r->nodeIds[i] == nodeId);
+  return r->nodes[i];
 }
 
 apf::MeshEntity* lookupVert(Reader* r, long nodeId, apf::ModelEntity* g)
 {
-  PCU_ALWAYS_ASSERT(r->nodeMap.count(nodeId));
-  Node& n = r->nodeMap[nodeId];
+  Node& n = findNode(r, nodeId);
   if (n.entity)
     return n.entity;
   n.entity = r->mesh->createVert(g);
@@ -228,15 +302,15 @@ void readQuadraticElement(Reader* r)
     nids[i] = getLong(r);
   for (long i = 0; i < nedges; ++i) {
     long nid = nids[ getQuadGmshIdx(i, apfType) ];
-    apf::Vector3 point = r->nodeMap[nid].point;
+    apf::Vector3 point = findNode(r, nid).point;
     apf::setVector(coord, edges[i], 0, point);
   }
 }
 
-void readQuadratic(Reader* r, apf::Mesh2* m, const char* filename)
+void readQuadratic(Reader* r, apf::Mesh2* m)
 {
   m->changeShape(apf::getSerendipity());
-  initReader(r, m, filename);
+  rewindReader(r);
   seekMarker(r, "$Elements");
   long n = getLong(r);
   getLine(r);
@@ -245,7 +319,6 @@ void readQuadratic(Reader* r, apf::Mesh2* m, const char* filename)
     getLine(r);
   }
   checkMarker(r, "$EndElements");
-  freeReader(r);
 }
 
 void readGmsh(apf::Mesh2* m, const char* filename)
@@ -254,10 +327,10 @@ void readGmsh(apf::Mesh2* m, const char* filename)
   initReader(&r, m, filename);
   readNodes(&r);
   readElements(&r);
-  freeReader(&r);
   m->acceptChanges();
   if (r.isQuadratic)
-    readQuadratic(&r, m, filename);
+    readQuadratic(&r, m);
+  freeReader(&r);
 }
 
 }
@@ -3,12 +3,16 @@
 #include "apfMesh2.h"
 #include "pcu_io.h"
 #include "pcu_byteorder.h"
+#include <PCU.h>
 
 #include <cstdio>
 #include <cstring>
+#include <limits>
 #include <pcu_util.h>
 #include <lionPrint.h>
 #include <cstdlib>
+#include <vector>
+#include <apfConvert.h>
 
 /*
 read files in the AFLR3 format from Dave Marcum at Mississippi State
@@ -34,7 +38,7 @@ namespace {
   struct Reader {
     apf::Mesh2* mesh;
     FILE* file;
-    std::map<long, apf::MeshEntity*> nodeMap;
+    std::vector<apf::MeshEntity*> nodes;
     unsigned* faceVerts[2];
     unsigned* faceTags[2];
     bool swapBytes;
@@ -114,8 +118,8 @@ namespace {
 
   apf::MeshEntity* lookupVert(Reader* r, long ftnNodeId) {
     const long cNodeId = ftnToC(ftnNodeId);
-    PCU_ALWAYS_ASSERT(r->nodeMap.count(cNodeId));
-    return r->nodeMap[cNodeId];
+    PCU_ALWAYS_ASSERT(cNodeId >= 0 && (size_t)cNodeId < r->nodes.size());
+    return r->nodes[cNodeId];
   }
 
   void readNodes(Reader* r, header* h) {
@@ -123,11 +127,12 @@ namespace {
     size_t cnt = h->nvtx*dim;
     double* xyz = (double*) calloc(cnt,sizeof(double));
     readDoubles(r->file, xyz, cnt, r->swapBytes);
+    r->nodes.resize(h->nvtx);
     for(long id=0; id<h->nvtx; id++) {
       apf::Vector3 p;
       for(unsigned j=0; j<dim; j++)
         p[j] = xyz[id*dim+j];
-      r->nodeMap[id] = makeVtx(r,p,0);
+      r->nodes[id] = makeVtx(r,p,0);
     }
     free(xyz);
     lion_eprint(1, "read %d vtx\n", h->nvtx);
@@ -138,7 +143,7 @@ namespace {
     apf::MeshTag* t = m->createIntTag("ugrid-vtx-ids",1);
     for(long lid=0; lid<h->nvtx; lid++) {
       int iid = lid;
-      m->setIntTag(r->nodeMap[lid],t,&iid);
+      m->setIntTag(r->nodes[lid],t,&iid);
     }
   }
 
@@ -259,6 +264,87 @@ namespace {
     m->acceptChanges();
   }
 
+  /* the range of a block of n items read by this part */
+  void getShare(long n, long& first, long& count) {
+    const long peers = PCU_Comm_Peers();
+    const long self = PCU_Comm_Self();
+    first = n * self / peers;
+    count = n * (self + 1) / peers - first;
+  }
+
+  void seekTo(Reader* r, long offset) {
+    int err = fseek(r->file, offset, SEEK_SET);
+    PCU_ALWAYS_ASSERT(!err);
+  }
+
+  /* each part reads its share of every element block starting
+     at the byte offset of the block, so all parts read the file
+     at the same time and no part holds the whole mesh */
+  void readElmShares(Reader* r, header* h, long offset,
+      std::vector<apf::Gid>& conn, int nelms[4], int types[4]) {
+    const int type[4] = {apf::Mesh::TET, apf::Mesh::PYRAMID,
+      apf::Mesh::PRISM, apf::Mesh::HEX};
+    const long cnt[4] = {h->ntet, h->npyr, h->nprz, h->nhex};
+    std::vector<unsigned> vtx;
+    for(int i=0; i<4; i++) {
+      const unsigned nverts = apf::Mesh::adjacentCount[type[i]][0];
+      long first, count;
+      getShare(cnt[i], first, count);
+      vtx.resize(count * nverts);
+      seekTo(r, offset + first * nverts * sizeof(unsigned));
+      if (count)
+        readUnsigneds(r->file, &vtx[0], vtx.size(), r->swapBytes);
+      size_t start = conn.size();
+      conn.resize(start + vtx.size());
+      for(long e=0; e<count; e++)
+        for(unsigned j=0; j<nverts; j++)
+          conn[start + e*nverts + ugridToMdsElmIdx(type[i],j)] =
+            ftnToC(vtx[e*nverts+j]);
+      nelms[i] = count;
+      types[i] = type[i];
+      offset += cnt[i] * nverts * sizeof(unsigned);
+    }
+  }
+
+  void readDistributedUgrid(apf::Mesh2* m, const char* filename)
+  {
+    header hdr;
+    Reader r;
+    initReader(&r, m, filename);
+    readHeader(&r, &hdr);
+    if (!PCU_Comm_Self())
+      hdr.print();
+    const long coordsAt = 7 * sizeof(unsigned);
+    const long elmsAt = coordsAt + hdr.nvtx * 3 * sizeof(double) +
+      sizeof(unsigned) * (hdr.ntri * 3 + hdr.nquad * 4 +
+          (hdr.ntri + hdr.nquad));
+    std::vector<apf::Gid> conn;
+    int nelms[4];
+    int types[4];
+    readElmShares(&r, &hdr, elmsAt, conn, nelms, types);
+    apf::GlobalToVert globalToVert;
+    apf::construct(m, conn.empty() ? 0 : &conn[0], nelms, types, 4,
+        globalToVert);
+    std::vector<apf::Gid>().swap(conn);
+    long first, count;
+    getShare(hdr.nvtx, first, count);
+    std::vector<double> xyz(count * 3);
+    seekTo(&r, coordsAt + first * 3 * sizeof(double));
+    if (count)
+      readDoubles(r.file, &xyz[0], xyz.size(), r.swapBytes);
+    apf::setCoords(m, xyz.empty() ? 0 : &xyz[0], count, globalToVert);
+    /* readers of this tag take it as an int, as the serial loader
+       sets it, so the ids of a file this large must fit */
+    apf::MeshTag* t = m->createIntTag("ugrid-vtx-ids",1);
+    APF_ITERATE(apf::GlobalToVert, globalToVert, it) {
+      PCU_ALWAYS_ASSERT(it->first <= std::numeric_limits<int>::max());
+      int iid = it->first;
+      m->setIntTag(it->second, t, &iid);
+    }
+    freeReader(&r);
+    apf::alignMdsRemotes(m);
+  }
+
   void getMaxAndAvg(std::set<int>*& cnt, int numparts, int& max, double& avg) {
     for(int i=0; i<numparts; i++) {
       avg += cnt[i].size();
@@ -414,6 +500,20 @@ namespace apf {
         m->count(0), m->count(1), m->count(2), m->count(3));
     return m;
   }
+  Mesh2* loadMdsDistributedFromUgrid(gmi_model* g, const char* filename)
+  {
+    double t0 = PCU_Time();
+    Mesh2* m = makeEmptyMdsMesh(g, 3, false);
+    readDistributedUgrid(m, filename);
+    long n[4];
+    for (int d = 0; d < 4; ++d)
+      n[d] = countOwned(m, d);
+    PCU_Add_Longs(n, 4);
+    if (!PCU_Comm_Self())
+      lion_eprint(1,"vtx %ld edge %ld face %ld rgn %ld read in %f seconds\n",
+          n[0], n[1], n[2], n[3], PCU_Time() - t0);
+    return m;
+  }
   void printUgridPtnStats(gmi_model* g, const char* ufile, const char* vtxptn,
       const double elmWeights[]) {
     Mesh2* m = makeEmptyMdsMesh(g, 0, false);
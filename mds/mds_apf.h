@@ -54,9 +54,19 @@ void mds_apf_destroy_entity(struct mds_apf* m, mds_id e);
 void* mds_get_part(struct mds_apf* m, mds_id e);
 void mds_set_part(struct mds_apf* m, mds_id e, void* p);
 
+enum {
+  MDS_HILBERT,
+  MDS_MORTON
+};
+
 struct mds_tag* mds_number_verts_bfs(struct mds_apf* m);
+struct mds_tag* mds_number_verts_rcm(struct mds_apf* m);
+struct mds_tag* mds_number_verts_sfc(struct mds_apf* m, int curve);
+void mds_number_elems_rcm(struct mds_apf* m, struct mds_tag* tag);
+void mds_number_elems_sfc(struct mds_apf* m, struct mds_tag* tag, int curve);
 struct mds_apf* mds_reorder(struct mds_apf* m, int ignore_peers,
     struct mds_tag* vert_numbers);
+void mds_apf_compact(struct mds_apf* m, struct mds_tag* numbers);
 
 struct gmi_ent* mds_find_model(struct mds_apf* m, int dim, int id);
 int mds_model_dim(struct mds_apf* m, struct gmi_ent* model);
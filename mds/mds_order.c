@@ -13,6 +13,7 @@
 #include <pcu_util.h>
 #include <string.h>
 #include <limits.h>
+#include <float.h>
 #include <PCU.h>
 
 struct queue {
@@ -134,6 +135,295 @@ struct mds_tag* mds_number_verts_bfs(struct mds_apf* m)
   return tag;
 }
 
+static int dim_count(struct mds* m, int dim)
+{
+  int type;
+  int n = 0;
+  for (type = 0; type < MDS_TYPES; ++type)
+    if (mds_dim[type] == dim)
+      n += m->n[type];
+  return n;
+}
+
+/* vertices neighbor through edges, other entities
+   neighbor through their sides */
+static void get_neighbors(struct mds* m, mds_id e, struct mds_set* s)
+{
+  int dim;
+  int i, j;
+  struct mds_set sides;
+  struct mds_set up;
+  dim = mds_dim[mds_type(e)];
+  s->n = 0;
+  if (dim == 0) {
+    mds_get_adjacent(m, e, 1, &sides);
+    for (i = 0; i < sides.n; ++i)
+      s->e[s->n++] = other_vert(m, sides.e[i], e);
+    return;
+  }
+  mds_get_adjacent(m, e, dim - 1, &sides);
+  for (i = 0; i < sides.n; ++i) {
+    mds_get_adjacent(m, sides.e[i], dim, &up);
+    for (j = 0; j < up.n; ++j)
+      if (up.e[j] != e)
+        s->e[s->n++] = up.e[j];
+  }
+}
+
+static int count_neighbors(struct mds* m, mds_id e)
+{
+  struct mds_set s;
+  get_neighbors(m, e, &s);
+  return s.n;
+}
+
+static void sort_by_degree(struct mds* m, struct mds_set* s)
+{
+  int deg[MDS_SET_MAX];
+  int i, j;
+  int d;
+  mds_id e;
+  for (i = 0; i < s->n; ++i)
+    deg[i] = count_neighbors(m, s->e[i]);
+  for (i = 1; i < s->n; ++i) {
+    e = s->e[i];
+    d = deg[i];
+    for (j = i; j > 0 && deg[j - 1] > d; --j) {
+      s->e[j] = s->e[j - 1];
+      deg[j] = deg[j - 1];
+    }
+    s->e[j] = e;
+    deg[j] = d;
+  }
+}
+
+static mds_id find_min_degree(struct mds* m, int dim)
+{
+  mds_id e;
+  mds_id best = MDS_NONE;
+  int d;
+  int best_d = INT_MAX;
+  for (e = mds_begin(m, dim); e != MDS_NONE; e = mds_next(m, e)) {
+    d = count_neighbors(m, e);
+    if (d < best_d) {
+      best_d = d;
+      best = e;
+    }
+  }
+  return best;
+}
+
+static void number_connected_cm(struct mds* m, mds_id e,
+    struct mds_tag* tag, int label[MDS_TYPES], struct queue* q)
+{
+  struct mds_set adj;
+  int i;
+  if (!visit(m, tag, &label[mds_type(e)], e))
+    return;
+  push_queue(q, e);
+  while ( ! queue_empty(q)) {
+    e = pop_queue(q);
+    get_neighbors(m, e, &adj);
+    sort_by_degree(m, &adj);
+    for (i = 0; i < adj.n; ++i)
+      if (visit(m, tag, &label[mds_type(adj.e[i])], adj.e[i]))
+        push_queue(q, adj.e[i]);
+  }
+}
+
+/* Cuthill-McKee from a minimum degree seed,
+   then reversed within each type */
+static void number_dim_rcm(struct mds* m, struct mds_tag* tag, int dim)
+{
+  struct queue q;
+  int label[MDS_TYPES] = {0};
+  mds_id e;
+  int* ip;
+  make_queue(&q, dim_count(m, dim));
+  e = find_min_degree(m, dim);
+  if (e != MDS_NONE)
+    number_connected_cm(m, e, tag, label, &q);
+  for (e = mds_begin(m, dim); e != MDS_NONE; e = mds_next(m, e))
+    number_connected_cm(m, e, tag, label, &q);
+  free_queue(&q);
+  for (e = mds_begin(m, dim); e != MDS_NONE; e = mds_next(m, e)) {
+    PCU_ALWAYS_ASSERT(label[mds_type(e)] == m->n[mds_type(e)]);
+    ip = mds_get_tag(tag, e);
+    *ip = m->n[mds_type(e)] - 1 - *ip;
+  }
+}
+
+struct mds_tag* mds_number_verts_rcm(struct mds_apf* m)
+{
+  struct mds_tag* tag;
+  PCU_ALWAYS_ASSERT(m->mds.n[MDS_VERTEX] < INT_MAX);
+  tag = mds_create_tag(&m->tags, "mds_number", sizeof(int), mds_apf_int);
+  number_dim_rcm(&m->mds, tag, 0);
+  return tag;
+}
+
+void mds_number_elems_rcm(struct mds_apf* m, struct mds_tag* tag)
+{
+  number_dim_rcm(&m->mds, tag, m->mds.d);
+}
+
+#define SFC_BITS 21
+
+struct sfc_item {
+  unsigned long long key;
+  mds_id e;
+};
+
+static int compare_sfc_items(const void* a, const void* b)
+{
+  unsigned long long ka = ((struct sfc_item const*)a)->key;
+  unsigned long long kb = ((struct sfc_item const*)b)->key;
+  if (ka < kb)
+    return -1;
+  if (ka > kb)
+    return 1;
+  return 0;
+}
+
+static void get_centroid(struct mds_apf* m, mds_id e, double x[3])
+{
+  struct mds_set vs;
+  double* p;
+  int i, j;
+  if (mds_type(e) == MDS_VERTEX) {
+    p = mds_apf_point(m, e);
+    for (j = 0; j < 3; ++j)
+      x[j] = p[j];
+    return;
+  }
+  mds_get_adjacent(&m->mds, e, 0, &vs);
+  x[0] = x[1] = x[2] = 0;
+  for (i = 0; i < vs.n; ++i) {
+    p = mds_apf_point(m, vs.e[i]);
+    for (j = 0; j < 3; ++j)
+      x[j] += p[j];
+  }
+  for (j = 0; j < 3; ++j)
+    x[j] /= vs.n;
+}
+
+static void get_box(struct mds_apf* m, double lo[3], double hi[3])
+{
+  mds_id v;
+  double* p;
+  int j;
+  for (j = 0; j < 3; ++j) {
+    lo[j] = DBL_MAX;
+    hi[j] = -DBL_MAX;
+  }
+  for (v = mds_begin(&m->mds, 0); v != MDS_NONE; v = mds_next(&m->mds, v)) {
+    p = mds_apf_point(m, v);
+    for (j = 0; j < 3; ++j) {
+      if (p[j] < lo[j])
+        lo[j] = p[j];
+      if (p[j] > hi[j])
+        hi[j] = p[j];
+    }
+  }
+}
+
+static unsigned long long interleave(unsigned x[3])
+{
+  unsigned long long key = 0;
+  int b, j;
+  for (b = SFC_BITS - 1; b >= 0; --b)
+    for (j = 0; j < 3; ++j)
+      key = (key << 1) | ((x[j] >> b) & 1);
+  return key;
+}
+
+/* J. Skilling, "Programming the Hilbert curve",
+   AIP Conf. Proc. 707, 381 (2004) */
+static unsigned long long hilbert_key(unsigned x[3])
+{
+  unsigned const top = 1u << (SFC_BITS - 1);
+  unsigned p, q, t;
+  int j;
+  for (q = top; q > 1; q >>= 1) {
+    p = q - 1;
+    for (j = 0; j < 3; ++j) {
+      if (x[j] & q) {
+        x[0] ^= p;
+      } else {
+        t = (x[0] ^ x[j]) & p;
+        x[0] ^= t;
+        x[j] ^= t;
+      }
+    }
+  }
+  for (j = 1; j < 3; ++j)
+    x[j] ^= x[j - 1];
+  t = 0;
+  for (q = top; q > 1; q >>= 1)
+    if (x[2] & q)
+      t ^= q - 1;
+  for (j = 0; j < 3; ++j)
+    x[j] ^= t;
+  return interleave(x);
+}
+
+static unsigned long long sfc_key(double const x[3],
+    double const lo[3], double const hi[3], int curve)
+{
+  unsigned const max = (1u << SFC_BITS) - 1;
+  unsigned q[3];
+  int j;
+  for (j = 0; j < 3; ++j) {
+    if (hi[j] > lo[j])
+      q[j] = (unsigned)((x[j] - lo[j]) / (hi[j] - lo[j]) * max);
+    else
+      q[j] = 0;
+  }
+  if (curve == MDS_HILBERT)
+    return hilbert_key(q);
+  return interleave(q);
+}
+
+static void number_dim_sfc(struct mds_apf* m, struct mds_tag* tag,
+    int dim, int curve)
+{
+  struct sfc_item* items;
+  int label[MDS_TYPES] = {0};
+  double lo[3], hi[3], x[3];
+  mds_id e;
+  int n, i;
+  n = dim_count(&m->mds, dim);
+  items = malloc(n * sizeof(*items));
+  get_box(m, lo, hi);
+  i = 0;
+  for (e = mds_begin(&m->mds, dim);
+       e != MDS_NONE;
+       e = mds_next(&m->mds, e)) {
+    get_centroid(m, e, x);
+    items[i].key = sfc_key(x, lo, hi, curve);
+    items[i].e = e;
+    ++i;
+  }
+  qsort(items, n, sizeof(*items), compare_sfc_items);
+  for (i = 0; i < n; ++i)
+    visit(&m->mds, tag, &label[mds_type(items[i].e)], items[i].e);
+  free(items);
+}
+
+struct mds_tag* mds_number_verts_sfc(struct mds_apf* m, int curve)
+{
+  struct mds_tag* tag;
+  PCU_ALWAYS_ASSERT(m->mds.n[MDS_VERTEX] < INT_MAX);
+  tag = mds_create_tag(&m->tags, "mds_number", sizeof(int), mds_apf_int);
+  number_dim_sfc(m, tag, 0, curve);
+  return tag;
+}
+
+void mds_number_elems_sfc(struct mds_apf* m, struct mds_tag* tag, int curve)
+{
+  number_dim_sfc(m, tag, m->mds.d, curve);
+}
+
 static mds_id* sort_verts(struct mds_apf* m, struct mds_tag* tag)
 {
   mds_id v;
@@ -165,13 +455,22 @@ static void number_ents_of_type(struct mds* m,
   }
 }
 
+/* callers may number a whole dimension themselves,
+   see mds_number_elems_rcm and mds_number_elems_sfc */
+static int is_numbered(struct mds* m, struct mds_tag* tag, int dim)
+{
+  mds_id e = mds_begin(m, dim);
+  return e != MDS_NONE && mds_has_tag(tag, e);
+}
+
 static void number_other_ents(struct mds_apf* m, struct mds_tag* tag)
 {
   mds_id* sorted_verts;
   int type;
   sorted_verts = sort_verts(m, tag);
   for (type = MDS_VERTEX + 1; type < MDS_TYPES; ++type)
-    number_ents_of_type(&m->mds, sorted_verts, tag, type);
+    if (!is_numbered(&m->mds, tag, mds_dim[type]))
+      number_ents_of_type(&m->mds, sorted_verts, tag, type);
   free(sorted_verts);
 }
 
@@ -416,3 +715,155 @@ struct mds_apf* mds_reorder(struct mds_apf* m, int ignore_peers,
   mds_apf_destroy(m);
   return m2;
 }
+
+static void map_from_tag(struct mds* m, struct mds_tag* tag,
+    mds_id* new_of[MDS_TYPES])
+{
+  int t;
+  mds_id i;
+  for (t = 0; t < MDS_TYPES; ++t) {
+    new_of[t] = malloc(m->end[t] * sizeof(mds_id));
+    for (i = 0; i < m->end[t]; ++i)
+      if (m->free[t][i] == MDS_LIVE)
+        new_of[t][i] = *((int*)mds_get_tag(tag, mds_identify(t, i)));
+      else
+        new_of[t][i] = MDS_NONE;
+  }
+}
+
+struct compact_reply {
+  int p;
+  mds_id e;
+  int j;
+  mds_id ne;
+};
+
+/* each copy asks the part holding its counterpart for the new id of
+   that counterpart. asking, rather than announcing the new ids to the
+   copies, also works for nets where only one side points to the other,
+   like pumi ghosts */
+static void compact_net(struct mds_net* net, struct mds* m,
+    mds_id* new_of[MDS_TYPES])
+{
+  int t;
+  mds_id i;
+  int j;
+  mds_id e;
+  mds_id ce;
+  mds_id ne;
+  int n = 0;
+  int cap = 0;
+  struct compact_reply* replies = NULL;
+  struct mds_copies* cs;
+  PCU_Comm_Begin();
+  for (t = 0; t < MDS_TYPES; ++t) {
+    if (!net->data[t])
+      continue;
+    for (i = 0; i < m->end[t]; ++i) {
+      cs = net->data[t][i];
+      if (!cs)
+        continue;
+      e = mds_identify(t, i);
+      for (j = 0; j < cs->n; ++j) {
+        PCU_COMM_PACK(cs->c[j].p, cs->c[j].e);
+        PCU_COMM_PACK(cs->c[j].p, e);
+        PCU_COMM_PACK(cs->c[j].p, j);
+      }
+    }
+  }
+  PCU_Comm_Send();
+  while (PCU_Comm_Receive()) {
+    PCU_COMM_UNPACK(ce);
+    PCU_COMM_UNPACK(e);
+    PCU_COMM_UNPACK(j);
+    if (n == cap) {
+      cap = cap ? 2 * cap : 64;
+      replies = realloc(replies, cap * sizeof(*replies));
+    }
+    replies[n].p = PCU_Comm_Sender();
+    replies[n].e = e;
+    replies[n].j = j;
+    t = mds_type(ce);
+    PCU_ALWAYS_ASSERT(new_of[t][mds_index(ce)] != MDS_NONE);
+    replies[n].ne = mds_identify(t, new_of[t][mds_index(ce)]);
+    ++n;
+  }
+  PCU_Comm_Begin();
+  for (i = 0; i < n; ++i) {
+    PCU_COMM_PACK(replies[i].p, replies[i].e);
+    PCU_COMM_PACK(replies[i].p, replies[i].j);
+    PCU_COMM_PACK(replies[i].p, replies[i].ne);
+  }
+  free(replies);
+  PCU_Comm_Send();
+  while (PCU_Comm_Receive()) {
+    PCU_COMM_UNPACK(e);
+    PCU_COMM_UNPACK(j);
+    PCU_COMM_UNPACK(ne);
+    cs = mds_get_copies(net, e);
+    PCU_ALWAYS_ASSERT(cs && j < cs->n);
+    cs->c[j].e = ne;
+  }
+  for (t = 0; t < MDS_TYPES; ++t) {
+    if (!net->data[t])
+      continue;
+    mds_permute(net->data[t], sizeof(struct mds_copies*),
+        m->end[t], new_of[t]);
+    for (i = m->n[t]; i < m->end[t]; ++i)
+      net->data[t][i] = NULL;
+  }
+}
+
+static void compact_tag(struct mds_tag* tag, struct mds* m,
+    mds_id* new_of[MDS_TYPES])
+{
+  int t;
+  mds_id i;
+  mds_id ni;
+  unsigned char* has;
+  for (t = 0; t < MDS_TYPES; ++t) {
+    if (!tag->has[t])
+      continue;
+    mds_permute(tag->data[t], tag->bytes, m->end[t], new_of[t]);
+    has = calloc(m->cap[t] / 8 + 1, 1);
+    for (i = 0; i < m->end[t]; ++i) {
+      ni = new_of[t][i];
+      if (ni != MDS_NONE && (tag->has[t][i / 8] & (1 << (i % 8))))
+        has[ni / 8] |= (1 << (ni % 8));
+    }
+    free(tag->has[t]);
+    tag->has[t] = has;
+  }
+}
+
+void mds_apf_compact(struct mds_apf* m, struct mds_tag* numbers)
+{
+  mds_id* new_of[MDS_TYPES];
+  struct mds_tag* tag;
+  int t;
+  if (numbers) {
+    number_other_ents(m, numbers);
+    map_from_tag(&m->mds, numbers, new_of);
+    mds_destroy_tag(&m->tags, numbers);
+  } else {
+    mds_compact_map(&m->mds, new_of);
+  }
+  compact_net(&m->remotes, &m->mds, new_of);
+  compact_net(&m->ghosts, &m->mds, new_of);
+  compact_net(&m->matches, &m->mds, new_of);
+  for (tag = m->tags.first; tag; tag = tag->next)
+    compact_tag(tag, &m->mds, new_of);
+  mds_permute(m->point, sizeof(*(m->point)),
+      m->mds.end[MDS_VERTEX], new_of[MDS_VERTEX]);
+  mds_permute(m->param, sizeof(*(m->param)),
+      m->mds.end[MDS_VERTEX], new_of[MDS_VERTEX]);
+  for (t = 0; t < MDS_TYPES; ++t) {
+    mds_permute(m->model[t], sizeof(*(m->model[t])),
+        m->mds.end[t], new_of[t]);
+    mds_permute(m->parts[t], sizeof(*(m->parts[t])),
+        m->mds.end[t], new_of[t]);
+  }
+  mds_compact(&m->mds, new_of);
+  for (t = 0; t < MDS_TYPES; ++t)
+    free(new_of[t]);
+}
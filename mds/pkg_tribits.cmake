@@ -16,6 +16,7 @@ set(MDS_SOURCES
   mds_smb.c
   mds_tag.c
   apfMDS.cc
+  apfMDSArrays.cc
   apfPM.cc
   apfBox.cc
   mdsANSYS.cc
@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include <apfMesh2.h>
+#include <apfMDS.h>
 #include <apfNumbering.h>
 #include <apfShape.h>
 #include <PCU.h>
@@ -112,6 +113,77 @@ static void matrices_from_osh(
   }
 }
 
+/* compact MDS meshes (see apf::hasMdsArrays) move tag-backed
+   fields, coordinates, classification and connectivity as whole
+   arrays instead of visiting every entity through apf */
+
+static apf::MeshTag* field_tag(apf::Field* f, int ent_dim) {
+  static char const* const postfix[4] = {"_ver", "_edg", "_tri", "_tet"};
+  if (apf::isFrozen(f)) return nullptr;
+  std::string name = apf::getName(f);
+  return apf::getMesh(f)->findTag((name + postfix[ent_dim]).c_str());
+}
+
+/* apf keeps 3 components per vector and 9 per matrix, row by row */
+static void pack_to_osh(int value_type, int dim, int nc,
+    std::vector<double> const& raw, osh::HostWrite<osh::Real> data) {
+  auto n = data.size() / nc;
+  for (osh::LO i = 0; i < n; ++i) {
+    if (value_type == apf::VECTOR) {
+      for (int j = 0; j < dim; ++j) data[i * dim + j] = raw[i * 3 + j];
+    } else if (value_type == apf::MATRIX) {
+      for (int j = 0; j < dim; ++j)
+        for (int k = 0; k < dim; ++k)
+          data[i * dim * dim + k * dim + j] = raw[i * 9 + j * 3 + k];
+    } else {
+      for (int j = 0; j < nc; ++j) data[i * nc + j] = raw[i * nc + j];
+    }
+  }
+}
+
+static void unpack_from_osh(int value_type, int dim, int nc,
+    osh::HostRead<osh::Real> data, std::vector<double>& raw) {
+  auto n = data.size() / nc;
+  for (osh::LO i = 0; i < n; ++i) {
+    if (value_type == apf::VECTOR) {
+      for (int j = 0; j < 3; ++j)
+        raw[i * 3 + j] = (j < dim) ? data[i * dim + j] : 0;
+    } else if (value_type == apf::MATRIX) {
+      for (int j = 0; j < 3; ++j)
+        for (int k = 0; k < 3; ++k)
+          raw[i * 9 + j * 3 + k] = (j < dim && k < dim) ?
+            data[i * dim * dim + k * dim + j] : 0;
+    } else {
+      for (int j = 0; j < nc; ++j) raw[i * nc + j] = data[i * nc + j];
+    }
+  }
+}
+
+static bool field_to_osh_arrays(apf::Field* f, int ent_dim, int nc,
+    osh::HostWrite<osh::Real> data) {
+  auto am = static_cast<apf::Mesh2*>(apf::getMesh(f));
+  if (!apf::hasMdsArrays(am)) return false;
+  auto tag = field_tag(f, ent_dim);
+  if (!tag) return false;
+  std::vector<double> raw(am->count(ent_dim) * apf::countComponents(f));
+  if (!apf::getMdsTagArray(am, tag, ent_dim, raw.data())) return false;
+  pack_to_osh(apf::getValueType(f), am->getDimension(), nc, raw, data);
+  return true;
+}
+
+static bool field_from_osh_arrays(apf::Field* f,
+    osh::Tag<osh::Real> const* tag, int ent_dim) {
+  auto am = static_cast<apf::Mesh2*>(apf::getMesh(f));
+  if (!apf::hasMdsArrays(am)) return false;
+  auto ftag = field_tag(f, ent_dim);
+  if (!ftag) return false;
+  std::vector<double> raw(am->count(ent_dim) * apf::countComponents(f));
+  unpack_from_osh(apf::getValueType(f), am->getDimension(), tag->ncomps(),
+      osh::HostRead<osh::Real>(tag->array()), raw);
+  apf::setMdsTagArray(am, ftag, ent_dim, raw.data());
+  return true;
+}
+
 static void field_to_osh(osh::Mesh* om, apf::Field* f) {
   auto dim = om->dim();
   auto am = apf::getMesh(f);
@@ -140,6 +212,10 @@ static void field_to_osh(osh::Mesh* om, apf::Field* f) {
     nc = apf::countComponents(f);
   }
   auto data = osh::HostWrite<osh::Real>(om->nents(ent_dim) * nc);
+  if (field_to_osh_arrays(f, ent_dim, nc, data)) {
+    om->add_tag(ent_dim, name, nc, osh::Reals(data.write()));
+    return;
+  }
   auto it = am->begin(ent_dim);
   if (vt == apf::VECTOR) {
     vectors_to_osh(f, it, data);
@@ -153,6 +229,7 @@ static void field_to_osh(osh::Mesh* om, apf::Field* f) {
 
 static void field_from_osh(apf::Field* f, osh::Tag<osh::Real> const* tag,
     int ent_dim) {
+  if (field_from_osh_arrays(f, tag, ent_dim)) return;
   auto am = apf::getMesh(f);
   auto dim = am->getDimension();
   auto data = osh::HostRead<osh::Real>(tag->array());
@@ -160,7 +237,7 @@ static void field_from_osh(apf::Field* f, osh::Tag<osh::Real> const* tag,
   apf::MeshIterator* it = am->begin(ent_dim);
   if (value_type == apf::VECTOR) {
     vectors_from_osh(f, it, data);
-  } if (value_type == apf::MATRIX) {
+  } else if (value_type == apf::MATRIX) {
     if (dim == 2) matrices_from_osh<2>(f, it, data);
     if (dim == 3) matrices_from_osh<3>(f, it, data);
   } else components_from_osh(f, it, data);
@@ -213,18 +290,46 @@ static void fields_from_osh(apf::Mesh* am, osh::Mesh* om) {
 }
 
 static void coords_to_osh(osh::Mesh* om, apf::Mesh* am) {
-  field_to_osh(om, am->getCoordinateField());
+  if (!apf::hasMdsArrays(am)) {
+    field_to_osh(om, am->getCoordinateField());
+    return;
+  }
+  auto dim = am->getDimension();
+  auto nverts = osh::LO(am->count(0));
+  std::vector<double> x(nverts * 3);
+  apf::getMdsCoordinates(static_cast<apf::Mesh2*>(am), x.data());
+  osh::HostWrite<osh::Real> host_coords(nverts * dim);
+  pack_to_osh(apf::VECTOR, dim, dim, x, host_coords);
+  om->add_tag(0, "coordinates", dim, osh::Reals(host_coords.write()));
 }
 
-static void coords_from_osh(apf::Mesh* am, osh::Mesh* om) {
-  field_from_osh(am->getCoordinateField(),
-      om->get_tag<osh::Real>(0, "coordinates"), 0);
+static void coords_from_osh(apf::Mesh2* am, osh::Mesh* om) {
+  auto tag = om->get_tag<osh::Real>(0, "coordinates");
+  if (!apf::hasMdsArrays(am) || osh::LO(am->count(0)) != om->nverts()) {
+    field_from_osh(am->getCoordinateField(), tag, 0);
+    return;
+  }
+  std::vector<double> x(am->count(0) * 3);
+  unpack_from_osh(apf::VECTOR, om->dim(), om->dim(),
+      osh::HostRead<osh::Real>(tag->array()), x);
+  apf::setMdsCoordinates(am, x.data());
 }
 
 static void class_to_osh(osh::Mesh* mesh_osh, apf::Mesh* mesh_apf, int dim) {
   auto nents = osh::LO(mesh_apf->count(dim));
   auto host_class_id = osh::HostWrite<osh::LO>(nents);
   auto host_class_dim = osh::HostWrite<osh::I8>(nents);
+  if (apf::hasMdsArrays(mesh_apf)) {
+    std::vector<int> class_dim(nents);
+    apf::getMdsClassification(static_cast<apf::Mesh2*>(mesh_apf), dim,
+        class_dim.data(), host_class_id.data());
+    for (osh::LO i = 0; i < nents; ++i)
+      host_class_dim[i] = osh::I8(class_dim[i]);
+    mesh_osh->add_tag(dim, "class_dim", 1,
+        osh::Read<osh::I8>(host_class_dim.write()));
+    mesh_osh->add_tag(dim, "class_id", 1, osh::LOs(host_class_id.write()));
+    return;
+  }
   auto iter = mesh_apf->begin(dim);
   apf::MeshEntity* e;
   int i = 0;
@@ -244,19 +349,25 @@ static void conn_to_osh(osh::Mesh* mesh_osh, apf::Mesh* mesh_apf,
   auto nhigh = osh::LO(mesh_apf->count(d));
   auto deg = d + 1;
   osh::HostWrite<osh::LO> host_ev2v(nhigh * deg);
-  auto iter = mesh_apf->begin(d);
-  apf::MeshEntity* he;
-  int i = 0;
-  while ((he = mesh_apf->iterate(iter))) {
-    apf::Downward eev;
-    auto deg2 = mesh_apf->getDownward(he, 0, eev);
-    OMEGA_H_CHECK(deg == deg2);
-    for (int j = 0; j < deg; ++j) {
-      host_ev2v[i * deg + j] = apf::getNumber(vert_nums, eev[j], 0, 0);
+  if (apf::hasMdsArrays(mesh_apf)) {
+    /* MDS indices follow iteration order, like vert_nums */
+    apf::getMdsDownward(static_cast<apf::Mesh2*>(mesh_apf), d, 0,
+        host_ev2v.data());
+  } else {
+    auto iter = mesh_apf->begin(d);
+    apf::MeshEntity* he;
+    int i = 0;
+    while ((he = mesh_apf->iterate(iter))) {
+      apf::Downward eev;
+      auto deg2 = mesh_apf->getDownward(he, 0, eev);
+      OMEGA_H_CHECK(deg == deg2);
+      for (int j = 0; j < deg; ++j) {
+        host_ev2v[i * deg + j] = apf::getNumber(vert_nums, eev[j], 0, 0);
+      }
+      ++i;
     }
-    ++i;
+    mesh_apf->end(iter);
   }
-  mesh_apf->end(iter);
   auto ev2v = osh::LOs(host_ev2v.write());
   osh::Adj high2low;
   if (d == 1) {
@@ -271,6 +382,17 @@ static void conn_to_osh(osh::Mesh* mesh_osh, apf::Mesh* mesh_apf,
 
 static void globals_to_osh(
     osh::Mesh* mesh_osh, apf::Mesh* mesh_apf, int dim) {
+  if (PCU_Comm_Peers() == 1) {
+    /* one part owns everything in iteration order */
+    auto nents = osh::LO(mesh_apf->count(dim));
+    osh::HostWrite<osh::GO> host_globals(nents);
+    for (osh::LO i = 0; i < nents; ++i) host_globals[i] = i;
+    auto globals = osh::Read<osh::GO>(host_globals.write());
+    mesh_osh->add_tag(dim, "global", 1, globals);
+    mesh_osh->set_owners(dim, osh::owners_from_globals(
+          mesh_osh->comm(), globals, osh::Read<osh::I32>()));
+    return;
+  }
   apf::GlobalNumbering* globals_apf = apf::makeGlobal(
       apf::numberOwnedDimension(mesh_apf, "smb2osh_global", dim));
   apf::synchronize(globals_apf);
@@ -306,13 +428,15 @@ void to_omega_h(osh::Mesh* om, apf::Mesh* am) {
   coords_to_osh(om, am);
   class_to_osh(om, am, 0);
   globals_to_osh(om, am, 0);
-  auto vert_nums = apf::numberOverlapDimension(am, "apf2osh", 0);
+  apf::Numbering* vert_nums = nullptr;
+  if (!apf::hasMdsArrays(am))
+    vert_nums = apf::numberOverlapDimension(am, "apf2osh", 0);
   for (int d = 1; d <= dim; ++d) {
     conn_to_osh(om, am, vert_nums, d);
     class_to_osh(om, am, d);
     globals_to_osh(om, am, d);
   }
-  apf::destroyNumbering(vert_nums);
+  if (vert_nums) apf::destroyNumbering(vert_nums);
   fields_to_osh(om, am);
 }
 
@@ -440,15 +564,73 @@ static void owners_from_osh(
   }
 }
 
+/* MDS derives the vertices of a simplex from its sides, so an
+   element built from the Omega_h side array has the Omega_h vertex
+   order only if both order the sides of a simplex the same way.
+   otherwise elements could come out inverted, so compare them */
+static void check_verts_from_osh(apf::Mesh2* am, osh::Mesh* om,
+    std::vector<apf::MeshEntity*> const& elems) {
+  auto dim = om->dim();
+  auto ev2v = osh::HostRead<osh::LO>(om->ask_verts_of(dim));
+  for (size_t i = 0; i < elems.size(); ++i) {
+    apf::Downward v;
+    int nv = am->getDownward(elems[i], 0, v);
+    OMEGA_H_CHECK(nv == dim + 1);
+    for (int j = 0; j < nv; ++j)
+      if (apf::getMdsIndex(am, v[j]) != ev2v[i * nv + j])
+        apf::fail("from_omega_h: element vertices out of Omega_h order\n");
+  }
+}
+
+/* Omega_h orders the downward adjacencies of simplices like apf,
+   so each dimension is created from its downward array. the
+   entities get their classification as they are created */
+static std::vector<apf::MeshEntity*>
+ents_from_osh_arrays(apf::Mesh2* am, osh::Mesh* om, int ent_dim) {
+  auto n = om->nents(ent_dim);
+  auto class_dim = osh::HostRead<osh::I8>(
+      om->get_array<osh::I8>(ent_dim, "class_dim"));
+  auto class_id = osh::HostRead<osh::LO>(
+      om->get_array<osh::LO>(ent_dim, "class_id"));
+  std::vector<int> model_dim(n);
+  std::vector<int> model_tag(n);
+  for (osh::LO i = 0; i < n; ++i) {
+    model_dim[i] = class_dim[i];
+    model_tag[i] = class_id[i];
+  }
+  std::vector<int> down;
+  if (ent_dim) {
+    auto ab2b = osh::HostRead<osh::LO>(
+        om->ask_down(ent_dim, ent_dim - 1).ab2b);
+    down.resize(ab2b.size());
+    for (osh::LO i = 0; i < ab2b.size(); ++i) down[i] = ab2b[i];
+  }
+  apf::createMdsEntities(am, ent_dim, n, down.data(),
+      model_dim.data(), model_tag.data());
+  std::vector<apf::MeshEntity*> ents(n);
+  for (osh::LO i = 0; i < n; ++i)
+    ents[i] = apf::getMdsEntity(am, ent_dim, i);
+  if (ent_dim == om->dim())
+    check_verts_from_osh(am, om, ents);
+  return ents;
+}
+
 void from_omega_h(apf::Mesh2* am, osh::Mesh* om)
 {
   std::vector<apf::MeshEntity*> ents[4];
-  ents[0] = verts_from_osh(am, om);
-  for (int d = 1; d <= om->dim(); ++d)
-    ents[d] = ents_from_osh(am, om, ents[0], d);
+  bool arrays = apf::hasMdsArrays(am) && !am->count(0);
+  if (arrays) {
+    for (int d = 0; d <= om->dim(); ++d)
+      ents[d] = ents_from_osh_arrays(am, om, d);
+  } else {
+    ents[0] = verts_from_osh(am, om);
+    for (int d = 1; d <= om->dim(); ++d)
+      ents[d] = ents_from_osh(am, om, ents[0], d);
+  }
   coords_from_osh(am, om);
   for (int d = 0; d <= om->dim(); ++d) {
-    class_from_osh(am, om, ents[d], d);
+    if (!arrays)
+      class_from_osh(am, om, ents[d], d);
     owners_from_osh(am, om, ents[d], d);
     apf::initResidence(am, d);
   }
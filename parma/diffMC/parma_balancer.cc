@@ -1,5 +1,6 @@
 #include <PCU.h>
 #include "parma_balancer.h"
+#include "parma_step.h"
 #include "parma_monitor.h"
 #include "parma_graphDist.h"
 #include "parma_commons.h"
@@ -36,7 +37,10 @@ namespace parma {
     if( 1 == PCU_Comm_Peers() ) return;
     int step = 0;
     double t0 = PCU_Time();
+    steps.clear();
+    std::vector<Parma_StepInfo>* outer = setStepLog(&steps);
     while (runStep(wtag,tolerance) && step++ < maxStep);
+    setStepLog(outer);
     printTiming(name, step, tolerance, PCU_Time()-t0);
   }
   void Balancer::monitorUpdate(double v, Slope* s, Average* a) {
@@ -45,3 +49,12 @@ namespace parma {
     a->push(slope);
   }
 }
+
+bool Parma_GetBalancerSteps(apf::Balancer* b,
+    std::vector<Parma_StepInfo>& steps) {
+  parma::Balancer* pb = dynamic_cast<parma::Balancer*>(b);
+  if (!pb)
+    return false;
+  steps = pb->steps;
+  return true;
+}
@@ -2,6 +2,8 @@
 #define PARMA_BALANCER_H
 
 #include <apfPartition.h>
+#include <parma.h>
+#include <vector>
 
 namespace parma {
   class Slope;
@@ -18,6 +20,7 @@ namespace parma {
       int verbose;
       const char* name;
       int maxStep;
+      std::vector<Parma_StepInfo> steps;
     protected:
       Slope* iS;
       Average* iA;
@@ -1,4 +1,5 @@
 #include <PCU.h>
+#include <pcu_util.h>
 #include <parma_balancer.h>
 #include "parma.h"
 #include "parma_step.h"
@@ -42,6 +43,43 @@ namespace {
         return b.step(tolerance, verbose);
       }
   };
+
+  /* migrates the flow of several modeled diffusion steps, or the
+     minimal balancing flow if steps is zero */
+  class FlowElmBalancer : public parma::Balancer {
+    private:
+      int steps;
+      double sideTol;
+    public:
+      FlowElmBalancer(apf::Mesh* m, int n, double f, int v, const char* name)
+        : Balancer(m, f, v, name), steps(n) {
+          parma::Sides* s = parma::makeVtxSides(mesh);
+          sideTol = parma::avgSharedSides(s);
+          delete s;
+      }
+      bool runStep(apf::MeshTag* wtag, double tolerance) {
+        const double maxElmImb =
+          Parma_GetWeightedEntImbalance(mesh, wtag, mesh->getDimension());
+        parma::Sides* s = parma::makeVtxSides(mesh);
+        double avgSides = parma::avgSharedSides(s);
+        parma::Weights* w =
+          parma::makeEntWeights(mesh, wtag, s, mesh->getDimension());
+        parma::Targets* t = steps ?
+          parma::makeFlowTargets(s, w, factor, steps) :
+          parma::makeMinFlowTargets(s, w, tolerance);
+        parma::Selector* sel = parma::makeFlowSelector(mesh, wtag);
+
+        monitorUpdate(maxElmImb, iS, iA);
+        monitorUpdate(avgSides, sS, sA);
+        if( !PCU_Comm_Self() && verbose )
+          status("elmImb %f avgSides %f\n", maxElmImb, avgSides);
+        parma::BalOrStall* stopper =
+          new parma::BalOrStall(iA, sA, sideTol*.001, verbose);
+
+        parma::Stepper b(mesh, factor, s, w, t, sel, "elm", stopper);
+        return b.step(tolerance, verbose);
+      }
+  };
 }
 
 apf::Balancer* Parma_MakeElmBalancer(apf::Mesh* m,
@@ -50,3 +88,17 @@ apf::Balancer* Parma_MakeElmBalancer(apf::Mesh* m,
     status("stepFactor %.3f\n", stepFactor);
   return new ElmBalancer(m, stepFactor, verbosity);
 }
+
+apf::Balancer* Parma_MakeMultiStepElmBalancer(apf::Mesh* m,
+    int stepsPerMigration, double stepFactor, int verbosity) {
+  PCU_ALWAYS_ASSERT(stepsPerMigration > 0);
+  if( !PCU_Comm_Self() && verbosity )
+    status("stepsPerMigration %d stepFactor %.3f\n",
+        stepsPerMigration, stepFactor);
+  return new FlowElmBalancer(m, stepsPerMigration, stepFactor, verbosity,
+      "multistep elements");
+}
+
+apf::Balancer* Parma_MakeIncrementalElmBalancer(apf::Mesh* m, int verbosity) {
+  return new FlowElmBalancer(m, 0, 1.0, verbosity, "incremental elements");
+}
@@ -0,0 +1,157 @@
+#include <PCU.h>
+#include <apf.h>
+#include "parma_selector.h"
+#include "parma_targets.h"
+#include "parma_weights.h"
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <vector>
+
+namespace {
+  /* (score, element) */
+  typedef std::pair<int, int> Candidate;
+  /* (shared vertices, peer) */
+  typedef std::pair<int, int> PeerContact;
+
+  /* grow a region towards each destination part from the vertices it
+     shares with it. elements are scored by their number of vertices
+     already on the destination and the best scored element is taken
+     next, so the regions stay compact. the destinations with the
+     smallest boundaries grow first, the others can reach around them.
+     the mesh adjacencies are copied into dense arrays once per
+     selection */
+  class FlowSelector : public parma::Selector {
+    public:
+      FlowSelector(apf::Mesh* m, apf::MeshTag* w) : Selector(m, w) {}
+      apf::Migration* run(parma::Targets* tgts) {
+        apf::Migration* plan = new apf::Migration(mesh);
+        number();
+        std::map<int, int> contact;
+        for (size_t i = 0; i < bdryPeer.size(); i++)
+          contact[bdryPeer[i]]++;
+        std::vector<PeerContact> order;
+        const parma::Targets::Item* t;
+        tgts->begin();
+        while( (t = tgts->iterate()) )
+          if (t->second > 0)
+            order.push_back(PeerContact(contact[t->first], t->first));
+        tgts->end();
+        std::sort(order.begin(), order.end());
+        for (size_t i = 0; i < order.size(); i++)
+          fill(plan, order[i].second, tgts->get(order[i].second));
+        return plan;
+      }
+    private:
+      std::vector<apf::MeshEntity*> elms;
+      std::vector<double> weight;
+      std::vector<int> elmVtxOffset;
+      std::vector<int> elmVtx;
+      std::vector<int> vtxElmOffset;
+      std::vector<int> vtxElm;
+      std::vector<int> bdryVtx;
+      std::vector<int> bdryPeer;
+      std::vector<int> dest;
+      std::vector<int> score;
+      std::vector<char> onPeer;
+      void number() {
+        const int dim = mesh->getDimension();
+        apf::MeshTag* id = mesh->createIntTag("parma_flow_id", 1);
+        int nv = 0;
+        apf::MeshIterator* it = mesh->begin(0);
+        apf::MeshEntity* e;
+        while ((e = mesh->iterate(it))) {
+          mesh->setIntTag(e, id, &nv);
+          if (mesh->isShared(e)) {
+            apf::Copies rmts;
+            mesh->getRemotes(e, rmts);
+            APF_ITERATE(apf::Copies, rmts, r) {
+              bdryVtx.push_back(nv);
+              bdryPeer.push_back(r->first);
+            }
+          }
+          nv++;
+        }
+        mesh->end(it);
+        elmVtxOffset.push_back(0);
+        it = mesh->begin(dim);
+        while ((e = mesh->iterate(it))) {
+          elms.push_back(e);
+          weight.push_back(parma::getEntWeight(mesh, e, wtag));
+          apf::Downward verts;
+          const int n = mesh->getDownward(e, 0, verts);
+          for (int i = 0; i < n; i++) {
+            int v;
+            mesh->getIntTag(verts[i], id, &v);
+            elmVtx.push_back(v);
+          }
+          elmVtxOffset.push_back(elmVtx.size());
+        }
+        mesh->end(it);
+        apf::removeTagFromDimension(mesh, id, 0);
+        mesh->destroyTag(id);
+        /* invert the element to vertex adjacency */
+        vtxElmOffset.assign(nv + 1, 0);
+        for (size_t i = 0; i < elmVtx.size(); i++)
+          vtxElmOffset[elmVtx[i] + 1]++;
+        for (int v = 0; v < nv; v++)
+          vtxElmOffset[v + 1] += vtxElmOffset[v];
+        vtxElm.resize(elmVtx.size());
+        std::vector<int> next(vtxElmOffset.begin(), vtxElmOffset.end() - 1);
+        const int ne = static_cast<int>(elms.size());
+        for (int i = 0; i < ne; i++)
+          for (int j = elmVtxOffset[i]; j < elmVtxOffset[i+1]; j++)
+            vtxElm[next[elmVtx[j]]++] = i;
+        dest.assign(ne, -1);
+        score.assign(ne, 0);
+        onPeer.assign(nv, 0);
+      }
+      void addVtx(int v, std::priority_queue<Candidate>& q,
+          std::vector<int>& touchedVtx, std::vector<int>& touchedElm) {
+        if (onPeer[v])
+          return;
+        onPeer[v] = 1;
+        touchedVtx.push_back(v);
+        for (int i = vtxElmOffset[v]; i < vtxElmOffset[v+1]; i++) {
+          const int e = vtxElm[i];
+          if (dest[e] != -1)
+            continue;
+          if (!score[e])
+            touchedElm.push_back(e);
+          q.push(Candidate(++score[e], e));
+        }
+      }
+      void fill(apf::Migration* plan, int peer, double target) {
+        std::priority_queue<Candidate> q;
+        std::vector<int> touchedVtx;
+        std::vector<int> touchedElm;
+        for (size_t i = 0; i < bdryVtx.size(); i++)
+          if (bdryPeer[i] == peer)
+            addVtx(bdryVtx[i], q, touchedVtx, touchedElm);
+        double planW = 0;
+        while (planW < target && !q.empty()) {
+          const Candidate c = q.top();
+          q.pop();
+          const int e = c.second;
+          /* skip taken elements and stale scores */
+          if (dest[e] != -1 || c.first != score[e])
+            continue;
+          dest[e] = peer;
+          plan->send(elms[e], peer);
+          planW += weight[e];
+          for (int i = elmVtxOffset[e]; i < elmVtxOffset[e+1]; i++)
+            addVtx(elmVtx[i], q, touchedVtx, touchedElm);
+        }
+        for (size_t i = 0; i < touchedVtx.size(); i++)
+          onPeer[touchedVtx[i]] = 0;
+        for (size_t i = 0; i < touchedElm.size(); i++)
+          score[touchedElm[i]] = 0;
+      }
+  };
+}
+
+namespace parma {
+  Selector* makeFlowSelector(apf::Mesh* m, apf::MeshTag* w) {
+    return new FlowSelector(m, w);
+  }
+}
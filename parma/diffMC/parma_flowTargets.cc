@@ -0,0 +1,248 @@
+#include <PCU.h>
+#include "parma_sides.h"
+#include "parma_weights.h"
+#include "parma_targets.h"
+#include <algorithm>
+
+namespace parma {
+  /* run several steps of the weight diffusion on a local model of the
+     part graph: each part only exchanges its modeled weight with its
+     neighbors, so the net flow of all the steps is known before any
+     element is migrated */
+  class FlowTargets : public Targets {
+    public:
+      FlowTargets(Sides* s, Weights* w, double alpha, int steps) {
+        init(s, w, alpha, steps);
+      }
+      double total() {
+        return totW;
+      }
+    private:
+      FlowTargets();
+      double totW;
+      void sendFlows(Sides* s, double& selfW, double alpha,
+          Associative<double>& peerW, Associative<double>& flow) {
+        const Sides::Item* side;
+        double out = 0;
+        PCU_Comm_Begin();
+        s->begin();
+        while( (side = s->iterate()) ) {
+          const int peer = side->first;
+          double f = 0;
+          if ( selfW > peerW.get(peer) ) {
+            double sideFraction = side->second;
+            sideFraction /= s->total();
+            f = (selfW - peerW.get(peer)) * sideFraction * alpha;
+            out += f;
+          }
+          flow.set(peer, flow.get(peer) + f);
+          PCU_COMM_PACK(peer, f);
+        }
+        s->end();
+        PCU_Comm_Send();
+        double in = 0;
+        while (PCU_Comm_Receive()) {
+          double f;
+          PCU_COMM_UNPACK(f);
+          const int peer = PCU_Comm_Sender();
+          flow.set(peer, flow.get(peer) - f);
+          in += f;
+        }
+        selfW += in - out;
+        /* share the modeled weight for the next step */
+        PCU_Comm_Begin();
+        s->begin();
+        while( (side = s->iterate()) )
+          PCU_COMM_PACK(side->first, selfW);
+        s->end();
+        PCU_Comm_Send();
+        while (PCU_Comm_Receive()) {
+          double pw;
+          PCU_COMM_UNPACK(pw);
+          peerW.set(PCU_Comm_Sender(), pw);
+        }
+      }
+      void init(Sides* s, Weights* w, double alpha, int steps) {
+        totW = 0;
+        Associative<double> peerW;
+        Associative<double> flow;
+        const Sides::Item* side;
+        s->begin();
+        while( (side = s->iterate()) ) {
+          peerW.set(side->first, w->get(side->first));
+          flow.set(side->first, 0);
+        }
+        s->end();
+        double selfW = w->self();
+        for (int i = 0; i < steps; i++)
+          sendFlows(s, selfW, alpha, peerW, flow);
+        const Associative<double>::Item* f;
+        flow.begin();
+        while( (f = flow.iterate()) )
+          if ( f->second > 0 ) {
+            set(f->first, f->second);
+            totW += f->second;
+          }
+        flow.end();
+      }
+  };
+  Targets* makeFlowTargets(Sides* s, Weights* w, double alpha, int steps) {
+    return new FlowTargets(s, w, alpha, steps);
+  }
+
+  /* plan the migration that brings the parts above the tolerance down
+     to it with little migration. first each heavy part sends its excess
+     directly to the neighbors with room below the tolerance, which grant
+     their room in proportion to the requests. the excess that is left
+     is moved by the flow with the smallest 2-norm f_ij = x_i - x_j,
+     where L x = b, L is the Laplacian of the part graph and b takes the
+     remaining excess to the parts with room left (Hu and Blake 1999).
+     x is found by conjugate gradients with one neighbor exchange and
+     two reductions per iteration */
+  class MinFlowTargets : public Targets {
+    public:
+      MinFlowTargets(Sides* s, Weights* w, double tolerance) {
+        init(s, w, tolerance);
+      }
+      double total() {
+        return totW;
+      }
+    private:
+      MinFlowTargets();
+      double totW;
+      void add(int peer, double f) {
+        set(peer, get(peer) + f);
+        totW += f;
+      }
+      /* send v to all neighbors, return the sum of the received values */
+      double exchange(Sides* s, double v, Associative<double>* peerV = 0) {
+        const Sides::Item* side;
+        PCU_Comm_Begin();
+        s->begin();
+        while( (side = s->iterate()) )
+          PCU_COMM_PACK(side->first, v);
+        s->end();
+        PCU_Comm_Send();
+        double sum = 0;
+        while (PCU_Comm_Receive()) {
+          double pv;
+          PCU_COMM_UNPACK(pv);
+          if (peerV)
+            peerV->set(PCU_Comm_Sender(), pv);
+          sum += pv;
+        }
+        return sum;
+      }
+      /* send each neighbor its value of out, return the received values */
+      void exchange(Sides* s, Associative<double>& out,
+          Associative<double>& in) {
+        const Sides::Item* side;
+        PCU_Comm_Begin();
+        s->begin();
+        while( (side = s->iterate()) ) {
+          const double v = out.get(side->first);
+          PCU_COMM_PACK(side->first, v);
+        }
+        s->end();
+        PCU_Comm_Send();
+        while (PCU_Comm_Receive()) {
+          double v;
+          PCU_COMM_UNPACK(v);
+          in.set(PCU_Comm_Sender(), v);
+        }
+      }
+      void sendDirect(Sides* s, double& excess, double& room) {
+        Associative<double> peerRoom;
+        const double nbrRoom = exchange(s, room, &peerRoom);
+        Associative<double> request;
+        const Sides::Item* side;
+        s->begin();
+        while( (side = s->iterate()) ) {
+          const int peer = side->first;
+          double r = 0;
+          if (excess > 0 && nbrRoom > 0)
+            r = std::min(excess * peerRoom.get(peer) / nbrRoom,
+                peerRoom.get(peer));
+          request.set(peer, r);
+        }
+        s->end();
+        Associative<double> requested;
+        exchange(s, request, requested);
+        double totRequested = 0;
+        const Associative<double>::Item* r;
+        requested.begin();
+        while( (r = requested.iterate()) )
+          totRequested += r->second;
+        requested.end();
+        const double share =
+          totRequested > room ? room / totRequested : 1.0;
+        Associative<double> grant;
+        requested.begin();
+        while( (r = requested.iterate()) ) {
+          grant.set(r->first, r->second * share);
+          room -= r->second * share;
+        }
+        requested.end();
+        Associative<double> granted;
+        exchange(s, grant, granted);
+        granted.begin();
+        while( (r = granted.iterate()) )
+          if (r->second > 0) {
+            add(r->first, r->second);
+            excess -= r->second;
+          }
+        granted.end();
+      }
+      double solve(Sides* s, double b) {
+        const int maxIter = 1000;
+        const double tol = 1e-8;
+        const double degree = s->size();
+        double x = 0;
+        double r = b;
+        double p = r;
+        double rr = PCU_Add_Double(r*r);
+        const double rr0 = rr;
+        for (int i = 0; i < maxIter && rr > tol*tol*rr0 && rr > 0; i++) {
+          const double ap = degree*p - exchange(s, p);
+          const double pap = PCU_Add_Double(p*ap);
+          if (pap <= 0)
+            break;
+          const double alpha = rr / pap;
+          x += alpha*p;
+          r -= alpha*ap;
+          const double rrNext = PCU_Add_Double(r*r);
+          p = r + (rrNext/rr)*p;
+          rr = rrNext;
+        }
+        return x;
+      }
+      void sendFlow(Sides* s, double excess, double room) {
+        const double totExcess = PCU_Add_Double(excess);
+        const double totRoom = PCU_Add_Double(room);
+        if (totExcess <= 0 || totRoom <= 0)
+          return;
+        const double x = solve(s, excess - room * totExcess / totRoom);
+        Associative<double> peerX;
+        exchange(s, x, &peerX);
+        const Associative<double>::Item* p;
+        peerX.begin();
+        while( (p = peerX.iterate()) )
+          if (x > p->second)
+            add(p->first, x - p->second);
+        peerX.end();
+      }
+      void init(Sides* s, Weights* w, double tolerance) {
+        totW = 0;
+        const double avg = PCU_Add_Double(w->self()) / PCU_Comm_Peers();
+        /* aim a bit below the tolerance for the selection granularity */
+        const double maxW = (1 + (tolerance - 1) * 0.9) * avg;
+        double excess = std::max(w->self() - maxW, 0.0);
+        double room = std::max(maxW - w->self(), 0.0);
+        sendDirect(s, excess, room);
+        sendFlow(s, excess, room);
+      }
+  };
+  Targets* makeMinFlowTargets(Sides* s, Weights* w, double tolerance) {
+    return new MinFlowTargets(s, w, tolerance);
+  }
+}
@@ -27,5 +27,6 @@ namespace parma {
   Selector* makeCentroidSelector(apf::Mesh* m, apf::MeshTag* w, Centroids* c);
   Selector* makeShapeSelector(apf::Mesh* m, apf::MeshTag* wtag);
   Selector* makeWeldSelector(apf::Mesh* m, apf::MeshTag* w, Sides* s);
+  Selector* makeFlowSelector(apf::Mesh* m, apf::MeshTag* w);
 }
 #endif
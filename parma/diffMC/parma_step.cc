@@ -11,6 +11,14 @@
 namespace parma {
   using parmaCommons::status;
 
+  static std::vector<Parma_StepInfo>* stepLog = 0;
+
+  std::vector<Parma_StepInfo>* setStepLog(std::vector<Parma_StepInfo>* log) {
+    std::vector<Parma_StepInfo>* old = stepLog;
+    stepLog = log;
+    return old;
+  }
+
   Stepper::Stepper(apf::Mesh* mIn, double alphaIn,
      Sides* s, Weights* w, Targets* t, Selector* sel,
      const char* entType, Stop* stopper)
@@ -34,12 +42,19 @@ namespace parma {
       status("%s imbalance %.3f avg %.3f\n", name, imb, avg);
     if ( stop->stop(imb,maxImb) )
       return false;
+    const double t0 = PCU_Time();
     apf::Migration* plan = selects->run(targets);
+    const double selectTime = PCU_Max_Double(PCU_Time()-t0);
     int planSz = PCU_Add_Int(plan->count());
-    const double t0 = PCU_Time();
+    const double t1 = PCU_Time();
     m->migrate(plan);
+    const double migrationTime = PCU_Time()-t1;
     if ( !PCU_Comm_Self() && verbosity )
-      status("%d elements migrated in %f seconds\n", planSz, PCU_Time()-t0);
+      status("%d elements migrated in %f seconds\n", planSz, migrationTime);
+    if ( stepLog ) {
+      Parma_StepInfo info = {imb, planSz, selectTime, migrationTime};
+      stepLog->push_back(info);
+    }
     if( verbosity > 1 ) 
       Parma_PrintPtnStats(m, "endStep", (verbosity>2));
     return true;
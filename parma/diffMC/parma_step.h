@@ -1,6 +1,7 @@
 #ifndef PARMA_STEP_H
 #define PARMA_STEP_H
 #include <apfMesh.h>
+#include <parma.h>
 #include "parma_associative.h"
 #include "parma_stop.h"
 
@@ -28,5 +29,8 @@ namespace parma {
       const char* name;
       Stop* stop;
   };
+  /* the steps of all Steppers are appended to log until it is
+     replaced, returns the previous log */
+  std::vector<Parma_StepInfo>* setStepLog(std::vector<Parma_StepInfo>* log);
 }
 #endif
@@ -24,5 +24,7 @@ namespace parma {
       double vtxTol, double edgeTol, double alpha);
   Targets* makeShapeTargets(Sides* s);
   Targets* makeGhostTargets(Sides* s, Weights* w, Ghosts* g, double alpha);
+  Targets* makeFlowTargets(Sides* s, Weights* w, double alpha, int steps);
+  Targets* makeMinFlowTargets(Sides* s, Weights* w, double tolerance);
 }
 #endif
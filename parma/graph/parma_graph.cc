@@ -0,0 +1,385 @@
+#include "parma_graph.h"
+#include <pcu_util.h>
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+namespace parma {
+
+namespace {
+
+/* coarsening stops at this many graph vertices per part */
+const int coarsePerPart = 20;
+const int minCoarse = 100;
+const size_t maxLevels = 32;
+/* a level that shrinks by less than this is not worth keeping */
+const double minReduction = 0.95;
+const int bisectTries = 4;
+const int refinePasses = 8;
+
+double getTotalWeight(Graph const& g)
+{
+  double total = 0;
+  for (int i = 0; i < g.size(); ++i)
+    total += g.vwgt[i];
+  return total;
+}
+
+/* deterministic shuffle so the matching does not follow the input
+   order, which for meshes is usually a sweep through space */
+void shuffle(std::vector<int>& order)
+{
+  unsigned seed = order.size();
+  for (size_t i = order.size(); i > 1; --i) {
+    seed = seed * 1103515245u + 12345u;
+    size_t j = (seed >> 8) % i;
+    std::swap(order[i - 1], order[j]);
+  }
+}
+
+/* heavy-edge matching, unmatched vertices map to themselves.
+   returns the number of coarse vertices */
+int matchHeavyEdges(Graph const& g, double maxWeight, std::vector<int>& cmap)
+{
+  int n = g.size();
+  std::vector<int> match(n, -1);
+  std::vector<int> order(n);
+  for (int i = 0; i < n; ++i)
+    order[i] = i;
+  shuffle(order);
+  cmap.assign(n, -1);
+  int cn = 0;
+  for (int i = 0; i < n; ++i) {
+    int u = order[i];
+    if (match[u] != -1)
+      continue;
+    int best = u;
+    int bestWeight = -1;
+    for (int j = g.xadj[u]; j < g.xadj[u + 1]; ++j) {
+      int v = g.adj[j];
+      if (match[v] != -1 || v == u)
+        continue;
+      if (g.vwgt[u] + g.vwgt[v] > maxWeight)
+        continue;
+      if (g.adjwgt[j] > bestWeight) {
+        best = v;
+        bestWeight = g.adjwgt[j];
+      }
+    }
+    match[u] = best;
+    match[best] = u;
+    cmap[u] = cmap[best] = cn++;
+  }
+  return cn;
+}
+
+void contract(Graph const& g, std::vector<int> const& cmap, int cn,
+    Graph& cg)
+{
+  int n = g.size();
+  std::vector<int> first(cn + 1, 0);
+  for (int i = 0; i < n; ++i)
+    ++first[cmap[i] + 1];
+  for (int c = 0; c < cn; ++c)
+    first[c + 1] += first[c];
+  std::vector<int> members(n);
+  std::vector<int> fill(first.begin(), first.end() - 1);
+  for (int i = 0; i < n; ++i)
+    members[fill[cmap[i]]++] = i;
+  cg.vwgt.assign(cn, 0);
+  cg.xadj.assign(cn + 1, 0);
+  cg.adj.clear();
+  cg.adjwgt.clear();
+  cg.adj.reserve(g.adj.size() / 2);
+  cg.adjwgt.reserve(g.adj.size() / 2);
+  /* slot[d] is the position of coarse neighbor d in cg.adj,
+     values before the current row start are stale */
+  std::vector<int> slot(cn, -1);
+  for (int c = 0; c < cn; ++c) {
+    int start = static_cast<int>(cg.adj.size());
+    for (int k = first[c]; k < first[c + 1]; ++k) {
+      int u = members[k];
+      cg.vwgt[c] += g.vwgt[u];
+      for (int j = g.xadj[u]; j < g.xadj[u + 1]; ++j) {
+        int d = cmap[g.adj[j]];
+        if (d == c)
+          continue;
+        if (slot[d] < start) {
+          slot[d] = static_cast<int>(cg.adj.size());
+          cg.adj.push_back(d);
+          cg.adjwgt.push_back(g.adjwgt[j]);
+        } else {
+          cg.adjwgt[slot[d]] += g.adjwgt[j];
+        }
+      }
+    }
+    cg.xadj[c + 1] = static_cast<int>(cg.adj.size());
+  }
+}
+
+/* the last vertex reached by a breadth-first search of the subset,
+   a cheap pseudo-peripheral seed */
+int findFarVertex(Graph const& g, int start, std::vector<int>& side)
+{
+  std::vector<int> queue(1, start);
+  side[start] = 1;
+  for (size_t i = 0; i < queue.size(); ++i) {
+    int v = queue[i];
+    for (int j = g.xadj[v]; j < g.xadj[v + 1]; ++j)
+      if (side[g.adj[j]] == 0) {
+        side[g.adj[j]] = 1;
+        queue.push_back(g.adj[j]);
+      }
+  }
+  for (size_t i = 0; i < queue.size(); ++i)
+    side[queue[i]] = 0;
+  return queue.back();
+}
+
+typedef std::pair<int, int> GainEntry;
+
+/* greedy graph growing: side[v] is -1 outside the subset, 0 for subset
+   vertices not yet taken and 1 for the grown region. gain[v] is the cut
+   reduction of moving v into the region. returns the resulting cut */
+int growRegion(Graph const& g, std::vector<int> const& verts, int seed,
+    double target, std::vector<int>& side, std::vector<int>& gain)
+{
+  int cut = 0;
+  for (size_t i = 0; i < verts.size(); ++i) {
+    int v = verts[i];
+    gain[v] = 0;
+    for (int j = g.xadj[v]; j < g.xadj[v + 1]; ++j)
+      if (side[g.adj[j]] != -1)
+        gain[v] -= g.adjwgt[j];
+  }
+  std::priority_queue<GainEntry> q;
+  q.push(GainEntry(gain[seed], seed));
+  double weight = 0;
+  size_t next = 0;
+  while (weight < target) {
+    if (q.empty()) {
+      /* the subset is disconnected, restart from an untaken vertex */
+      while (next < verts.size() && side[verts[next]] != 0)
+        ++next;
+      if (next == verts.size())
+        break;
+      q.push(GainEntry(gain[verts[next]], verts[next]));
+    }
+    GainEntry top = q.top();
+    q.pop();
+    int v = top.second;
+    if (side[v] != 0 || top.first != gain[v])
+      continue;
+    if (weight + g.vwgt[v] / 2 > target)
+      break;
+    side[v] = 1;
+    weight += g.vwgt[v];
+    cut -= gain[v];
+    for (int j = g.xadj[v]; j < g.xadj[v + 1]; ++j) {
+      int u = g.adj[j];
+      if (side[u] != 0)
+        continue;
+      gain[u] += 2 * g.adjwgt[j];
+      q.push(GainEntry(gain[u], u));
+    }
+  }
+  return cut;
+}
+
+void bisect(Graph const& g, std::vector<int> const& verts, int k, int first,
+    std::vector<int>& part, std::vector<int>& side, std::vector<int>& gain)
+{
+  if (k == 1 || verts.size() < 2) {
+    for (size_t i = 0; i < verts.size(); ++i)
+      part[verts[i]] = first;
+    return;
+  }
+  int k0 = k / 2;
+  double total = 0;
+  for (size_t i = 0; i < verts.size(); ++i) {
+    side[verts[i]] = 0;
+    total += g.vwgt[verts[i]];
+  }
+  double target = total * k0 / k;
+  std::vector<char> best(verts.size(), 0);
+  int bestCut = -1;
+  for (int t = 0; t < bisectTries; ++t) {
+    int seed;
+    if (t == 0)
+      seed = findFarVertex(g, verts[0], side);
+    else
+      seed = verts[(verts.size() * t) / bisectTries];
+    int cut = growRegion(g, verts, seed, target, side, gain);
+    if (bestCut == -1 || cut < bestCut) {
+      bestCut = cut;
+      for (size_t i = 0; i < verts.size(); ++i)
+        best[i] = side[verts[i]];
+    }
+    for (size_t i = 0; i < verts.size(); ++i)
+      side[verts[i]] = 0;
+  }
+  std::vector<int> in;
+  std::vector<int> out;
+  for (size_t i = 0; i < verts.size(); ++i) {
+    side[verts[i]] = -1;
+    if (best[i])
+      in.push_back(verts[i]);
+    else
+      out.push_back(verts[i]);
+  }
+  bisect(g, in, k0, first, part, side, gain);
+  bisect(g, out, k - k0, first + k0, part, side, gain);
+}
+
+void partitionCoarsest(Graph const& g, int k, std::vector<int>& part)
+{
+  int n = g.size();
+  std::vector<int> verts(n);
+  for (int i = 0; i < n; ++i)
+    verts[i] = i;
+  std::vector<int> side(n, -1);
+  std::vector<int> gain(n, 0);
+  part.assign(n, 0);
+  bisect(g, verts, k, 0, part, side, gain);
+}
+
+/* greedy k-way boundary refinement. a vertex moves to the adjacent part
+   it is most connected to if that reduces the cut, keeps the cut while
+   evening out the two parts, or relieves a part above maxWeight */
+void refine(Graph const& g, int k, double maxWeight, std::vector<int>& part)
+{
+  int n = g.size();
+  std::vector<double> pw(k, 0);
+  for (int v = 0; v < n; ++v)
+    pw[part[v]] += g.vwgt[v];
+  std::vector<int> conn(k, 0);
+  std::vector<int> touched;
+  for (int pass = 0; pass < refinePasses; ++pass) {
+    int moved = 0;
+    for (int v = 0; v < n; ++v) {
+      int a = part[v];
+      touched.clear();
+      bool boundary = false;
+      for (int j = g.xadj[v]; j < g.xadj[v + 1]; ++j) {
+        int b = part[g.adj[j]];
+        if (!conn[b])
+          touched.push_back(b);
+        conn[b] += g.adjwgt[j];
+        if (b != a)
+          boundary = true;
+      }
+      if (boundary) {
+        double w = g.vwgt[v];
+        int to = -1;
+        for (size_t i = 0; i < touched.size(); ++i) {
+          int b = touched[i];
+          if (b == a || pw[b] + w > maxWeight)
+            continue;
+          if (to == -1 || conn[b] > conn[to] ||
+              (conn[b] == conn[to] && pw[b] < pw[to]))
+            to = b;
+        }
+        if (to != -1) {
+          int moveGain = conn[to] - conn[a];
+          if (moveGain > 0 ||
+              (moveGain == 0 && pw[to] + w < pw[a]) ||
+              pw[a] > maxWeight) {
+            part[v] = to;
+            pw[a] -= w;
+            pw[to] += w;
+            ++moved;
+          }
+        }
+      }
+      for (size_t i = 0; i < touched.size(); ++i)
+        conn[touched[i]] = 0;
+    }
+    if (!moved)
+      break;
+  }
+}
+
+}
+
+int getEdgeCut(Graph const& g, std::vector<int> const& part)
+{
+  int cut = 0;
+  for (int v = 0; v < g.size(); ++v)
+    for (int j = g.xadj[v]; j < g.xadj[v + 1]; ++j)
+      if (part[v] != part[g.adj[j]])
+        cut += g.adjwgt[j];
+  return cut / 2;
+}
+
+void partitionGraph(Graph const& g, int k, double tolerance,
+    std::vector<int>& part)
+{
+  PCU_ALWAYS_ASSERT(k > 0);
+  PCU_ALWAYS_ASSERT(static_cast<int>(g.xadj.size()) == g.size() + 1);
+  part.assign(g.size(), 0);
+  if (k == 1 || !g.size())
+    return;
+  double total = getTotalWeight(g);
+  double maxWeight = tolerance * total / k;
+  int stop = std::max(coarsePerPart * k, minCoarse);
+  /* keep coarse vertices light enough that the coarsest graph
+     can still be balanced */
+  double maxVertexWeight = 1.5 * total / stop;
+  std::vector<Graph> levels;
+  std::vector<std::vector<int> > maps;
+  levels.reserve(maxLevels);
+  maps.reserve(maxLevels);
+  Graph const* fine = &g;
+  while (fine->size() > stop && levels.size() < maxLevels) {
+    std::vector<int> cmap;
+    int cn = matchHeavyEdges(*fine, maxVertexWeight, cmap);
+    if (cn > minReduction * fine->size())
+      break;
+    levels.push_back(Graph());
+    maps.push_back(std::vector<int>());
+    maps.back().swap(cmap);
+    contract(*fine, maps.back(), cn, levels.back());
+    fine = &levels.back();
+  }
+  std::vector<int> coarse;
+  partitionCoarsest(*fine, k, coarse);
+  refine(*fine, k, maxWeight, coarse);
+  for (size_t l = levels.size(); l > 0; --l) {
+    Graph const& finer = (l > 1) ? levels[l - 2] : g;
+    std::vector<int> const& cmap = maps[l - 1];
+    std::vector<int> projected(finer.size());
+    for (int i = 0; i < finer.size(); ++i)
+      projected[i] = coarse[cmap[i]];
+    refine(finer, k, maxWeight, projected);
+    coarse.swap(projected);
+  }
+  part.swap(coarse);
+}
+
+void coarsenGraph(Graph const& g, int target, Graph& coarse,
+    std::vector<int>& cmap)
+{
+  coarse = g;
+  cmap.resize(g.size());
+  for (int i = 0; i < g.size(); ++i)
+    cmap[i] = i;
+  if (!g.size())
+    return;
+  double maxVertexWeight = 1.5 * getTotalWeight(g) / std::max(target, 1);
+  for (size_t l = 0; coarse.size() > target && l < maxLevels; ++l) {
+    std::vector<int> lmap;
+    int cn = matchHeavyEdges(coarse, maxVertexWeight, lmap);
+    if (cn > minReduction * coarse.size())
+      break;
+    Graph next;
+    contract(coarse, lmap, cn, next);
+    coarse.xadj.swap(next.xadj);
+    coarse.adj.swap(next.adj);
+    coarse.adjwgt.swap(next.adjwgt);
+    coarse.vwgt.swap(next.vwgt);
+    for (size_t i = 0; i < cmap.size(); ++i)
+      cmap[i] = lmap[cmap[i]];
+  }
+}
+
+}
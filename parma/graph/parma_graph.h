@@ -0,0 +1,37 @@
+#ifndef PARMA_GRAPH_H
+#define PARMA_GRAPH_H
+
+#include <vector>
+
+namespace parma {
+
+/* compressed adjacency graph: the neighbors of vertex i are
+   adj[xadj[i]] ... adj[xadj[i+1]-1] with edge weights in adjwgt */
+struct Graph
+{
+  int size() const {return static_cast<int>(vwgt.size());}
+  std::vector<int> xadj;
+  std::vector<int> adj;
+  std::vector<int> adjwgt;
+  std::vector<double> vwgt;
+};
+
+int getEdgeCut(Graph const& g, std::vector<int> const& part);
+
+/* multilevel k-way partitioning: heavy-edge matching coarsening,
+   greedy graph growing bisection of the coarsest graph, then
+   boundary refinement while projecting back to the input graph.
+   on return part[i] is in [0,k) and no part weighs more than
+   tolerance times the average unless a single vertex forces it */
+void partitionGraph(Graph const& g, int k, double tolerance,
+    std::vector<int>& part);
+
+/* heavy-edge matching coarsening alone, until at most target vertices
+   remain or a level stops shrinking. cmap[i] is the coarse vertex
+   that vertex i of g ends up in */
+void coarsenGraph(Graph const& g, int target, Graph& coarse,
+    std::vector<int>& cmap);
+
+}
+
+#endif
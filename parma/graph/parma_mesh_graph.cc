@@ -0,0 +1,343 @@
+#include <PCU.h>
+#include "parma_graph.h"
+#include <parma.h>
+#include <apfMesh.h>
+#include <apfPartition.h>
+#include <pcu_util.h>
+#include <lionPrint.h>
+#include <algorithm>
+#include <map>
+
+namespace parma {
+
+/* the local element dual graph, elements are adjacent through sides */
+static void getElementGraph(apf::Mesh* m, apf::MeshTag* weights,
+    Graph& g, std::vector<apf::MeshEntity*>& elems)
+{
+  int dim = m->getDimension();
+  size_t n = m->count(dim);
+  elems.resize(n);
+  g.vwgt.resize(n);
+  g.xadj.assign(n + 1, 0);
+  g.adj.clear();
+  g.adjwgt.clear();
+  apf::MeshTag* ids = m->createIntTag("parma_graph_id", 1);
+  apf::MeshIterator* it = m->begin(dim);
+  apf::MeshEntity* e;
+  int i = 0;
+  while ((e = m->iterate(it))) {
+    m->setIntTag(e, ids, &i);
+    elems[i] = e;
+    if (weights)
+      m->getDoubleTag(e, weights, &(g.vwgt[i]));
+    else
+      g.vwgt[i] = 1;
+    ++i;
+  }
+  m->end(it);
+  PCU_ALWAYS_ASSERT(static_cast<size_t>(i) == n);
+  for (i = 0; i < static_cast<int>(n); ++i) {
+    apf::Downward sides;
+    int ns = m->getDownward(elems[i], dim - 1, sides);
+    for (int j = 0; j < ns; ++j) {
+      apf::Up up;
+      m->getUp(sides[j], up);
+      for (int k = 0; k < up.n; ++k) {
+        if (up.e[k] == elems[i] || !m->hasTag(up.e[k], ids))
+          continue;
+        int other;
+        m->getIntTag(up.e[k], ids, &other);
+        g.adj.push_back(other);
+        g.adjwgt.push_back(1);
+      }
+    }
+    g.xadj[i + 1] = static_cast<int>(g.adj.size());
+  }
+  apf::removeTagFromDimension(m, ids, dim);
+  m->destroyTag(ids);
+}
+
+/* split the local part into multiple parts numbered from offset,
+   elements of part zero stay where they are */
+static apf::Migration* splitMesh(apf::Mesh* m, apf::MeshTag* weights,
+    double tolerance, int multiple, int offset, int& cut)
+{
+  Graph g;
+  std::vector<apf::MeshEntity*> elems;
+  getElementGraph(m, weights, g, elems);
+  std::vector<int> part;
+  partitionGraph(g, multiple, tolerance, part);
+  cut = getEdgeCut(g, part);
+  apf::Migration* plan = new apf::Migration(m);
+  for (size_t i = 0; i < elems.size(); ++i)
+    if (part[i])
+      plan->send(elems[i], part[i] + offset);
+  return plan;
+}
+
+class GraphSplitter : public apf::Splitter
+{
+  public:
+    GraphSplitter(apf::Mesh* m, bool s)
+    {
+      mesh = m;
+      sync = s;
+    }
+    virtual ~GraphSplitter() {}
+    virtual apf::Migration* split(apf::MeshTag* weights, double tolerance,
+        int multiple)
+    {
+      double t0 = PCU_Time();
+      int offset = sync ? mesh->getId() * multiple : 0;
+      int cut;
+      apf::Migration* plan =
+        splitMesh(mesh, weights, tolerance, multiple, offset, cut);
+      if (sync) {
+        long totalCut = PCU_Add_Long(cut);
+        double t1 = PCU_Time();
+        if (!PCU_Comm_Self())
+          lion_oprint(1,"planned graph factor %d with %ld cut sides "
+              "in %f seconds\n", multiple, totalCut, t1 - t0);
+      }
+      return plan;
+    }
+  private:
+    apf::Mesh* mesh;
+    bool sync;
+};
+
+/* each part of a group coarsens its own graph to about this many
+   vertices, so a group leader only ever holds groupSize times this */
+const int groupCoarseSize = 1000;
+
+template <class T>
+static void packVector(int to, std::vector<T> const& v)
+{
+  int n = static_cast<int>(v.size());
+  PCU_COMM_PACK(to, n);
+  if (n)
+    PCU_Comm_Pack(to, &v[0], n * sizeof(T));
+}
+
+template <class T>
+static void unpackVector(std::vector<T>& v)
+{
+  int n;
+  PCU_COMM_UNPACK(n);
+  v.resize(n);
+  if (n)
+    PCU_Comm_Unpack(&v[0], n * sizeof(T));
+}
+
+/* a part's coarse graph and its edges to the coarse vertices of the
+   other parts in its group, (crossFrom[i], crossPart[i], crossTo[i]) */
+struct CoarsePart
+{
+  Graph graph;
+  std::vector<int> crossFrom;
+  std::vector<int> crossPart;
+  std::vector<int> crossTo;
+};
+
+/* pair up the coarse vertices on either side of each shared side */
+static void getCrossEdges(apf::Mesh* m,
+    std::vector<apf::MeshEntity*> const& elems,
+    std::vector<int> const& cmap, int leader, int size, CoarsePart& cp)
+{
+  int sideDim = m->getDimension() - 1;
+  std::map<apf::MeshEntity*, int> sideVertex;
+  PCU_Comm_Begin();
+  for (size_t i = 0; i < elems.size(); ++i) {
+    apf::Downward sides;
+    int ns = m->getDownward(elems[i], sideDim, sides);
+    for (int j = 0; j < ns; ++j) {
+      if (!m->isShared(sides[j]))
+        continue;
+      apf::Copies remotes;
+      m->getRemotes(sides[j], remotes);
+      APF_ITERATE(apf::Copies, remotes, rit) {
+        if (rit->first < leader || rit->first >= leader + size)
+          continue;
+        sideVertex[sides[j]] = cmap[i];
+        PCU_COMM_PACK(rit->first, rit->second);
+        PCU_COMM_PACK(rit->first, cmap[i]);
+      }
+    }
+  }
+  PCU_Comm_Send();
+  while (PCU_Comm_Receive()) {
+    apf::MeshEntity* side;
+    int to;
+    PCU_COMM_UNPACK(side);
+    PCU_COMM_UNPACK(to);
+    PCU_ALWAYS_ASSERT(sideVertex.count(side));
+    cp.crossFrom.push_back(sideVertex[side]);
+    cp.crossPart.push_back(PCU_Comm_Sender());
+    cp.crossTo.push_back(to);
+  }
+}
+
+/* assemble the coarse graphs of a group, merging parallel edges */
+static void assembleGroup(std::vector<CoarsePart> const& parts,
+    std::vector<int> const& base, int leader, Graph& g)
+{
+  typedef std::pair<int, int> Edge;
+  std::vector<std::vector<Edge> > edges(base.back());
+  g.vwgt.resize(base.back());
+  for (size_t p = 0; p < parts.size(); ++p) {
+    Graph const& pg = parts[p].graph;
+    for (int i = 0; i < pg.size(); ++i) {
+      g.vwgt[base[p] + i] = pg.vwgt[i];
+      for (int j = pg.xadj[i]; j < pg.xadj[i + 1]; ++j)
+        edges[base[p] + i].push_back(
+            Edge(base[p] + pg.adj[j], pg.adjwgt[j]));
+    }
+    for (size_t i = 0; i < parts[p].crossFrom.size(); ++i)
+      edges[base[p] + parts[p].crossFrom[i]].push_back(
+          Edge(base[parts[p].crossPart[i] - leader] + parts[p].crossTo[i],
+               1));
+  }
+  g.xadj.assign(edges.size() + 1, 0);
+  g.adj.clear();
+  g.adjwgt.clear();
+  for (size_t v = 0; v < edges.size(); ++v) {
+    std::sort(edges[v].begin(), edges[v].end());
+    for (size_t j = 0; j < edges[v].size(); ++j) {
+      if (j && edges[v][j].first == edges[v][j - 1].first)
+        g.adjwgt.back() += edges[v][j].second;
+      else {
+        g.adj.push_back(edges[v][j].first);
+        g.adjwgt.push_back(edges[v][j].second);
+      }
+    }
+    g.xadj[v + 1] = static_cast<int>(g.adj.size());
+  }
+}
+
+/* the leader of a group gathers the coarse graphs of its parts,
+   partitions them and sends each part the new part of its coarse
+   vertices, numbered from zero within the group. returns the cut of
+   the group graph on leaders and zero elsewhere */
+static int partitionGroup(CoarsePart const& cp, int leader, int size,
+    double tolerance, std::vector<int>& part)
+{
+  int self = PCU_Comm_Self();
+  PCU_Comm_Begin();
+  packVector(leader, cp.graph.vwgt);
+  packVector(leader, cp.graph.xadj);
+  packVector(leader, cp.graph.adj);
+  packVector(leader, cp.graph.adjwgt);
+  packVector(leader, cp.crossFrom);
+  packVector(leader, cp.crossPart);
+  packVector(leader, cp.crossTo);
+  PCU_Comm_Send();
+  std::vector<CoarsePart> parts(self == leader ? size : 0);
+  while (PCU_Comm_Receive()) {
+    CoarsePart& p = parts[PCU_Comm_Sender() - leader];
+    unpackVector(p.graph.vwgt);
+    unpackVector(p.graph.xadj);
+    unpackVector(p.graph.adj);
+    unpackVector(p.graph.adjwgt);
+    unpackVector(p.crossFrom);
+    unpackVector(p.crossPart);
+    unpackVector(p.crossTo);
+  }
+  int cut = 0;
+  PCU_Comm_Begin();
+  if (self == leader) {
+    std::vector<int> base(size + 1, 0);
+    for (int p = 0; p < size; ++p)
+      base[p + 1] = base[p] + parts[p].graph.size();
+    Graph g;
+    assembleGroup(parts, base, leader, g);
+    std::vector<int> gpart;
+    partitionGraph(g, size, tolerance, gpart);
+    cut = getEdgeCut(g, gpart);
+    for (int p = 0; p < size; ++p)
+      packVector(leader + p, std::vector<int>(
+            gpart.begin() + base[p], gpart.begin() + base[p + 1]));
+  }
+  PCU_Comm_Send();
+  while (PCU_Comm_Receive())
+    unpackVector(part);
+  return cut;
+}
+
+class GraphBalancer : public apf::Balancer
+{
+  public:
+    GraphBalancer(apf::Mesh* m, int g, double f, int v)
+    {
+      mesh = m;
+      groupSize = g;
+      factor = f;
+      verbose = v;
+    }
+    virtual ~GraphBalancer() {}
+    virtual void balance(apf::MeshTag* weights, double tolerance)
+    {
+      if (PCU_Comm_Peers() == 1)
+        return;
+      PCU_ALWAYS_ASSERT(weights);
+      double imb =
+        Parma_GetWeightedEntImbalance(mesh, weights, mesh->getDimension());
+      if (imb > tolerance && groupSize > 1)
+        repartition(weights, tolerance);
+      apf::Balancer* b = Parma_MakeElmBalancer(mesh, factor, verbose);
+      b->balance(weights, tolerance);
+      delete b;
+    }
+  private:
+    /* repartition each group of parts with the multilevel partitioner.
+       every part coarsens its own element graph and only the coarse
+       graphs are gathered on the group leader, so the leader's memory
+       does not grow with the mesh. elements then move straight to
+       their new parts. imbalance between the groups is left to the
+       diffusive balancer */
+    void repartition(apf::MeshTag* weights, double tolerance)
+    {
+      double t0 = PCU_Time();
+      int self = mesh->getId();
+      int leader = self - self % groupSize;
+      int size = std::min(groupSize, PCU_Comm_Peers() - leader);
+      Graph g;
+      std::vector<apf::MeshEntity*> elems;
+      getElementGraph(mesh, weights, g, elems);
+      CoarsePart cp;
+      std::vector<int> cmap;
+      coarsenGraph(g, groupCoarseSize, cp.graph, cmap);
+      getCrossEdges(mesh, elems, cmap, leader, size, cp);
+      std::vector<int> part;
+      int cut = partitionGroup(cp, leader, size, tolerance, part);
+      apf::Migration* plan = new apf::Migration(mesh);
+      for (size_t i = 0; i < elems.size(); ++i)
+        if (leader + part[cmap[i]] != self)
+          plan->send(elems[i], leader + part[cmap[i]]);
+      mesh->migrate(plan);
+      long totalCut = PCU_Add_Long(cut);
+      double imb =
+        Parma_GetWeightedEntImbalance(mesh, weights, mesh->getDimension());
+      double t1 = PCU_Time();
+      if (!PCU_Comm_Self() && verbose)
+        lion_oprint(1,"graph repartition in groups of %d: %ld cut sides "
+            "imbalance %.3f in %f seconds\n", groupSize, totalCut, imb,
+            t1 - t0);
+    }
+    apf::Mesh* mesh;
+    int groupSize;
+    double factor;
+    int verbose;
+};
+
+}
+
+apf::Splitter* Parma_MakeGraphSplitter(apf::Mesh* m, bool sync)
+{
+  return new parma::GraphSplitter(m, sync);
+}
+
+apf::Balancer* Parma_MakeGraphBalancer(apf::Mesh* m, int groupSize,
+    double stepFactor, int verbosity)
+{
+  return new parma::GraphBalancer(m, groupSize, stepFactor, verbosity);
+}
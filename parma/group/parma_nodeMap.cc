@@ -0,0 +1,383 @@
+#include <PCU.h>
+#include <parma.h>
+#include <apfMesh.h>
+#include <apfPartition.h>
+#include <pcu_util.h>
+#include <lionPrint.h>
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <vector>
+
+namespace {
+
+typedef std::map<int, long> Neighbors;
+
+/* node id of every rank: ranks are grouped by the MPI shared memory
+   split unless ranksPerNode asks for consecutive blocks of ranks */
+void getNodes(int ranksPerNode, std::vector<int>& nodeOf)
+{
+  int self = PCU_Comm_Self();
+  int peers = PCU_Comm_Peers();
+  nodeOf.resize(peers);
+  if (ranksPerNode > 0) {
+    for (int i = 0; i < peers; ++i)
+      nodeOf[i] = i / ranksPerNode;
+    return;
+  }
+  MPI_Comm comm = PCU_Get_Comm();
+  MPI_Comm nodeComm;
+  MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, self, MPI_INFO_NULL,
+      &nodeComm);
+  int leader = self;
+  MPI_Bcast(&leader, 1, MPI_INT, 0, nodeComm);
+  MPI_Comm_free(&nodeComm);
+  MPI_Allgather(&leader, 1, MPI_INT, &nodeOf[0], 1, MPI_INT, comm);
+  /* number the nodes by their leaders in rank order */
+  std::map<int, int> ids;
+  for (int i = 0; i < peers; ++i)
+    if (!ids.count(nodeOf[i])) {
+      int id = static_cast<int>(ids.size());
+      ids[nodeOf[i]] = id;
+    }
+  for (int i = 0; i < peers; ++i)
+    nodeOf[i] = ids[nodeOf[i]];
+}
+
+/* the number of vertices shared with each neighboring part */
+void getNeighbors(apf::Mesh* m, Neighbors& nbrs)
+{
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  while ((v = m->iterate(it))) {
+    if (!m->isShared(v))
+      continue;
+    apf::Copies remotes;
+    m->getRemotes(v, remotes);
+    APF_ITERATE(apf::Copies, remotes, rit)
+      ++nbrs[rit->first];
+  }
+  m->end(it);
+}
+
+struct PartGraph
+{
+  std::vector<int> xadj;
+  std::vector<int> adj;
+  std::vector<long> wgt;
+};
+
+void gatherPartGraph(apf::Mesh* m, PartGraph& g)
+{
+  Neighbors nbrs;
+  getNeighbors(m, nbrs);
+  PCU_Comm_Begin();
+  int n = static_cast<int>(nbrs.size());
+  PCU_COMM_PACK(0, n);
+  APF_ITERATE(Neighbors, nbrs, nit) {
+    PCU_COMM_PACK(0, nit->first);
+    PCU_COMM_PACK(0, nit->second);
+  }
+  PCU_Comm_Send();
+  int peers = PCU_Comm_Peers();
+  std::vector<Neighbors> all(peers);
+  while (PCU_Comm_Receive()) {
+    int from = PCU_Comm_Sender();
+    PCU_COMM_UNPACK(n);
+    for (int i = 0; i < n; ++i) {
+      int part;
+      long shared;
+      PCU_COMM_UNPACK(part);
+      PCU_COMM_UNPACK(shared);
+      all[from][part] = shared;
+    }
+  }
+  if (PCU_Comm_Self())
+    return;
+  g.xadj.assign(peers + 1, 0);
+  for (int p = 0; p < peers; ++p) {
+    APF_ITERATE(Neighbors, all[p], nit) {
+      g.adj.push_back(nit->first);
+      g.wgt.push_back(nit->second);
+    }
+    g.xadj[p + 1] = static_cast<int>(g.adj.size());
+  }
+}
+
+long getCut(PartGraph const& g, std::vector<int> const& nodeOfPart)
+{
+  long cut = 0;
+  for (size_t p = 0; p + 1 < g.xadj.size(); ++p)
+    for (int j = g.xadj[p]; j < g.xadj[p + 1]; ++j)
+      if (nodeOfPart[p] != nodeOfPart[g.adj[j]])
+        cut += g.wgt[j];
+  return cut;
+}
+
+typedef std::pair<long, int> Candidate;
+
+/* fill each node to its number of ranks by greedily taking the
+   unassigned part most connected to the parts already on it.
+   each node starts from and prefers its current parts so that a
+   mapping that is already good moves little */
+void groupParts(PartGraph const& g, std::vector<int> const& nodeOf,
+    std::vector<int>& group)
+{
+  int peers = static_cast<int>(nodeOf.size());
+  int nodes = 0;
+  for (int i = 0; i < peers; ++i)
+    if (nodeOf[i] + 1 > nodes)
+      nodes = nodeOf[i] + 1;
+  std::vector<int> capacity(nodes, 0);
+  for (int i = 0; i < peers; ++i)
+    ++capacity[nodeOf[i]];
+  group.assign(peers, -1);
+  std::vector<long> conn(peers, 0);
+  /* parts are only ever assigned, so the first unassigned part
+     never moves back */
+  int unassigned = 0;
+  for (int n = 0; n < nodes; ++n) {
+    /* keys are twice the connection plus one for parts already
+       on this node, so those win ties */
+    std::priority_queue<Candidate> q;
+    std::vector<int> touched;
+    for (int p = 0; p < peers; ++p)
+      if (nodeOf[p] == n && group[p] == -1)
+        q.push(Candidate(1, p));
+    for (int taken = 0; taken < capacity[n]; ++taken) {
+      int p = -1;
+      while (!q.empty() && p == -1) {
+        Candidate c = q.top();
+        q.pop();
+        int o = c.second;
+        if (group[o] == -1 && c.first == 2 * conn[o] + (nodeOf[o] == n))
+          p = o;
+      }
+      if (p == -1) {
+        while (group[unassigned] != -1)
+          ++unassigned;
+        p = unassigned;
+      }
+      group[p] = n;
+      for (int j = g.xadj[p]; j < g.xadj[p + 1]; ++j) {
+        int o = g.adj[j];
+        if (group[o] != -1)
+          continue;
+        if (!conn[o])
+          touched.push_back(o);
+        conn[o] += g.wgt[j];
+        q.push(Candidate(2 * conn[o] + (nodeOf[o] == n), o));
+      }
+    }
+    for (size_t i = 0; i < touched.size(); ++i)
+      conn[touched[i]] = 0;
+  }
+}
+
+long getConnection(PartGraph const& g, std::vector<int> const& group,
+    int p, int node)
+{
+  long c = 0;
+  for (int j = g.xadj[p]; j < g.xadj[p + 1]; ++j)
+    if (group[g.adj[j]] == node)
+      c += g.wgt[j];
+  return c;
+}
+
+long getWeight(PartGraph const& g, int p, int q)
+{
+  for (int j = g.xadj[p]; j < g.xadj[p + 1]; ++j)
+    if (g.adj[j] == q)
+      return g.wgt[j];
+  return 0;
+}
+
+/* the parts grouped on each node, and where each part sits
+   in its node's list */
+struct Members
+{
+  Members(std::vector<int> const& group):
+    position(group.size())
+  {
+    for (size_t p = 0; p < group.size(); ++p) {
+      if (group[p] + 1 > static_cast<int>(parts.size()))
+        parts.resize(group[p] + 1);
+      position[p] = static_cast<int>(parts[group[p]].size());
+      parts[group[p]].push_back(static_cast<int>(p));
+    }
+  }
+  /* p takes the place of q and q the place of p */
+  void swap(int p, int a, int q, int b)
+  {
+    std::swap(position[p], position[q]);
+    parts[a][position[q]] = q;
+    parts[b][position[p]] = p;
+  }
+  std::vector<std::vector<int> > parts;
+  std::vector<int> position;
+};
+
+/* swap pairs of parts between nodes while that lowers the cut.
+   only nodes a part is connected to are searched for partners */
+void swapParts(PartGraph const& g, std::vector<int>& group)
+{
+  const int maxPasses = 10;
+  int peers = static_cast<int>(group.size());
+  Members members(group);
+  /* the last part that searched each node in this pass */
+  std::vector<int> seen(members.parts.size());
+  for (int pass = 0; pass < maxPasses; ++pass) {
+    int swaps = 0;
+    std::fill(seen.begin(), seen.end(), -1);
+    for (int p = 0; p < peers; ++p) {
+      int a = group[p];
+      long home = getConnection(g, group, p, a);
+      long bestGain = 0;
+      int best = -1;
+      for (int j = g.xadj[p]; j < g.xadj[p + 1]; ++j) {
+        int b = group[g.adj[j]];
+        if (b == a || seen[b] == p)
+          continue;
+        seen[b] = p;
+        long away = getConnection(g, group, p, b) - home;
+        if (away <= 0)
+          continue;
+        std::vector<int> const& onB = members.parts[b];
+        for (size_t i = 0; i < onB.size(); ++i) {
+          int q = onB[i];
+          long gain = away + getConnection(g, group, q, a)
+            - getConnection(g, group, q, b) - 2 * getWeight(g, p, q);
+          /* the lowest part wins ties whatever the list order */
+          if (gain > bestGain ||
+              (gain == bestGain && best != -1 && q < best)) {
+            bestGain = gain;
+            best = q;
+          }
+        }
+      }
+      if (best != -1) {
+        int b = group[best];
+        members.swap(p, a, best, b);
+        group[p] = b;
+        group[best] = a;
+        ++swaps;
+      }
+    }
+    if (!swaps)
+      break;
+  }
+}
+
+/* parts that stay on their node keep their rank, the others take the
+   ranks vacated on their new node */
+void assignRanks(std::vector<int> const& nodeOf,
+    std::vector<int> const& group, std::vector<int>& dest)
+{
+  int peers = static_cast<int>(nodeOf.size());
+  dest.assign(peers, -1);
+  std::vector<bool> used(peers, false);
+  for (int p = 0; p < peers; ++p)
+    if (group[p] == nodeOf[p]) {
+      dest[p] = p;
+      used[p] = true;
+    }
+  std::vector<int> nextFree(peers, 0);
+  for (int p = 0; p < peers; ++p) {
+    if (dest[p] != -1)
+      continue;
+    int n = group[p];
+    int& r = nextFree[n];
+    while (used[r] || nodeOf[r] != n)
+      ++r;
+    dest[p] = r;
+    used[r] = true;
+  }
+}
+
+void migrateParts(apf::Mesh* m, int to)
+{
+  apf::Migration* plan = new apf::Migration(m);
+  if (to != m->getId()) {
+    apf::MeshIterator* it = m->begin(m->getDimension());
+    apf::MeshEntity* e;
+    while ((e = m->iterate(it)))
+      plan->send(e, to);
+    m->end(it);
+  }
+  m->migrate(plan);
+}
+
+long getSyncBytes(apf::Mesh* m, std::vector<int> const& nodeOf,
+    int components)
+{
+  long bytes = 0;
+  int node = nodeOf[m->getId()];
+  long perCopy = sizeof(apf::MeshEntity*) + components * sizeof(double);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  while ((v = m->iterate(it))) {
+    if (!m->isShared(v) || !m->isOwned(v))
+      continue;
+    apf::Copies remotes;
+    m->getRemotes(v, remotes);
+    APF_ITERATE(apf::Copies, remotes, rit)
+      if (nodeOf[rit->first] != node)
+        bytes += perCopy;
+  }
+  m->end(it);
+  return PCU_Add_Long(bytes);
+}
+
+}
+
+long Parma_GetInterNodeSyncBytes(apf::Mesh* m, int ranksPerNode,
+    int components)
+{
+  std::vector<int> nodeOf;
+  getNodes(ranksPerNode, nodeOf);
+  return getSyncBytes(m, nodeOf, components);
+}
+
+void Parma_MapPartsToNodes(apf::Mesh* m, int ranksPerNode, int verbosity)
+{
+  PCU_ALWAYS_ASSERT(m->getId() == PCU_Comm_Self());
+  double t0 = PCU_Time();
+  std::vector<int> nodeOf;
+  getNodes(ranksPerNode, nodeOf);
+  long before = 0;
+  if (verbosity)
+    before = getSyncBytes(m, nodeOf, 3);
+  PartGraph g;
+  gatherPartGraph(m, g);
+  int peers = PCU_Comm_Peers();
+  std::vector<int> dest(peers);
+  if (!PCU_Comm_Self()) {
+    std::vector<int> group;
+    groupParts(g, nodeOf, group);
+    swapParts(g, group);
+    std::vector<int> swapped(nodeOf);
+    swapParts(g, swapped);
+    if (getCut(g, swapped) <= getCut(g, group))
+      group.swap(swapped);
+    if (getCut(g, group) < getCut(g, nodeOf))
+      assignRanks(nodeOf, group, dest);
+    else
+      for (int p = 0; p < peers; ++p)
+        dest[p] = p;
+  }
+  MPI_Bcast(&dest[0], peers, MPI_INT, 0, PCU_Get_Comm());
+  int moved = 0;
+  for (int p = 0; p < peers; ++p)
+    if (dest[p] != p)
+      ++moved;
+  if (moved)
+    migrateParts(m, dest[m->getId()]);
+  if (verbosity) {
+    long after = getSyncBytes(m, nodeOf, 3);
+    double t1 = PCU_Time();
+    if (!PCU_Comm_Self())
+      lion_oprint(1,"mapped %d of %d parts to new ranks, inter-node "
+          "synchronize bytes %ld before %ld after, in %f seconds\n",
+          moved, peers, before, after, t1 - t0);
+  }
+}
@@ -13,6 +13,7 @@
 
 #include "apf.h"
 #include "apfPartition.h"
+#include <vector>
 
 /**
  * @brief get entity imbalance
@@ -241,6 +242,68 @@ apf::Balancer* Parma_MakeVtxBalancer(apf::Mesh* m, double stepFactor=0.1,
 apf::Balancer* Parma_MakeElmBalancer(apf::Mesh* m, double stepFactor=0.1,
     int verbosity=0);
 
+/**
+ * @brief create an APF Balancer targeting element imbalance that plans
+ *        several diffusion steps before each migration
+ * @remark parts model the diffusion of their weights with their
+ *         neighbors for stepsPerMigration steps, exchanging only one
+ *         weight per neighbor and step, and then migrate the net flow
+ *         at once. elements are selected by growing compact regions
+ *         from the part boundaries with priority queues.
+ * @param m (In) partitioned mesh
+ * @param stepsPerMigration (In) number of modeled diffusion steps
+ * @param stepFactor (In) amount of weight to migrate between neighbors
+ *        in each modeled step, useful range [0.1-0.5]
+ * @param verbosity (In) output control, higher values output more
+ * @return apf balancer instance
+ */
+apf::Balancer* Parma_MakeMultiStepElmBalancer(apf::Mesh* m,
+    int stepsPerMigration=8, double stepFactor=0.1, int verbosity=0);
+
+/**
+ * @brief create an APF Balancer targeting element imbalance that keeps
+ *        the current partition and migrates as little as possible
+ * @remark parts above the tolerance send their excess to neighbors
+ *         below it, and what the neighbors can not take is moved by the
+ *         smallest 2-norm flow on the part graph, found by solving a
+ *         Laplacian system. parts are only brought to just below the
+ *         tolerance. it is meant for partitions whose weights changed
+ *         locally, ie. after mesh adaptation, and usually needs one
+ *         migration. the migrated elements are reported by
+ *         Parma_GetBalancerSteps.
+ * @param m (In) partitioned mesh
+ * @param verbosity (In) output control, higher values output more
+ * @return apf balancer instance
+ */
+apf::Balancer* Parma_MakeIncrementalElmBalancer(apf::Mesh* m,
+    int verbosity=0);
+
+/**
+ * @brief the record of one step of a diffusive balancer
+ */
+struct Parma_StepInfo
+{
+  /** @brief imbalance at the start of the step */
+  double imbalance;
+  /** @brief number of elements migrated by all parts */
+  long elements;
+  /** @brief max seconds over the parts spent selecting elements */
+  double selectTime;
+  /** @brief seconds spent migrating */
+  double migrationTime;
+};
+
+/**
+ * @brief get the steps taken by the last call to balance
+ * @remark steps are recorded by the diffusive balancers, balancers that
+ *         only run other balancers record none
+ * @param b (In) balancer
+ * @param steps (InOut) one entry per migration
+ * @return false if b is not a diffusive balancer
+ */
+bool Parma_GetBalancerSteps(apf::Balancer* b,
+    std::vector<Parma_StepInfo>& steps);
+
 /**
  * @brief create an APF Balancer targeting vertex, edge, and elm imbalance
  * @param m (In) partitioned mesh
@@ -267,6 +330,35 @@ apf::Balancer* Parma_MakeVtxElmBalancer(apf::Mesh* m,
  */
 apf::Splitter* Parma_MakeRibSplitter(apf::Mesh* m, bool sync = true);
 
+/**
+ * @brief create an APF Splitter using multilevel graph partitioning
+ * @remark the element dual graph of each part is coarsened by heavy edge
+ *         matching, bisected by greedy graph growing and refined while it
+ *         is projected back, without any external partitioner
+ * @param m (In) partitioned mesh
+ * @param sync (In) true if all parts will be split, false o.w.
+ * @return apf splitter instance
+ */
+apf::Splitter* Parma_MakeGraphSplitter(apf::Mesh* m, bool sync = true);
+
+/**
+ * @brief create an APF Balancer using hierarchical graph partitioning
+ * @remark if the element imbalance is above tolerance, each group of
+ *         groupSize consecutive parts is repartitioned with the multilevel
+ *         graph partitioner: every part coarsens its element graph, the
+ *         first part of the group partitions the gathered coarse graphs
+ *         and elements move once to their new parts. Element diffusion
+ *         then balances the groups against each other
+ * @param m (In) partitioned mesh
+ * @param groupSize (In) number of parts repartitioned together
+ * @param stepFactor (In) amount of weight to migrate between neighbors
+ *        during diffusion, useful range [0.1-0.5]
+ * @param verbosity (In) output control, higher values output more
+ * @return apf balancer instance
+ */
+apf::Balancer* Parma_MakeGraphBalancer(apf::Mesh* m, int groupSize = 4,
+    double stepFactor = 0.1, int verbosity = 0);
+
 /**
  * @brief create a mesh tag that weighs elements by their memory consumption
  * @param m (In) partitioned mesh
@@ -320,6 +412,38 @@ void Parma_ShrinkPartition(apf::Mesh2* m, int factor, Parma_GroupCode& toRun);
  */
 void Parma_SplitPartition(apf::Mesh2* m, int factor, Parma_GroupCode& toRun);
 
+/**
+ * @brief Move whole parts between processes so that parts sharing many
+ *        vertices are placed on the same node.
+ * @details The part adjacency graph, weighted by the number of shared
+ *          vertices, is gathered on rank zero and each node is filled
+ *          with the parts most connected to those already placed on it.
+ *          Parts that stay on their node keep their rank.
+ *          The mapping is only applied if it reduces the weight of the
+ *          part graph edges between nodes.
+ *          One part per process is assumed.
+ * @param m (InOut) partitioned mesh
+ * @param ranksPerNode (In) if zero the nodes are found with
+ *        MPI_Comm_split_type(MPI_COMM_TYPE_SHARED), otherwise each block
+ *        of ranksPerNode consecutive ranks is treated as a node, which
+ *        also allows mapping to sockets
+ * @param verbosity (In) output control, if non-zero the inter-node
+ *        synchronize bytes before and after the mapping are reported
+ */
+void Parma_MapPartsToNodes(apf::Mesh* m, int ranksPerNode = 0,
+    int verbosity = 0);
+
+/**
+ * @brief Get the number of bytes a synchronize of a vertex field would
+ *        send between processes on different nodes.
+ * @param m (In) partitioned mesh
+ * @param ranksPerNode (In) see Parma_MapPartsToNodes
+ * @param components (In) number of doubles per vertex
+ * @return the total bytes over all processes
+ */
+long Parma_GetInterNodeSyncBytes(apf::Mesh* m, int ranksPerNode = 0,
+    int components = 3);
+
 /**
  * @brief Compute maximal independent set numbering
  * @remark This function will compute the maximal independent set numbering
@@ -22,6 +22,7 @@ SET(DIFFMC_SOURCES
   diffMC/parma_ltSelector.cc
   diffMC/parma_elmLtVtxEdgeSelector.cc
   diffMC/parma_elmSelector.cc
+  diffMC/parma_flowSelector.cc
   diffMC/parma_vtxSides.cc
   diffMC/parma_entWeights.cc
   diffMC/parma_ghost.cc
@@ -42,6 +43,7 @@ SET(DIFFMC_SOURCES
   diffMC/parma_vtxBalancer.cc
   diffMC/parma_vtxSelector.cc
   diffMC/parma_weightTargets.cc
+  diffMC/parma_flowTargets.cc
   diffMC/parma_weightSideTargets.cc
   diffMC/parma_preserveTargets.cc
   diffMC/parma_vtxEdgeTargets.cc
@@ -59,8 +61,14 @@ SET(RIB_SOURCES
   rib/parma_mesh_rib.cc
   )
 
+SET(GRAPH_SOURCES
+  graph/parma_graph.cc
+  graph/parma_mesh_graph.cc
+  )
+
 SET(GROUP_SOURCES
   group/parma_group.cc
+  group/parma_nodeMap.cc
   )
 
 INCLUDE_DIRECTORIES(${CMAKE_CURRENT_BINARY_DIR})
@@ -71,7 +79,7 @@ SET(parmaDepLibs ${APF_LIBS})
 
 TRIBITS_ADD_LIBRARY(
   parma
-  SOURCES ${DIFFMC_SOURCES} ${RIB_SOURCES} ${GROUP_SOURCES} ${API_SOURCE}
+  SOURCES ${DIFFMC_SOURCES} ${RIB_SOURCES} ${GRAPH_SOURCES} ${GROUP_SOURCES} ${API_SOURCE}
   HEADERS ${PARMA_EXTERNAL_HEADERS})
 
 TRIBITS_PACKAGE_POSTPROCESS()
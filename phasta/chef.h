@@ -11,6 +11,10 @@
 
 struct RStream;
 struct GRStream;
+namespace ph {
+  struct Output;
+  struct Solution;
+}
 namespace chef {
   /** @brief read and write to and from files */
   void cook(gmi_model*& g, apf::Mesh2*& m);
@@ -56,6 +60,15 @@ namespace chef {
   void preprocess(apf::Mesh2*& m, ph::Input& ctrl);
   /** @brief read fields from the mesh and write to streams */
   void preprocess(apf::Mesh2*& m, ph::Input& ctrl, GRStream* out);
+  /** @brief generate the PHASTA arrays and detach the solution fields
+      into memory for a coupled solver, writing no files
+      @details the solver reads the arrays of out and the fields of
+      sol directly. out must be new and ctrl must outlive it */
+  void preprocess(apf::Mesh2*& m, ph::Input& ctrl, ph::Output& out,
+      ph::Solution& sol);
+  /** @brief attach the fields a coupled solver left in memory,
+      instead of reading restart files or streams */
+  void attachSolution(ph::Input& ctrl, apf::Mesh2* m, ph::Solution& sol);
 }
 
 #endif
@@ -39,36 +39,37 @@ static int getPhastaType(apf::Mesh* m, apf::MeshEntity* e)
   return table[m->getType(e)];
 }
 
-static void insertKey(Blocks& b, BlockKey const& k)
+/* there are at most MAX_BLOCK_KEYS blocks, so a scan of the keys
+   beats a search tree */
+template <class B, class K>
+static int insertKey(B& b, K const& k)
 {
-  if (b.keyToIndex.count(k)) {
-    int idx = b.keyToIndex[k];
-    ++(b.nElements[idx]);
-  } else {
-    int idx = b.keyToIndex.size();
-    b.keyToIndex[k] = idx;
-    b.nElements[idx] = 1;
-    b.keys[idx] = k;
-    b.nElementNodes[idx] = k.nElementVertices;
-  }
+  for (int i = 0; i < b.nBlocks; ++i)
+    if (!(b.keys[i] < k) && !(k < b.keys[i])) {
+      ++(b.nElements[i]);
+      return i;
+    }
+  PCU_ALWAYS_ASSERT(b.nBlocks < MAX_BLOCK_KEYS);
+  int idx = b.nBlocks++;
+  b.nElements[idx] = 1;
+  b.keys[idx] = k;
+  b.nElementNodes[idx] = k.nElementVertices;
+  return idx;
 }
 
-static void insertKeyInterface
-(
-  BlocksInterface&         b,
-  BlockKeyInterface const& k
-)
+/* counting sort of the entities found by a counting pass into
+   their blocks, keeping the iterator order within each block */
+static void sortBlocks(BlocksCommon& b,
+    std::vector<apf::MeshEntity*> const& ents,
+    std::vector<int> const& blocks)
 {
-  if (b.keyToIndex.count(k)) {
-    int idx = b.keyToIndex[k];
-    ++(b.nElements[idx]);
-  } else {
-    int idx = b.keyToIndex.size();
-    b.keyToIndex[k] = idx;
-    b.nElements[idx] = 1;
-    b.keys[idx] = k;
-    b.nElementNodes[idx] = k.nElementVertices;
-  }
+  b.offsets.assign(b.nBlocks + 1, 0);
+  for (int i = 0; i < b.nBlocks; ++i)
+    b.offsets[i + 1] = b.offsets[i] + b.nElements[i];
+  std::vector<int> next(b.offsets.begin(), b.offsets.end() - 1);
+  b.entities.resize(ents.size());
+  for (size_t i = 0; i < ents.size(); ++i)
+    b.entities[next[blocks[i]]++] = ents[i];
 }
 
 static void getBlockKeyCommon(apf::Mesh* m, apf::MeshEntity* e, BlockKey& k)
@@ -88,14 +89,21 @@ void getInteriorBlockKey(apf::Mesh* m, apf::MeshEntity* e, BlockKey& k)
 
 static void getInteriorBlocks(apf::Mesh* m, Blocks& b)
 {
+  b.nBlocks = 0;
+  std::vector<apf::MeshEntity*> ents;
+  std::vector<int> blocks;
+  ents.reserve(m->count(m->getDimension()));
+  blocks.reserve(m->count(m->getDimension()));
   apf::MeshIterator* it = m->begin(m->getDimension());
   apf::MeshEntity* e;
   while ((e = m->iterate(it))) {
     BlockKey k;
     getInteriorBlockKey(m, e, k);
-    insertKey(b, k);
+    ents.push_back(e);
+    blocks.push_back(insertKey(b, k));
   }
   m->end(it);
+  sortBlocks(b, ents, blocks);
 }
 
 static void applyTriQuadHack(BlockKey& k)
@@ -120,6 +128,9 @@ void getBoundaryBlockKey(apf::Mesh* m, apf::MeshEntity* e,
 
 void getBoundaryBlocks(apf::Mesh* m, BCs& bcs, Blocks& b)
 {
+  b.nBlocks = 0;
+  std::vector<apf::MeshEntity*> ents;
+  std::vector<int> blocks;
   int boundaryDim = m->getDimension() - 1;
   apf::MeshIterator* it = m->begin(boundaryDim);
   apf::MeshEntity* f;
@@ -138,9 +149,11 @@ void getBoundaryBlocks(apf::Mesh* m, BCs& bcs, Blocks& b)
     apf::MeshEntity* e = m->getUpward(f, 0);
     BlockKey k;
     getBoundaryBlockKey(m, e, f, k);
-    insertKey(b, k);
+    ents.push_back(f);
+    blocks.push_back(insertKey(b, k));
   }
   m->end(it);
+  sortBlocks(b, ents, blocks);
 }
 
 static void applyTriQuadHackElement
@@ -187,6 +200,9 @@ void getInterfaceBlockKey
 
 void getInterfaceBlocks(apf::Mesh* m, BCs& bcs, BlocksInterface& b)
 {
+  b.nBlocks = 0;
+  std::vector<apf::MeshEntity*> ents;
+  std::vector<int> blocks;
   int interfaceDim = m->getDimension() - 1;
   apf::MeshIterator* it = m->begin(interfaceDim);
   apf::MeshEntity* face;
@@ -210,9 +226,11 @@ void getInterfaceBlocks(apf::Mesh* m, BCs& bcs, BlocksInterface& b)
 
     BlockKeyInterface k;
     getInterfaceBlockKey(m, e0, e1, face, k);
-    insertKeyInterface(b, k);
+    ents.push_back(face);
+    blocks.push_back(insertKey(b, k));
   }
   m->end(it);
+  sortBlocks(b, ents, blocks);
 }
 
 void getAllBlocks(apf::Mesh* m, BCs& bcs, AllBlocks& b)
@@ -41,15 +41,23 @@ enum {
   MAX_BLOCK_KEYS = 12
 };
 
+/* blocks are found in one counting pass over the mesh and then
+   sorted into flat arrays, so filling a block is a loop over its
+   own range and blocks can be filled independently */
 struct BlocksCommon
 {
-  typedef std::map<BlockKey, int> Map;
-  Map keyToIndex;
+  BlocksCommon():nBlocks(0) {}
+  int nBlocks;
   int nElements[MAX_BLOCK_KEYS];
   int nElementNodes[MAX_BLOCK_KEYS];
+  /* block i holds entities[offsets[i]] to entities[offsets[i + 1] - 1]
+     in the order of the mesh iterator. these are the elements of
+     interior blocks and the faces of boundary and interface blocks */
+  std::vector<apf::MeshEntity*> entities;
+  std::vector<int> offsets;
   int getSize()
   {
-    return keyToIndex.size();
+    return nBlocks;
   }
 };
 
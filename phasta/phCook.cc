@@ -159,20 +159,39 @@ namespace ph {
     ph::checkReorder(m,in,numMasters);
   }
 
-  void preprocess(apf::Mesh2* m, Input& in, Output& out, BCs& bcs) {
-    phastaio_initStats();
+  /* the part of preprocess shared by the file, stream and
+     in-memory outputs: it fills out and touches no files */
+  static void buildOutput(apf::Mesh2* m, Input& in, Output& out,
+      BCs& bcs) {
     if(PCU_Comm_Peers() > 1)
       ph::migrateInterfaceItr(m, bcs);
     if (in.simmetrixMesh == 0)
       ph::checkReorder(m,in,PCU_Comm_Peers());
+    ph::enterFilteredMatching(m, in, bcs);
+    ph::generateOutput(in, bcs, m, out);
+    ph::exitFilteredMatching(m);
+  }
+
+  /* reads the boundary conditions and sets up the solution fields */
+  static void readBCsAndFields(apf::Mesh2* m, Input& in, BCs& bcs) {
+    gmi_model* g = m->getModel();
+    PCU_ALWAYS_ASSERT(g);
+    lion_eprint(1, "reading %s\n", in.attributeFileName.c_str());
+    ph::readBCs(g, in.attributeFileName.c_str(), in.axisymmetry, bcs);
+    if (!in.solutionMigration)
+      ph::attachZeroSolution(in, m);
+    if (in.buildMapping)
+      ph::buildMapping(m);
+  }
+
+  void preprocess(apf::Mesh2* m, Input& in, Output& out, BCs& bcs) {
+    phastaio_initStats();
     if (in.adaptFlag)
       ph::goToStepDir(in.timeStepNumber,in.ramdisk);
     std::string path = ph::setupOutputDir(in.ramdisk);
     std::string subDirPath = path;
     ph::setupOutputSubdir(subDirPath,in.ramdisk);
-    ph::enterFilteredMatching(m, in, bcs);
-    ph::generateOutput(in, bcs, m, out);
-    ph::exitFilteredMatching(m);
+    buildOutput(m, in, out, bcs);
     // a path is not needed for inmem
     if ( in.writeRestartFiles ) {
       if(!PCU_Comm_Self()) lion_oprint(1,"write file-based restart file\n");
@@ -212,17 +231,22 @@ namespace ph {
     if(in.printIOtime) phastaio_printStats();
   }
   void preprocess(apf::Mesh2* m, Input& in, Output& out) {
-    gmi_model* g = m->getModel();
-    PCU_ALWAYS_ASSERT(g);
     BCs bcs;
-    lion_eprint(1, "reading %s\n", in.attributeFileName.c_str());
-    ph::readBCs(g, in.attributeFileName.c_str(), in.axisymmetry, bcs);
-    if (!in.solutionMigration)
-      ph::attachZeroSolution(in, m);
-    if (in.buildMapping)
-      ph::buildMapping(m);
+    readBCsAndFields(m, in, bcs);
     preprocess(m,in,out,bcs);
   }
+  /* the in-memory counterpart of preprocess above: the same arrays
+     and fields, but nothing is written and the working directory
+     is left alone */
+  void preprocess(apf::Mesh2* m, Input& in, Output& out, Solution& sol) {
+    BCs bcs;
+    readBCsAndFields(m, in, bcs);
+    buildOutput(m, in, out, bcs);
+    ph::detachSolution(in, m, sol);
+#ifdef HAVE_SIMMETRIX
+    ph::clearAttAssociation(m->getModel(),in);
+#endif
+  }
 }
 
 namespace chef {
@@ -329,5 +353,16 @@ namespace chef {
     out.grs = grs;
     ph::preprocess(m,in,out);
   }
+
+  void preprocess(apf::Mesh2*& m, ph::Input& in, ph::Output& out,
+      ph::Solution& sol) {
+    out.openfile_write = 0;
+    out.grs = 0;
+    ph::preprocess(m,in,out,sol);
+  }
+
+  void attachSolution(ph::Input& in, apf::Mesh2* m, ph::Solution& sol) {
+    ph::attachSolution(in, m, sol);
+  }
 }
 
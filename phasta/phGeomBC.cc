@@ -283,25 +283,9 @@ static void writeGrowthCurves(Output& o, FILE* f)
   }
 }
 
-void writeGeomBC(Output& o, std::string path, int timestep)
+static void writeGeomBCData(Output& o, FILE* f)
 {
-  double t0 = PCU_Time();
   apf::Mesh* m = o.mesh;
-  std::stringstream tss; 
-  std::string timestep_or_dat;
-  if (! timestep)
-    timestep_or_dat = "dat";
-  else {
-    tss << timestep;   
-    timestep_or_dat = tss.str();
-  }
-  path += buildGeomBCFileName(timestep_or_dat);
-  phastaio_setfile(GEOMBC_WRITE);
-  FILE* f = o.openfile_write(o, path.c_str());
-  if (!f) {
-    lion_eprint(1,"failed to open \"%s\"!\n", path.c_str());
-    abort();
-  }
   ph_write_preamble(f);
   int params[MAX_PARAMS];
 /* all of these strings are looked for by the other programs
@@ -363,7 +347,34 @@ void writeGeomBC(Output& o, std::string path, int timestep)
   writeElementGraph(o, f);
   writeEdges(o, f);
   writeGrowthCurves(o, f);
-  PHASTAIO_CLOSETIME(fclose(f);)
+}
+
+void writeGeomBC(Output& o, std::string path, int timestep)
+{
+  double t0 = PCU_Time();
+  std::stringstream tss; 
+  std::string timestep_or_dat;
+  if (! timestep)
+    timestep_or_dat = "dat";
+  else {
+    tss << timestep;   
+    timestep_or_dat = tss.str();
+  }
+  path += buildGeomBCFileName(timestep_or_dat);
+  phastaio_setfile(GEOMBC_WRITE);
+  /* the file is sized first, so the blocks go to disk
+     from one buffer with a single write */
+  ph_start_count();
+  writeGeomBCData(o, NULL);
+  size_t bytes = ph_count_bytes();
+  FILE* f = o.openfile_write(o, path.c_str());
+  if (!f) {
+    lion_eprint(1,"failed to open \"%s\"!\n", path.c_str());
+    abort();
+  }
+  char* buffer = ph_size_buffer(f, bytes);
+  writeGeomBCData(o, f);
+  ph_close_file(f, buffer, bytes);
   double t1 = PCU_Time();
   if (!PCU_Comm_Self())
     lion_oprint(1,"geombc file written in %f seconds\n", t1 - t0);
@@ -20,10 +20,30 @@ STEP_PARAM
 
 static const char* magic_name = "byteorder magic number";
 
+/* bytes the writers were given a NULL file for, see ph_start_count */
+static size_t counted = 0;
+
+void ph_start_count(void)
+{
+  counted = 0;
+}
+
+size_t ph_count_bytes(void)
+{
+  return counted;
+}
+
 void ph_write_header(FILE* f, const char* name, size_t bytes,
     int nparam, int* params)
 {
   int i;
+  if (!f) {
+    counted += snprintf(NULL, 0, "%s : < %lu > ", name, (long)bytes);
+    for (i = 0; i < nparam; ++i)
+      counted += snprintf(NULL, 0, "%d ", params[i]);
+    counted += 1;
+    return;
+  }
   fprintf(f,"%s : < %lu > ", name, (long)bytes);
   for (i = 0; i < nparam; ++i)
     fprintf(f, "%d ", params[i]);
@@ -97,6 +117,10 @@ static void write_magic_number(FILE* f)
   int why = 1;
   int magic = MAGIC;
   ph_write_header(f, magic_name, sizeof(int) + 1, 1, &why);
+  if (!f) {
+    counted += sizeof(int) + 1;
+    return;
+  }
   fwrite(&magic, sizeof(int), 1, f);
   fprintf(f,"\n");
 }
@@ -127,11 +151,17 @@ static int read_magic_number(FILE* f)
   return magic != MAGIC;
 }
 
+static const char* preamble =
+  "# PHASTA Input File Version 2.0\n"
+  "# Byte Order Magic Number : 362436 \n"
+  "# Output generated by libph version: yes\n";
+
 void ph_write_preamble(FILE* f)
 {
-  fprintf(f, "# PHASTA Input File Version 2.0\n");
-  fprintf(f, "# Byte Order Magic Number : 362436 \n");
-  fprintf(f, "# Output generated by libph version: yes\n");
+  if (f)
+    fputs(preamble, f);
+  else
+    counted += strlen(preamble);
   write_magic_number(f);
 }
 
@@ -139,6 +169,10 @@ void ph_write_doubles(FILE* f, const char* name, double* data,
     size_t n, int nparam, int* params)
 {
   ph_write_header(f, name, n * sizeof(double) + 1, nparam, params);
+  if (!f) {
+    counted += n * sizeof(double) + 1;
+    return;
+  }
   PHASTAIO_WRITETIME(fwrite(data, sizeof(double), n, f);, (n*sizeof(double)))
   fprintf(f, "\n");
 }
@@ -147,10 +181,35 @@ void ph_write_ints(FILE* f, const char* name, int* data,
     size_t n, int nparam, int* params)
 {
   ph_write_header(f, name, n * sizeof(int) + 1, nparam, params);
+  if (!f) {
+    counted += n * sizeof(int) + 1;
+    return;
+  }
   PHASTAIO_WRITETIME(fwrite(data, sizeof(int), n, f);, (n*sizeof(int)))
   fprintf(f, "\n");
 }
 
+char* ph_size_buffer(FILE* f, size_t bytes)
+{
+  char* buffer;
+  int failed;
+  /* in-memory streams have no descriptor and nothing to save */
+  if (fileno(f) < 0 || !bytes)
+    return NULL;
+  buffer = malloc(bytes);
+  PCU_ALWAYS_ASSERT(buffer);
+  failed = setvbuf(f, buffer, _IOFBF, bytes);
+  PCU_ALWAYS_ASSERT(!failed);
+  return buffer;
+}
+
+void ph_close_file(FILE* f, char* buffer, size_t bytes)
+{
+  PHASTAIO_FLUSHTIME(fflush(f);, bytes)
+  PHASTAIO_CLOSETIME(fclose(f);)
+  free(buffer);
+}
+
 static void parse_params(char* header, long* bytes,
     int* nodes, int* vars, int* step)
 {
@@ -13,6 +13,25 @@ void ph_write_doubles(FILE* f, const char* name, double* data,
 void ph_write_ints(FILE* f, const char* name, int* data,
     size_t n, int nparam, int* params);
 
+/**
+ * @brief count the bytes of a file instead of writing them
+ * @details after this the writers above, given a NULL file,
+ *          only add the bytes they would write to ph_count_bytes
+ */
+void ph_start_count(void);
+/** @brief the bytes counted since ph_start_count */
+size_t ph_count_bytes(void);
+/**
+ * @brief give a file opened for writing one buffer of the whole file
+ * @details the writers copy every block into it once and
+ *          ph_close_file writes it to disk with a single call.
+ *          in-memory streams are left alone, they already are a buffer.
+ * @return the buffer to pass to ph_close_file
+ */
+char* ph_size_buffer(FILE* f, size_t bytes);
+/** @brief write the buffered bytes at once, close f and free the buffer */
+void ph_close_file(FILE* f, char* buffer, size_t bytes);
+
 /**
  * @brief determines if bytes read from the need to be 
  *        swapped to account for endianness
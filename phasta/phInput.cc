@@ -68,6 +68,7 @@ static void setDefaults(Input& in)
   in.vertexImbalance = 1.05;
   in.rs = 0;
   in.formEdges = 0;
+  in.outputThreads = 1;
   in.simmetrixMesh = 0;
   in.maxAdaptIterations = 3;
   in.adaptShrinkLimit = 10000;
@@ -155,6 +156,7 @@ static void formMaps(Input& in, StringMap& stringMap, IntMap& intMap, DblMap& db
   dblMap["vertexImbalance"] = &in.vertexImbalance;
   dblMap["adaptShrinkLimit"] = &in.adaptShrinkLimit;
   intMap["formEdges"] = &in.formEdges;
+  intMap["outputThreads"] = &in.outputThreads;
   intMap["simmetrixMesh"] = &in.simmetrixMesh;
   intMap["maxAdaptIterations"] = &in.maxAdaptIterations;
   intMap["printIOtime"] = &in.printIOtime;
@@ -140,6 +140,10 @@ class Input
     int filterMatches;
     int axisymmetry;
     int formEdges;
+    /** \brief threads filling the element connectivity blocks
+       of the phasta output, through apf::runThreads, so more than
+       one only helps when core is built with ENABLE_THREADS */
+    int outputThreads;
     int parmaLoops;
     int parmaVerbosity;
     /** \brief write the geombc file during in-memory data transfer
@@ -28,6 +28,7 @@ namespace ph {
 
 typedef std::map<gmi_ent*, int> MaterialMap;
 typedef std::set<int> MaterialSet;
+typedef std::set<gmi_ent*> InterfaceSet;
 
 bool isInterface(gmi_model* gm, gmi_ent* ge, FieldBCs& fbcs)
 {
@@ -88,6 +89,20 @@ static void findMaterials(gmi_model* gm, FieldBCs& fbcs,
   gmi_end(gm, rit);
 }
 
+/* isInterface for every model entity below the regions, evaluated
+   once instead of once per mesh entity */
+static void findInterfaces(gmi_model* gm, FieldBCs& fbcs, InterfaceSet& is)
+{
+  for (int d = 0; d < 3; ++d) {
+    gmi_iter* it = gmi_begin(gm, d);
+    gmi_ent* ge;
+    while ((ge = gmi_next(gm, it)))
+      if (isInterface(gm, ge, fbcs))
+        is.insert(ge);
+    gmi_end(gm, it);
+  }
+}
+
 static void replaceAdjacencies(apf::Mesh2* m,
     apf::MeshEntity* of, apf::MeshEntity* olda, apf::MeshEntity* newa)
 {
@@ -127,9 +142,12 @@ static void cutEntity(apf::Mesh2* m, MaterialMap& mm, apf::MeshEntity* e)
 {
   apf::Adjacent elements;
   m->getAdjacent(e, m->getDimension(), elements);
+  std::vector<int> materials(elements.getSize());
   MaterialSet ms;
-  APF_ITERATE(apf::Adjacent, elements, it)
-    ms.insert(mm[ (gmi_ent*) (m->toModel(*it)) ]);
+  for (size_t i = 0; i < elements.getSize(); ++i) {
+    materials[i] = mm[ (gmi_ent*) (m->toModel(elements[i])) ];
+    ms.insert(materials[i]);
+  }
   std::vector<apf::MeshEntity*> ents;
   ents.reserve(ms.size());
   ms.erase(ms.begin());
@@ -137,9 +155,9 @@ static void cutEntity(apf::Mesh2* m, MaterialMap& mm, apf::MeshEntity* e)
   ents.push_back(e);
   APF_ITERATE(MaterialSet, ms, it) {
     apf::MeshEntity* ne = cloneEntity(m, e);
-    APF_ITERATE(apf::Adjacent, elements, eit)
-      if (mm[ (gmi_ent*) (m->toModel(*eit))] == *it)
-        replaceAdjacencies(m, *eit, e, ne);
+    for (size_t i = 0; i < elements.getSize(); ++i)
+      if (materials[i] == *it)
+        replaceAdjacencies(m, elements[i], e, ne);
     ents.push_back(ne);
   }
   APF_ITERATE(std::vector<apf::MeshEntity*>, ents, ait)
@@ -148,22 +166,24 @@ static void cutEntity(apf::Mesh2* m, MaterialMap& mm, apf::MeshEntity* e)
         m->addMatch(*ait, m->getId(), *bit);
 }
 
-static void cutEntities(apf::Mesh2* m, FieldBCs& fbcs, MaterialMap& mm)
+/* all entities to cut are found in one pass before any is cut,
+   so the model classification is only tested once per entity */
+static void cutEntities(apf::Mesh2* m, InterfaceSet& is, MaterialMap& mm)
 {
   apf::setMdsMatching(m, true);
+  std::vector<apf::MeshEntity*> toCut[3];
   for (int d = m->getDimension() - 1; d >= 0; --d) {
     apf::MeshIterator* it = m->begin(d);
     apf::MeshEntity* e;
-    std::vector<apf::MeshEntity*> toCut;
-    toCut.reserve(m->count(d));
-    while ((e = m->iterate(it))) {
-      if (isInterface(m->getModel(), (gmi_ent*) m->toModel(e), fbcs))
-        toCut.push_back(e);
-    }
+    while ((e = m->iterate(it)))
+      if (is.count((gmi_ent*) m->toModel(e)))
+        toCut[d].push_back(e);
     m->end(it);
-    for (size_t i = 0; i < toCut.size(); ++i)
-      cutEntity(m, mm, toCut[i]);
-    lion_oprint(1,"cut %zd entities in dimension %d\n",toCut.size(),d);
+  }
+  for (int d = m->getDimension() - 1; d >= 0; --d) {
+    for (size_t i = 0; i < toCut[d].size(); ++i)
+      cutEntity(m, mm, toCut[d][i]);
+    lion_oprint(1,"cut %zd entities in dimension %d\n",toCut[d].size(),d);
   }
 }
 
@@ -176,7 +196,9 @@ void cutInterface(apf::Mesh2* m, BCs& bcs)
   FieldBCs& fbcs = bcs.fields[name];
   MaterialMap mm;
   findMaterials(m->getModel(), fbcs, mm);
-  cutEntities(m, fbcs, mm);
+  InterfaceSet is;
+  findInterfaces(m->getModel(), fbcs, is);
+  cutEntities(m, is, mm);
 }
 
 #ifdef HAVE_SIMMETRIX
@@ -238,6 +260,8 @@ int migrateInterface(apf::Mesh2*& m, ph::BCs& bcs) {
     return -1;
   }
   ph::FieldBCs& fbcs = bcs.fields[name];
+  InterfaceSet is;
+  findInterfaces(m->getModel(), fbcs, is);
 
   int faceDim = m->getDimension() - 1;
 
@@ -253,7 +277,7 @@ int migrateInterface(apf::Mesh2*& m, ph::BCs& bcs) {
       continue;
 
     gmi_ent* gf = (gmi_ent*) me;
-    if (!ph::isInterface(m->getModel(), gf, fbcs))
+    if (!is.count(gf))
       continue;
 
     ++nDG;
@@ -281,20 +305,214 @@ int migrateInterface(apf::Mesh2*& m, ph::BCs& bcs) {
   return totalPlan;
 }
 
+/* elements that must end up on the same part: the two elements
+   on either side of a cut interface face are joined.
+   joins within a part are kept in a union-find, joins across
+   parts are links along which the component labels are exchanged */
+struct InterfaceGraph {
+  struct Link {
+    int element;
+    int peer;
+    apf::MeshEntity* face;
+    int sent;
+  };
+  std::vector<apf::MeshEntity*> elements;
+  std::vector<int> parent;
+  std::vector<int> label;
+  std::vector<Link> links;
+  int find(int i)
+  {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+  void join(int i, int j)
+  {
+    i = find(i);
+    j = find(j);
+    if (i != j)
+      parent[i] = j;
+  }
+};
+
+static int getGraphIndex(apf::Mesh2* m, apf::MeshTag* t,
+    apf::MeshEntity* e, InterfaceGraph& g)
+{
+  int i;
+  if (m->hasTag(e, t)) {
+    m->getIntTag(e, t, &i);
+    return i;
+  }
+  i = g.elements.size();
+  g.elements.push_back(e);
+  g.parent.push_back(i);
+  m->setIntTag(e, t, &i);
+  return i;
+}
+
+static bool isInterfaceFace(apf::Mesh2* m, InterfaceSet& is,
+    apf::MeshEntity* f)
+{
+  apf::ModelEntity* me = m->toModel(f);
+  return m->getModelType(me) == m->getDimension() - 1 &&
+         is.count((gmi_ent*) me);
+}
+
+static void buildInterfaceGraph(apf::Mesh2* m, InterfaceSet& is,
+    apf::MeshTag* t, InterfaceGraph& g)
+{
+  int self = PCU_Comm_Self();
+  apf::MeshIterator* it = m->begin(m->getDimension() - 1);
+  apf::MeshEntity* f;
+  while ((f = m->iterate(it))) {
+    if (!isInterfaceFace(m, is, f))
+      continue;
+    int i = getGraphIndex(m, t, m->getUpward(f, 0), g);
+    apf::DgCopies dgCopies;
+    m->getDgCopies(f, dgCopies);
+    for (size_t j = 0; j < dgCopies.getSize(); ++j) {
+      if (dgCopies[j].peer == self) {
+        apf::MeshEntity* o = m->getUpward(dgCopies[j].entity, 0);
+        g.join(i, getGraphIndex(m, t, o, g));
+      } else {
+        InterfaceGraph::Link l;
+        l.element = i;
+        l.peer = dgCopies[j].peer;
+        l.face = dgCopies[j].entity;
+        l.sent = -1;
+        g.links.push_back(l);
+      }
+    }
+  }
+  m->end(it);
+  g.label.assign(g.elements.size(), self);
+}
+
+/* each component takes the largest part it touches as its label.
+   every round sends, for each link, the label of its component
+   if it changed since it was last sent, so the exchange stops
+   one round after the labels settle */
+static void exchangeInterfaceLabels(apf::Mesh2* m, apf::MeshTag* t,
+    InterfaceGraph& g, int& rounds, long& labels)
+{
+  rounds = 0;
+  labels = 0;
+  for (;;) {
+    PCU_Comm_Begin();
+    for (size_t i = 0; i < g.links.size(); ++i) {
+      InterfaceGraph::Link& l = g.links[i];
+      int label = g.label[g.find(l.element)];
+      if (label == l.sent)
+        continue;
+      PCU_COMM_PACK(l.peer, l.face);
+      PCU_COMM_PACK(l.peer, label);
+      l.sent = label;
+      ++labels;
+    }
+    PCU_Comm_Send();
+    int changed = 0;
+    while (PCU_Comm_Receive()) {
+      apf::MeshEntity* f;
+      int label;
+      PCU_COMM_UNPACK(f);
+      PCU_COMM_UNPACK(label);
+      apf::MeshEntity* e = m->getUpward(f, 0);
+      PCU_ALWAYS_ASSERT(m->hasTag(e, t));
+      int i;
+      m->getIntTag(e, t, &i);
+      int r = g.find(i);
+      if (label > g.label[r]) {
+        g.label[r] = label;
+        changed = 1;
+      }
+    }
+    ++rounds;
+    if (!PCU_Max_Int(changed))
+      break;
+  }
+}
+
+static void planInterfaceMigration(apf::Mesh2* m, InterfaceSet& is,
+    apf::Migration* plan, int& rounds, long& labels)
+{
+  apf::MeshTag* t = m->createIntTag("ph_interface_element", 1);
+  InterfaceGraph g;
+  buildInterfaceGraph(m, is, t, g);
+  exchangeInterfaceLabels(m, t, g, rounds, labels);
+  int self = PCU_Comm_Self();
+  for (size_t i = 0; i < g.elements.size(); ++i) {
+    int to = g.label[g.find(i)];
+    if (to != self)
+      plan->send(g.elements[i], to);
+    m->removeTag(g.elements[i], t);
+  }
+  m->destroyTag(t);
+}
+
+static long countRemoteInterfaces(apf::Mesh2* m, InterfaceSet& is)
+{
+  long n = 0;
+  apf::MeshIterator* it = m->begin(m->getDimension() - 1);
+  apf::MeshEntity* f;
+  while ((f = m->iterate(it))) {
+    if (!isInterfaceFace(m, is, f))
+      continue;
+    apf::DgCopies dgCopies;
+    m->getDgCopies(f, dgCopies);
+    for (size_t j = 0; j < dgCopies.getSize(); ++j)
+      if (dgCopies[j].peer != PCU_Comm_Self())
+        ++n;
+  }
+  m->end(it);
+  return PCU_Add_Long(n);
+}
+
+/* the plan moves each component to the largest part it touches
+   without looking at the load, so the element imbalance before
+   and after it is reported */
+static double getElementImbalance(apf::Mesh* m)
+{
+  long n = m->count(m->getDimension());
+  double avg = static_cast<double>(PCU_Add_Long(n)) / PCU_Comm_Peers();
+  return PCU_Max_Double(n / avg);
+}
+
 bool migrateInterfaceItr(apf::Mesh2*& m, ph::BCs& bcs) {
+  std::string name("DG interface");
+  if (!haveBC(bcs, name))
+    return false;
+  double t0 = PCU_Time();
+  double imbalance = getElementImbalance(m);
+  InterfaceSet is;
+  findInterfaces(m->getModel(), bcs.fields[name], is);
+  apf::Migration* plan = new apf::Migration(m);
+  int rounds;
+  long labels;
+  planInterfaceMigration(m, is, plan, rounds, labels);
+  long moved = PCU_Add_Long(plan->count());
+  labels = PCU_Add_Long(labels);
+  m->migrate(plan);
+  long remaining = countRemoteInterfaces(m, is);
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "migrate interface: %d label rounds, %ld labels "
+        "(%ld bytes) exchanged, %ld elements moved in %f seconds\n",
+        rounds, labels, labels * long(sizeof(apf::MeshEntity*) + sizeof(int)),
+        moved, PCU_Time() - t0);
+  /* every component lands on one part, the pairwise
+     migrations remain as a fallback */
   int maxItr = 10;
-  int itr = 0;
-  int result = 1;
-  while(result != 0) {
-    result = migrateInterface(m, bcs);
-    itr++;
-    if(itr >= maxItr) {
-      lion_oprint(1,"migrate interface iteration more than maxItr");
-      break;
-    }
-    if(result == -1)
-      return false;
+  for (int itr = 0; remaining && itr < maxItr; ++itr) {
+    migrateInterface(m, bcs);
+    remaining = countRemoteInterfaces(m, is);
   }
+  if (remaining)
+    lion_oprint(1,"migrate interface iteration more than maxItr\n");
+  double after = getElementImbalance(m);
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "migrate interface: max element imbalance %f before, "
+        "%f after\n", imbalance, after);
   return true;
 }
 
@@ -4,6 +4,7 @@
 #include <apf.h>
 #include <phInterfaceCutter.h>
 #include <pcu_util.h>
+#include <algorithm>
 
 namespace ph {
 
@@ -96,9 +97,37 @@ struct PhastaSharing : public apf::Sharing {
    of this code.
 */
 
+/* counting sort of the (peer, entity) pairs of one direction
+   into links, keeping the order of entities within a link */
+static void appendLinks(int send, std::vector<int> const& peers,
+    std::vector<apf::MeshEntity*> const& ents, Links& links)
+{
+  std::vector<int> sorted(peers);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  std::vector<int> slots(peers.size());
+  std::vector<int> next(sorted.size() + 1, 0);
+  for (size_t i = 0; i < peers.size(); ++i) {
+    slots[i] = std::lower_bound(sorted.begin(), sorted.end(), peers[i])
+      - sorted.begin();
+    ++next[slots[i] + 1];
+  }
+  int base = links.entities.size();
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    next[i + 1] += next[i];
+    links.keys.push_back(LinkKey(send, sorted[i]));
+    links.offsets.push_back(base + next[i + 1]);
+  }
+  links.entities.resize(base + ents.size());
+  for (size_t i = 0; i < ents.size(); ++i)
+    links.entities[base + next[slots[i]]++] = ents[i];
+}
+
 void getLinks(apf::Mesh* m, int dim, Links& links, BCs& bcs)
 {
   PhastaSharing shr(m);
+  std::vector<int> peers;
+  std::vector<apf::MeshEntity*> ents;
   PCU_Comm_Begin();
   apf::MeshIterator* it = m->begin(dim);
   apf::MeshEntity* v;
@@ -117,20 +146,28 @@ void getLinks(apf::Mesh* m, int dim, Links& links, BCs& bcs)
       /* in matching we may accumulate multiple occurrences
          of the same master in the outgoing links array
          to a part that contains multiple copies of it. */
-      links[LinkKey(1, remotes[i].peer)].push_back(v);
+      peers.push_back(remotes[i].peer);
+      ents.push_back(v);
       PCU_COMM_PACK(remotes[i].peer, remotes[i].entity);
     }
   }
   m->end(it);
+  links = Links();
+  links.offsets.push_back(0);
+  appendLinks(1, peers, ents, links);
+  peers.clear();
+  ents.clear();
   PCU_Comm_Send();
   while (PCU_Comm_Listen()) {
     int peer = PCU_Comm_Sender();
     while (!PCU_Comm_Unpacked()) {
       apf::MeshEntity* v;
       PCU_COMM_UNPACK(v);
-      links[LinkKey(0, peer)].push_back(v);
+      peers.push_back(peer);
+      ents.push_back(v);
     }
   }
+  appendLinks(0, peers, ents, links);
 }
 
 /* encode the local links into a big array of integers
@@ -153,23 +190,20 @@ void getLinks(apf::Mesh* m, int dim, Links& links, BCs& bcs)
 void encodeILWORK(apf::Numbering* n, Links& links, int& size, int*& a)
 {
   size = 1; // total links
-  APF_ITERATE(Links, links, it) {
-    size += 4; //link header
-    size += it->second.size() * 2; //entity entries
-  }
+  size += links.size() * 4; //link headers
+  size += links.entities.size() * 2; //entity entries
   a = new int[size];
   a[0] = links.size();
   int i = 1;
-  APF_ITERATE(Links, links, it) {
-    LinkKey k = it->first;
-    Link& l = it->second;
+  for (size_t l = 0; l < links.size(); ++l) {
+    LinkKey k = links.keys[l];
     a[i++] = 0;
     a[i++] = k.send;
     a[i++] = k.peer + 1; /* peers numbered from 1 */
-    a[i++] = l.size();
-    APF_ITERATE(Link, l, lit) {
+    a[i++] = links.offsets[l + 1] - links.offsets[l];
+    for (int j = links.offsets[l]; j < links.offsets[l + 1]; ++j) {
       /* entities also numbered from 1 */
-      a[i++] = apf::getNumber(n, *lit, 0, 0) + 1;
+      a[i++] = apf::getNumber(n, links.entities[j], 0, 0) + 1;
       a[i++] = 1;
     }
   }
@@ -185,21 +219,18 @@ void encodeILWORKF(apf::Numbering* n, Links& links, int& size, int*& a)
 {
   apf::Mesh* m = apf::getMesh(n);
   size = 1; // total links
-  APF_ITERATE(Links, links, it) {
-    size += 2; //link header
-    size += it->second.size(); //entity entries
-  }
+  size += links.size() * 2; //link headers
+  size += links.entities.size(); //entity entries
   a = new int[size];
   a[0] = links.size();
   int i = 1;
-  APF_ITERATE(Links, links, it) {
-    LinkKey k = it->first;
-    Link& l = it->second;
+  for (size_t l = 0; l < links.size(); ++l) {
+    LinkKey k = links.keys[l];
     a[i++] = k.peer + 1; /* peers numbered from 1 */
-    a[i++] = l.size();
-    APF_ITERATE(Link, l, lit) {
+    a[i++] = links.offsets[l + 1] - links.offsets[l];
+    for (int j = links.offsets[l]; j < links.offsets[l + 1]; ++j) {
       /* entities also numbered from 1 */
-      apf::MeshEntity* e = getSideElement(m, *lit);
+      apf::MeshEntity* e = getSideElement(m, links.entities[j]);
       a[i++] = apf::getNumber(n, e, 0, 0) + 1;
     }
   }
@@ -17,9 +17,19 @@ struct LinkKey
   bool operator<(LinkKey const& other) const;
 };
 
-typedef std::vector<apf::MeshEntity*> Link;
-
-typedef std::map<LinkKey, Link> Links;
+/* the links of one part as flat arrays, sorted by LinkKey:
+   sends before receives, then by peer.
+   link i holds entities[offsets[i]] to entities[offsets[i + 1] - 1] */
+struct Links
+{
+  std::vector<LinkKey> keys;
+  std::vector<int> offsets;
+  std::vector<apf::MeshEntity*> entities;
+  size_t size() const
+  {
+    return keys.size();
+  }
+};
 
 void getLinks(apf::Mesh* m, int dim, Links& links, ph::BCs& bcs);
 
@@ -21,6 +21,8 @@
 #include <stdlib.h>
 #include <typeinfo>
 #include <pcu_util.h>
+#include <apfThreads.h>
+#include <algorithm>
 
 namespace ph {
 
@@ -132,6 +134,60 @@ static void getVertexLinks(Output& o, apf::Numbering* n, BCs& bcs)
   encodeILWORK(n, links, o.nlwork, o.arrays.ilwork);
 }
 
+/* block entities are handed to threads in batches of this many */
+enum { BLOCK_BATCH = 4096 };
+
+template <class F>
+struct BlockWork : public apf::ThreadWork
+{
+  BlocksCommon* blocks;
+  F* fill;
+  void run(int, int first, int last)
+  {
+    std::vector<int>& offsets = blocks->offsets;
+    int i = std::upper_bound(offsets.begin(), offsets.end(), first)
+      - offsets.begin() - 1;
+    for (int e = first; e < last; ++e) {
+      while (e >= offsets[i + 1])
+        ++i;
+      (*fill)(i, e - offsets[i], blocks->entities[e]);
+    }
+  }
+};
+
+/* calls fill(i, j, e) for every entity e, the j'th of block i,
+   through apf::runThreads. fill may only read the mesh and write
+   its own slots of the output arrays */
+template <class F>
+static void fillBlocks(apf::Mesh* m, BlocksCommon& bs, F& fill, int threads)
+{
+  BlockWork<F> w;
+  w.blocks = &bs;
+  w.fill = &fill;
+  int total = bs.entities.size();
+  threads = apf::countThreads(threads, total, BLOCK_BATCH);
+  if (threads > 1)
+    apf::prepareThreadedReads(m);
+  apf::runThreads(&w, total, threads, BLOCK_BATCH);
+}
+
+struct InteriorFill
+{
+  apf::Mesh* mesh;
+  apf::Numbering* n;
+  Blocks* blocks;
+  int*** ien;
+  void operator()(int i, int j, apf::MeshEntity* e)
+  {
+    int nv = blocks->nElementNodes[i];
+    ien[i][j] = new int[nv];
+    apf::Downward v;
+    getVertices(mesh, e, v);
+    for (int k = 0; k < nv; ++k)
+      ien[i][j][k] = apf::getNumber(n, v[k], 0, 0);
+  }
+};
+
 static void getInterior(Output& o, BCs& bcs, apf::Numbering* n)
 {
   apf::Mesh* m = o.mesh;
@@ -140,45 +196,30 @@ static void getInterior(Output& o, BCs& bcs, apf::Numbering* n)
   int**  mattype = 0;
   if (bcs.fields.count("material type"))
     mattype = new int* [bs.getSize()];
-  apf::NewArray<int> js(bs.getSize());
   for (int i = 0; i < bs.getSize(); ++i) {
     ien    [i] = new int*[bs.nElements[i]];
     if (mattype)
       mattype[i] = new int [bs.nElements[i]];
-    js[i] = 0;
   }
-  gmi_model* gm = m->getModel();
-  apf::MeshEntity* e;
-  apf::MeshIterator* it = m->begin(m->getDimension());
-  while ((e = m->iterate(it))) {
-    BlockKey k;
-    getInteriorBlockKey(m, e, k);
-    int nv = k.nElementVertices;
-    PCU_ALWAYS_ASSERT(bs.keyToIndex.count(k));
-    int i = bs.keyToIndex[k];
-    int j = js[i];
-    ien[i][j] = new int[nv];
-    apf::Downward v;
-    getVertices(m, e, v);
-    for (int k = 0; k < nv; ++k)
-      ien[i][j][k] = apf::getNumber(n, v[k], 0, 0);
-
-    /* get material type */
-    if (mattype) {
-      gmi_ent* ge = (gmi_ent*)m->toModel(e);
-      apf::Vector3 x;
-      //m->getPoint(e, 0, x);
-      x = apf::getLinearCentroid(m, e);
-      std::string s("material type");
-      FieldBCs& fbcs = bcs.fields[s];
-      double* matval = getBCValue(gm, fbcs, ge, x);
-      mattype[i][j] = *matval;
-    }
-    ++js[i];
+  InteriorFill fill;
+  fill.mesh = m;
+  fill.n = n;
+  fill.blocks = &bs;
+  fill.ien = ien;
+  fillBlocks(m, bs, fill, o.in->outputThreads);
+  /* get material type */
+  if (mattype) {
+    gmi_model* gm = m->getModel();
+    FieldBCs& fbcs = bcs.fields["material type"];
+    for (int i = 0; i < bs.getSize(); ++i)
+      for (int j = 0; j < bs.nElements[i]; ++j) {
+        apf::MeshEntity* e = bs.entities[bs.offsets[i] + j];
+        gmi_ent* ge = (gmi_ent*)m->toModel(e);
+        apf::Vector3 x = apf::getLinearCentroid(m, e);
+        double* matval = getBCValue(gm, fbcs, ge, x);
+        mattype[i][j] = *matval;
+      }
   }
-  m->end(it);
-  for (int i = 0; i < bs.getSize(); ++i)
-    PCU_ALWAYS_ASSERT(js[i] == bs.nElements[i]);
   o.arrays.ien     = ien;
   o.arrays.mattype = mattype;
 }
@@ -223,6 +264,25 @@ static void checkBoundaryVertex(apf::Mesh* m,
     PCU_ALWAYS_ASSERT((p[3]-p[0]) * apf::cross((p[1]-p[0]), (p[2]-p[0])) > 0);
 }
 
+struct BoundaryFill
+{
+  apf::Mesh* mesh;
+  apf::Numbering* n;
+  Blocks* blocks;
+  int*** ienb;
+  void operator()(int i, int j, apf::MeshEntity* f)
+  {
+    apf::MeshEntity* e = mesh->getUpward(f, 0);
+    int nv = blocks->nElementNodes[i];
+    apf::Downward v;
+    getBoundaryVertices(mesh, e, f, v);
+    ienb[i][j] = new int[nv];
+    checkBoundaryVertex(mesh, f, v, blocks->keys[i].elementType);
+    for (int k = 0; k < nv; ++k)
+      ienb[i][j][k] = apf::getNumber(n, v[k], 0, 0);
+  }
+};
+
 static void getBoundary(Output& o, BCs& bcs, apf::Numbering* n)
 {
   apf::Mesh* m = o.mesh;
@@ -235,63 +295,40 @@ static void getBoundary(Output& o, BCs& bcs, apf::Numbering* n)
     mattypeb = new int*[bs.getSize()];
   int*** ibcb = new int**[bs.getSize()];
   double*** bcb = new double**[bs.getSize()];
-  apf::NewArray<int> js(bs.getSize());
   for (int i = 0; i < bs.getSize(); ++i) {
     ienb[i]     = new int*[bs.nElements[i]];
     if (mattypeb)
       mattypeb[i] = new int [bs.nElements[i]];
     ibcb[i]     = new int*[bs.nElements[i]];
     bcb[i]      = new double*[bs.nElements[i]];
-    js[i] = 0;
   }
-  int boundaryDim = m->getDimension() - 1;
-  apf::MeshEntity* f;
-  apf::MeshIterator* it = m->begin(boundaryDim);
-  while ((f = m->iterate(it))) {
-    apf::ModelEntity* me = m->toModel(f);
-    if (m->getModelType(me) != boundaryDim)
-      continue;
-    if (getBCValue(m->getModel(), bcs.fields["DG interface"], (gmi_ent*) me) != 0){
-      apf::DgCopies dgCopies;
-      m->getDgCopies(f, dgCopies);
-      if (dgCopies.getSize() == 1) // This prevents adding interface elements...
-        continue;
-    }
-    if (m->countUpward(f)>1)   // don't want interior region boundaries here...
-      continue;
-    gmi_ent* gf = (gmi_ent*)me;
-    apf::MeshEntity* e = m->getUpward(f, 0);
-    BlockKey k;
-    getBoundaryBlockKey(m, e, f, k);
-    PCU_ALWAYS_ASSERT(bs.keyToIndex.count(k));
-    int i = bs.keyToIndex[k];
-    int j = js[i];
-    int nv = k.nElementVertices;
-    apf::Downward v;
-    getBoundaryVertices(m, e, f, v);
-    ienb[i][j] = new int[nv];
-    checkBoundaryVertex(m, f, v, k.elementType);
-    for (int k = 0; k < nv; ++k)
-      ienb[i][j][k] = apf::getNumber(n, v[k], 0, 0);
-    bcb[i][j] = new double[nbc]();
-    ibcb[i][j] = new int[2](); /* <- parens initialize to zero */
-    apf::Vector3 x = apf::getLinearCentroid(m, f);
-    applyNaturalBCs(gm, gf, bcs, x, bcb[i][j], ibcb[i][j]);
+  BoundaryFill fill;
+  fill.mesh = m;
+  fill.n = n;
+  fill.blocks = &bs;
+  fill.ienb = ienb;
+  fillBlocks(m, bs, fill, o.in->outputThreads);
+  /* boundary conditions are evaluated by one thread */
+  for (int i = 0; i < bs.getSize(); ++i)
+    for (int j = 0; j < bs.nElements[i]; ++j) {
+      apf::MeshEntity* f = bs.entities[bs.offsets[i] + j];
+      gmi_ent* gf = (gmi_ent*)m->toModel(f);
+      bcb[i][j] = new double[nbc]();
+      ibcb[i][j] = new int[2](); /* <- parens initialize to zero */
+      apf::Vector3 x = apf::getLinearCentroid(m, f);
+      applyNaturalBCs(gm, gf, bcs, x, bcb[i][j], ibcb[i][j]);
 
-    /* get material type */
-    if (mattypeb) {
-      gmi_ent* ge = (gmi_ent*)m->toModel(e);
-      x = apf::getLinearCentroid(m, e);
-      std::string s("material type");
-      FieldBCs& fbcs = bcs.fields[s];
-      double* matvalb = getBCValue(gm, fbcs, ge, x);
-      mattypeb[i][j] = *matvalb;
+      /* get material type */
+      if (mattypeb) {
+        apf::MeshEntity* e = m->getUpward(f, 0);
+        gmi_ent* ge = (gmi_ent*)m->toModel(e);
+        x = apf::getLinearCentroid(m, e);
+        std::string s("material type");
+        FieldBCs& fbcs = bcs.fields[s];
+        double* matvalb = getBCValue(gm, fbcs, ge, x);
+        mattypeb[i][j] = *matvalb;
+      }
     }
-    ++js[i];
-  }
-  m->end(it);
-  for (int i = 0; i < bs.getSize(); ++i)
-    PCU_ALWAYS_ASSERT(js[i] == bs.nElements[i]);
   o.arrays.ienb = ienb;
   o.arrays.mattypeb = mattypeb;
   o.arrays.ibcb = ibcb;
@@ -483,38 +520,21 @@ static void getInterface
     mattypeif0 = new int*[bs.getSize()];
     mattypeif1 = new int*[bs.getSize()];
   }
-  apf::NewArray<int> js(bs.getSize());
   for (int i = 0; i < bs.getSize(); ++i) {
     ienif0[i] = new int*[bs.nElements[i]];
     ienif1[i] = new int*[bs.nElements[i]];
     if (mattypeif0) mattypeif0[i] = new int [bs.nElements[i]];
     if (mattypeif1) mattypeif1[i] = new int [bs.nElements[i]];
-    js[i] = 0;
   }
-  int interfaceDim = m->getDimension() - 1;
-  apf::MeshEntity*   face;
-  apf::MeshIterator* it = m->begin(interfaceDim);
-
-  while ((face = m->iterate(it))) {
-    apf::ModelEntity* me = m->toModel(face);
-    if (getBCValue(m->getModel(), bcs.fields["DG interface"], (gmi_ent*) me) == 0)
-      continue;
-    if (m->getModelType(me) != interfaceDim)
-      continue;
+  for (int i = 0; i < bs.getSize(); ++i)
+  for (int j = 0; j < bs.nElements[i]; ++j) {
+    apf::MeshEntity* face = bs.entities[bs.offsets[i] + j];
     apf::DgCopies dgCopies;
     m->getDgCopies(face, dgCopies);
     PCU_ALWAYS_ASSERT(dgCopies.getSize() == 1);
     apf::MeshEntity* e0 = m->getUpward(face, 0);
     apf::MeshEntity* e1 = m->getUpward(dgCopies[0].entity, 0);
-    /* in order to avoid repeatation of elements */
-    if (e0 > e1)
-      continue;
-
-    BlockKeyInterface k;
-    getInterfaceBlockKey(m, e0, e1, face, k);
-    PCU_ALWAYS_ASSERT(bs.keyToIndex.count(k));
-    int i = bs.keyToIndex[k];
-    int j = js[i];
+    BlockKeyInterface& k = bs.keys[i];
     int nv0 = k.nElementVertices;
     int nv1 = k.nElementVertices1;
     apf::Downward v0, v1;
@@ -578,11 +598,7 @@ static void getInterface
       mattypeif0[i][j] = *matvalif0;
       mattypeif1[i][j] = *matvalif1;
     }
-    ++js[i];
   }
-  m->end(it);
-  for (int i = 0; i < bs.getSize(); ++i)
-    PCU_ALWAYS_ASSERT(js[i] == bs.nElements[i]);
   o.arrays.ienif0 = ienif0;
   o.arrays.ienif1 = ienif1;
   o.arrays.mattypeif0 = mattypeif0;
@@ -1028,10 +1044,13 @@ void generateOutput(Input& in, BCs& bcs, apf::Mesh* mesh, Output& o)
   if (in.mesh2geom)
     getM2GFields(o);
   getGlobal(o);
+  double tBlocks = PCU_Time();
   getAllBlocks(o.mesh, bcs, o.blocks);
   apf::Numbering* n = apf::numberOverlapNodes(mesh, "ph_local");
   apf::Numbering* rn = apf::numberElements(o.mesh, "ph_elem");
+  double tLinks = PCU_Time();
   getVertexLinks(o, n, bcs);
+  double tConnectivity = PCU_Time();
   getInterior(o, bcs, n);
   getBoundary(o, bcs, n);
   getInterfaceFlag(o, bcs);
@@ -1039,14 +1058,17 @@ void generateOutput(Input& in, BCs& bcs, apf::Mesh* mesh, Output& o)
   checkInterface(o,bcs);
   getRigidBody(o,bcs,n);
   getLocalPeriodicMasters(o, n, bcs);
+  double tEdges = PCU_Time();
   getEdges(o, n, rn, bcs);
   getGrowthCurves(o);
   getBoundaryElements(o);
   getInterfaceElements(o);
   getMaxElementNodes(o);
+  double tBCs = PCU_Time();
   getEssentialBCs(bcs, o);
   getGCEssentialBCs(o, n);
   getInitialConditions(bcs, o);
+  double tGraph = PCU_Time();
   getElementGraph(o, rn, bcs);
   apf::destroyNumbering(n);
   apf::destroyNumbering(rn);
@@ -1055,6 +1077,20 @@ void generateOutput(Input& in, BCs& bcs, apf::Mesh* mesh, Output& o)
   double t1 = PCU_Time();
   if (!PCU_Comm_Self())
     lion_oprint(1,"generated output structs in %f seconds\n",t1 - t0);
+  if (in.timing) {
+    /* the slowest part of each step */
+    double steps[7] = {tBlocks - t0, tLinks - tBlocks,
+      tConnectivity - tLinks, tEdges - tConnectivity, tBCs - tEdges,
+      tGraph - tBCs, t1 - tGraph};
+    const char* names[7] = {"counts and coordinates", "blocks",
+      "vertex links", "connectivity", "edges", "boundary conditions",
+      "element graph"};
+    for (int i = 0; i < 7; ++i) {
+      double t = PCU_Max_Double(steps[i]);
+      if (!PCU_Comm_Self())
+        lion_oprint(1,"  %s: %f seconds\n", names[i], t);
+    }
+  }
 }
 
 }
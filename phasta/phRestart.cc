@@ -7,6 +7,7 @@
 #include "phiotimer.h"
 #include "apfShape.h"
 #include "ph.h"
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
@@ -328,6 +329,33 @@ static bool isNodalField(const char* fieldname, int nnodes, apf::Mesh* m)
   return false;
 }
 
+/* returns true for nodal fields */
+static bool attachSolutionField(
+    Input& in,
+    apf::Mesh* m,
+    const char* name,
+    double* data,
+    int nodes,
+    int vars)
+{
+  if (!isNodalField(name, nodes, m)) {
+    if (!attachRandField(in, name, data, nodes, vars))
+      attachCellField(m, name, data, vars, vars);
+    return false;
+  }
+  int out_size = vars;
+  if ( std::string(name) == std::string("solution") )
+    out_size = in.ensa_dof;
+  if (m->findField(name)) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "field \"%s\" already attached to the mesh, "
+                      "ignoring request to re-attach...\n", name);
+  } else {
+    attachField(m, name, data, vars, out_size);
+  }
+  return true;
+}
+
 int readAndAttachField(
     Input& in,
     FILE* f,
@@ -343,46 +371,26 @@ int readAndAttachField(
   /* no field was found or the field has an empty data block */
   if(ret==0 || ret==1)
     return ret;
-  if (!isNodalField(hname, nodes, m)) {
-    if (attachRandField(in, hname, data, nodes, vars)) {
-      free(data);
-      return 1;
-    }
-    attachCellField(m, hname, data, vars, vars);
-    free(data);
-    return 1;
-  }
-  PCU_ALWAYS_ASSERT(step == in.timeStepNumber);
-  int out_size = vars;
-  if ( std::string(hname) == std::string("solution") )
-    out_size = in.ensa_dof;
-  if (m->findField(hname)) {
-    if (!PCU_Comm_Self())
-      lion_eprint(1, "field \"%s\" already attached to the mesh, "
-                      "ignoring request to re-attach...\n", hname);
-  } else {
-    attachField(m, hname, data, vars, out_size);
-  }
+  if (attachSolutionField(in, m, hname, data, nodes, vars))
+    PCU_ALWAYS_ASSERT(step == in.timeStepNumber);
   free(data);
   return 1;
 }
 
-void detachAndWriteField(
-    Input& in,
+static void detachSolutionField(
     apf::Mesh* m,
-    FILE* f,
+    Solution& s,
     const char* fieldname)
 {
   double* data;
   int size;
   detachField(m, fieldname, data, size);
-  ph_write_field(f, fieldname, data, m->count(0), size, in.timeStepNumber);
-  free(data);
+  s.add(fieldname, data, m->count(0), size);
 }
 
-void detachAndWriteRandField(
+static void detachRandField(
     Input& in,
-    FILE* f,
+    Solution& s,
     const char* fieldname)
 {
   if (!strcmp(fieldname, "rbParams")) {
@@ -396,12 +404,47 @@ void detachAndWriteRandField(
         iv++;
       }
     }
-    ph_write_field(f, fieldname, data, nnodes, nvars, in.timeStepNumber);
-    free(data);
+    s.add(fieldname, data, nnodes, nvars);
     in.rbParamData.clear();
   }
 }
 
+Solution::~Solution()
+{
+  clear();
+}
+
+void Solution::add(const char* name, double* data, int nEntities,
+    int nComponents)
+{
+  SolutionField* f = find(name);
+  if (f) {
+    free(f->data);
+  } else {
+    fields.push_back(SolutionField());
+    f = &fields.back();
+    f->name = name;
+  }
+  f->data = data;
+  f->nEntities = nEntities;
+  f->nComponents = nComponents;
+}
+
+SolutionField* Solution::find(const char* name)
+{
+  for (size_t i = 0; i < fields.size(); ++i)
+    if (fields[i].name == name)
+      return &fields[i];
+  return 0;
+}
+
+void Solution::clear()
+{
+  for (size_t i = 0; i < fields.size(); ++i)
+    free(fields[i].data);
+  fields.clear();
+}
+
 /* silliest darn fields I ever did see */
 static double* buildMappingPartId(apf::Mesh* m)
 {
@@ -480,49 +523,128 @@ void attachZeroSolution(Input& in, apf::Mesh* m)
   delete [] data;
 }
 
+/* the mesh fields a solver takes, in restart file order */
+static void getSolutionFields(Input& in, apf::Mesh* m,
+    std::vector<std::string>& names)
+{
+  const char* optional[6] = {"solution", "time derivative of solution",
+    "motion_coords", "mesh_vel", "dc_lag", "pressure projection vectors"};
+  for (int i = 0; i < 6; ++i)
+    if (m->findField(optional[i]))
+      names.push_back(optional[i]);
+  if (in.displacementMigration)
+    names.push_back("displacement");
+  if (in.dwalMigration)
+    names.push_back("dwal");
+  if (in.buildMapping) {
+    names.push_back("mapping_partid");
+    names.push_back("mapping_vtxid");
+  }
+}
+
+/* the other fields go first, so they are never held
+   alongside the detached arrays */
+static void destroyOtherFields(apf::Mesh* m,
+    std::vector<std::string> const& keep)
+{
+  for (int i = m->countFields() - 1; i >= 0; --i) {
+    apf::Field* f = m->getField(i);
+    if (std::find(keep.begin(), keep.end(), apf::getName(f)) == keep.end())
+      apf::destroyField(f);
+  }
+}
+
+void detachSolution(Input& in, apf::Mesh* m, Solution& s)
+{
+  std::vector<std::string> names;
+  getSolutionFields(in, m, names);
+  destroyOtherFields(m, names);
+  for (size_t i = 0; i < names.size(); ++i)
+    detachSolutionField(m, s, names[i].c_str());
+  if (in.nRigidBody)
+    detachRandField(in, s, "rbParams");
+  PCU_ALWAYS_ASSERT(!m->countFields());
+}
+
+void attachSolution(Input& in, apf::Mesh* m, Solution& s)
+{
+  double t0 = PCU_Time();
+  for (size_t i = 0; i < s.fields.size(); ++i) {
+    SolutionField& f = s.fields[i];
+    attachSolutionField(in, m, f.name.c_str(), f.data,
+        f.nEntities, f.nComponents);
+  }
+  s.clear();
+  double t1 = PCU_Time();
+  if (!PCU_Comm_Self())
+    lion_oprint(1,"fields attached from memory in %f seconds\n", t1 - t0);
+}
+
+static void writeRestartHeader(Input& in, int nodes, FILE* f)
+{
+  ph_write_preamble(f);
+  ph_write_header(f, "number of modes", 0, 1, &nodes);
+  ph_write_header(f, "number of variables", 0, 1, &in.ensa_dof);
+}
+
+static void writeSolution(Input& in, Solution& s, FILE* f)
+{
+  for (size_t i = 0; i < s.fields.size(); ++i)
+    ph_write_field(f, s.fields[i].name.c_str(), s.fields[i].data,
+        s.fields[i].nEntities, s.fields[i].nComponents, in.timeStepNumber);
+}
+
+/* the size of the restart file, from the field sizes alone */
+static size_t countRestartBytes(Input& in, apf::Mesh* m,
+    std::vector<std::string> const& names)
+{
+  int nodes = m->count(0);
+  ph_start_count();
+  writeRestartHeader(in, nodes, NULL);
+  for (size_t i = 0; i < names.size(); ++i) {
+    apf::Field* f = m->findField(names[i].c_str());
+    PCU_ALWAYS_ASSERT(f);
+    ph_write_field(NULL, names[i].c_str(), NULL, nodes,
+        apf::countComponents(f), in.timeStepNumber);
+  }
+  if (in.nRigidBody)
+    ph_write_field(NULL, "rbParams", NULL, in.nRigidBody, in.nRBParam,
+        in.timeStepNumber);
+  return ph_count_bytes();
+}
+
+/* each field is detached, written and freed before the next, so only
+   one is ever held outside the mesh */
 void detachAndWriteSolution(Input& in, Output& out, apf::Mesh* m, std::string path)
 {
   double t0 = PCU_Time();
   path += buildRestartFileName("restart", in.timeStepNumber);
   phastaio_setfile(RESTART_WRITE);
+  std::vector<std::string> names;
+  getSolutionFields(in, m, names);
+  destroyOtherFields(m, names);
+  /* like writeGeomBC, the file goes out of one buffer of its size */
+  size_t bytes = countRestartBytes(in, m, names);
   FILE* f = out.openfile_write(out, path.c_str());
   if (!f) {
     lion_eprint(1,"failed to open \"%s\"!\n", path.c_str());
     abort();
   }
-  ph_write_preamble(f);
-  int nodes = m->count(0);
-  ph_write_header(f, "number of modes", 0, 1, &nodes);
-  ph_write_header(f, "number of variables", 0, 1, &in.ensa_dof);
-  apf::Field* errField = m->findField("errors");
-  if (errField)
-    apf::destroyField(errField);
-  if (m->findField("solution"))
-    detachAndWriteField(in, m, f, "solution");
-  if (m->findField("time derivative of solution"))
-    detachAndWriteField(in, m, f, "time derivative of solution");
-  if (m->findField("motion_coords"))
-    detachAndWriteField(in, m, f, "motion_coords");
-  if (m->findField("mesh_vel"))
-    detachAndWriteField(in, m, f, "mesh_vel");
-  if (m->findField("dc_lag"))
-    detachAndWriteField(in, m, f, "dc_lag");
-  if (m->findField("pressure projection vectors"))
-    detachAndWriteField(in, m, f, "pressure projection vectors");
-  if (in.displacementMigration)
-    detachAndWriteField(in, m, f, "displacement");
-  if (in.dwalMigration)
-    detachAndWriteField(in, m, f, "dwal");
-  if (in.buildMapping) {
-    detachAndWriteField(in, m, f, "mapping_partid");
-    detachAndWriteField(in, m, f, "mapping_vtxid");
+  char* buffer = ph_size_buffer(f, bytes);
+  writeRestartHeader(in, m->count(0), f);
+  Solution s;
+  for (size_t i = 0; i < names.size(); ++i) {
+    detachSolutionField(m, s, names[i].c_str());
+    writeSolution(in, s, f);
+    s.clear();
   }
-  if (in.nRigidBody)
-    detachAndWriteRandField(in, f, "rbParams");
-  /* destroy any remaining fields */
-  while(m->countFields())
-    apf::destroyField( m->getField(0) );
-  PHASTAIO_CLOSETIME(fclose(f);)
+  if (in.nRigidBody) {
+    detachRandField(in, s, "rbParams");
+    writeSolution(in, s, f);
+    s.clear();
+  }
+  ph_close_file(f, buffer, bytes);
+  PCU_ALWAYS_ASSERT(!m->countFields());
   double t1 = PCU_Time();
   if (!PCU_Comm_Self())
     lion_oprint(1,"solution written in %f seconds\n", t1 - t0);
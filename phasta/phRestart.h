@@ -4,9 +4,45 @@
 #include "phInput.h"
 #include "phOutput.h"
 #include <apfMesh.h>
+#include <string>
+#include <vector>
 
 namespace ph {
 
+/** \brief a restart field held in memory
+  \details values are laid out as in the restart files, so component
+  j of entity i is data[j * nEntities + i]. data is allocated with
+  malloc and belongs to the Solution holding the field. */
+struct SolutionField
+{
+  std::string name;
+  double* data;
+  int nEntities;
+  int nComponents;
+};
+
+/** \brief the restart fields of one part, handed between chef and a
+  coupled solver in memory
+  \details this replaces a restart file or stream: there are no
+  headers, no byte swapping and no parsing, the solver reads and
+  writes the arrays directly. */
+struct Solution
+{
+  Solution() {}
+  ~Solution();
+  /** \brief add a field, taking ownership of its malloc'ed data.
+    a field of the same name is replaced */
+  void add(const char* name, double* data, int nEntities, int nComponents);
+  /** \brief the field with this name, or null */
+  SolutionField* find(const char* name);
+  /** \brief free all fields */
+  void clear();
+  std::vector<SolutionField> fields;
+private:
+  Solution(Solution const&);
+  Solution& operator=(Solution const&);
+};
+
 apf::Field* extractField(apf::Mesh* m,
     const char* packedFieldname,
     const char* requestFieldname,
@@ -25,6 +61,15 @@ void buildMapping(apf::Mesh* m);
 void detachAndWriteSolution(Input& in, Output& out, 
     apf::Mesh* m, std::string path);
 void attachZeroSolution(Input& in, apf::Mesh* m);
+/** \brief move the fields detachAndWriteSolution would write into
+  (s) and destroy all mesh fields
+  \details the other mesh fields are destroyed first and each field
+  is destroyed as soon as it is copied, so the solution fields are
+  held about once, either in the mesh or in (s). */
+void detachSolution(Input& in, apf::Mesh* m, Solution& s);
+/** \brief attach the fields of (s) to the mesh as readAndAttachFields
+  would, then free them */
+void attachSolution(Input& in, apf::Mesh* m, Solution& s);
 
 void detachField(apf::Field* f, double*& data, int& size);
 
@@ -18,6 +18,9 @@ struct phastaio_stats {
   size_t writeBytes[NUM_PHASTAIO_MODES];
   size_t reads[NUM_PHASTAIO_MODES];
   size_t writes[NUM_PHASTAIO_MODES];
+  size_t flushTime[NUM_PHASTAIO_MODES];
+  size_t flushBytes[NUM_PHASTAIO_MODES];
+  size_t flushes[NUM_PHASTAIO_MODES];
   size_t openTime[NUM_PHASTAIO_MODES];
   size_t closeTime[NUM_PHASTAIO_MODES];
   size_t opens[NUM_PHASTAIO_MODES];
@@ -113,6 +116,17 @@ void phastaio_addWriteTime(size_t t) {
   phastaio_global_stats.writes[i]++;
 }
 
+void phastaio_addFlushBytes(size_t b) {
+  const int i = phastaio_global_stats.fileIdx;
+  phastaio_global_stats.flushBytes[i] += b;
+}
+
+void phastaio_addFlushTime(size_t t) {
+  const int i = phastaio_global_stats.fileIdx;
+  phastaio_global_stats.flushTime[i] += t;
+  phastaio_global_stats.flushes[i]++;
+}
+
 void phastaio_setfile(int f) {
   char msg[64]; sprintf(msg, "f %d", f);
   PCU_ALWAYS_ASSERT_VERBOSE(f >= 0 && f < NUM_PHASTAIO_MODES, msg);
@@ -194,6 +208,21 @@ static size_t phastaio_getWrites() {
   return phastaio_global_stats.writes[i];
 }
 
+static size_t phastaio_getFlushTime() {
+  const int i = phastaio_global_stats.fileIdx;
+  return phastaio_global_stats.flushTime[i];
+}
+
+static size_t phastaio_getFlushBytes() {
+  const int i = phastaio_global_stats.fileIdx;
+  return phastaio_global_stats.flushBytes[i];
+}
+
+static size_t phastaio_getFlushes() {
+  const int i = phastaio_global_stats.fileIdx;
+  return phastaio_global_stats.flushes[i];
+}
+
 static size_t phastaio_getOpens() {
   const int i = phastaio_global_stats.fileIdx;
   return phastaio_global_stats.opens[i];
@@ -258,6 +287,15 @@ void phastaio_printStats() {
       printMinMaxAvgDbl("writeBandwidth (MB/s)",
           ((double)phastaio_getWriteBytes())/phastaio_getWriteTime());
     }
+    int flushes = PCU_Max_Int((int)phastaio_getFlushes());
+    if(flushes) {
+      totalus += phastaio_getFlushTime();
+      printMinMaxAvgSzt("flushes", phastaio_getFlushes());
+      printMinMaxAvgSzt("flushTime (us)", phastaio_getFlushTime());
+      printMinMaxAvgSzt("flushBytes (B)", phastaio_getFlushBytes());
+      printMinMaxAvgDbl("flushBandwidth (MB/s)",
+          ((double)phastaio_getFlushBytes())/phastaio_getFlushTime());
+    }
     int opens = PCU_Max_Int((int)phastaio_getOpens());
     if(opens) {
       totalus += phastaio_getOpenTime();
@@ -292,6 +330,9 @@ void phastaio_initStats() {
     phastaio_global_stats.writeBytes[i] = 0;
     phastaio_global_stats.reads[i] = 0;
     phastaio_global_stats.writes[i] = 0;
+    phastaio_global_stats.flushTime[i] = 0;
+    phastaio_global_stats.flushBytes[i] = 0;
+    phastaio_global_stats.flushes[i] = 0;
     phastaio_global_stats.openTime[i] = 0;
     phastaio_global_stats.closeTime[i] = 0;
     phastaio_global_stats.opens[i] = 0;
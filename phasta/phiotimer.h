@@ -29,6 +29,16 @@ extern "C" {
     phastaio_addWriteBytes(bytes);\
 }
 
+#define PHASTAIO_FLUSHTIME(cmd,bytes) {\
+    phastaioTime t0,t1;\
+    phastaio_time(&t0);\
+    cmd\
+    phastaio_time(&t1);\
+    const size_t time = phastaio_time_diff(&t0,&t1);\
+    phastaio_addFlushTime(time);\
+    phastaio_addFlushBytes(bytes);\
+}
+
 #define PHASTAIO_OPENTIME(cmd) {\
     phastaioTime t0,t1;\
     phastaio_time(&t0);\
@@ -76,6 +86,10 @@ void phastaio_addWriteBytes(size_t b);
 void phastaio_addReadTime(size_t t);
 /* \brief accumulate time writing */
 void phastaio_addWriteTime(size_t t);
+/* \brief accumulate bytes flushed from memory to a file */
+void phastaio_addFlushBytes(size_t b);
+/* \brief accumulate time flushing from memory to a file */
+void phastaio_addFlushTime(size_t t);
 /* \brief accumulate time opening */
 void phastaio_addOpenTime(size_t t);
 /* \brief accumulate time closing */
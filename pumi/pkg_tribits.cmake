@@ -7,6 +7,7 @@ set(SOURCES
   pumi_geom.cc
   pumi_gentity.cc
   pumi_ghost.cc
+  pumi_ghost_update.cc
   pumi_gtag.cc
   pumi_mesh.cc
   pumi_mentity.cc
@@ -80,6 +80,24 @@ typedef apf::Sharing Ownership;
 typedef apf::Sharing* pOwnership;
 typedef apf::CopyArray CopyArray; // array type for remote copies
 
+/** \brief precomputed ghost field exchange, built by pumi_field_syncGhosts.
+  \details the owned entities whose values go to part sendPeers[i] are
+  send[sendOffsets[i]] ... send[sendOffsets[i+1]-1], and the ghosts filled
+  by part recvPeers[i] are listed the same way in recv. both sides list
+  the entities in the same order so only values are exchanged */
+struct GhostSchedule
+{
+  GhostSchedule(): valid(false) {}
+  void clear();
+  bool valid;
+  std::vector<int> sendPeers;
+  std::vector<int> sendOffsets;
+  std::vector<pMeshEnt> send;
+  std::vector<int> recvPeers;
+  std::vector<int> recvOffsets;
+  std::vector<pMeshEnt> recv;
+};
+
 // singleton to save model/mesh
 class pumi
 {
@@ -97,6 +115,10 @@ public:
   pMeshTag ghost_tag;
   std::vector<pMeshEnt> ghost_vec[4];
   std::vector<pMeshEnt> ghosted_vec[4];
+  // bridge dim, ghost dim, #layer and include copy of each ghost layer
+  std::vector<int> ghost_layers;
+  bool ghost_by_plan;
+  GhostSchedule ghost_schedule;
 private:
   static pumi* _instance;
 };
@@ -220,6 +242,11 @@ void pumi_mesh_createAdjacency(pMesh m, int from_dim, int to_dim);
 void pumi_mesh_deleteAdjacency(pMesh m, int from_dim, int to_dim);
 void pumi_mesh_createFullAdjacency(pMesh m);
 
+// close the gaps left in the mesh arrays by deleted entities
+// (see apf::compactMdsMesh). entity handles change, so the ghost
+// lists are rebuilt
+void pumi_mesh_compact(pMesh m);
+
 // write mesh into a file - mesh_type should be "mds" or "vtk"
 void pumi_mesh_write (pMesh m, const char* fileName, const char* mesh_type="mds");
 pGeom pumi_mesh_getGeom(pMesh m);
@@ -251,6 +278,9 @@ void pumi_mesh_getTag(pMesh m, std::vector<pMeshTag> tags);
 //************************************
 
 // migrate mesh per migration plan which contains a set of pairs [element and destination part]
+// ghosts the migration does not touch are kept, the rest are deleted before
+// and restored after it: ghost layers are recomputed, ghosts from a plan are
+// sent to the same parts, and only the missing ghosts are sent
 void pumi_mesh_migrate(pMesh m, Migration* plan);
 
 //************************************
@@ -344,7 +374,17 @@ void pumi_ghost_createLayer (pMesh m, int brgType, int ghostType, int numLayer,
 // Ghosting: ghosting plan object for local elements or part to destinations. 
 void pumi_ghost_create(pMesh m, Ghosting* plan);
 
-void pumi_ghost_delete (pMesh m);
+/** \brief delete all ghost copies
+  \details with keepLayers the ghost layers are remembered and
+  pumi_ghost_update restores them, e.g. around mesh adaptation */
+void pumi_ghost_delete (pMesh m, bool keepLayers=false);
+
+/** \brief bring the ghost layers created by pumi_ghost_createLayer up to
+  date with the mesh.
+  \details the layers are recomputed, ghost copies that are no longer
+  wanted are deleted and only the missing ones are sent. ghosts created
+  with pumi_ghost_create from a user plan can not be updated */
+void pumi_ghost_update (pMesh m);
 
 //************************************
 // MISCELLANEOUS
@@ -511,6 +551,10 @@ pNumbering pumi_field_getNumbering(pField f);
 void pumi_field_delete(pField f);
 void pumi_field_synchronize(pField f, pOwnership o=NULL);
 void pumi_field_accumulate(pField f, pOwnership o=NULL);
+/** \brief copy the owned values of a field to its ghost copies.
+  \details the exchange schedule is built on the first call after the
+  ghosts change and reused, so each call only sends the field values */
+void pumi_field_syncGhosts(pField f);
 void pumi_field_freeze(pField f);
 void pumi_field_unfreeze(pField f);
 pField pumi_mesh_findField(pMesh m, const char* name);
@@ -210,7 +210,8 @@ static void setupGhosts(pMesh m, EntityVector& received)
 }
 
 // *****************************************
-static void ghost_collectEntities (pMesh m, Ghosting* plan, EntityVector entitiesToGhost[4])
+void ghost_collectEntities (pMesh m, Ghosting* plan,
+    EntityVector entitiesToGhost[4])
 // *****************************************
 {    
 
@@ -391,7 +392,29 @@ void ghost_sendEntities(Ghosting* plan, int entDim,
 #include "apfNumbering.h"
 #include "apfShape.h"
 // *********************************************************
-void pumi_ghost_create(pMesh m, Ghosting* plan)
+void ghost_exchange(Ghosting* plan, EntityVector entities_to_ghost[4])
+// *********************************************************
+{
+  // a sender that already has ghosts must not mark its new ghost ghosted
+  apf::DynamicArray<pMeshTag> all, tags;
+  plan->getMesh()->getTags(all);
+  for (size_t i = 0; i < all.getSize(); ++i)
+    if (all[i]!=pumi::instance()->ghosted_tag)
+      tags.append(all[i]);
+  for (int dimension = 0; dimension <= plan->ghost_dim; ++dimension)
+  {
+    PCU_Comm_Begin();
+    ghost_sendEntities(plan, dimension, entities_to_ghost[dimension], tags);
+    PCU_Comm_Send();
+    EntityVector received;
+    ghost_receiveEntities(plan,tags,received);
+    setupGhosts(plan->getMesh(),received);
+  }
+  pumi::instance()->ghost_schedule.clear();
+}
+
+// *********************************************************
+static void ghost_create(pMesh m, Ghosting* plan)
 // *********************************************************
 {
   if (PCU_Comm_Peers()==1) return;
@@ -412,18 +435,7 @@ void pumi_ghost_create(pMesh m, Ghosting* plan)
 
   EntityVector entities_to_ghost[4];
   ghost_collectEntities(m, plan, entities_to_ghost);
-
-  apf::DynamicArray<pMeshTag> tags;
-  plan->getMesh()->getTags(tags);
-  for (int dimension = 0; dimension <= plan->ghost_dim; ++dimension)
-  {
-    PCU_Comm_Begin();
-    ghost_sendEntities(plan, dimension, entities_to_ghost[dimension], tags);
-    PCU_Comm_Send();
-    EntityVector received;
-    ghost_receiveEntities(plan,tags,received);
-    setupGhosts(plan->getMesh(),received);
-  }
+  ghost_exchange(plan, entities_to_ghost);
   
   delete plan;
   m->acceptChanges();
@@ -440,6 +452,27 @@ void pumi_ghost_create(pMesh m, Ghosting* plan)
     lion_oprint(1,"mesh ghosted in %f seconds\n", PCU_Time()-t0);
 }
 
+// *********************************************************
+void pumi_ghost_create(pMesh m, Ghosting* plan)
+// *********************************************************
+{
+  // ghosts from a user plan cannot be recomputed by pumi_ghost_update
+  pumi::instance()->ghost_by_plan = true;
+  ghost_create(m, plan);
+}
+
+// unlike pumi_ment_isOn, ghost copies don't count so that a layer
+// plan is the same whether or not the mesh is already ghosted
+// *********************************************************
+static bool isOnPart(pMesh m, pMeshEnt e, int part)
+// *********************************************************
+{
+  if (part==m->getId()) return true;
+  apf::Copies remotes;
+  m->getRemotes(e,remotes);
+  return remotes.count(part);
+}
+
 // *********************************************************
 void do_off_part_bridge(pMesh m, int brg_dim, int ghost_dim, int num_layer, 
                         std::set<pMeshEnt>** off_bridge_set, Ghosting* plan)
@@ -522,7 +555,8 @@ void do_off_part_bridge(pMesh m, int brg_dim, int ghost_dim, int num_layer,
         int num_brg=m->getDownward(ghost_ent,brg_dim, adjacent);
         for (int b=0; b<num_brg; ++b)
         {     
-          if (m->isShared(adjacent[b]) && adjacent[b]!=r && !pumi_ment_isOn(adjacent[b], r_pid))
+          if (m->isShared(adjacent[b]) && adjacent[b]!=r &&
+              !isOnPart(m, adjacent[b], r_pid))
             off_bridge_set[r_layer+1][r_pid].insert(adjacent[b]);
         }
       } // if (r_layer<num_layer)
@@ -557,7 +591,8 @@ void do_off_part_bridge(pMesh m, int brg_dim, int ghost_dim, int num_layer,
           int num_brg=m->getDownward(ghost_ent,brg_dim, adjacent);
           for (int b=0; b<num_brg; ++b)
           {     
-            if (m->isShared(adjacent[b]) && adjacent[b]!=r && !pumi_ment_isOn(adjacent[b], r_pid))
+            if (m->isShared(adjacent[b]) && adjacent[b]!=r &&
+              !isOnPart(m, adjacent[b], r_pid))
               off_bridge_set[layer+1][r_pid].insert(adjacent[b]);
           } // for int b=0
         } // if (layer<=num_layer)
@@ -644,7 +679,8 @@ void do_off_part_bridge(pMesh m, int brg_dim, int ghost_dim, int num_layer,
           int num_brg=m->getDownward(ghost_ent,brg_dim, adjacent);
           for (int b=0; b<num_brg; ++b)
           {     
-            if (m->isShared(adjacent[b]) && adjacent[b]!=r && !pumi_ment_isOn(adjacent[b], r_pid))
+            if (m->isShared(adjacent[b]) && adjacent[b]!=r &&
+              !isOnPart(m, adjacent[b], r_pid))
             {
               if (off_bridge_marker[adjacent[b]].find(r_pid)==off_bridge_marker[adjacent[b]].end())
                 off_bridge_set[r_layer+1][r_pid].insert(adjacent[b]);
@@ -682,7 +718,8 @@ void do_off_part_bridge(pMesh m, int brg_dim, int ghost_dim, int num_layer,
             int num_brg=m->getDownward(ghost_ent,brg_dim, adjacent);
             for (int b=0; b<num_brg; ++b)
             {     
-              if (m->isShared(adjacent[b]) && adjacent[b]!=r && !pumi_ment_isOn(adjacent[b], r_pid))
+              if (m->isShared(adjacent[b]) && adjacent[b]!=r &&
+              !isOnPart(m, adjacent[b], r_pid))
                 off_bridge_set[layer+1][r_pid].insert(adjacent[b]);
             } // for int b=0
           } // if (layer<=num_layer)
@@ -703,26 +740,12 @@ void do_off_part_bridge(pMesh m, int brg_dim, int ghost_dim, int num_layer,
 
 
 // *********************************************************
-void pumi_ghost_createLayer (pMesh m, int brg_dim, int ghost_dim, int num_layer, int include_copy)
+void ghost_planLayer (pMesh m, int brg_dim, int ghost_dim, int num_layer,
+                      int include_copy, Ghosting* plan)
 // *********************************************************
 {
-  if (PCU_Comm_Peers()==1 || num_layer==0) return;
-  
-  int dummy=1, mesh_dim=m->getDimension(), self = pumi_rank();;
-  
-  // brid/ghost dim check
-  if (brg_dim>=ghost_dim || 0>brg_dim || brg_dim>=mesh_dim || 
-      ghost_dim>mesh_dim || ghost_dim<1)
-  {
-    if (!self)
-       std::cout<<__func__<<" ERROR: invalid bridge/ghost dimension\n";   
-    return;
-  }
-
-  double t0 = PCU_Time();
-
+  int dummy=1, self = pumi_rank();
   pMeshTag tag = m->createIntTag("ghost_check_mark",1);
-  Ghosting* plan = new Ghosting(m, ghost_dim);
 
 // ********************************************
 // STEP 1: compute entities to ghost
@@ -796,7 +819,7 @@ void pumi_ghost_createLayer (pMesh m, int brg_dim, int ghost_dim, int num_layer,
             {
               APF_ITERATE(apf::Copies,remotes,rit)
               {
-                if (!pumi_ment_isOn(adjacent[b], rit->first))
+                if (!isOnPart(m, adjacent[b], rit->first))
                   off_bridge_set[layer][rit->first].insert(adjacent[b]);
               }
             } // if (m->isShared(adjacent[b])
@@ -837,19 +860,63 @@ void pumi_ghost_createLayer (pMesh m, int brg_dim, int ghost_dim, int num_layer,
     delete [] off_bridge_set[i];
   delete [] off_bridge_set;
 
-// ********************************************
-// STEP 3: perform ghosting
-// ********************************************
+}
+
+// *********************************************************
+void pumi_ghost_createLayer (pMesh m, int brg_dim, int ghost_dim,
+    int num_layer, int include_copy)
+// *********************************************************
+{
+  if (PCU_Comm_Peers()==1 || num_layer==0) return;
+
+  int mesh_dim=m->getDimension(), self = pumi_rank();
+
+  // brid/ghost dim check
+  if (brg_dim>=ghost_dim || 0>brg_dim || brg_dim>=mesh_dim ||
+      ghost_dim>mesh_dim || ghost_dim<1)
+  {
+    if (!self)
+       std::cout<<__func__<<" ERROR: invalid bridge/ghost dimension\n";
+    return;
+  }
+
+  double t0 = PCU_Time();
+
+  Ghosting* plan = new Ghosting(m, ghost_dim);
+  ghost_planLayer(m, brg_dim, ghost_dim, num_layer, include_copy, plan);
+
+  // remember the layer so pumi_ghost_update can recompute it
+  std::vector<int>& layers = pumi::instance()->ghost_layers;
+  bool known = false;
+  for (size_t i=0; i<layers.size(); i+=4)
+    if (layers[i]==brg_dim && layers[i+1]==ghost_dim &&
+        layers[i+2]==num_layer && layers[i+3]==include_copy)
+      known = true;
+  if (!known)
+  {
+    layers.push_back(brg_dim);
+    layers.push_back(ghost_dim);
+    layers.push_back(num_layer);
+    layers.push_back(include_copy);
+  }
+
   if (!PCU_Comm_Self())
     lion_oprint(1,"ghosting plan computed in %f seconds\n", PCU_Time()-t0);
 
-  pumi_ghost_create(m, plan);
+  ghost_create(m, plan);
 }
 
 // *********************************************************
-void pumi_ghost_delete (pMesh m)
+void pumi_ghost_delete (pMesh m, bool keepLayers)
 // *********************************************************
 {
+  pumi::instance()->ghost_schedule.clear();
+  if (!keepLayers)
+  {
+    pumi::instance()->ghost_layers.clear();
+    pumi::instance()->ghost_by_plan = false;
+  }
+
   pMeshTag tag = pumi::instance()->ghosted_tag;
   if (!tag) return;
 
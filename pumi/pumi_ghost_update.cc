@@ -0,0 +1,598 @@
+/******************************************************************************
+
+  (c) 2026 Scientific Computation Research Center,
+      Rensselaer Polytechnic Institute. All rights reserved.
+
+  This work is open source software, licensed under the terms of the
+  BSD license as described in the LICENSE file in the top-level directory.
+
+*******************************************************************************/
+#include "pumi.h"
+#include <iostream>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <lionPrint.h>
+
+#include "apf.h"
+#include "apfField.h"
+#include "apfFieldData.h"
+#include "apfNumbering.h"
+
+// defined in pumi_ghost.cc
+void ghost_collectEntities (pMesh m, Ghosting* plan,
+    EntityVector entitiesToGhost[4]);
+void ghost_exchange(Ghosting* plan, EntityVector entities_to_ghost[4]);
+void ghost_planLayer (pMesh m, int brg_dim, int ghost_dim, int num_layer,
+                      int include_copy, Ghosting* plan);
+
+void GhostSchedule::clear()
+{
+  valid = false;
+  sendPeers.clear();
+  sendOffsets.clear();
+  send.clear();
+  recvPeers.clear();
+  recvOffsets.clear();
+  recv.clear();
+}
+
+// frozen fields keep their data in arrays indexed by a local numbering,
+// so they are unfrozen while ghosts are created or destroyed
+// *********************************************************
+static void ghost_unfreeze(pMesh m, std::vector<apf::Field*>& frozen)
+// *********************************************************
+{
+  for (int i=0; i<m->countFields(); ++i)
+  {
+    pField f = m->getField(i);
+    if (isFrozen(f))
+    {
+      frozen.push_back(f);
+      apf::unfreeze(f);
+    }
+  }
+}
+
+// *********************************************************
+static void ghost_refreeze(pMesh m, std::vector<apf::Field*>& frozen)
+// *********************************************************
+{
+  // see pumi_ghost_create about local numberings of frozen fields
+  while (m->countNumberings()) destroyNumbering(m->getNumbering(0));
+  for (size_t i=0; i<frozen.size(); ++i)
+    apf::freeze(frozen[i]);
+}
+
+/* decides which ghost copies of a ghosted entity stay */
+struct GhostFilter
+{
+  virtual ~GhostFilter() {}
+  virtual bool keep(pMeshEnt e, int d, int part) = 0;
+};
+
+/* a ghost stays if the recomputed plan still sends it to its part */
+struct PlanFilter : public GhostFilter
+{
+  PlanFilter(Ghosting* p): plan(p) {}
+  bool keep(pMeshEnt e, int d, int part)
+  {
+    if (d>plan->ghost_dim || !plan->has(e)) return false;
+    Parts& parts = plan->sending(e, d);
+    return parts.find(part)!=parts.end();
+  }
+  Ghosting* plan;
+};
+
+/* a ghost stays over a migration if no copy of its original
+   or of any entity bounding the original is touched by it */
+struct MigrationFilter : public GhostFilter
+{
+  MigrationFilter(pMesh mesh, pMeshTag t): m(mesh), touched(t) {}
+  bool keep(pMeshEnt e, int d, int)
+  {
+    if (m->hasTag(e, touched)) return false;
+    for (int bd=0; bd<d; ++bd)
+    {
+      apf::Adjacent bounds;
+      m->getAdjacent(e, bd, bounds);
+      for (size_t i=0; i<bounds.getSize(); ++i)
+        if (m->hasTag(bounds[i], touched)) return false;
+    }
+    return true;
+  }
+  pMesh m;
+  pMeshTag touched;
+};
+
+// *********************************************************
+static void removeFromVector(std::vector<pMeshEnt>& ents,
+    std::set<pMeshEnt>& gone)
+// *********************************************************
+{
+  size_t kept=0;
+  for (size_t i=0; i<ents.size(); ++i)
+    if (!gone.count(ents[i]))
+      ents[kept++]=ents[i];
+  ents.resize(kept);
+}
+
+/* every copy of a ghosted entity drops the ghost copies the filter
+   does not keep and the owner tells the holders to destroy them.
+   the filter must give the same answer on all copies */
+// *********************************************************
+static int ghost_removeStale(pMesh m, GhostFilter& filter)
+// *********************************************************
+{
+  pumi* p = pumi::instance();
+  int self = PCU_Comm_Self();
+  PCU_Comm_Begin();
+  for (int d=0; d<4; ++d)
+  {
+    std::set<pMeshEnt> unghosted;
+    APF_ITERATE(std::vector<pMeshEnt>, p->ghosted_vec[d], it)
+    {
+      pMeshEnt e = *it;
+      apf::Copies ghosts, kept;
+      m->getGhosts(e, ghosts);
+      bool owned = m->getOwner(e)==self;
+      APF_ITERATE(apf::Copies, ghosts, git)
+      {
+        if (filter.keep(e, d, git->first))
+          kept.insert(*git);
+        else if (owned)
+          PCU_COMM_PACK(git->first, git->second);
+      }
+      if (kept.size()==ghosts.size()) continue;
+      m->deleteGhost(e);
+      APF_ITERATE(apf::Copies, kept, git)
+        m->addGhost(e, git->first, git->second);
+      if (kept.empty())
+      {
+        m->removeTag(e, p->ghosted_tag);
+        unghosted.insert(e);
+      }
+    }
+    removeFromVector(p->ghosted_vec[d], unghosted);
+  }
+  PCU_Comm_Send();
+
+  std::vector<pMeshEnt> stale[4];
+  std::set<pMeshEnt> gone;
+  while (PCU_Comm_Receive())
+  {
+    pMeshEnt e;
+    PCU_COMM_UNPACK(e);
+    stale[apf::getDimension(m, e)].push_back(e);
+    gone.insert(e);
+  }
+  for (int d=0; d<4; ++d)
+    removeFromVector(p->ghost_vec[d], gone);
+  for (int d=3; d>=0; --d)
+    APF_ITERATE(std::vector<pMeshEnt>, stale[d], it)
+    {
+      // a stale ghost can not bound a ghost that is still wanted
+      PCU_ALWAYS_ASSERT(!m->countUpward(*it));
+      m->destroy(*it);
+    }
+  p->ghost_schedule.clear();
+  return gone.size();
+}
+
+/* a ghost below the ghost dimension only exists to bound ghosts of
+   the ghost dimension. the holders destroy the ones left without
+   upward adjacencies and tell every copy of the original */
+// *********************************************************
+static int ghost_removeOrphans(pMesh m, int ghost_dim)
+// *********************************************************
+{
+  pumi* p = pumi::instance();
+  int removed = 0;
+  PCU_Comm_Begin();
+  for (int d=ghost_dim-1; d>=0; --d)
+  {
+    std::set<pMeshEnt> orphans;
+    APF_ITERATE(std::vector<pMeshEnt>, p->ghost_vec[d], it)
+    {
+      pMeshEnt g = *it;
+      if (m->countUpward(g)) continue;
+      apf::Copies copies;
+      m->getRemotes(g, copies);
+      m->getGhosts(g, copies);
+      APF_ITERATE(apf::Copies, copies, cit)
+        PCU_COMM_PACK(cit->first, cit->second);
+      orphans.insert(g);
+    }
+    removeFromVector(p->ghost_vec[d], orphans);
+    APF_ITERATE(std::set<pMeshEnt>, orphans, it)
+      m->destroy(*it);
+    removed += orphans.size();
+  }
+  PCU_Comm_Send();
+  std::set<pMeshEnt> unghosted[4];
+  while (PCU_Comm_Receive())
+  {
+    pMeshEnt e;
+    PCU_COMM_UNPACK(e);
+    apf::Copies ghosts;
+    m->getGhosts(e, ghosts);
+    ghosts.erase(PCU_Comm_Sender());
+    m->deleteGhost(e);
+    APF_ITERATE(apf::Copies, ghosts, git)
+      m->addGhost(e, git->first, git->second);
+    if (ghosts.empty())
+    {
+      m->removeTag(e, p->ghosted_tag);
+      unghosted[apf::getDimension(m, e)].insert(e);
+    }
+  }
+  for (int d=0; d<4; ++d)
+    removeFromVector(p->ghosted_vec[d], unghosted[d]);
+  p->ghost_schedule.clear();
+  return removed;
+}
+
+/* the owner of an entity follows the element counts of its parts, so
+   it can move when the mesh changes. a ghost keeps its owner's copy as
+   its ghost copy and the other copies as remotes, which are swapped
+   here for the ghosts whose owner moved */
+// *********************************************************
+static void ghost_updateOwners(pMesh m)
+// *********************************************************
+{
+  pumi* p = pumi::instance();
+  for (int d=0; d<4; ++d)
+    APF_ITERATE(std::vector<pMeshEnt>, p->ghost_vec[d], it)
+    {
+      pMeshEnt g = *it;
+      int owner = m->getOwner(g);
+      int recorded;
+      m->getIntTag(g, p->ghost_tag, &recorded);
+      if (owner==recorded) continue;
+      apf::Copies remotes, ghosts;
+      m->getRemotes(g, remotes);
+      m->getGhosts(g, ghosts);
+      PCU_ALWAYS_ASSERT(remotes.count(owner) && ghosts.count(recorded));
+      pMeshEnt copy = remotes[owner];
+      remotes.erase(owner);
+      remotes[recorded] = ghosts[recorded];
+      m->setRemotes(g, remotes);
+      m->deleteGhost(g);
+      m->addGhost(g, owner, copy);
+      m->setIntTag(g, p->ghost_tag, &owner);
+    }
+  p->ghost_schedule.clear();
+}
+
+static int countGhosts()
+{
+  int n=0;
+  for (int d=0; d<4; ++d)
+    n+=pumi::instance()->ghost_vec[d].size();
+  return n;
+}
+
+/* the ghost dimension shared by all layers, or -1 if they differ */
+static int ghost_layerDim()
+{
+  std::vector<int>& layers = pumi::instance()->ghost_layers;
+  for (size_t i=4; i<layers.size(); i+=4)
+    if (layers[i+1]!=layers[1])
+      return -1;
+  return layers[1];
+}
+
+// *********************************************************
+void pumi_ghost_update(pMesh m)
+// *********************************************************
+{
+  pumi* p = pumi::instance();
+  if (PCU_Comm_Peers()==1 || p->ghost_layers.empty()) return;
+  if (p->ghost_by_plan)
+  {
+    if (!PCU_Comm_Self())
+      std::cout<<"[PUMI ERROR] "<<__func__
+               <<" failed: ghosts created from a plan can't be updated\n";
+    return;
+  }
+
+  std::vector<int> layers(p->ghost_layers);
+  int ghost_dim = ghost_layerDim();
+  // a ghost of one layer may be the closure of another layer's ghost,
+  // so layers of different ghost dimensions are rebuilt from scratch
+  if (ghost_dim<0)
+  {
+    pumi_ghost_delete(m);
+    for (size_t i=0; i<layers.size(); i+=4)
+      pumi_ghost_createLayer(m, layers[i], layers[i+1], layers[i+2],
+          layers[i+3]);
+    return;
+  }
+
+  double t0 = PCU_Time();
+  Ghosting* plan = new Ghosting(m, ghost_dim);
+  for (size_t i=0; i<layers.size(); i+=4)
+    ghost_planLayer(m, layers[i], ghost_dim, layers[i+2], layers[i+3], plan);
+
+  std::vector<apf::Field*> frozen_fields;
+  ghost_unfreeze(m, frozen_fields);
+
+  EntityVector entities_to_ghost[4];
+  ghost_collectEntities(m, plan, entities_to_ghost);
+  PlanFilter wanted(plan);
+  int removed = ghost_removeStale(m, wanted);
+  int before = countGhosts();
+  ghost_exchange(plan, entities_to_ghost);
+  int added = countGhosts()-before;
+  delete plan;
+  m->acceptChanges();
+  ghost_updateOwners(m);
+  ghost_refreeze(m, frozen_fields);
+
+  removed = PCU_Add_Int(removed);
+  added = PCU_Add_Int(added);
+  if (!PCU_Comm_Self())
+    lion_oprint(1,"ghosts updated in %f seconds: %d stale removed, %d added\n",
+        PCU_Time()-t0, removed, added);
+}
+
+/* ghosts made from a user plan can not be recomputed, so the ghost
+   parts of every ghosted entity of the top ghost dimension are put in
+   a tag that migrates with the entity, padded with -1 */
+// *********************************************************
+static pMeshTag ghost_savePlan(pMesh m, int& ghost_dim)
+// *********************************************************
+{
+  pumi* p = pumi::instance();
+  ghost_dim = -1;
+  for (int d=0; d<4; ++d)
+    if (!p->ghosted_vec[d].empty())
+      ghost_dim = d;
+  ghost_dim = PCU_Max_Int(ghost_dim);
+  if (ghost_dim<0) return NULL;
+  int width = 0;
+  APF_ITERATE(std::vector<pMeshEnt>, p->ghosted_vec[ghost_dim], it)
+  {
+    apf::Copies ghosts;
+    m->getGhosts(*it, ghosts);
+    width = std::max(width, (int)ghosts.size());
+  }
+  width = PCU_Max_Int(width);
+  pMeshTag tag = m->createIntTag("_ghost_plan_parts_", width);
+  std::vector<int> parts(width);
+  APF_ITERATE(std::vector<pMeshEnt>, p->ghosted_vec[ghost_dim], it)
+  {
+    apf::Copies ghosts;
+    m->getGhosts(*it, ghosts);
+    std::fill(parts.begin(), parts.end(), -1);
+    int i = 0;
+    APF_ITERATE(apf::Copies, ghosts, git)
+      parts[i++] = git->first;
+    m->setIntTag(*it, tag, &parts[0]);
+  }
+  return tag;
+}
+
+// *********************************************************
+static Ghosting* ghost_loadPlan(pMesh m, pMeshTag tag, int ghost_dim)
+// *********************************************************
+{
+  Ghosting* plan = new Ghosting(m, ghost_dim);
+  std::vector<int> parts(m->getTagSize(tag));
+  pMeshEnt e;
+  apf::MeshIterator* it = m->begin(ghost_dim);
+  while ((e = m->iterate(it)))
+  {
+    if (!m->hasTag(e, tag)) continue;
+    m->getIntTag(e, tag, &parts[0]);
+    for (size_t i=0; i<parts.size() && parts[i]!=-1; ++i)
+      plan->send(e, parts[i]);
+  }
+  m->end(it);
+  apf::removeTagFromDimension(m, tag, ghost_dim);
+  m->destroyTag(tag);
+  return plan;
+}
+
+/* tags the elements of the migration plan and their closure on every
+   part that has a copy of them. these are the entities apf migration
+   creates, destroys or gives new remote copies */
+// *********************************************************
+static pMeshTag ghost_markMigrating(pMesh m, Migration* plan,
+    std::vector<pMeshEnt>& marked)
+// *********************************************************
+{
+  pMeshTag tag = m->createIntTag("_ghost_migrating_", 1);
+  int dim = m->getDimension();
+  int one = 1;
+  for (int i=0; i<plan->count(); ++i)
+  {
+    pMeshEnt e = plan->get(i);
+    PCU_ALWAYS_ASSERT(!m->isGhost(e));
+    for (int d=0; d<=dim; ++d)
+    {
+      apf::Adjacent closure;
+      m->getAdjacent(e, d, closure);
+      for (size_t j=0; j<closure.getSize(); ++j)
+        if (!m->hasTag(closure[j], tag))
+        {
+          m->setIntTag(closure[j], tag, &one);
+          marked.push_back(closure[j]);
+        }
+    }
+  }
+  PCU_Comm_Begin();
+  for (size_t i=0; i<marked.size(); ++i)
+  {
+    apf::Copies remotes;
+    m->getRemotes(marked[i], remotes);
+    APF_ITERATE(apf::Copies, remotes, rit)
+      PCU_COMM_PACK(rit->first, rit->second);
+  }
+  PCU_Comm_Send();
+  while (PCU_Comm_Receive())
+  {
+    pMeshEnt e;
+    PCU_COMM_UNPACK(e);
+    if (m->hasTag(e, tag)) continue;
+    m->setIntTag(e, tag, &one);
+    marked.push_back(e);
+  }
+  return tag;
+}
+
+/* apf migration can not carry ghosts of the entities it touches, so
+   only those are deleted before it, along with the closure ghosts they
+   leave unused. afterwards the layers are recomputed, or the plan
+   ghosts are resent to the parts they were on, and both send only the
+   ghosts that are missing */
+// *********************************************************
+void ghost_migrate(pMesh m, Migration* plan)
+// *********************************************************
+{
+  pumi* p = pumi::instance();
+  int ghost_dim = -1;
+  pMeshTag saved = NULL;
+  if (p->ghost_by_plan)
+    saved = ghost_savePlan(m, ghost_dim);
+  else if (!p->ghost_layers.empty())
+    ghost_dim = ghost_layerDim();
+  // mixed layers are rebuilt from scratch by pumi_ghost_update anyway,
+  // and a plan without ghosts left has nothing to keep
+  if (ghost_dim<0)
+  {
+    pumi_ghost_delete(m, true);
+    apf::migrate(m, plan);
+    if (!p->ghost_by_plan)
+      pumi_ghost_update(m);
+    return;
+  }
+
+  std::vector<apf::Field*> frozen_fields;
+  ghost_unfreeze(m, frozen_fields);
+  std::vector<pMeshEnt> marked;
+  pMeshTag tag = ghost_markMigrating(m, plan, marked);
+  MigrationFilter untouched(m, tag);
+  int removed = ghost_removeStale(m, untouched);
+  for (size_t i=0; i<marked.size(); ++i)
+    m->removeTag(marked[i], tag);
+  m->destroyTag(tag);
+  removed += ghost_removeOrphans(m, ghost_dim);
+  m->acceptChanges();
+  ghost_refreeze(m, frozen_fields);
+
+  removed = PCU_Add_Int(removed);
+  if (!PCU_Comm_Self())
+    lion_oprint(1,"%d ghosts touched by migration removed\n", removed);
+  apf::migrate(m, plan);
+  ghost_updateOwners(m);
+
+  if (!p->ghost_by_plan)
+    pumi_ghost_update(m);
+  else
+  {
+    pumi_ghost_create(m, ghost_loadPlan(m, saved, ghost_dim));
+    ghost_updateOwners(m);
+  }
+}
+
+typedef std::map<int, std::vector<pMeshEnt> > EntityLists;
+
+/* owners tell each ghost holder which ghost pointers they will fill,
+   in the order the values are going to be packed */
+// *********************************************************
+static void ghost_buildSchedule(apf::Mesh* m, GhostSchedule& s)
+// *********************************************************
+{
+  pumi* p = pumi::instance();
+  int self = PCU_Comm_Self();
+  EntityLists sending;
+  PCU_Comm_Begin();
+  for (int d=0; d<4; ++d)
+    APF_ITERATE(std::vector<pMeshEnt>, p->ghosted_vec[d], it)
+    {
+      pMeshEnt e = *it;
+      if (m->getOwner(e)!=self) continue;
+      apf::Copies ghosts;
+      m->getGhosts(e, ghosts);
+      APF_ITERATE(apf::Copies, ghosts, git)
+      {
+        sending[git->first].push_back(e);
+        PCU_COMM_PACK(git->first, git->second);
+      }
+    }
+  PCU_Comm_Send();
+  EntityLists receiving;
+  while (PCU_Comm_Receive())
+  {
+    pMeshEnt e;
+    PCU_COMM_UNPACK(e);
+    receiving[PCU_Comm_Sender()].push_back(e);
+  }
+
+  s.clear();
+  s.sendOffsets.push_back(0);
+  APF_ITERATE(EntityLists, sending, it)
+  {
+    s.sendPeers.push_back(it->first);
+    s.send.insert(s.send.end(), it->second.begin(), it->second.end());
+    s.sendOffsets.push_back(s.send.size());
+  }
+  s.recvOffsets.push_back(0);
+  APF_ITERATE(EntityLists, receiving, it)
+  {
+    s.recvPeers.push_back(it->first);
+    s.recv.insert(s.recv.end(), it->second.begin(), it->second.end());
+    s.recvOffsets.push_back(s.recv.size());
+  }
+  s.valid = true;
+}
+
+// *********************************************************
+void pumi_field_syncGhosts(pField f)
+// *********************************************************
+{
+  pumi* p = pumi::instance();
+  if (!p->ghosted_tag) return;
+  apf::Mesh* m = apf::getMesh(f);
+  GhostSchedule& s = p->ghost_schedule;
+  if (!s.valid)
+    ghost_buildSchedule(m, s);
+
+  apf::FieldDataOf<double>* data =
+    static_cast<apf::FieldDataOf<double>*>(f->getData());
+  apf::FieldShape* shape = apf::getShape(f);
+  int components = apf::countComponents(f);
+  std::vector<double> values;
+  PCU_Comm_Begin();
+  for (size_t i=0; i<s.sendPeers.size(); ++i)
+    for (int j=s.sendOffsets[i]; j<s.sendOffsets[i+1]; ++j)
+    {
+      pMeshEnt e = s.send[j];
+      int n = shape->countNodesOn(m->getType(e))*components;
+      if (!n) continue;
+      values.resize(n);
+      data->get(e, &values[0]);
+      PCU_Comm_Pack(s.sendPeers[i], &values[0], n*sizeof(double));
+    }
+  PCU_Comm_Send();
+  while (PCU_Comm_Receive())
+  {
+    int from = PCU_Comm_Sender();
+    size_t i = std::lower_bound(s.recvPeers.begin(), s.recvPeers.end(), from)
+      - s.recvPeers.begin();
+    PCU_ALWAYS_ASSERT(i<s.recvPeers.size() && s.recvPeers[i]==from);
+    for (int j=s.recvOffsets[i]; j<s.recvOffsets[i+1]; ++j)
+    {
+      pMeshEnt e = s.recv[j];
+      int n = shape->countNodesOn(m->getType(e))*components;
+      if (!n) continue;
+      values.resize(n);
+      PCU_Comm_Unpack(&values[0], n*sizeof(double));
+      data->set(e, &values[0]);
+    }
+  }
+}
@@ -149,6 +149,7 @@ pumi::pumi(): mesh(NULL), model(NULL)
 {
   ghost_tag=NULL;
   ghosted_tag=NULL;
+  ghost_by_plan=false;
   num_local_ent = NULL;
   num_own_ent = NULL;
   num_global_ent = NULL;
@@ -306,9 +307,43 @@ pMesh pumi_mesh_loadAll(pGeom g, const char* filename, bool stitch_link)
   return pumi::instance()->mesh;
 }
 
+// defined in pumi_ghost_update.cc
+void ghost_migrate(pMesh m, Migration* plan);
+
 void pumi_mesh_migrate(pMesh m, Migration* plan)
 {
-  apf::migrate(m, plan);
+  if (!pumi::instance()->ghosted_tag)
+  {
+    apf::migrate(m, plan);
+    return;
+  }
+  ghost_migrate(m, plan);
+}
+
+void pumi_mesh_compact(pMesh m)
+{
+  pumi* p = pumi::instance();
+  apf::compactMdsMesh(m);
+  p->ghost_schedule.clear();
+  for (int d=0; d<4; ++d)
+  {
+    p->ghost_vec[d].clear();
+    p->ghosted_vec[d].clear();
+  }
+  if (!p->ghost_tag) return;
+  for (int d=0; d<=m->getDimension(); ++d)
+  {
+    pMeshEnt e;
+    pMeshIter it = m->begin(d);
+    while ((e = m->iterate(it)))
+    {
+      if (m->hasTag(e, p->ghost_tag))
+        p->ghost_vec[d].push_back(e);
+      if (m->hasTag(e, p->ghosted_tag))
+        p->ghosted_vec[d].push_back(e);
+    }
+    m->end(it);
+  }
 }
 
 int pumi_mesh_getDim(pMesh m)
@@ -591,6 +626,9 @@ void pumi_mesh_delete(pMesh m)
     m->destroyTag(pumi::instance()->ghost_tag);
   if (m->findTag("ghosted_tag"))
     m->destroyTag(pumi::instance()->ghosted_tag);
+  pumi::instance()->ghost_layers.clear();
+  pumi::instance()->ghost_by_plan = false;
+  pumi::instance()->ghost_schedule.clear();
   m->destroyNative();
   apf::destroyMesh(m);
 }
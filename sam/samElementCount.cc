@@ -2,7 +2,12 @@
 
 #include <apf.h>
 #include <apfMesh.h>
+#include <apfShape.h>
+#include <gmi.h>
 #include <PCU.h>
+#include <pcu_util.h>
+#include <algorithm>
+#include <map>
 
 namespace sam {
 
@@ -89,6 +94,11 @@ double getLengthScalar(int dim, double targetElementCount,
 
 double getIsoLengthScalar(apf::Field* iso_field, double targetElementCount) {
   apf::Mesh* m = apf::getMesh(iso_field);
+  if (apf::getShape(iso_field) == apf::getLagrange(1)) {
+    PackedIsoSize p;
+    packIsoSize(iso_field, p);
+    return getIsoScaleForCount(p, targetElementCount);
+  }
   double currentMetricVolume = getTotalMetricVolumeIso(iso_field);
   return getLengthScalar(m->getDimension(), targetElementCount,
       currentMetricVolume);
@@ -106,4 +116,184 @@ void scaleIsoSizeField(apf::Field* iso_field, double targetElementCount) {
   m->end(it);
 }
 
+void packIsoSize(apf::Field* iso_field, PackedIsoSize& p) {
+  apf::Mesh* m = apf::getMesh(iso_field);
+  p = PackedIsoSize();
+  p.dim = m->getDimension();
+  apf::MeshTag* index = m->createIntTag("sam_pack_index", 1);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* e;
+  while ((e = m->iterate(it))) {
+    int i = p.size.size();
+    m->setIntTag(e, index, &i);
+    p.size.push_back(apf::getScalar(iso_field, e, 0));
+  }
+  m->end(it);
+  gmi_model* g = m->getModel();
+  std::map<int, int> regions;
+  gmi_iter* gi = gmi_begin(g, p.dim);
+  gmi_ent* ge;
+  while ((ge = gmi_next(g, gi)))
+    p.regionTags.push_back(gmi_tag(g, ge));
+  gmi_end(g, gi);
+  std::sort(p.regionTags.begin(), p.regionTags.end());
+  for (size_t i = 0; i < p.regionTags.size(); ++i)
+    regions[p.regionTags[i]] = i;
+  p.offset.push_back(0);
+  it = m->begin(p.dim);
+  while ((e = m->iterate(it))) {
+    apf::Downward verts;
+    int nverts = m->getDownward(e, 0, verts);
+    for (int j = 0; j < nverts; ++j) {
+      int i;
+      m->getIntTag(verts[j], index, &i);
+      p.vertex.push_back(i);
+    }
+    p.offset.push_back(p.vertex.size());
+    p.measure.push_back(apf::measure(m, e));
+    apf::ModelEntity* c = m->toModel(e);
+    int region = -1;
+    if (m->getModelType(c) == p.dim) {
+      std::map<int, int>::iterator r = regions.find(m->getModelTag(c));
+      if (r != regions.end())
+        region = r->second;
+    }
+    p.region.push_back(region);
+  }
+  m->end(it);
+  apf::removeTagFromDimension(m, index, 0);
+  m->destroyTag(index);
+}
+
+/* predicts the counts for several scale factors in one pass,
+   into counts[k] for scales[k] and, if regionCounts is not null,
+   into regionCounts[k * regionTags.size() + region] */
+static void predictCounts(PackedIsoSize const& p, int n,
+    double const* scales, double minSize, double maxSize,
+    double* counts, double* regionCounts) {
+  double perfect = getPerfectVolume(p.dim);
+  size_t nregions = p.regionTags.size();
+  double sum[16];
+  PCU_ALWAYS_ASSERT(n <= 16);
+  std::fill(counts, counts + n, 0);
+  if (regionCounts)
+    std::fill(regionCounts, regionCounts + n * nregions, 0);
+  for (size_t i = 0; i < p.measure.size(); ++i) {
+    std::fill(sum, sum + n, 0);
+    for (int j = p.offset[i]; j < p.offset[i + 1]; ++j) {
+      double h = p.size[p.vertex[j]];
+      for (int k = 0; k < n; ++k) {
+        double sh = h * scales[k];
+        if (minSize > 0)
+          sh = std::max(sh, minSize);
+        if (maxSize > 0)
+          sh = std::min(sh, maxSize);
+        sum[k] += sh;
+      }
+    }
+    double nverts = p.offset[i + 1] - p.offset[i];
+    for (int k = 0; k < n; ++k) {
+      double count = p.measure[i] *
+        getVolumeChange(p.dim, sum[k] / nverts) / perfect;
+      counts[k] += count;
+      if (regionCounts && p.region[i] != -1)
+        regionCounts[k * nregions + p.region[i]] += count;
+    }
+  }
+}
+
+double predictElementCount(PackedIsoSize const& p, double scale,
+    double minSize, double maxSize, std::vector<double>* regionCounts) {
+  double count;
+  double* rc = 0;
+  if (regionCounts) {
+    regionCounts->assign(p.regionTags.size(), 0);
+    if (!regionCounts->empty())
+      rc = &(*regionCounts)[0];
+  }
+  predictCounts(p, 1, &scale, minSize, maxSize, &count, rc);
+  return count;
+}
+
+void predictRegionCounts(PackedIsoSize const& p,
+    std::vector<double>& regionCounts, double scale,
+    double minSize, double maxSize) {
+  int nregions = p.regionTags.size();
+  PCU_ALWAYS_ASSERT(PCU_Max_Int(nregions) == PCU_Min_Int(nregions));
+  predictElementCount(p, scale, minSize, maxSize, &regionCounts);
+  if (nregions)
+    PCU_Add_Doubles(&regionCounts[0], nregions);
+}
+
+double getIsoScaleForCount(PackedIsoSize const& p, double targetElementCount,
+    double minSize, double maxSize) {
+  PCU_ALWAYS_ASSERT(targetElementCount > 0);
+  double count = PCU_Add_Double(predictElementCount(p));
+  PCU_ALWAYS_ASSERT(count > 0);
+  /* unbounded sizes scaled by s give count * s^(-dim) elements */
+  double scale = pow(count / targetElementCount, 1. / p.dim);
+  if (minSize <= 0 && maxSize <= 0)
+    return scale;
+  /* bounded counts still fall as the scale grows, so search a
+     bracket in log space, predicting all its candidates at once */
+  enum { CANDIDATES = 16, MAX_ROUNDS = 8 };
+  double const tolerance = 1e-3;
+  double lo = scale / 16;
+  double hi = scale * 16;
+  double best = scale;
+  double bestError = -1;
+  for (int round = 0; round < MAX_ROUNDS; ++round) {
+    double scales[CANDIDATES];
+    double counts[CANDIDATES];
+    for (int k = 0; k < CANDIDATES; ++k)
+      scales[k] = lo * pow(hi / lo, double(k) / (CANDIDATES - 1));
+    predictCounts(p, CANDIDATES, scales, minSize, maxSize, counts, 0);
+    PCU_Add_Doubles(counts, CANDIDATES);
+    for (int k = 0; k < CANDIDATES; ++k) {
+      double error = fabs(counts[k] - targetElementCount);
+      if (bestError < 0 || error < bestError) {
+        best = scales[k];
+        bestError = error;
+      }
+    }
+    if (bestError <= tolerance * targetElementCount)
+      break;
+    /* the bounds hold every size, no factor changes the count */
+    if (counts[0] == counts[CANDIDATES - 1])
+      break;
+    int k = 0;
+    while (k < CANDIDATES && counts[k] > targetElementCount)
+      ++k;
+    double ratio = hi / lo;
+    if (k == 0) {
+      hi = lo;
+      lo /= ratio;
+    } else if (k == CANDIDATES) {
+      lo = hi;
+      hi *= ratio;
+    } else {
+      lo = scales[k - 1];
+      hi = scales[k];
+    }
+  }
+  return best;
+}
+
+double limitIsoSizeField(apf::Field* iso_field, double maxElementCount) {
+  PackedIsoSize p;
+  packIsoSize(iso_field, p);
+  double count = PCU_Add_Double(predictElementCount(p));
+  if (count <= maxElementCount)
+    return 1;
+  double scale = pow(count / maxElementCount, 1. / p.dim);
+  apf::Mesh* m = apf::getMesh(iso_field);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* vert;
+  while ((vert = m->iterate(it)))
+    apf::setScalar(iso_field, vert, 0,
+        apf::getScalar(iso_field, vert, 0) * scale);
+  m->end(it);
+  return scale;
+}
+
 }
@@ -1,6 +1,8 @@
 #ifndef SAM_ELEMENT_COUNT_H
 #define SAM_ELEMENT_COUNT_H
 
+#include <vector>
+
 namespace apf {
   class Field;
 }
@@ -10,6 +12,66 @@ namespace sam {
 double getIsoLengthScalar(apf::Field* iso_field, double targetElementCount);
 void scaleIsoSizeField(apf::Field* iso_field, double targetElementCount);
 
+/** \brief an isotropic size field packed for element count predictions
+  \details packing walks the mesh once. Predictions for scaled and
+  bounded versions of the size field are then flat loops over these
+  arrays, with no apf calls per entity. */
+struct PackedIsoSize {
+  /** \brief mesh dimension */
+  int dim;
+  /** \brief desired size at each vertex of this part */
+  std::vector<double> size;
+  /** \brief element (i) uses the vertices
+    vertex[offset[i]] to vertex[offset[i + 1] - 1] */
+  std::vector<int> offset;
+  std::vector<int> vertex;
+  /** \brief measure of each element */
+  std::vector<double> measure;
+  /** \brief index into regionTags of the model region of each element,
+    -1 for elements not classified on a model region */
+  std::vector<int> region;
+  /** \brief tags of the model regions, the same on all parts */
+  std::vector<int> regionTags;
+};
+
+/** \brief pack a scalar vertex size field and its mesh */
+void packIsoSize(apf::Field* iso_field, PackedIsoSize& p);
+
+/** \brief predict the element count of this part
+  \details the sizes are multiplied by (scale) and then bounded
+  to [minSize, maxSize] at the vertices; a bound that is not
+  positive is ignored. The prediction integrates the metric volume
+  at element centroids as getIsoLengthScalar does.
+  \param regionCounts if not null, gets the predicted count of this
+         part in each model region of regionTags */
+double predictElementCount(PackedIsoSize const& p, double scale = 1,
+    double minSize = 0, double maxSize = 0,
+    std::vector<double>* regionCounts = 0);
+
+/** \brief predict the global element count of each model region
+  \details collective, using one reduction */
+void predictRegionCounts(PackedIsoSize const& p,
+    std::vector<double>& regionCounts, double scale = 1,
+    double minSize = 0, double maxSize = 0);
+
+/** \brief find the factor to multiply sizes by so that the predicted
+  global element count meets a target
+  \details collective. Without size bounds the factor has a closed
+  form and takes one reduction. With bounds, each reduction predicts
+  a batch of candidate factors at once and narrows the bracket
+  around the target by that many steps, so a few reductions suffice.
+  If the bounds keep the target out of reach the factor that comes
+  closest is returned. */
+double getIsoScaleForCount(PackedIsoSize const& p, double targetElementCount,
+    double minSize = 0, double maxSize = 0);
+
+/** \brief coarsen a size field that would give more than
+  maxElementCount elements globally
+  \details for capping a run's mesh size before adapting.
+  collective.
+  \returns the factor applied to the sizes, 1 if none was needed */
+double limitIsoSizeField(apf::Field* iso_field, double maxElementCount);
+
 }
 
 #endif
@@ -33,9 +33,17 @@ apf::Field* getGradIPField(apf::Field* f,
                            int order);
 
 /** @brief recover a nodal field using patch recovery
+  * @details by default, patches are assembled from the local elements
+  *          and a layer of integration point data received once from
+  *          the neighboring parts. only patches that reach past that
+  *          layer fall back to cavity migration.
   * @param ip_field (In) integration point field
+  * @param useHalo (In) if false, every patch uses cavity migration
+  * @param threads (In) threads fitting the local patches,
+  *                see apf::runThreads
   */
-apf::Field* recoverField(apf::Field* ip_field);
+apf::Field* recoverField(apf::Field* ip_field, bool useHalo = true,
+    int threads = 1);
 
 /** @brief run the SPR ZZ error estimator
   * @param f the integration-point input field
@@ -12,10 +12,14 @@
 #include <apfMesh.h>
 #include <apfShape.h>
 #include <apfCavityOp.h>
+#include <apfThreads.h>
 
 #include <mthQR.h>
 
 #include <set>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 #include <pcu_util.h>
 
 namespace spr {
@@ -417,10 +421,500 @@ public:
   Patch patch;
 };
 
-apf::Field* recoverField(apf::Field* f)
+/* all elements a patch may use, in flat arrays: the local elements
+   followed by a one layer halo of elements received from the parts
+   sharing their vertices. halo elements only carry sample points and
+   values, the mesh itself is not modified */
+struct PatchData {
+  enum { MAX_VERTS = 8 };
+  int num_elements;
+  int num_components;
+  /* local vertex numbers of each element, -1 for the vertices
+     of halo elements that are not on this part */
+  std::vector<int> element_verts;
+  std::vector<int> element_num_verts;
+  std::vector<apf::Vector3> points;
+  std::vector<double> values;
+  /* vertex to element adjacency */
+  std::vector<int> vert_offsets;
+  std::vector<int> vert_elements;
+  apf::MeshTag* vert_numbers;
+};
+
+static void addElementData(PatchData* d, Recovery* r, int nv,
+    int const* verts, apf::Vector3 const* points, double const* values)
+{
+  for (int i = 0; i < PatchData::MAX_VERTS; ++i)
+    d->element_verts.push_back(i < nv ? verts[i] : -1);
+  d->element_num_verts.push_back(nv);
+  int np = r->points_per_element;
+  d->points.insert(d->points.end(), points, points + np);
+  d->values.insert(d->values.end(), values,
+      values + np * d->num_components);
+  ++d->num_elements;
+}
+
+static void getElementSamples(Recovery* r, apf::MeshEntity* e,
+    apf::Vector3* points, double* values)
+{
+  int nc = apf::countComponents(r->f);
+  apf::MeshElement* me = apf::createMeshElement(r->mesh, e);
+  for (int l = 0; l < r->points_per_element; ++l) {
+    apf::Vector3 param;
+    apf::getIntPoint(me, r->order, l, param);
+    apf::mapLocalToGlobal(me, param, points[l]);
+    apf::getComponents(r->f, e, l, values + l * nc);
+  }
+  apf::destroyMeshElement(me);
+}
+
+static void numberVertices(PatchData* d, apf::Mesh* m)
+{
+  d->vert_numbers = m->createIntTag("spr_vert", 1);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  int n = 0;
+  while ((v = m->iterate(it))) {
+    m->setIntTag(v, d->vert_numbers, &n);
+    ++n;
+  }
+  m->end(it);
+  d->vert_offsets.assign(n + 1, 0);
+}
+
+static int getVertexNumber(PatchData* d, apf::Mesh* m, apf::MeshEntity* v)
+{
+  int n;
+  m->getIntTag(v, d->vert_numbers, &n);
+  return n;
+}
+
+/* send each element with a vertex on the part boundary to every part
+   sharing one of its vertices, along with the remote copies of its
+   vertices on that part */
+static void exchangeHalo(PatchData* d, Recovery* r,
+    std::vector<apf::MeshEntity*> const& elements)
+{
+  apf::Mesh* m = r->mesh;
+  int np = r->points_per_element;
+  int nc = d->num_components;
+  std::vector<apf::Vector3> points(np);
+  std::vector<double> values(np * nc);
+  PCU_Comm_Begin();
+  for (size_t i = 0; i < elements.size(); ++i) {
+    apf::MeshEntity* e = elements[i];
+    apf::Downward verts;
+    int nv = m->getDownward(e, 0, verts);
+    apf::Copies remotes[PatchData::MAX_VERTS];
+    std::vector<int> parts;
+    for (int j = 0; j < nv; ++j) {
+      if (!m->isShared(verts[j]))
+        continue;
+      m->getRemotes(verts[j], remotes[j]);
+      APF_ITERATE(apf::Copies, remotes[j], rit)
+        if (std::find(parts.begin(), parts.end(), rit->first) == parts.end())
+          parts.push_back(rit->first);
+    }
+    if (parts.empty())
+      continue;
+    getElementSamples(r, e, &points[0], &values[0]);
+    for (size_t k = 0; k < parts.size(); ++k) {
+      int to = parts[k];
+      PCU_COMM_PACK(to, nv);
+      for (int j = 0; j < nv; ++j) {
+        apf::MeshEntity* remote = 0;
+        if (remotes[j].count(to))
+          remote = remotes[j][to];
+        PCU_COMM_PACK(to, remote);
+      }
+      PCU_Comm_Pack(to, &points[0], np * sizeof(apf::Vector3));
+      PCU_Comm_Pack(to, &values[0], np * nc * sizeof(double));
+    }
+  }
+  PCU_Comm_Send();
+  while (PCU_Comm_Receive()) {
+    int nv;
+    PCU_COMM_UNPACK(nv);
+    int verts[PatchData::MAX_VERTS];
+    for (int j = 0; j < nv; ++j) {
+      apf::MeshEntity* v;
+      PCU_COMM_UNPACK(v);
+      verts[j] = v ? getVertexNumber(d, m, v) : -1;
+    }
+    PCU_Comm_Unpack(&points[0], np * sizeof(apf::Vector3));
+    PCU_Comm_Unpack(&values[0], np * nc * sizeof(double));
+    addElementData(d, r, nv, verts, &points[0], &values[0]);
+  }
+}
+
+static void buildVertexElements(PatchData* d)
+{
+  std::vector<int>& offsets = d->vert_offsets;
+  int nv = static_cast<int>(offsets.size()) - 1;
+  for (int i = 0; i < d->num_elements; ++i)
+    for (int j = 0; j < d->element_num_verts[i]; ++j) {
+      int v = d->element_verts[i * PatchData::MAX_VERTS + j];
+      if (v != -1)
+        ++offsets[v + 1];
+    }
+  for (int v = 0; v < nv; ++v)
+    offsets[v + 1] += offsets[v];
+  d->vert_elements.resize(offsets[nv]);
+  std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+  for (int i = 0; i < d->num_elements; ++i)
+    for (int j = 0; j < d->element_num_verts[i]; ++j) {
+      int v = d->element_verts[i * PatchData::MAX_VERTS + j];
+      if (v != -1)
+        d->vert_elements[fill[v]++] = i;
+    }
+}
+
+static void setupPatchData(PatchData* d, Recovery* r)
+{
+  apf::Mesh* m = r->mesh;
+  d->num_elements = 0;
+  d->num_components = apf::countComponents(r->f);
+  numberVertices(d, m);
+  /* ghost copies from pumi_ghost_createLayer are left out,
+     their data arrives through the halo like any other */
+  std::vector<apf::MeshEntity*> elements;
+  elements.reserve(m->count(r->dim));
+  apf::MeshIterator* it = m->begin(r->dim);
+  apf::MeshEntity* e;
+  while ((e = m->iterate(it)))
+    if (!m->isGhost(e))
+      elements.push_back(e);
+  m->end(it);
+  int np = r->points_per_element;
+  std::vector<apf::Vector3> points(np);
+  std::vector<double> values(np * d->num_components);
+  for (size_t i = 0; i < elements.size(); ++i) {
+    apf::Downward verts;
+    int nv = r->mesh->getDownward(elements[i], 0, verts);
+    PCU_ALWAYS_ASSERT(nv <= PatchData::MAX_VERTS);
+    int numbers[PatchData::MAX_VERTS];
+    for (int j = 0; j < nv; ++j)
+      numbers[j] = getVertexNumber(d, m, verts[j]);
+    getElementSamples(r, elements[i], &points[0], &values[0]);
+    addElementData(d, r, nv, numbers, &points[0], &values[0]);
+  }
+  exchangeHalo(d, r, elements);
+  buildVertexElements(d);
+}
+
+static void destroyPatchData(PatchData* d, apf::Mesh* m)
+{
+  apf::removeTagFromDimension(m, d->vert_numbers, 0);
+  m->destroyTag(d->vert_numbers);
+}
+
+/* least squares workspace reused by all patches. the Householder
+   vectors are kept instead of forming the square Q matrix */
+struct FitWork {
+  std::vector<double> a;
+  std::vector<double> v;
+  std::vector<double> rhs;
+  mth::Vector<double> coeffs;
+  mth::Vector<double> terms;
+};
+
+static void reserve(std::vector<double>& x, size_t n)
+{
+  if (x.size() < n)
+    x.resize(n);
+}
+
+/* same reflectors and rank test as mth::decomposeQR */
+static bool factorFit(FitWork* w, int m, int n)
+{
+  std::vector<double>& a = w->a;
+  std::vector<double>& v = w->v;
+  for (int k = 0; k < n; ++k) {
+    double cnorm = 0;
+    for (int i = k; i < m; ++i)
+      cnorm += a[i * n + k] * a[i * n + k];
+    cnorm = sqrt(cnorm);
+    if (cnorm < 1e-10)
+      return false;
+    for (int i = k; i < m; ++i)
+      v[i * n + k] = a[i * n + k];
+    v[k * n + k] += (a[k * n + k] < 0 ? -1 : 1) * cnorm;
+    double rnorm = 0;
+    for (int i = k; i < m; ++i)
+      rnorm += v[i * n + k] * v[i * n + k];
+    rnorm = sqrt(rnorm);
+    for (int i = k; i < m; ++i)
+      v[i * n + k] /= rnorm;
+    for (int j = k; j < n; ++j) {
+      double dot = 0;
+      for (int i = k; i < m; ++i)
+        dot += a[i * n + j] * v[i * n + k];
+      for (int i = k; i < m; ++i)
+        a[i * n + j] -= 2 * dot * v[i * n + k];
+    }
+  }
+  return true;
+}
+
+static void solveFit(FitWork* w, int m, int n)
+{
+  std::vector<double>& a = w->a;
+  std::vector<double>& v = w->v;
+  std::vector<double>& b = w->rhs;
+  for (int k = 0; k < n; ++k) {
+    double dot = 0;
+    for (int i = k; i < m; ++i)
+      dot += b[i] * v[i * n + k];
+    for (int i = k; i < m; ++i)
+      b[i] -= 2 * dot * v[i * n + k];
+  }
+  w->coeffs.resize(n);
+  for (int ii = 0; ii < n; ++ii) {
+    int i = n - ii - 1;
+    double x = b[i];
+    for (int j = i + 1; j < n; ++j)
+      x -= a[i * n + j] * w->coeffs(j);
+    w->coeffs(i) = x / a[i * n + i];
+  }
+}
+
+struct FlatPatch {
+  std::vector<int> elements;
+  std::vector<int> old_elements;
+  /* mark[i] == stamp when element i is in the patch */
+  std::vector<int> mark;
+  int stamp;
+};
+
+static void addFlatElement(FlatPatch* p, int e)
+{
+  if (p->mark[e] == p->stamp)
+    return;
+  p->mark[e] = p->stamp;
+  p->elements.push_back(e);
+}
+
+static bool prepareFlatFit(Recovery* r, PatchData* d, FlatPatch* p,
+    FitWork* w)
+{
+  int np = r->points_per_element;
+  int m = np * p->elements.size();
+  int n = r->polynomial_terms;
+  if (m < n)
+    return false;
+  reserve(w->a, m * n);
+  reserve(w->v, m * n);
+  for (size_t i = 0; i < p->elements.size(); ++i)
+    for (int l = 0; l < np; ++l) {
+      int row = i * np + l;
+      evalPolynomialTerms(r->dim, r->order,
+          d->points[p->elements[i] * np + l], w->terms);
+      for (int j = 0; j < n; ++j)
+        w->a[row * n + j] = w->terms(j);
+    }
+  return factorFit(w, m, n);
+}
+
+static int countSharedVerts(PatchData* d, int a, int b)
+{
+  int const* va = &d->element_verts[a * PatchData::MAX_VERTS];
+  int const* vb = &d->element_verts[b * PatchData::MAX_VERTS];
+  int shared = 0;
+  for (int i = 0; i < d->element_num_verts[a]; ++i)
+    for (int j = 0; j < d->element_num_verts[b]; ++j)
+      if (va[i] != -1 && va[i] == vb[j])
+        ++shared;
+  return shared;
+}
+
+/* mirrors expandAsNecessary: elements sharing an entity of dimension
+   shared_dim with the old patch are those sharing shared_dim + 1
+   vertices with one of its elements. returns false if the patch needs
+   elements beyond the halo */
+static bool expandFlatPatch(Recovery* r, PatchData* d, FlatPatch* p,
+    FitWork* w)
+{
+  while (!prepareFlatFit(r, d, p, w)) {
+    p->old_elements = p->elements;
+    for (size_t i = 0; i < p->old_elements.size(); ++i) {
+      int e = p->old_elements[i];
+      for (int j = 0; j < d->element_num_verts[e]; ++j)
+        if (d->element_verts[e * PatchData::MAX_VERTS + j] == -1)
+          return false;
+    }
+    bool done = false;
+    for (int shared_dim = r->dim - 1; shared_dim >= 0; --shared_dim) {
+      for (size_t i = 0; i < p->old_elements.size(); ++i) {
+        int e = p->old_elements[i];
+        for (int j = 0; j < d->element_num_verts[e]; ++j) {
+          int v = d->element_verts[e * PatchData::MAX_VERTS + j];
+          for (int k = d->vert_offsets[v]; k < d->vert_offsets[v + 1]; ++k) {
+            int c = d->vert_elements[k];
+            if (countSharedVerts(d, e, c) >= shared_dim + 1)
+              addFlatElement(p, c);
+          }
+        }
+      }
+      if (prepareFlatFit(r, d, p, w)) {
+        done = true;
+        break;
+      }
+    }
+    if (done)
+      break;
+    if (p->elements.size() == p->old_elements.size())
+      apf::fail("SPR: patch construction: all hope is lost.");
+  }
+  return true;
+}
+
+static bool buildFlatPatch(Recovery* r, PatchData* d, FlatPatch* p,
+    FitWork* w, apf::MeshEntity* entity)
+{
+  apf::Mesh* m = r->mesh;
+  ++p->stamp;
+  p->elements.clear();
+  apf::Downward verts;
+  int nv = 1;
+  if (apf::getDimension(m, entity))
+    nv = m->getDownward(entity, 0, verts);
+  else
+    verts[0] = entity;
+  int numbers[PatchData::MAX_VERTS];
+  for (int i = 0; i < nv; ++i)
+    numbers[i] = getVertexNumber(d, m, verts[i]);
+  int v = numbers[0];
+  for (int k = d->vert_offsets[v]; k < d->vert_offsets[v + 1]; ++k) {
+    int e = d->vert_elements[k];
+    int const* ev = &d->element_verts[e * PatchData::MAX_VERTS];
+    int found = 0;
+    for (int i = 0; i < nv; ++i)
+      for (int j = 0; j < d->element_num_verts[e]; ++j)
+        if (ev[j] == numbers[i])
+          ++found;
+    if (found == nv)
+      addFlatElement(p, e);
+  }
+  return expandFlatPatch(r, d, p, w);
+}
+
+/* writes the nodal values of the entity, node by node, to out */
+static void runFlatSpr(Recovery* r, PatchData* d, FlatPatch* p,
+    FitWork* w, apf::MeshEntity* entity, double* out)
+{
+  apf::Mesh* m = r->mesh;
+  int np = r->points_per_element;
+  int nc = d->num_components;
+  int rows = np * p->elements.size();
+  int n = r->polynomial_terms;
+  int num_nodes = m->getShape()->countNodesOn(m->getType(entity));
+  reserve(w->rhs, rows);
+  apf::NewArray<apf::Vector3> nodal_points(num_nodes);
+  for (int i = 0; i < num_nodes; ++i)
+    m->getPoint(entity, i, nodal_points[i]);
+  for (int c = 0; c < nc; ++c) {
+    for (size_t i = 0; i < p->elements.size(); ++i)
+      for (int l = 0; l < np; ++l)
+        w->rhs[i * np + l] = d->values[(p->elements[i] * np + l) * nc + c];
+    solveFit(w, rows, n);
+    for (int j = 0; j < num_nodes; ++j) {
+      evalPolynomialTerms(r->dim, r->order, nodal_points[j], w->terms);
+      out[j * nc + c] = w->coeffs * w->terms;
+    }
+  }
+}
+
+/* the patches of owned entities are independent of each other, so
+   they are fitted by threads with a patch and workspace each. values
+   go to a flat array and are written to the field afterwards, since
+   giving field values to entities is not safe from threads */
+struct LocalRecovery : public apf::ThreadWork
+{
+  Recovery* recovery;
+  PatchData* data;
+  std::vector<apf::MeshEntity*> entities;
+  /* values of entities[i] start at values[offsets[i]] */
+  std::vector<int> offsets;
+  std::vector<double> values;
+  std::vector<char> recovered;
+  std::vector<FlatPatch> patches;
+  std::vector<FitWork> works;
+  void run(int thread, int first, int last)
+  {
+    FlatPatch* p = &patches[thread];
+    FitWork* w = &works[thread];
+    for (int i = first; i < last; ++i) {
+      recovered[i] = buildFlatPatch(recovery, data, p, w, entities[i]);
+      if (recovered[i])
+        runFlatSpr(recovery, data, p, w, entities[i], &values[offsets[i]]);
+    }
+  }
+};
+
+/* patches are handed to threads in batches of this many */
+static int const patchBatch = 64;
+
+/* recover all owned entities whose patch is complete on this part.
+   returns the number of entities left for cavity migration */
+static int recoverLocally(Recovery* r, int threads)
+{
+  apf::Mesh* m = r->mesh;
+  PatchData data;
+  setupPatchData(&data, r);
+  LocalRecovery lr;
+  lr.recovery = r;
+  lr.data = &data;
+  int offset = 0;
+  for (int d = 0; d <= 3; ++d) {
+    if (!m->getShape()->hasNodesIn(d))
+      continue;
+    apf::MeshIterator* it = m->begin(d);
+    apf::MeshEntity* e;
+    while ((e = m->iterate(it))) {
+      if (!m->isOwned(e))
+        continue;
+      lr.entities.push_back(e);
+      lr.offsets.push_back(offset);
+      offset += m->getShape()->countNodesOn(m->getType(e)) *
+        data.num_components;
+    }
+    m->end(it);
+  }
+  int count = lr.entities.size();
+  lr.values.resize(offset);
+  lr.recovered.assign(count, 0);
+  threads = apf::countThreads(threads, count, patchBatch);
+  lr.patches.resize(threads);
+  for (int i = 0; i < threads; ++i) {
+    lr.patches[i].mark.assign(data.num_elements, 0);
+    lr.patches[i].stamp = 0;
+  }
+  lr.works.resize(threads);
+  apf::prepareThreadedReads(m);
+  apf::runThreads(&lr, count, threads, patchBatch);
+  int left = 0;
+  for (int i = 0; i < count; ++i) {
+    if (!lr.recovered[i]) {
+      ++left;
+      continue;
+    }
+    apf::MeshEntity* e = lr.entities[i];
+    int nodes = m->getShape()->countNodesOn(m->getType(e));
+    for (int j = 0; j < nodes; ++j)
+      apf::setComponents(r->f_star, e, j,
+          &lr.values[lr.offsets[i] + j * data.num_components]);
+  }
+  destroyPatchData(&data, m);
+  apf::synchronize(r->f_star);
+  return PCU_Add_Int(left);
+}
+
+apf::Field* recoverField(apf::Field* f, bool useHalo, int threads)
 {
   Recovery recovery;
   setupRecovery(&recovery, f);
+  if (useHalo && !recoverLocally(&recovery, threads))
+    return recovery.f_star;
   PatchOp op(&recovery);
   for (int d = 0; d <= 3; ++d)
     if (recovery.mesh->getShape()->hasNodesIn(d))
@@ -14,6 +14,7 @@
 
 #include <math.h>
 #include <pcu_util.h>
+#include <vector>
 
 /* This test file uses an alternative and more traditional method to
  * compute Jacobian differences, using the property of Bezier's that
@@ -398,6 +399,21 @@ void test3D()
     } else {
       PCU_ALWAYS_ASSERT(validityTag == 1);
     }
+    // the batched check has to agree with the one at a time check
+    crv::Quality* qual = crv::makeQuality(m,2);
+    apf::MeshEntity* tets[2] = {tet, tet};
+    int batchTags[2];
+    qual->checkBatchValidity(tets,2,batchTags);
+    validityTag = qual->checkValidity(tet);
+    PCU_ALWAYS_ASSERT(batchTags[0] == validityTag);
+    PCU_ALWAYS_ASSERT(batchTags[1] == validityTag);
+    delete qual;
+    // and so do several threads sharing the batches
+    std::vector<apf::MeshEntity*> many(200,tet);
+    std::vector<int> threadTags(many.size());
+    crv::checkValidities(m,&many[0],many.size(),&threadTags[0],3);
+    for (size_t i = 0; i < many.size(); ++i)
+      PCU_ALWAYS_ASSERT(threadTags[i] == validityTag);
     crv::getQuality(m,tet);
     m->destroyNative();
     apf::destroyMesh(m);
@@ -0,0 +1,103 @@
+#include <ma.h>
+#include <apf.h>
+#include <gmi_mesh.h>
+#include <gmi_null.h>
+#include <apfMDS.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#ifdef HAVE_SIMMETRIX
+#include <gmi_sim.h>
+#include <SimUtil.h>
+#include <MeshSim.h>
+#include <SimModel.h>
+#endif
+#include <pcu_util.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+const char* modelFile = 0;
+const char* meshFile = 0;
+const char* outFile = 0;
+bool useHilbert = false;
+
+void getConfig(int argc, char** argv)
+{
+  if ( argc != 4 && argc != 5 ) {
+    if ( !PCU_Comm_Self() )
+      printf("Usage: %s <model> <mesh> <outMesh> [hilbert]\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  modelFile = argv[1];
+  meshFile = argv[2];
+  outFile = argv[3];
+  useHilbert = (argc == 5 && !strcmp(argv[4], "hilbert"));
+}
+
+/* the coordinates stored in a field must still match
+   the vertices they were attached to */
+void checkCoordinates(apf::Mesh2* m, apf::Field* f)
+{
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  while ((v = m->iterate(it))) {
+    apf::Vector3 x, y;
+    m->getPoint(v, 0, x);
+    apf::getVector(f, v, 0, y);
+    PCU_ALWAYS_ASSERT((x - y).getLength() < 1e-12);
+  }
+  m->end(it);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+#ifdef HAVE_SIMMETRIX
+  MS_init();
+  SimModel_start();
+  Sim_readLicenseFile(0);
+  gmi_sim_start();
+  gmi_register_sim();
+#endif
+  gmi_register_null();
+  gmi_register_mesh();
+  getConfig(argc,argv);
+  ma::Mesh* m = apf::loadMdsMesh(modelFile,meshFile);
+  ma::Input* in = ma::configureUniformRefine(m, 1);
+  if (in->shouldSnap) {
+    in->shouldSnap = false;
+    PCU_ALWAYS_ASSERT(in->shouldTransferParametric);
+  }
+  in->shouldFixShape = false;
+  ma::adapt(in);
+  apf::Field* coords = apf::createLagrangeField(m, "coords", apf::VECTOR, 1);
+  apf::copyData(coords, m->getCoordinateField());
+  double fill = PCU_Min_Double(apf::getMdsFill(m));
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "fill ratio before compaction %f\n", fill);
+  apf::MeshTag* order = 0;
+  if (useHilbert)
+    order = apf::numberMdsMesh(m, apf::MDS_HILBERT_ORDER);
+  apf::compactMdsMesh(m, order);
+  PCU_ALWAYS_ASSERT(apf::getMdsFill(m) == 1);
+  checkCoordinates(m, coords);
+  apf::destroyField(coords);
+  apf::verify(m);
+  m->writeNative(outFile);
+  m->destroyNative();
+  apf::destroyMesh(m);
+#ifdef HAVE_SIMMETRIX
+  gmi_sim_stop();
+  Sim_unregisterAllKeys();
+  SimModel_stop();
+  MS_exit();
+#endif
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
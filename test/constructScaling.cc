@@ -0,0 +1,101 @@
+#include <gmi_null.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apfConvert.h>
+#include <apf.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include "kuhn.h"
+#include <cstdlib>
+#include <vector>
+
+/* builds a box of n*n*(n*peers) cubes, six tets each, where every
+   part holds one slab of n*n*n cubes and only knows the global ids
+   of its own connectivity. the ids start at 2^32 so the 64-bit
+   path of apf::construct is exercised */
+
+namespace {
+
+const apf::Gid offset = apf::Gid(1) << 32;
+
+int n;
+
+apf::Gid getId(int i, int j, int k)
+{
+  return offset + i + apf::Gid(n + 1) * (j + apf::Gid(n + 1) * k);
+}
+
+void makeConnectivity(std::vector<apf::Gid>& conn)
+{
+  int k0 = PCU_Comm_Self() * n;
+  for (int k = k0; k < k0 + n; ++k)
+  for (int j = 0; j < n; ++j)
+  for (int i = 0; i < n; ++i)
+    for (int t = 0; t < 6; ++t) {
+      int corners[4];
+      getKuhnTet(t, corners);
+      for (int c = 0; c < 4; ++c) {
+        long ijk[3];
+        getKuhnCorner(i, j, k, corners[c], ijk);
+        conn.push_back(getId(ijk[0], ijk[1], ijk[2]));
+      }
+    }
+}
+
+void setPoints(apf::Mesh2* m, apf::GlobalToVert& globalToVert)
+{
+  APF_ITERATE(apf::GlobalToVert, globalToVert, it) {
+    apf::Gid id = it->first - offset;
+    apf::Vector3 p(id % (n + 1), (id / (n + 1)) % (n + 1),
+        id / ((n + 1) * (n + 1)));
+    m->setPoint(it->second, 0, p / n);
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s <cubes per part edge>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  n = atoi(argv[1]);
+  gmi_register_null();
+  std::vector<apf::Gid> conn;
+  makeConnectivity(conn);
+  int nelem = conn.size() / 4;
+
+  gmi_model* model = gmi_load(".null");
+  apf::Mesh2* m = apf::makeEmptyMdsMesh(model, 3, false);
+  double t0 = PCU_Time();
+  apf::GlobalToVert outMap;
+  apf::construct(m, &conn[0], nelem, apf::Mesh::TET, outMap);
+  double t1 = PCU_Time();
+  apf::alignMdsRemotes(m);
+  apf::deriveMdsModel(m);
+  setPoints(m, outMap);
+  outMap.clear();
+  double t2 = PCU_Time();
+  long elements = PCU_Add_Long(m->count(3));
+  long verts = PCU_Add_Long(apf::countOwned(m, 0));
+  long side = n;
+  long peers = PCU_Comm_Peers();
+  PCU_ALWAYS_ASSERT(elements == 6 * side * side * side * peers);
+  PCU_ALWAYS_ASSERT(verts == (side + 1) * (side + 1) * (side * peers + 1));
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "constructed %ld tets and %ld vertices in %f seconds, "
+        "%f seconds with the model\n", elements, verts, t1 - t0, t2 - t0);
+  m->verify();
+
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -105,6 +105,9 @@ int main(int argc, char** argv)
   print_stats("malloc used", get_chunks());
   Parma_PrintPtnStats(m, "");
   list_tags(m);
+  apf::printMdsMemory(m);
+  apf::dropMdsUpward(m);
+  print_stats("malloc used without upward adjacency", get_chunks());
   m->destroyNative();
   apf::destroyMesh(m);
 #ifdef HAVE_SIMMETRIX
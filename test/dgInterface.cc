@@ -0,0 +1,262 @@
+#include <phBC.h>
+#include <phInterfaceCutter.h>
+#include <gmi_base.h>
+#include <apf.h>
+#include <apfMDS.h>
+#include <apfBox.h>
+#include <apfMesh2.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* cuts a box split by the plane x = 0.5 into two model regions,
+   with periodic matches between the faces at y = 0 and y = 1.
+   the elements are then scattered so that DG pairs cross parts,
+   and ph::migrateInterfaceItr must bring every pair onto one part
+   while getDgCopies leaves out the periodic matches */
+
+namespace {
+
+/* regions 1 and 2 bounded by faces 1 and 2, sharing face 3.
+   edge 1 is where face 3 meets the boundary */
+char const* const dmg =
+"2 3 1 1\n"
+"0 0 0\n"
+"0 0 0\n"
+"1 0 0 0\n"
+"1 1 1\n"
+"1 1\n1\n 1 0\n"
+"2 1\n1\n 1 0\n"
+"3 1\n1\n 1 0\n"
+"1 1\n2\n 1 0\n 3 0\n"
+"2 1\n2\n 2 0\n 3 0\n";
+
+int const interfaceTag = 3;
+
+gmi_model* makeModel()
+{
+  FILE* f = tmpfile();
+  PCU_ALWAYS_ASSERT(f);
+  fputs(dmg, f);
+  rewind(f);
+  /* plain malloc because gmi_destroy calls plain free */
+  gmi_base* m = (gmi_base*) malloc(sizeof(*m));
+  m->model.ops = &gmi_base_ops;
+  gmi_base_read_dmg(m, f);
+  fclose(f);
+  return &m->model;
+}
+
+void makeBCs(ph::BCs& bcs)
+{
+  ph::ConstantBC* bc = new ph::ConstantBC();
+  bc->tag = interfaceTag;
+  bc->dim = 2;
+  bc->value = new double[1];
+  bc->value[0] = 1;
+  bcs.fields["DG interface"].bcs.insert(bc);
+}
+
+bool allAt(apf::Mesh* m, apf::MeshEntity* e, int d, double x)
+{
+  apf::Downward v;
+  int n = m->getDownward(e, 0, v);
+  for (int i = 0; i < n; ++i) {
+    apf::Vector3 p;
+    m->getPoint(v[i], 0, p);
+    if (std::fabs(p[d] - x) > 1e-9)
+      return false;
+  }
+  return true;
+}
+
+bool onBoundary(apf::Mesh* m, apf::MeshEntity* e)
+{
+  for (int d = 0; d < 3; ++d)
+    if (allAt(m, e, d, 0) || allAt(m, e, d, 1))
+      return true;
+  return false;
+}
+
+apf::ModelEntity* classify(apf::Mesh* m, apf::MeshEntity* e)
+{
+  int side = apf::getLinearCentroid(m, e).x() < 0.5 ? 1 : 2;
+  bool inside = apf::getDimension(m, e) == 3;
+  bool plane = !inside && allAt(m, e, 0, 0.5);
+  bool boundary = !inside && onBoundary(m, e);
+  if (plane && boundary)
+    return m->findModelEntity(1, 1);
+  if (plane)
+    return m->findModelEntity(2, interfaceTag);
+  if (boundary)
+    return m->findModelEntity(2, side);
+  return m->findModelEntity(3, side);
+}
+
+void setModel(apf::Mesh2* m, gmi_model* g)
+{
+  gmi_model* box = m->getModel();
+  m->setModel(g);
+  gmi_destroy(box);
+  for (int d = 0; d <= 3; ++d) {
+    apf::MeshIterator* it = m->begin(d);
+    apf::MeshEntity* e;
+    while ((e = m->iterate(it)))
+      m->setModelEntity(e, classify(m, e));
+    m->end(it);
+  }
+}
+
+void getFacesAt(apf::Mesh* m, double y, std::vector<apf::MeshEntity*>& fs)
+{
+  apf::MeshIterator* it = m->begin(2);
+  apf::MeshEntity* f;
+  while ((f = m->iterate(it)))
+    if (allAt(m, f, 1, y))
+      fs.push_back(f);
+  m->end(it);
+}
+
+/* only faces are matched, which is enough to tell
+   periodic matches from DG copies */
+void matchPeriodicFaces(apf::Mesh2* m)
+{
+  std::vector<apf::MeshEntity*> low;
+  std::vector<apf::MeshEntity*> high;
+  getFacesAt(m, 0, low);
+  getFacesAt(m, 1, high);
+  PCU_ALWAYS_ASSERT(low.size() == high.size());
+  for (size_t i = 0; i < low.size(); ++i) {
+    apf::Vector3 a = apf::getLinearCentroid(m, low[i]);
+    a.y() = 1;
+    size_t j = 0;
+    while (j < high.size() &&
+           !((apf::getLinearCentroid(m, high[j]) - a).getLength() < 1e-9))
+      ++j;
+    PCU_ALWAYS_ASSERT(j < high.size());
+    m->addMatch(low[i], m->getId(), high[j]);
+    m->addMatch(high[j], m->getId(), low[i]);
+  }
+}
+
+/* the cut mesh is made on the first rank alone */
+apf::Mesh2* makeCutBox(ph::BCs& bcs)
+{
+  int self = PCU_Comm_Self();
+  MPI_Comm serial;
+  MPI_Comm_split(MPI_COMM_WORLD, self ? 1 : 0, 0, &serial);
+  PCU_Switch_Comm(serial);
+  apf::Mesh2* m = 0;
+  if (!self) {
+    m = apf::makeMdsBox(4, 4, 4, 1, 1, 1, true);
+    setModel(m, makeModel());
+    ph::cutInterface(m, bcs);
+    matchPeriodicFaces(m);
+  }
+  PCU_Switch_Comm(MPI_COMM_WORLD);
+  MPI_Comm_free(&serial);
+  if (self)
+    m = apf::makeEmptyMdsMesh(makeModel(), 3, true);
+  return m;
+}
+
+/* consecutive elements go to different parts,
+   which splits most DG pairs */
+void scatter(apf::Mesh2* m)
+{
+  apf::Migration* plan = new apf::Migration(m);
+  if (!PCU_Comm_Self()) {
+    apf::MeshIterator* it = m->begin(3);
+    apf::MeshEntity* e;
+    int i = 0;
+    while ((e = m->iterate(it))) {
+      int to = (i++ / 7) % PCU_Comm_Peers();
+      if (to)
+        plan->send(e, to);
+    }
+    m->end(it);
+  }
+  m->migrate(plan);
+}
+
+long countRemoteCopies(apf::Mesh* m)
+{
+  long n = 0;
+  apf::MeshIterator* it = m->begin(2);
+  apf::MeshEntity* f;
+  while ((f = m->iterate(it))) {
+    apf::DgCopies c;
+    m->getDgCopies(f, c);
+    for (size_t i = 0; i < c.getSize(); ++i)
+      if (c[i].peer != PCU_Comm_Self())
+        ++n;
+  }
+  m->end(it);
+  return PCU_Add_Long(n);
+}
+
+void checkCopies(apf::Mesh* m)
+{
+  long dg = 0;
+  long periodic = 0;
+  apf::MeshIterator* it = m->begin(2);
+  apf::MeshEntity* f;
+  while ((f = m->iterate(it))) {
+    apf::ModelEntity* me = m->toModel(f);
+    apf::Matches matches;
+    m->getMatches(f, matches);
+    apf::DgCopies c;
+    m->getDgCopies(f, c);
+    if (m->getModelType(me) == 2 && m->getModelTag(me) == interfaceTag) {
+      PCU_ALWAYS_ASSERT(c.getSize() == 1);
+      PCU_ALWAYS_ASSERT(c[0].peer == PCU_Comm_Self());
+      PCU_ALWAYS_ASSERT(m->toModel(c[0].entity) == me);
+      ++dg;
+    } else {
+      PCU_ALWAYS_ASSERT(!c.getSize());
+      if (matches.getSize())
+        ++periodic;
+    }
+  }
+  m->end(it);
+  dg = PCU_Add_Long(dg);
+  periodic = PCU_Add_Long(periodic);
+  /* both sides of the 4x4 grid of squares on each plane */
+  PCU_ALWAYS_ASSERT(dg == 2 * 4 * 4 * 2);
+  PCU_ALWAYS_ASSERT(periodic == 2 * 4 * 4 * 2);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 1) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  ph::BCs bcs;
+  makeBCs(bcs);
+  apf::Mesh2* m = makeCutBox(bcs);
+  scatter(m);
+  long elements = PCU_Add_Long(m->count(3));
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1 || countRemoteCopies(m));
+  PCU_ALWAYS_ASSERT(ph::migrateInterfaceItr(m, bcs));
+  PCU_ALWAYS_ASSERT(PCU_Add_Long(m->count(3)) == elements);
+  PCU_ALWAYS_ASSERT(!countRemoteCopies(m));
+  checkCopies(m);
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "every DG pair of %ld elements is on one part\n", elements);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
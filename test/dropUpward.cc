@@ -0,0 +1,124 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+/* drops the upward adjacency of an MDS mesh and checks that the
+   lazy rebuild and apf::restoreMdsUpward give back the same
+   adjacency, before and after the mesh is changed without it */
+
+namespace {
+
+typedef std::vector<apf::MeshEntity*> Ents;
+
+/* one-level upward adjacency of every entity, each list sorted
+   since the rebuild may link upward entities in another order */
+void getUpward(apf::Mesh* m, std::vector<Ents>* up)
+{
+  for (int d = 0; d < m->getDimension(); ++d) {
+    up[d].clear();
+    apf::MeshIterator* it = m->begin(d);
+    apf::MeshEntity* e;
+    while ((e = m->iterate(it))) {
+      apf::Up u;
+      m->getUp(e, u);
+      Ents ents(u.e, u.e + u.n);
+      std::sort(ents.begin(), ents.end());
+      up[d].push_back(ents);
+    }
+    m->end(it);
+  }
+}
+
+void checkDropped(apf::Mesh2* m)
+{
+  apf::MdsMemory mem;
+  apf::getMdsMemory(m, mem);
+  for (int d = 0; d < m->getDimension(); ++d)
+    PCU_ALWAYS_ASSERT(!mem.adjacency[d][d + 1]);
+}
+
+/* the second-order adjacency goes through the rebuilt
+   upward arrays as well */
+long countBridges(apf::Mesh* m)
+{
+  long n = 0;
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  while ((v = m->iterate(it))) {
+    apf::Adjacent adj;
+    apf::getBridgeAdjacent(m, v, m->getDimension(), 0, adj);
+    n += adj.getSize();
+  }
+  m->end(it);
+  return n;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s <model.dmg> <mesh.smb>\n", argv[0]);
+    PCU_Comm_Free();
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  gmi_register_mesh();
+  apf::Mesh2* m = apf::loadMdsMesh(argv[1], argv[2]);
+  int dim = m->getDimension();
+  std::vector<Ents> before[3];
+  std::vector<Ents> after[3];
+  getUpward(m, before);
+  long bridges = countBridges(m);
+  apf::MdsMemory mem;
+  apf::getMdsMemory(m, mem);
+  size_t full = apf::getMdsMemoryTotal(mem);
+  apf::dropMdsUpward(m);
+  checkDropped(m);
+  getUpward(m, after);
+  for (int d = 0; d < dim; ++d)
+    PCU_ALWAYS_ASSERT(before[d] == after[d]);
+  apf::getMdsMemory(m, mem);
+  PCU_ALWAYS_ASSERT(apf::getMdsMemoryTotal(mem) == full);
+  /* entities created and destroyed while the upward adjacency is
+     gone must show up correctly once it is rebuilt */
+  apf::dropMdsUpward(m);
+  apf::MeshIterator* it = m->begin(dim);
+  apf::MeshEntity* e = m->iterate(it);
+  m->end(it);
+  apf::Downward verts;
+  int nv = m->getDownward(e, 0, verts);
+  apf::ModelEntity* c = m->toModel(e);
+  int type = m->getType(e);
+  m->destroy(e);
+  checkDropped(m);
+  apf::restoreMdsUpward(m);
+  apf::getMdsMemory(m, mem);
+  for (int d = 0; d < dim; ++d)
+    PCU_ALWAYS_ASSERT(mem.adjacency[d][d + 1]);
+  apf::buildElement(m, c, type, verts);
+  PCU_ALWAYS_ASSERT(nv == apf::Mesh::adjacentCount[type][0]);
+  getUpward(m, after);
+  for (int d = 0; d < dim; ++d)
+    PCU_ALWAYS_ASSERT(before[d].size() == after[d].size());
+  PCU_ALWAYS_ASSERT(countBridges(m) == bridges);
+  apf::verify(m);
+  long n = PCU_Add_Long(m->count(dim));
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "upward adjacency of %ld elements rebuilt\n", n);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,183 @@
+#include <dsp.h>
+#include <apf.h>
+#include <apfMDS.h>
+#include <apfBox.h>
+#include <apfMesh2.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <cmath>
+#include <cstdlib>
+
+/* smooths a rigid lift of the top of a unit box over the rest of it,
+   with the bottom fixed, using the conjugate gradient smoothers.
+   the box is built on the first part and split into slabs along z.
+   every vertex has to move up by no more than the top and no less
+   than the bottom, and all copies of a vertex have to agree */
+
+namespace {
+
+int const n = 6;
+double const lift = 0.1;
+/* the residual tolerance of the smoothers, relative to the lift */
+double const slack = 1e-3;
+
+/* the model of apf::makeMdsBox is the same for any number of
+   elements, so the other parts take it from a single cube */
+gmi_model* makeBoxModel()
+{
+  apf::Mesh2* box = apf::makeMdsBox(1, 1, 1, 1, 1, 1, true);
+  gmi_model* g = box->getModel();
+  apf::disownMdsModel(box);
+  box->destroyNative();
+  apf::destroyMesh(box);
+  return g;
+}
+
+apf::Migration* getSlabPlan(apf::Mesh* m, int parts)
+{
+  apf::Migration* plan = new apf::Migration(m);
+  apf::MeshIterator* it = m->begin(3);
+  apf::MeshEntity* e;
+  while ((e = m->iterate(it))) {
+    int to = apf::getLinearCentroid(m, e).z() * parts;
+    if (to)
+      plan->send(e, to);
+  }
+  m->end(it);
+  return plan;
+}
+
+void switchToFirst()
+{
+  MPI_Comm groupComm;
+  int self = PCU_Comm_Self();
+  MPI_Comm_split(MPI_COMM_WORLD, self != 0, self, &groupComm);
+  PCU_Switch_Comm(groupComm);
+}
+
+void switchToAll()
+{
+  MPI_Comm prevComm = PCU_Get_Comm();
+  PCU_Switch_Comm(MPI_COMM_WORLD);
+  MPI_Comm_free(&prevComm);
+  PCU_Barrier();
+}
+
+apf::Mesh2* makeSlabs()
+{
+  int parts = PCU_Comm_Peers();
+  bool first = !PCU_Comm_Self();
+  apf::Mesh2* m = 0;
+  gmi_model* g = 0;
+  apf::Migration* plan = 0;
+  switchToFirst();
+  if (first) {
+    m = apf::makeMdsBox(n, n, n, 1, 1, 1, true);
+    g = m->getModel();
+    plan = getSlabPlan(m, parts);
+  } else {
+    g = makeBoxModel();
+  }
+  switchToAll();
+  return apf::repeatMdsMesh(m, g, plan, parts);
+}
+
+/* the owner's value, to compare each copy against */
+void checkCopies(apf::Field* df)
+{
+  apf::Mesh* m = apf::getMesh(df);
+  apf::Field* copy = apf::createFieldOn(m, "dsp_copy", apf::VECTOR);
+  apf::copyData(copy, df);
+  apf::synchronize(copy);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  while ((v = m->iterate(it))) {
+    apf::Vector3 a, b;
+    apf::getVector(df, v, 0, a);
+    apf::getVector(copy, v, 0, b);
+    PCU_ALWAYS_ASSERT((a - b).getLength() < slack * lift);
+  }
+  m->end(it);
+  apf::destroyField(copy);
+}
+
+void checkDisplacement(apf::Field* df, dsp::Boundary& fixed,
+    dsp::Boundary& moving)
+{
+  apf::Mesh* m = apf::getMesh(df);
+  double moved = 0;
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  while ((v = m->iterate(it))) {
+    apf::Vector3 d;
+    apf::getVector(df, v, 0, d);
+    apf::ModelEntity* me = m->toModel(v);
+    PCU_ALWAYS_ASSERT(std::fabs(d.x()) < slack * lift);
+    PCU_ALWAYS_ASSERT(std::fabs(d.y()) < slack * lift);
+    if (fixed.count(me))
+      PCU_ALWAYS_ASSERT(d.z() == 0);
+    else if (moving.count(me))
+      PCU_ALWAYS_ASSERT(std::fabs(d.z() - lift) < 1e-12);
+    else {
+      PCU_ALWAYS_ASSERT(d.z() > -slack * lift);
+      PCU_ALWAYS_ASSERT(d.z() < (1 + slack) * lift);
+      if (m->isOwned(v))
+        moved += d.z();
+    }
+  }
+  m->end(it);
+  /* the interior follows the lift, roughly linearly in z */
+  PCU_ALWAYS_ASSERT(PCU_Add_Double(moved) > 0);
+  checkCopies(df);
+}
+
+void testSmoother(apf::Mesh2* m, dsp::Smoother* smoother,
+    dsp::Boundary& fixed, dsp::Boundary& moving)
+{
+  apf::Matrix3x3 r(1,0,0,
+                   0,1,0,
+                   0,0,1);
+  apf::Vector3 t(0, 0, lift);
+  smoother->preprocess(m, fixed, moving);
+  /* the second solve starts from the first solution */
+  for (int i = 0; i < 2; ++i) {
+    apf::Field* df = dsp::applyRigidMotion(m, moving, r, t);
+    smoother->smooth(df, fixed, moving);
+    checkDisplacement(df, fixed, moving);
+    apf::destroyField(df);
+  }
+  smoother->cleanup();
+  delete smoother;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 1) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  apf::Mesh2* m = makeSlabs();
+  /* box model faces are numbered by their place in the 3x3x3 grid
+     of model entities, so the z=0 face is 0 and the z=1 face is 5 */
+  dsp::Boundary fixed;
+  fixed.insert(m->findModelEntity(2, 0));
+  dsp::closeBoundary(m, fixed);
+  dsp::Boundary moving;
+  moving.insert(m->findModelEntity(2, 5));
+  dsp::closeBoundary(m, moving);
+  testSmoother(m, dsp::Smoother::makeConjugateGradient(), fixed, moving);
+  testSmoother(m, dsp::Smoother::makeConjugateGradient(true), fixed, moving);
+  m->verify();
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
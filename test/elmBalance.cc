@@ -27,13 +27,14 @@ apf::MeshTag* setWeights(apf::Mesh* m) {
 
 int main(int argc, char** argv)
 {
-  PCU_ALWAYS_ASSERT(argc == 4);
+  PCU_ALWAYS_ASSERT(argc == 4 || argc == 5);
   MPI_Init(&argc,&argv);
   PCU_Comm_Init();
   lion_set_verbosity(1);
-  if ( argc != 4 ) {
+  if ( argc != 4 && argc != 5 ) {
     if ( !PCU_Comm_Self() )
-      printf("Usage: %s <model> <mesh> <out mesh>\n", argv[0]);
+      printf("Usage: %s <model> <mesh> <out mesh> "
+          "[steps per migration, 0 for incremental]\n", argv[0]);
     MPI_Finalize();
     exit(EXIT_FAILURE);
   }
@@ -53,8 +54,23 @@ int main(int argc, char** argv)
         imbalance[0], imbalance[1], imbalance[2], imbalance[3]);
   apf::MeshTag* weights = setWeights(m);
   const double step = 0.2; const int verbose = 1;
-  apf::Balancer* balancer = Parma_MakeElmBalancer(m, step, verbose);
+  apf::Balancer* balancer;
+  const int steps = argc == 5 ? atoi(argv[4]) : -1;
+  if ( steps > 0 )
+    balancer = Parma_MakeMultiStepElmBalancer(m, steps, step, verbose);
+  else if ( steps == 0 )
+    balancer = Parma_MakeIncrementalElmBalancer(m, verbose);
+  else
+    balancer = Parma_MakeElmBalancer(m, step, verbose);
   balancer->balance(weights, 1.05);
+  std::vector<Parma_StepInfo> info;
+  PCU_ALWAYS_ASSERT(Parma_GetBalancerSteps(balancer, info));
+  long moved = 0;
+  for (size_t i = 0; i < info.size(); ++i)
+    moved += info[i].elements;
+  if(!PCU_Comm_Self())
+    fprintf(stdout, "%lu migrations moved %ld elements\n",
+        (unsigned long)info.size(), moved);
   delete balancer;
   apf::removeTagFromDimension(m, weights, m->getDimension());
   m->destroyTag(weights);
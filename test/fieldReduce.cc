@@ -3,6 +3,7 @@
 #include <apfMesh2.h>
 #include <apfMDS.h>
 #include <apfShape.h>
+#include <apfSyncPlan.h>
 #include <PCU.h>
 #include <lionPrint.h>
 #include <parma.h>
@@ -58,8 +59,16 @@ apf::Field* getTestField(apf::Mesh* m, const char* fname, double addval)
   return f;
 }
 
+/* cases 3 to 5 repeat cases 0 to 2 through a SyncPlan */
 bool testReduce(apf::Mesh* m, int casenum)
 {
+  char fname[256];
+  sprintf(fname, "test%d", casenum);
+  apf::SyncPlan* plan = 0;
+  if (casenum > 2) {
+    plan = new apf::SyncPlan(m, apf::getLagrange(1));
+    casenum -= 3;
+  }
 
   double addval = 0;
   if (casenum == 0)  // sum
@@ -67,13 +76,20 @@ bool testReduce(apf::Mesh* m, int casenum)
   else
     addval = myrank;
 
-  char fname[256];
-  sprintf(fname, "test%d", casenum);
   apf::Field* f = getTestField(m, fname, addval);
   apf::FieldShape* fshape = apf::getShape(f);
   apf::Sharing* shr = apf::getSharing(m);
 
-  if (casenum == 0)
+  if (plan) {
+    if (casenum == 0)
+      plan->accumulate(f);
+    else if (casenum == 1)
+      plan->reduce(&f, 1, apf::ReductionMax<double>());
+    else if (casenum == 2)
+      plan->reduce(&f, 1, apf::ReductionMin<double>());
+    delete plan;
+  }
+  else if (casenum == 0)
     apf::accumulate(f, shr);
   else if (casenum == 1)
     apf::sharedReduction(f, shr, false, apf::ReductionMax<double>());
@@ -138,6 +154,60 @@ bool testReduce(apf::Mesh* m, int casenum)
   return failflag;
 }
 
+/* synchronize a scalar and a vector field together through a plan
+   and compare with apf::synchronize of copies of the fields */
+bool testSyncPlan(apf::Mesh* m)
+{
+  apf::Field* fields[2];
+  fields[0] = getTestField(m, "plan_scalar", myrank);
+  fields[1] = apf::createLagrangeField(m, "plan_vector", apf::VECTOR, 1);
+  apf::Field* expected[2];
+  expected[0] = getTestField(m, "sync_scalar", myrank);
+  expected[1] = apf::createLagrangeField(m, "sync_vector", apf::VECTOR, 1);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* e;
+  while ((e = m->iterate(it))) {
+    apf::Vector3 coords;
+    m->getPoint(e, 0, coords);
+    apf::setVector(fields[1], e, 0, coords * (myrank + 1));
+    apf::setVector(expected[1], e, 0, coords * (myrank + 1));
+  }
+  m->end(it);
+  const int steps = 10;
+  double t0 = PCU_Time();
+  apf::SyncPlan plan(m, apf::getLagrange(1));
+  double t1 = PCU_Time();
+  for (int i = 0; i < steps; ++i)
+    plan.synchronize(fields, 2);
+  double t2 = PCU_Time();
+  for (int i = 0; i < steps; ++i) {
+    apf::synchronize(expected[0]);
+    apf::synchronize(expected[1]);
+  }
+  double t3 = PCU_Time();
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "%d synchronizations of two fields: plan built in %f "
+        "seconds, plan %f seconds, apf::synchronize %f seconds\n",
+        steps, t1 - t0, t2 - t1, t3 - t2);
+  bool failflag = false;
+  it = m->begin(0);
+  while ((e = m->iterate(it))) {
+    double s = apf::getScalar(fields[0], e, 0);
+    failflag = failflag || s != apf::getScalar(expected[0], e, 0);
+    apf::Vector3 v;
+    apf::Vector3 w;
+    apf::getVector(fields[1], e, 0, v);
+    apf::getVector(expected[1], e, 0, w);
+    failflag = failflag || (v - w).getLength() != 0;
+  }
+  m->end(it);
+  for (int i = 0; i < 2; ++i) {
+    apf::destroyField(fields[i]);
+    apf::destroyField(expected[i]);
+  }
+  return failflag;
+}
+
 void freeMesh(apf::Mesh* m)
 {
   m->destroyNative();
@@ -182,8 +252,9 @@ int main(int argc, char** argv)
   m = apf::loadMdsMesh(g, meshFile);
 
   bool failflag = false;
-  for (int i=0; i < 3; ++i)
+  for (int i=0; i < 6; ++i)
     failflag = failflag || testReduce(m, i);
+  failflag = failflag || testSyncPlan(m);
 
   freeMesh(m);
 #ifdef HAVE_SIMMETRIX
@@ -0,0 +1,151 @@
+#include <gmi_analytic.h>
+#include <gmi_bvh.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+/* checks the tessellation tree of an analytic unit sphere
+   bounding a region, with its equator as a model edge,
+   and times a batch of closest point queries */
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+
+void sphere(double const p[2], double x[3], void*)
+{
+  x[0] = cos(p[0]) * cos(p[1]);
+  x[1] = sin(p[0]) * cos(p[1]);
+  x[2] = sin(p[1]);
+}
+
+void equator(double const p[2], double x[3], void*)
+{
+  x[0] = cos(p[0]);
+  x[1] = sin(p[0]);
+  x[2] = 0;
+}
+
+gmi_model* makeModel()
+{
+  gmi_model* m = gmi_make_analytic();
+  int edgePer[1] = {1};
+  double edgeRan[1][2] = {{0, 2 * pi}};
+  gmi_add_analytic(m, 1, 0, equator, edgePer, edgeRan, 0);
+  int facePer[2] = {1, 0};
+  double faceRan[2][2] = {{0, 2 * pi}, {-pi / 2, pi / 2}};
+  gmi_ent* f = gmi_add_analytic(m, 2, 0, sphere, facePer, faceRan, 0);
+  gmi_add_analytic_region(m, 0);
+  agm* topo = gmi_analytic_topo(m);
+  agm_bdry b = agm_add_bdry(topo, agm_from_gmi(gmi_find(m, 3, 0)));
+  agm_add_use(topo, b, agm_from_gmi(f));
+  return m;
+}
+
+double random01()
+{
+  return double(rand()) / RAND_MAX;
+}
+
+double distance(double const a[3], double const b[3])
+{
+  return sqrt((a[0] - b[0]) * (a[0] - b[0]) +
+              (a[1] - b[1]) * (a[1] - b[1]) +
+              (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+void checkClosestPoints(gmi_model* m, int n)
+{
+  std::vector<double> from(3 * n);
+  std::vector<double> to(3 * n);
+  std::vector<double> to_p(2 * n);
+  /* Gauss-Newton converges linearly near the center, where every
+     point of the sphere is almost equally far, so keep to a shell */
+  for (int i = 0; i < n; ++i) {
+    double* x = &from[3 * i];
+    double r;
+    do {
+      for (int j = 0; j < 3; ++j)
+        x[j] = 4 * random01() - 2;
+      r = sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+    } while (r < 0.5);
+  }
+  gmi_ent* f = gmi_find(m, 2, 0);
+  /* the first query builds the tree */
+  double t0 = PCU_Time();
+  gmi_closest_point(m, f, &from[0], &to[0], &to_p[0]);
+  double t1 = PCU_Time();
+  gmi_closest_point_batch(m, f, n, &from[0], &to[0], &to_p[0]);
+  double t2 = PCU_Time();
+  std::vector<double> y(3 * n);
+  gmi_eval_batch(m, f, n, &to_p[0], &y[0]);
+  double worst = 0;
+  for (int i = 0; i < n; ++i) {
+    double* x = &from[3 * i];
+    double r = sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+    worst = std::max(worst, fabs(distance(x, &to[3 * i]) - fabs(r - 1)));
+    PCU_ALWAYS_ASSERT(distance(&y[3 * i], &to[3 * i]) < 1e-12);
+  }
+  lion_oprint(1, "tree built in %f seconds, %d closest points in %f "
+      "seconds, worst error %e\n", t1 - t0, n, t2 - t1, worst);
+  PCU_ALWAYS_ASSERT(worst < 1e-9);
+}
+
+void checkEdge(gmi_model* m)
+{
+  double from[3] = {2, 2, 1};
+  double to[3];
+  double to_p[2];
+  gmi_closest_point(m, gmi_find(m, 1, 0), from, to, to_p);
+  double exact[3] = {sqrt(0.5), sqrt(0.5), 0};
+  PCU_ALWAYS_ASSERT(distance(exact, to) < 1e-6);
+  PCU_ALWAYS_ASSERT(fabs(to_p[0] - pi / 4) < 1e-6);
+  gmi_ent* e = gmi_bvh_closest(gmi_analytic_bvh(m), 1, from, to, to_p);
+  PCU_ALWAYS_ASSERT(e == gmi_find(m, 1, 0));
+}
+
+void checkRegion(gmi_model* m)
+{
+  gmi_ent* r = gmi_find(m, 3, 0);
+  for (int i = 0; i < 1000; ++i) {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      x[j] = 3 * random01() - 1.5;
+    double rad = sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+    /* the tessellation lies inside the sphere by up to 1 - cos(pi/32) */
+    if (fabs(rad - 1) < 0.01)
+      continue;
+    PCU_ALWAYS_ASSERT(gmi_is_point_in_region(m, r, x) == (rad < 1));
+  }
+  double lo[3];
+  double hi[3];
+  gmi_bbox(m, gmi_find(m, 2, 0), lo, hi);
+  for (int j = 0; j < 3; ++j) {
+    PCU_ALWAYS_ASSERT(fabs(lo[j] + 1) < 0.01);
+    PCU_ALWAYS_ASSERT(fabs(hi[j] - 1) < 0.01);
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  int n = (argc == 2) ? atoi(argv[1]) : 100000;
+  gmi_model* m = makeModel();
+  /* analytic models only answer closest points when asked to */
+  PCU_ALWAYS_ASSERT(!gmi_can_get_closest_point(m));
+  gmi_analytic_enable_closest_point(m);
+  PCU_ALWAYS_ASSERT(gmi_can_get_closest_point(m));
+  checkClosestPoints(m, n);
+  checkEdge(m);
+  checkRegion(m);
+  gmi_destroy(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
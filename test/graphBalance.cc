@@ -0,0 +1,85 @@
+#include <apf.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <gmi_mesh.h>
+#include <parma.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <cstdlib>
+
+/* unbalances a partitioned mesh by moving half of every odd part
+   to its even neighbor, then checks that the graph balancer brings
+   the element imbalance back under the tolerance */
+
+namespace {
+
+const double tolerance = 1.05;
+
+apf::MeshTag* setWeights(apf::Mesh* m)
+{
+  apf::MeshIterator* it = m->begin(m->getDimension());
+  apf::MeshEntity* e;
+  apf::MeshTag* tag = m->createDoubleTag("parma_weight", 1);
+  double w = 1.0;
+  while ((e = m->iterate(it)))
+    m->setDoubleTag(e, tag, &w);
+  m->end(it);
+  return tag;
+}
+
+void unbalance(apf::Mesh2* m)
+{
+  int self = PCU_Comm_Self();
+  apf::Migration* plan = new apf::Migration(m);
+  if (self % 2) {
+    int half = m->count(m->getDimension()) / 2;
+    apf::MeshIterator* it = m->begin(m->getDimension());
+    apf::MeshEntity* e;
+    while ((e = m->iterate(it)) && plan->count() < half)
+      plan->send(e, self - 1);
+    m->end(it);
+  }
+  m->migrate(plan);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if ( argc != 4 ) {
+    if ( !PCU_Comm_Self() )
+      printf("Usage: %s <model> <mesh> <out mesh>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() > 1);
+  gmi_register_mesh();
+  apf::Mesh2* m = apf::loadMdsMesh(argv[1],argv[2]);
+  int dim = m->getDimension();
+  long elements = PCU_Add_Long(m->count(dim));
+  unbalance(m);
+  apf::MeshTag* weights = setWeights(m);
+  double before = Parma_GetWeightedEntImbalance(m, weights, dim);
+  apf::Balancer* balancer = Parma_MakeGraphBalancer(m, 2, 0.2, 1);
+  balancer->balance(weights, tolerance);
+  delete balancer;
+  double after = Parma_GetWeightedEntImbalance(m, weights, dim);
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "element imbalance %.3f before and %.3f after\n",
+        before, after);
+  PCU_ALWAYS_ASSERT(before > tolerance);
+  PCU_ALWAYS_ASSERT(after <= tolerance);
+  PCU_ALWAYS_ASSERT(PCU_Add_Long(m->count(dim)) == elements);
+  apf::removeTagFromDimension(m, weights, dim);
+  m->destroyTag(weights);
+  m->verify();
+  m->writeNative(argv[3]);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
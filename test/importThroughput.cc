@@ -0,0 +1,201 @@
+#include <gmi_null.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include "kuhn.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* writes a box of n^3 cubes, six tets each, as a Gmsh file,
+   a little-endian UGRID file and a pair of ANSYS files, then
+   reads them back and reports the import throughput.
+   the files only hold tets, so the model is derived before
+   verifying.
+   the serial importers run on the first part while the
+   distributed UGRID importer runs on all parts */
+
+namespace {
+
+int n;
+
+long countVerts()
+{
+  return long(n + 1) * (n + 1) * (n + 1);
+}
+
+long countTets()
+{
+  return 6L * n * n * n;
+}
+
+void getPoint(long id, double x[3])
+{
+  x[0] = double(id % (n + 1)) / n;
+  x[1] = double((id / (n + 1)) % (n + 1)) / n;
+  x[2] = double(id / ((n + 1) * (n + 1))) / n;
+}
+
+/* one-based vertex ids of the Kuhn triangulation */
+void getTets(std::vector<unsigned>& conn)
+{
+  for (int k = 0; k < n; ++k)
+  for (int j = 0; j < n; ++j)
+  for (int i = 0; i < n; ++i)
+    for (int t = 0; t < 6; ++t) {
+      int corners[4];
+      getKuhnTet(t, corners);
+      for (int c = 0; c < 4; ++c) {
+        long ijk[3];
+        getKuhnCorner(i, j, k, corners[c], ijk);
+        conn.push_back(1 + ijk[0] + (n + 1) * (ijk[1] + (n + 1) * ijk[2]));
+      }
+    }
+}
+
+long fileSize(const char* name)
+{
+  FILE* f = fopen(name, "rb");
+  PCU_ALWAYS_ASSERT(f);
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fclose(f);
+  return size;
+}
+
+void writeGmsh(const char* name, std::vector<unsigned>& conn)
+{
+  FILE* f = fopen(name, "w");
+  PCU_ALWAYS_ASSERT(f);
+  fprintf(f, "$MeshFormat\n2.2 0 8\n$EndMeshFormat\n$Nodes\n%ld\n",
+      countVerts());
+  for (long i = 0; i < countVerts(); ++i) {
+    double x[3];
+    getPoint(i, x);
+    fprintf(f, "%ld %.17g %.17g %.17g\n", i + 1, x[0], x[1], x[2]);
+  }
+  fprintf(f, "$EndNodes\n$Elements\n%ld\n", countTets());
+  for (long i = 0; i < countTets(); ++i)
+    fprintf(f, "%ld 4 2 0 0 %u %u %u %u\n", i + 1, conn[i * 4],
+        conn[i * 4 + 1], conn[i * 4 + 2], conn[i * 4 + 3]);
+  fprintf(f, "$EndElements\n");
+  fclose(f);
+}
+
+void writeUgrid(const char* name, std::vector<unsigned>& conn)
+{
+  FILE* f = fopen(name, "wb");
+  PCU_ALWAYS_ASSERT(f);
+  unsigned header[7] = {unsigned(countVerts()), 0, 0,
+    unsigned(countTets()), 0, 0, 0};
+  fwrite(header, sizeof(unsigned), 7, f);
+  for (long i = 0; i < countVerts(); ++i) {
+    double x[3];
+    getPoint(i, x);
+    fwrite(x, sizeof(double), 3, f);
+  }
+  fwrite(&conn[0], sizeof(unsigned), conn.size(), f);
+  fclose(f);
+}
+
+/* SOLID72 elements in the fixed width ANSYS format */
+void writeANSYS(const char* nodeName, const char* elemName,
+    std::vector<unsigned>& conn)
+{
+  FILE* f = fopen(nodeName, "w");
+  PCU_ALWAYS_ASSERT(f);
+  for (long i = 0; i < countVerts(); ++i) {
+    double x[3];
+    getPoint(i, x);
+    fprintf(f, "%8ld %.17g %.17g %.17g\n", i + 1, x[0], x[1], x[2]);
+  }
+  fclose(f);
+  f = fopen(elemName, "w");
+  PCU_ALWAYS_ASSERT(f);
+  for (long i = 0; i < countTets(); ++i) {
+    for (int j = 0; j < 4; ++j)
+      fprintf(f, "%6u", conn[i * 4 + j]);
+    fprintf(f, "%6s%6s%6s%6s%6d%6d%6d%6d%6d%6ld\n", "", "", "", "",
+        1, 702, 1, 1, 0, i + 1);
+  }
+  fclose(f);
+}
+
+void report(const char* what, apf::Mesh2* m, double t, long bytes)
+{
+  long tets = PCU_Add_Long(m->count(3));
+  PCU_ALWAYS_ASSERT(tets == countTets());
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "%s: %ld tets in %f seconds, %f MB/s\n",
+        what, tets, t, bytes / t / (1024 * 1024));
+  apf::deriveMdsModel(m);
+  m->verify();
+  m->destroyNative();
+  apf::destroyMesh(m);
+}
+
+void readSerial(const char* gmsh, const char* ugrid,
+    const char* node, const char* elem)
+{
+  double t0 = PCU_Time();
+  apf::Mesh2* m = apf::loadMdsFromGmsh(gmi_load(".null"), gmsh);
+  report("gmsh", m, PCU_Time() - t0, fileSize(gmsh));
+  t0 = PCU_Time();
+  m = apf::loadMdsFromUgrid(gmi_load(".null"), ugrid);
+  report("ugrid", m, PCU_Time() - t0, fileSize(ugrid));
+  t0 = PCU_Time();
+  m = apf::loadMdsFromANSYS(node, elem);
+  report("ansys", m, PCU_Time() - t0, fileSize(node) + fileSize(elem));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s <cubes per box edge>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  n = atoi(argv[1]);
+  gmi_register_null();
+  const char* gmsh = "importThroughput.msh";
+  const char* ugrid = "importThroughput.lb8.ugrid";
+  const char* node = "importThroughput.node";
+  const char* elem = "importThroughput.elem";
+  if (!PCU_Comm_Self()) {
+    std::vector<unsigned> conn;
+    getTets(conn);
+    writeGmsh(gmsh, conn);
+    writeUgrid(ugrid, conn);
+    writeANSYS(node, elem, conn);
+  }
+  int rank = PCU_Comm_Self();
+  MPI_Comm self;
+  MPI_Comm_split(MPI_COMM_WORLD, rank, 0, &self);
+  PCU_Switch_Comm(self);
+  if (!rank)
+    readSerial(gmsh, ugrid, node, elem);
+  PCU_Switch_Comm(MPI_COMM_WORLD);
+  MPI_Comm_free(&self);
+  PCU_Barrier();
+  double t0 = PCU_Time();
+  apf::Mesh2* m = apf::loadMdsDistributedFromUgrid(gmi_load(".null"), ugrid);
+  report("distributed ugrid", m, PCU_Time() - t0, fileSize(ugrid));
+  PCU_Barrier();
+  if (!PCU_Comm_Self()) {
+    remove(gmsh);
+    remove(ugrid);
+    remove(node);
+    remove(elem);
+  }
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
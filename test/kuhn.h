@@ -0,0 +1,31 @@
+#ifndef KUHN_H
+#define KUHN_H
+
+#include <algorithm>
+
+/* the Kuhn triangulation of a cube into six tets that all share the
+   diagonal from corner 0 to corner 7. bit b of a corner number is the
+   offset of that corner along axis b, so corner 6 is at (0,1,1).
+   every tet is positively oriented */
+
+inline void getKuhnTet(int tet, int corners[4])
+{
+  int const perms[6][3] = {
+    {1,2,4},{2,4,1},{4,1,2},{2,1,4},{1,4,2},{4,2,1}};
+  corners[0] = 0;
+  corners[1] = perms[tet][0];
+  corners[2] = perms[tet][0] + perms[tet][1];
+  corners[3] = 7;
+  if (tet >= 3)
+    std::swap(corners[1], corners[2]);
+}
+
+/* the grid point of a corner of cube (i,j,k) */
+inline void getKuhnCorner(int i, int j, int k, int corner, long ijk[3])
+{
+  ijk[0] = i + (corner & 1);
+  ijk[1] = j + ((corner >> 1) & 1);
+  ijk[2] = k + ((corner >> 2) & 1);
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include "ma.h"
+#include <maAdapt.h>
+#include <maBalance.h>
+#include <apf.h>
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+
+/* refines the low x end of the mesh and coarsens the high end, so that
+   the peak memory of the next refinement is far from balanced */
+class Graded : public ma::IsotropicFunction
+{
+  public:
+    Graded(ma::Mesh* m)
+    {
+      mesh = m;
+      average = ma::getAverageEdgeLength(m);
+      ma::getBoundingBox(m,lower,upper);
+    }
+    virtual double getValue(ma::Entity* v)
+    {
+      ma::Vector p = ma::getPosition(mesh,v);
+      double x = (p[0] - lower[0])/(upper[0] - lower[0]);
+      return average*(4*x+1)/4;
+    }
+  private:
+    ma::Mesh* mesh;
+    double average;
+    ma::Vector lower;
+    ma::Vector upper;
+};
+
+int main(int argc, char** argv)
+{
+  PCU_ALWAYS_ASSERT(argc==3);
+  const char* modelFile = argv[1];
+  const char* meshFile = argv[2];
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  gmi_register_mesh();
+  ma::Mesh* m = apf::loadMdsMesh(modelFile,meshFile);
+  Graded sf(m);
+  ma::Input* in = ma::configure(m, &sf);
+  in->shouldRunPredictiveParma = true;
+  ma::validateInput(in);
+  ma::Adapt* a = new ma::Adapt(in);
+  double before = ma::getPredictedImbalance(a);
+  ma::runPredictive(a);
+  double after = ma::getPredictedImbalance(a);
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "predicted peak memory imbalance %f before, %f after\n",
+        before, after);
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1 ||
+      before > in->maximumImbalance);
+  PCU_ALWAYS_ASSERT(after <= in->maximumImbalance);
+  m->verify();
+  delete a;
+  delete in;
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,131 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <cstdlib>
+#include <vector>
+
+/* copies a serial mesh and a vertex field into an empty MDS mesh
+   through the flat array interface, the way a bridge to another
+   mesh data structure would, and times both directions */
+
+namespace {
+
+struct Arrays {
+  int dim;
+  std::vector<double> coords;
+  std::vector<double> field;
+  std::vector<int> down[4];
+  std::vector<int> modelDim[4];
+  std::vector<int> modelTag[4];
+};
+
+void exportMesh(apf::Mesh2* m, Arrays& a)
+{
+  a.dim = m->getDimension();
+  a.coords.resize(3 * m->count(0));
+  apf::getMdsCoordinates(m, &a.coords[0]);
+  for (int d = 0; d <= a.dim; ++d) {
+    int n = m->count(d);
+    if (d) {
+      a.down[d].resize(n * (d + 1));
+      apf::getMdsDownward(m, d, d - 1, &a.down[d][0]);
+    }
+    a.modelDim[d].resize(n);
+    a.modelTag[d].resize(n);
+    apf::getMdsClassification(m, d, &a.modelDim[d][0], &a.modelTag[d][0]);
+  }
+  a.field.resize(3 * m->count(0));
+  PCU_ALWAYS_ASSERT(
+      apf::getMdsTagArray(m, m->findTag("u_ver"), 0, &a.field[0]));
+}
+
+apf::Mesh2* importMesh(gmi_model* g, Arrays& a)
+{
+  apf::Mesh2* m = apf::makeEmptyMdsMesh(g, a.dim, false);
+  for (int d = 0; d <= a.dim; ++d)
+    apf::createMdsEntities(m, d, a.modelDim[d].size(),
+        d ? &a.down[d][0] : 0, &a.modelDim[d][0], &a.modelTag[d][0]);
+  apf::setMdsCoordinates(m, &a.coords[0]);
+  m->acceptChanges();
+  /* vertex fields keep their values in the tag (name)_ver */
+  apf::createFieldOn(m, "u", apf::VECTOR);
+  apf::setMdsTagArray(m, m->findTag("u_ver"), 0, &a.field[0]);
+  return m;
+}
+
+void compare(apf::Mesh2* a, apf::Mesh2* b)
+{
+  for (int d = 0; d <= a->getDimension(); ++d)
+    PCU_ALWAYS_ASSERT(a->count(d) == b->count(d));
+  apf::Field* fa = a->findField("u");
+  apf::Field* fb = b->findField("u");
+  for (int i = 0; i < int(a->count(0)); ++i) {
+    apf::MeshEntity* va = apf::getMdsEntity(a, 0, i);
+    apf::MeshEntity* vb = apf::getMdsEntity(b, 0, i);
+    apf::Vector3 xa = apf::getLinearCentroid(a, va);
+    apf::Vector3 xb = apf::getLinearCentroid(b, vb);
+    PCU_ALWAYS_ASSERT((xa - xb).getLength() == 0);
+    apf::Vector3 ua, ub;
+    apf::getVector(fa, va, 0, ua);
+    apf::getVector(fb, vb, 0, ub);
+    PCU_ALWAYS_ASSERT((ua - ub).getLength() == 0);
+    PCU_ALWAYS_ASSERT(a->getModelTag(a->toModel(va)) ==
+                      b->getModelTag(b->toModel(vb)));
+  }
+  int dim = a->getDimension();
+  for (int i = 0; i < int(a->count(dim)); ++i) {
+    apf::Downward da, db;
+    int n = a->getDownward(apf::getMdsEntity(a, dim, i), 0, da);
+    b->getDownward(apf::getMdsEntity(b, dim, i), 0, db);
+    for (int j = 0; j < n; ++j)
+      PCU_ALWAYS_ASSERT(apf::getMdsIndex(a, da[j]) ==
+                        apf::getMdsIndex(b, db[j]));
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s <model.dmg> <serial mesh.smb>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1);
+  gmi_register_mesh();
+  gmi_model* g = gmi_load(argv[1]);
+  apf::Mesh2* m = apf::loadMdsMesh(g, argv[2]);
+  apf::Field* f = apf::createFieldOn(m, "u", apf::VECTOR);
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = m->begin(0);
+  while ((v = m->iterate(it)))
+    apf::setVector(f, v, 0, apf::getLinearCentroid(m, v) * 2);
+  m->end(it);
+  double t0 = PCU_Time();
+  PCU_ALWAYS_ASSERT(apf::hasMdsArrays(m));
+  Arrays a;
+  exportMesh(m, a);
+  double t1 = PCU_Time();
+  apf::Mesh2* m2 = importMesh(g, a);
+  double t2 = PCU_Time();
+  m2->verify();
+  compare(m, m2);
+  lion_oprint(1, "exported %lu elements in %f seconds, imported in %f\n",
+      (unsigned long)m->count(m->getDimension()), t1 - t0, t2 - t1);
+  apf::disownMdsModel(m2);
+  m2->destroyNative();
+  apf::destroyMesh(m2);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -8,6 +8,7 @@
 #include <PCU.h>
 #include <lionPrint.h>
 #include <sstream>
+#include <string>
 
 static void writeStep(apf::Mesh* m, int i)
 {
@@ -22,10 +23,12 @@ int main(int argc, char** argv)
   MPI_Init(&argc,&argv);
   PCU_Comm_Init();
   lion_set_verbosity(1);
-  if ( argc != 3 ) {
-    fprintf(stderr, "Usage: %s <model> <mesh>\n", argv[0]);
+  if ( argc != 3 && argc != 4 ) {
+    fprintf(stderr, "Usage: %s <model> <mesh> [laplacian|cg|stiffened]\n",
+        argv[0]);
     return 0;
   }
+  std::string smootherName = argc == 4 ? argv[3] : "laplacian";
   gmi_register_mesh();
   apf::Mesh2* m = apf::loadMdsMesh(argv[1],argv[2]);
   dsp::Boundary moving;
@@ -38,7 +41,13 @@ int main(int argc, char** argv)
   fixed.insert(m->findModelEntity(2, 6));
   fixed.insert(m->findModelEntity(2, 17));
   dsp::closeBoundary(m, fixed);
-  dsp::Smoother* smoother = dsp::Smoother::makeLaplacian();
+  dsp::Smoother* smoother;
+  if (smootherName == "cg")
+    smoother = dsp::Smoother::makeConjugateGradient();
+  else if (smootherName == "stiffened")
+    smoother = dsp::Smoother::makeConjugateGradient(true);
+  else
+    smoother = dsp::Smoother::makeLaplacian();
 //double avgEdgeLen = ma::getAverageEdgeLength(m);
 //dsp::Adapter* adapter = dsp::Adapter::makeUniform(avgEdgeLen);
   dsp::Adapter* adapter = dsp::Adapter::makeEmpty();
@@ -0,0 +1,191 @@
+#include <apf.h>
+#include <gmi_mesh.h>
+#include <gmi_null.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <apfOmega_h.h>
+#include <cmath>
+#include <cstdlib>
+
+#include <Omega_h_library.hpp>
+#include <Omega_h_mesh.hpp>
+
+/* times round trips of a mesh with a vertex field between
+   MDS and Omega_h, the way a workflow alternating between
+   apf tools and Omega_h adaptation would. then checks that
+   the round trip through the flat MDS arrays gives the same
+   mesh as the one through per-entity calls */
+
+namespace {
+
+/* a created and destroyed vertex leaves a gap in the MDS arrays,
+   which sends to_omega_h and from_omega_h down the per-entity path */
+void leaveGap(apf::Mesh2* m)
+{
+  m->destroy(m->createVert(0));
+}
+
+/* sums that do not depend on the order of the entities */
+struct Summary
+{
+  long count[4];
+  long classified[4][4];
+  long inverted;
+  double volume;
+  double field;
+};
+
+void summarize(apf::Mesh* m, Summary& s)
+{
+  int dim = m->getDimension();
+  for (int d = 0; d < 4; ++d) {
+    s.count[d] = m->count(d);
+    for (int gd = 0; gd < 4; ++gd)
+      s.classified[d][gd] = 0;
+  }
+  s.inverted = 0;
+  s.volume = 0;
+  s.field = 0;
+  for (int d = 0; d <= dim; ++d) {
+    apf::MeshIterator* it = m->begin(d);
+    apf::MeshEntity* e;
+    while ((e = m->iterate(it)))
+      ++s.classified[d][m->getModelType(m->toModel(e))];
+    m->end(it);
+  }
+  apf::MeshIterator* it = m->begin(dim);
+  apf::MeshEntity* e;
+  while ((e = m->iterate(it))) {
+    double v = apf::measure(m, e);
+    if (v < 0)
+      ++s.inverted;
+    s.volume += v;
+  }
+  m->end(it);
+  apf::Field* f = m->findField("u");
+  PCU_ALWAYS_ASSERT(f);
+  it = m->begin(0);
+  while ((e = m->iterate(it))) {
+    apf::Vector3 u;
+    apf::getVector(f, e, 0, u);
+    s.field += u.x() + u.y() + u.z();
+  }
+  m->end(it);
+}
+
+void checkSame(Summary const& a, Summary const& b)
+{
+  for (int d = 0; d < 4; ++d) {
+    PCU_ALWAYS_ASSERT(a.count[d] == b.count[d]);
+    for (int gd = 0; gd < 4; ++gd)
+      PCU_ALWAYS_ASSERT(a.classified[d][gd] == b.classified[d][gd]);
+  }
+  PCU_ALWAYS_ASSERT(a.inverted == b.inverted);
+  PCU_ALWAYS_ASSERT(std::fabs(a.volume - b.volume) <=
+      1e-10 * std::fabs(a.volume));
+  PCU_ALWAYS_ASSERT(std::fabs(a.field - b.field) <=
+      1e-10 * (1 + std::fabs(a.field)));
+}
+
+apf::Mesh2* roundTrip(Omega_h::Library* lib, gmi_model* g,
+    apf::Mesh2* am, bool arrays)
+{
+  Omega_h::Mesh om(lib);
+  if (!arrays)
+    leaveGap(am);
+  PCU_ALWAYS_ASSERT(apf::hasMdsArrays(am) == arrays);
+  apf::to_omega_h(&om, am);
+  apf::Mesh2* back = apf::makeEmptyMdsMesh(g, om.dim(), false);
+  if (!arrays)
+    leaveGap(back);
+  PCU_ALWAYS_ASSERT(apf::hasMdsArrays(back) == arrays);
+  apf::from_omega_h(back, &om);
+  return back;
+}
+
+void checkPaths(Omega_h::Library* lib, gmi_model* g, apf::Mesh2* am)
+{
+  Summary original;
+  summarize(am, original);
+  apf::Mesh2* fast = roundTrip(lib, g, am, true);
+  apf::Mesh2* slow = roundTrip(lib, g, am, false);
+  Summary a;
+  summarize(fast, a);
+  Summary b;
+  summarize(slow, b);
+  checkSame(original, a);
+  checkSame(a, b);
+  apf::verify(fast);
+  apf::verify(slow);
+  apf::Mesh2* meshes[2] = {fast, slow};
+  for (int i = 0; i < 2; ++i) {
+    apf::disownMdsModel(meshes[i]);
+    meshes[i]->destroyNative();
+    apf::destroyMesh(meshes[i]);
+  }
+  if (!PCU_Comm_Self())
+    lion_oprint(1, "array and per-entity round trips agree\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+  MPI_Init(&argc, &argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 4) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s in.dmg in.smb <round trips>\n", argv[0]);
+    PCU_Comm_Free();
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  gmi_register_mesh();
+  gmi_register_null();
+  gmi_model* g = gmi_load(argv[1]);
+  int trips = atoi(argv[3]);
+  apf::Mesh2* am = apf::loadMdsMesh(g, argv[2]);
+  apf::Field* f = apf::createFieldOn(am, "u", apf::VECTOR);
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = am->begin(0);
+  while ((v = am->iterate(it)))
+    apf::setVector(f, v, 0, apf::getLinearCentroid(am, v));
+  am->end(it);
+  long elems = PCU_Add_Long(am->count(am->getDimension()));
+  {
+    auto lib = Omega_h::Library(&argc, &argv);
+    double to_time = 0;
+    double from_time = 0;
+    for (int i = 0; i < trips; ++i) {
+      Omega_h::Mesh om(&lib);
+      double t0 = PCU_Time();
+      apf::to_omega_h(&om, am);
+      double t1 = PCU_Time();
+      apf::disownMdsModel(am);
+      am->destroyNative();
+      apf::destroyMesh(am);
+      am = apf::makeEmptyMdsMesh(g, om.dim(), false);
+      double t2 = PCU_Time();
+      apf::from_omega_h(am, &om);
+      double t3 = PCU_Time();
+      to_time += t1 - t0;
+      from_time += t3 - t2;
+      PCU_ALWAYS_ASSERT(PCU_Add_Long(am->count(am->getDimension())) == elems);
+      PCU_ALWAYS_ASSERT(am->findField("u"));
+    }
+    to_time = PCU_Max_Double(to_time);
+    from_time = PCU_Max_Double(from_time);
+    if (!PCU_Comm_Self())
+      lion_oprint(1, "%d round trips of %ld elements: %f seconds to "
+          "Omega_h, %f seconds back\n", trips, elems, to_time, from_time);
+    checkPaths(&lib, g, am);
+  }
+  am->verify();
+  am->destroyNative();
+  apf::destroyMesh(am);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
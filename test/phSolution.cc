@@ -0,0 +1,115 @@
+#include <phRestart.h>
+#include <phInput.h>
+#include <apf.h>
+#include <apfMDS.h>
+#include <apfBox.h>
+#include <apfMesh2.h>
+#include <apfNumbering.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <cstdlib>
+
+/* moves the solution fields of a box mesh into a ph::Solution and
+   back. the arrays must have the restart file layout, other fields
+   must be gone, and the values must come back unchanged */
+
+namespace {
+
+int const dofs = 5;
+
+double value(int vertex, int component)
+{
+  return vertex + 0.1 * component;
+}
+
+void fillSolution(apf::Mesh* m, apf::Numbering* n, apf::Field* f)
+{
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  double c[dofs];
+  while ((v = m->iterate(it))) {
+    int i = apf::getNumber(n, v, 0, 0);
+    for (int j = 0; j < dofs; ++j)
+      c[j] = value(i, j);
+    apf::setComponents(f, v, 0, c);
+  }
+  m->end(it);
+}
+
+void checkArrays(ph::Solution& s, int nodes)
+{
+  ph::SolutionField* f = s.find("solution");
+  PCU_ALWAYS_ASSERT(f);
+  PCU_ALWAYS_ASSERT(f->nEntities == nodes);
+  PCU_ALWAYS_ASSERT(f->nComponents == dofs);
+  for (int i = 0; i < nodes; ++i)
+    for (int j = 0; j < dofs; ++j)
+      PCU_ALWAYS_ASSERT(f->data[j * nodes + i] == value(i, j));
+  PCU_ALWAYS_ASSERT(s.find("mapping_partid"));
+  PCU_ALWAYS_ASSERT(s.find("mapping_vtxid"));
+  PCU_ALWAYS_ASSERT(!s.find("errors"));
+}
+
+void checkSolution(apf::Mesh* m, apf::Numbering* n)
+{
+  apf::Field* f = m->findField("solution");
+  PCU_ALWAYS_ASSERT(f);
+  PCU_ALWAYS_ASSERT(apf::countComponents(f) == dofs);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  double c[dofs];
+  while ((v = m->iterate(it))) {
+    int i = apf::getNumber(n, v, 0, 0);
+    apf::getComponents(f, v, 0, c);
+    for (int j = 0; j < dofs; ++j)
+      PCU_ALWAYS_ASSERT(c[j] == value(i, j));
+  }
+  m->end(it);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 1) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  apf::Mesh2* m = apf::makeMdsBox(4, 4, 4, 1, 1, 1, true);
+  ph::Input in;
+  in.ensa_dof = dofs;
+  in.buildMapping = 1;
+  /* the restart layout follows iteration order */
+  apf::Numbering* n = apf::numberOverlapNodes(m, "phSolution");
+  int nodes = m->count(0);
+  ph::attachZeroSolution(in, m);
+  fillSolution(m, n, m->findField("solution"));
+  ph::buildMapping(m);
+  apf::createFieldOn(m, "errors", apf::SCALAR);
+  ph::Solution s;
+  ph::detachSolution(in, m, s);
+  PCU_ALWAYS_ASSERT(!m->countFields());
+  checkArrays(s, nodes);
+  ph::attachSolution(in, m, s);
+  PCU_ALWAYS_ASSERT(s.fields.empty());
+  checkSolution(m, n);
+  PCU_ALWAYS_ASSERT(m->findField("mapping_partid"));
+  PCU_ALWAYS_ASSERT(m->findField("mapping_vtxid"));
+  /* a second round trip starts from attached fields */
+  ph::detachSolution(in, m, s);
+  checkArrays(s, nodes);
+  ph::attachSolution(in, m, s);
+  checkSolution(m, n);
+  lion_oprint(1, "solution of %d vertices detached and attached\n", nodes);
+  apf::destroyNumbering(n);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
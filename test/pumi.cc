@@ -80,6 +80,8 @@ void TEST_MESH(pMesh m);
 void TEST_MESH_TAG(pMesh m);
 void TEST_NEW_MESH(pMesh m);
 void TEST_GHOSTING(pMesh m);
+void TEST_GHOST_MIGRATION(pMesh m);
+void TEST_GHOST_LAYER_MIGRATION(pMesh m);
 void TEST_FIELD(pMesh m);
 
 //*********************************************************
@@ -239,6 +241,10 @@ int main(int argc, char** argv)
   if (!pumi_rank()) std::cout<<"\n[test_pumi] field and numbering deleted\n";
   pumi_mesh_verify(m);
 
+  TEST_GHOST_MIGRATION(m);
+
+  TEST_GHOST_LAYER_MIGRATION(m);
+
   TEST_MESH_TAG(m);
 
   // clean-up 
@@ -864,6 +870,49 @@ void TEST_GHOSTING(pMesh m)
 
   pumi_ghost_delete(m);
 
+  // incremental update: recomputing unchanged layers has no delta
+  pumi_ghost_createLayer (m, 0, mesh_dim, 2, 1);
+  int* ghost_mcount=new int[4];
+  for (int i=0; i<4; ++i)
+    ghost_mcount[i] = pumi_mesh_getNumEnt(m, i);
+  pumi_ghost_update(m);
+  for (int i=0; i<4; ++i)
+    PCU_ALWAYS_ASSERT(ghost_mcount[i] == pumi_mesh_getNumEnt(m, i));
+  delete [] ghost_mcount;
+  pumi_mesh_verify(m);
+
+  // compaction renames entities, including ghosts whose copies are
+  // only known to their owners
+  pumi_mesh_compact(m);
+  PCU_ALWAYS_ASSERT(apf::getMdsFill(m) == 1);
+  pumi_mesh_verify(m);
+
+  // ghost value refresh with the precomputed schedule
+  for (int step=0; step<2; ++step)
+  {
+    it = m->begin(0);
+    while ((e = m->iterate(it)))
+    {
+      pumi_node_getCoord(e, 0, xyz);
+      for (int i=0; i<3;++i)
+        data[i] = pumi_ment_isGhost(e) ? 0.0 : xyz[i]*(step+1);
+      pumi_node_setField(f, e, 0, data);
+    }
+    m->end(it);
+    pumi_field_syncGhosts(f);
+    it = m->begin(0);
+    while ((e = m->iterate(it)))
+    {
+      pumi_node_getCoord(e, 0, xyz);
+      pumi_node_getField(f, e, 0, data);
+      for (int i=0; i<3;++i)
+        PCU_ALWAYS_ASSERT(data[i] == xyz[i]*(step+1));
+    }
+    m->end(it);
+  }
+
+  pumi_ghost_delete(m);
+
   for (int i=0; i<4; ++i)
   {
     if (org_mcount[i] != pumi_mesh_getNumEnt(m, i))
@@ -874,3 +923,104 @@ void TEST_GHOSTING(pMesh m)
   delete [] org_mcount;
   delete o;
 }
+
+static int countGhostElements(pMesh m, bool ghosted)
+{
+  int n=0;
+  pMeshEnt e;
+  pMeshIter it = m->begin(pumi_mesh_getDim(m));
+  while ((e = m->iterate(it)))
+    if (ghosted ? pumi_ment_isGhosted(e) : pumi_ment_isGhost(e))
+      ++n;
+  m->end(it);
+  return PCU_Add_Int(n);
+}
+
+// ghosts from a user plan have to survive migration of other elements
+void TEST_GHOST_MIGRATION(pMesh m)
+{
+  if (pumi_size()==1) return;
+  int mesh_dim=pumi_mesh_getDim(m);
+  pumi_ghost_create(m, getGhostingPlan(m));
+  int ghosts=countGhostElements(m, false);
+  int ghosted=countGhostElements(m, true);
+  PCU_ALWAYS_ASSERT(ghosts>0);
+
+  Migration* plan = new Migration(m);
+  pMeshEnt e;
+  pMeshIter it = m->begin(mesh_dim);
+  while ((e = m->iterate(it)) && plan->count()<10)
+    if (!pumi_ment_isGhost(e) && !pumi_ment_isGhosted(e))
+      plan->send(e, (pumi_rank()+1)%pumi_size());
+  m->end(it);
+  pumi_mesh_migrate(m, plan);
+
+  PCU_ALWAYS_ASSERT(countGhostElements(m, false)==ghosts);
+  PCU_ALWAYS_ASSERT(countGhostElements(m, true)==ghosted);
+  pumi_mesh_verify(m);
+  if (!pumi_rank())
+    std::cout<<"\n[test_pumi] "<<ghosts<<" plan ghosts kept over migration\n";
+  pumi_ghost_delete(m);
+  pumi_mesh_verify(m);
+}
+
+static int countTagged(pMesh m, pMeshTag tag)
+{
+  int n=0;
+  pMeshEnt e;
+  pMeshIter it = m->begin(pumi_mesh_getDim(m));
+  while ((e = m->iterate(it)))
+    if (m->hasTag(e, tag))
+      ++n;
+  m->end(it);
+  return n;
+}
+
+// migration next to layer ghosts keeps the ghosts it does not touch,
+// removes the touched and stale ones and sends only the missing ones
+void TEST_GHOST_LAYER_MIGRATION(pMesh m)
+{
+  if (pumi_size()==1) return;
+  int mesh_dim=pumi_mesh_getDim(m);
+  pumi_ghost_createLayer(m, 0, mesh_dim, 1, 1);
+  pMeshTag tag = m->createIntTag("ghost_before_migration", 1);
+  pMeshEnt e;
+  pMeshIter it = m->begin(mesh_dim);
+  while ((e = m->iterate(it)))
+    if (pumi_ment_isGhost(e))
+    {
+      int one=1;
+      m->setIntTag(e, tag, &one);
+    }
+  m->end(it);
+  int before=countGhostElements(m, false);
+
+  Migration* plan = new Migration(m);
+  it = m->begin(mesh_dim);
+  while ((e = m->iterate(it)) && plan->count()<10)
+    if (!pumi_ment_isGhost(e) && !pumi_ment_isGhosted(e))
+      plan->send(e, (pumi_rank()+1)%pumi_size());
+  m->end(it);
+  pumi_mesh_migrate(m, plan);
+
+  int after=countGhostElements(m, false);
+  int kept=PCU_Add_Int(countTagged(m, tag));
+  int removed=before-kept;
+  int added=after-kept;
+  if (!pumi_rank())
+    std::cout<<"\n[test_pumi] layer ghosts over migration: "<<kept
+             <<" kept, "<<removed<<" removed, "<<added<<" added\n";
+  PCU_ALWAYS_ASSERT(kept>0);
+  PCU_ALWAYS_ASSERT(removed>0 && removed<before);
+  PCU_ALWAYS_ASSERT(added>0 && added<after);
+  pumi_mesh_verify(m);
+
+  // the same layer built from scratch has the same ghosts on each part
+  apf::removeTagFromDimension(m, tag, mesh_dim);
+  m->destroyTag(tag);
+  pumi_ghost_delete(m);
+  pumi_ghost_createLayer(m, 0, mesh_dim, 1, 1);
+  PCU_ALWAYS_ASSERT(countGhostElements(m, false)==after);
+  pumi_ghost_delete(m);
+  pumi_mesh_verify(m);
+}
@@ -6,21 +6,146 @@
 #include <PCU.h>
 #include <lionPrint.h>
 #include <parma.h>
+#include <pcu_util.h>
 #ifdef HAVE_SIMMETRIX
 #include <gmi_sim.h>
 #include <SimUtil.h>
 #include <MeshSim.h>
 #include <SimModel.h>
 #endif
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+const int sweeps = 10;
+
+/* bandwidth and linear arrangement of the vertex graph (through edges)
+   and the element graph (through sides) under the current MDS order */
+void getBandwidth(apf::Mesh2* m, int dim, int& bw, long& la)
+{
+  int sideDim = dim ? m->getDimension() - 1 : 1;
+  bw = la = 0;
+  apf::MeshIterator* it = m->begin(sideDim);
+  apf::MeshEntity* s;
+  while ((s = m->iterate(it))) {
+    apf::MeshEntity* adj[2];
+    if (dim) {
+      apf::Up up;
+      m->getUp(s, up);
+      if (up.n != 2)
+        continue;
+      adj[0] = up.e[0];
+      adj[1] = up.e[1];
+    } else {
+      m->getDownward(s, 0, adj);
+    }
+    int d = abs(apf::getMdsIndex(m, adj[0]) - apf::getMdsIndex(m, adj[1]));
+    if (d > bw)
+      bw = d;
+    la += d;
+  }
+  m->end(it);
+  bw = PCU_Max_Int(bw);
+  la = PCU_Add_Long(la);
+}
+
+/* the checksum adds the coordinates every sweep reads, so any
+   ordering of the same mesh gives it up to roundoff */
+double sweepAdjacency(apf::Mesh2* m, double& checksum)
+{
+  double t0 = PCU_Time();
+  double sum = 0;
+  int dim = m->getDimension();
+  for (int i = 0; i < sweeps; ++i) {
+    apf::MeshIterator* it = m->begin(dim);
+    apf::MeshEntity* e;
+    while ((e = m->iterate(it))) {
+      apf::Downward verts;
+      int nv = m->getDownward(e, 0, verts);
+      for (int j = 0; j < nv; ++j) {
+        apf::Vector3 x;
+        m->getPoint(verts[j], 0, x);
+        sum += x[0];
+      }
+    }
+    m->end(it);
+  }
+  double t = PCU_Max_Double(PCU_Time() - t0);
+  checksum = PCU_Add_Double(sum);
+  return t;
+}
+
+double sweepSynchronize(apf::Mesh2* m)
+{
+  apf::Field* f = apf::createFieldOn(m, "reorder_bench", apf::VECTOR);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  while ((v = m->iterate(it))) {
+    apf::Vector3 x;
+    m->getPoint(v, 0, x);
+    apf::setVector(f, v, 0, x);
+  }
+  m->end(it);
+  double t0 = PCU_Time();
+  for (int i = 0; i < sweeps; ++i)
+    apf::synchronize(f);
+  double t = PCU_Max_Double(PCU_Time() - t0);
+  apf::destroyField(f);
+  return t;
+}
+
+double report(apf::Mesh2* m, const char* when)
+{
+  int vbw, ebw;
+  long vla, ela;
+  getBandwidth(m, 0, vbw, vla);
+  getBandwidth(m, m->getDimension(), ebw, ela);
+  double checksum;
+  double tAdj = sweepAdjacency(m, checksum);
+  double tSync = sweepSynchronize(m);
+  if (!PCU_Comm_Self()) {
+    lion_oprint(1, "%s: vertex bandwidth %d linear arrangement %ld\n",
+        when, vbw, vla);
+    lion_oprint(1, "%s: element bandwidth %d linear arrangement %ld\n",
+        when, ebw, ela);
+    lion_oprint(1, "%s: %d adjacency sweeps %f seconds, "
+        "%d synchronize calls %f seconds\n",
+        when, sweeps, tAdj, sweeps, tSync);
+    lion_oprint(1, "%s: adjacency checksum %f\n", when, checksum);
+  }
+  return checksum;
+}
+
+apf::MeshTag* getOrdering(apf::Mesh2* m, const char* name)
+{
+  if (!strcmp(name, "bfs"))
+    return apf::numberMdsMesh(m, apf::MDS_BFS_ORDER);
+  if (!strcmp(name, "rcm"))
+    return apf::numberMdsMesh(m, apf::MDS_RCM_ORDER);
+  if (!strcmp(name, "hilbert"))
+    return apf::numberMdsMesh(m, apf::MDS_HILBERT_ORDER);
+  if (!strcmp(name, "morton"))
+    return apf::numberMdsMesh(m, apf::MDS_MORTON_ORDER);
+  if (!strcmp(name, "parma"))
+    return Parma_BfsReorder(m);
+  if (!PCU_Comm_Self())
+    lion_eprint(1, "unknown ordering \"%s\"\n", name);
+  MPI_Finalize();
+  exit(EXIT_FAILURE);
+}
+
+}
 
 int main(int argc, char** argv) {
   MPI_Init(&argc,&argv);
   PCU_Comm_Init();
   lion_set_verbosity(1);
-  if ( argc != 4 ) {
+  if ( argc != 4 && argc != 5 ) {
     if ( !PCU_Comm_Self() )
-      printf("Usage: %s <model> <mesh> <out prefix>\n", argv[0]);
+      printf("Usage: %s <model> <mesh> <out prefix> "
+             "[parma|bfs|rcm|hilbert|morton]\n", argv[0]);
     MPI_Finalize();
     exit(EXIT_FAILURE);
   }
@@ -34,8 +159,12 @@ int main(int argc, char** argv) {
   gmi_register_null();
   gmi_register_mesh();
   apf::Mesh2* m = apf::loadMdsMesh(argv[1],argv[2]);
-  apf::MeshTag* order = Parma_BfsReorder(m);
+  double before = report(m, "input");
+  apf::MeshTag* order = getOrdering(m, argc == 5 ? argv[4] : "parma");
   apf::reorderMdsMesh(m, order);
+  double after = report(m, argc == 5 ? argv[4] : "parma");
+  /* reordering must not lose or repeat any element or vertex */
+  PCU_ALWAYS_ASSERT(fabs(after - before) <= 1e-9 * fabs(before));
   m->writeNative(argv[3]);
   m->destroyNative();
   apf::destroyMesh(m);
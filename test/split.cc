@@ -13,6 +13,7 @@
 #endif
 #include <pcu_util.h>
 #include <cstdlib>
+#include <cstring>
 
 namespace {
 
@@ -20,6 +21,7 @@ const char* modelFile = 0;
 const char* meshFile = 0;
 const char* outFile = 0;
 int partitionFactor = 1;
+bool useGraph = false;
 
 void freeMesh(apf::Mesh* m)
 {
@@ -29,7 +31,11 @@ void freeMesh(apf::Mesh* m)
 
 apf::Migration* getPlan(apf::Mesh* m)
 {
-  apf::Splitter* splitter = Parma_MakeRibSplitter(m);
+  apf::Splitter* splitter;
+  if (useGraph)
+    splitter = Parma_MakeGraphSplitter(m);
+  else
+    splitter = Parma_MakeRibSplitter(m);
   apf::MeshTag* weights = Parma_WeighByMemory(m);
   apf::Migration* plan = splitter->split(weights, 1.10, partitionFactor);
   apf::removeTagFromDimension(m, weights, m->getDimension());
@@ -58,9 +64,10 @@ void switchToAll()
 
 void getConfig(int argc, char** argv)
 {
-  if ( argc != 5 ) {
+  if ( argc != 5 && argc != 6 ) {
     if ( !PCU_Comm_Self() )
-      printf("Usage: %s <model> <mesh> <outMesh> <factor>\n", argv[0]);
+      printf("Usage: %s <model> <mesh> <outMesh> <factor> [rib|graph]\n",
+          argv[0]);
     MPI_Finalize();
     exit(EXIT_FAILURE);
   }
@@ -68,6 +75,7 @@ void getConfig(int argc, char** argv)
   meshFile = argv[2];
   outFile = argv[3];
   partitionFactor = atoi(argv[4]);
+  useGraph = (argc == 6 && !strcmp(argv[5], "graph"));
   PCU_ALWAYS_ASSERT(partitionFactor <= PCU_Comm_Peers());
 }
 
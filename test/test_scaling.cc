@@ -1,5 +1,7 @@
 #include <pcu_util.h>
 #include <iostream>
+#include <vector>
+#include <cmath>
 
 #include <gmi_mesh.h>
 #include <apfMDS.h>
@@ -24,6 +26,31 @@ int main(int argc, char** argv)
   std::cout << "scaling factor " << scaling_factor << '\n';
   PCU_ALWAYS_ASSERT(scaling_factor < 2.0);
   PCU_ALWAYS_ASSERT(0.5 < scaling_factor);
+  /* the packed predictions should agree with the count they are
+     scaled to, also when the sizes are bounded */
+  sam::PackedIsoSize packed;
+  sam::packIsoSize(identity_size, packed);
+  double target = 4 * PCU_Add_Double(m->count(m->getDimension()));
+  double scale = sam::getIsoScaleForCount(packed, target);
+  double count = PCU_Add_Double(sam::predictElementCount(packed, scale));
+  PCU_ALWAYS_ASSERT(fabs(count - target) < 1e-6 * target);
+  double minSize = 0;
+  for (size_t i = 0; i < packed.size.size(); ++i)
+    minSize += packed.size[i];
+  minSize = PCU_Add_Double(minSize) / PCU_Add_Double(packed.size.size());
+  minSize *= scale * 0.7;
+  scale = sam::getIsoScaleForCount(packed, target, minSize);
+  std::vector<double> regionCounts;
+  sam::predictRegionCounts(packed, regionCounts, scale, minSize);
+  count = 0;
+  for (size_t i = 0; i < regionCounts.size(); ++i)
+    count += regionCounts[i];
+  PCU_ALWAYS_ASSERT(fabs(count - target) < 1e-2 * target);
+  scale = sam::limitIsoSizeField(identity_size, target / 8);
+  sam::packIsoSize(identity_size, packed);
+  count = PCU_Add_Double(sam::predictElementCount(packed));
+  PCU_ALWAYS_ASSERT(scale > 1);
+  PCU_ALWAYS_ASSERT(fabs(count - target / 8) < 1e-6 * target);
   m->destroyNative();
   apf::destroyMesh(m);
   PCU_Comm_Free();
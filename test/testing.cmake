@@ -27,6 +27,7 @@ mpi_test(bezierRefine 1 ./bezierRefine)
 mpi_test(bezierSubdivision 1 ./bezierSubdivision)
 mpi_test(bezierValidity 1 ./bezierValidity)
 mpi_test(ma_analytic 1 ./ma_test_analytic_model)
+mpi_test(gmiBvh 1 ./gmiBvh)
 
 mpi_test(align 1 ./align)
 mpi_test(eigen_test 1 ./eigen_test)
@@ -130,6 +131,9 @@ if(ENABLE_SIMMETRIX AND PCU_COMPRESS AND SIM_PARASOLID
     "${MDIR}/mesh_.smb"
     WORKING_DIRECTORY ${MDIR})
 endif()
+mpi_test(phSolution 1 ./phSolution)
+mpi_test(dgInterface_2 2 ./dgInterface)
+mpi_test(dgInterface_4 4 ./dgInterface)
 
 if(ENABLE_ZOLTAN)
   mpi_test(pumi3d-1p 4
@@ -149,6 +153,11 @@ if(ENABLE_OMEGA_H)
     cube.osh
     ${MESHES}/cube/cube.dmg
     converted.smb)
+  mpi_test(oshRoundTrip 1
+    ./oshRoundTrip
+    ${MESHES}/cube/cube.dmg
+    ${MESHES}/cube/pumi670/cube.smb
+    10)
 endif()
 mpi_test(test_scaling 1
   ./test_scaling
@@ -173,6 +182,18 @@ mpi_test(reorder_serial 1
   ${MESHES}/cube/cube.dmg
   ${MESHES}/cube/pumi7k/cube.smb
   cube_bfs.smb)
+mpi_test(reorder_hilbert 1
+  ./reorder
+  ${MESHES}/cube/cube.dmg
+  ${MESHES}/cube/pumi7k/cube.smb
+  cube_hilbert.smb
+  hilbert)
+mpi_test(reorder_rcm 1
+  ./reorder
+  ${MESHES}/cube/cube.dmg
+  ${MESHES}/cube/pumi7k/cube.smb
+  cube_rcm.smb
+  rcm)
 mpi_test(create_misCube 1
   ./create_mis
   ${MESHES}/cube/cube.dmg
@@ -244,6 +265,15 @@ smoke_test(uniform_serial 1
   "${MDIR}/pipe.${GXT}"
   "${MDIR}/pipe.smb"
   "pipe_unif.smb")
+mpi_test(compact_serial 1
+  ./compact
+  "${MDIR}/pipe.${GXT}"
+  "pipe.smb"
+  "pipe_compact.smb")
+mpi_test(dropUpward_serial 1
+  ./dropUpward
+  "${MDIR}/pipe.${GXT}"
+  "pipe.smb")
 if(ENABLE_SIMMETRIX)
   mpi_test(snap_serial 1
     ./snap
@@ -293,6 +323,13 @@ smoke_test(split_2 2
   "${MDIR}/pipe.smb"
   ${MESHFILE}
   2)
+mpi_test(split_graph_2 2
+  ./split
+  "${MDIR}/pipe.${GXT}"
+  "pipe.smb"
+  "pipe_graph_2_.smb"
+  2
+  graph)
 mpi_test(collapse_2 2
   ./collapse
   "${MDIR}/pipe.${GXT}"
@@ -356,11 +393,31 @@ mpi_test(reorder 4
   "${MDIR}/torus.dmg"
   "${MDIR}/4imb/torus.smb"
   "torusBfs4p/")
+mpi_test(compact 4
+  ./compact
+  "${MDIR}/torus.dmg"
+  "${MDIR}/4imb/torus.smb"
+  "torusCompact4p/"
+  hilbert)
+mpi_test(dropUpward 4
+  ./dropUpward
+  "${MDIR}/torus.dmg"
+  "${MDIR}/4imb/torus.smb")
 mpi_test(balance 4
   ./balance
   "${MDIR}/torus.dmg"
   "${MDIR}/4imb/torus.smb"
   "${MDIR}/torusBal4p/")
+mpi_test(ma_predictive 4
+  ./ma_predictive
+  "${MDIR}/torus.dmg"
+  "${MDIR}/4imb/torus.smb")
+mpi_test(nodeMap 4
+  ./nodeMap
+  "${MDIR}/torus.dmg"
+  "${MDIR}/4imb/torus.smb"
+  "torusNodeMap4p/"
+  2)
 mpi_test(gap 4
   ./gap
   "${MDIR}/torus.dmg"
@@ -402,6 +459,23 @@ mpi_test(elmBalance 4
   "${MDIR}/afosr.dmg"
   "${MDIR}/4imb/"
   "afosrBal4p/")
+mpi_test(elmBalanceMultiStep 4
+  ./elmBalance
+  "${MDIR}/afosr.dmg"
+  "${MDIR}/4imb/"
+  "afosrMultiStepBal4p/"
+  8)
+mpi_test(elmBalanceIncremental 4
+  ./elmBalance
+  "${MDIR}/afosr.dmg"
+  "${MDIR}/4imb/"
+  "afosrIncrementalBal4p/"
+  0)
+mpi_test(graphBalance 4
+  ./graphBalance
+  "${MDIR}/afosr.dmg"
+  "${MDIR}/4imb/"
+  "afosrGraphBal4p/")
 mpi_test(vtxBalance 4
   ./vtxBalance
   "${MDIR}/afosr.${GXT}"
@@ -445,6 +519,10 @@ mpi_test(construct 4
   ./construct
   "${MDIR}/cube.dmg"
   "${MDIR}/pumi7k/4/cube.smb")
+mpi_test(constructScaling 4
+  ./constructScaling 8)
+mpi_test(importThroughput 4
+  ./importThroughput 8)
 set(MDIR ${MESHES}/spr)
 mpi_test(spr_3D 4
   ./spr_test
@@ -485,6 +563,14 @@ mpi_test(test_verify 4
   ./test_verify
   "${MDIR}/cube.dmg"
   "${MDIR}/pumi7k/4/cube.smb")
+mpi_test(verifyFast 4
+  ./verifyFast
+  "${MDIR}/cube.dmg"
+  "${MDIR}/pumi7k/4/cube.smb")
+mpi_test(mdsArrays 1
+  ./mdsArrays
+  "${MDIR}/cube.dmg"
+  "${MDIR}/pumi670/cube.smb")
 set(MDIR ${MESHES}/nonmanifold)
 mpi_test(nonmanif_verify 1
   ./verify
@@ -662,3 +748,7 @@ if (PCU_COMPRESS)
       WORKING_DIRECTORY ${MESHES}/phasta/4-1-Chef-Tet-Part/4-4-Chef-Part-ts20/run)
   endif()
 endif()
+if(ENABLE_DSP)
+  mpi_test(dspSmoothers_serial 1 ./dspSmoothers)
+  mpi_test(dspSmoothers 4 ./dspSmoothers)
+endif()
@@ -0,0 +1,115 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <lionPrint.h>
+#include <pcu_util.h>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+/* runs apf::verify, apf::verifyFast with threads and sampling, and
+   apf::verifyEntities on a part of the elements, which must all pass.
+   then points a remote copy of one vertex at another vertex and
+   checks that apf::verifyFast counts the mismatch */
+
+namespace {
+
+/* two shared vertices of this part with copies on the same part */
+bool findSharedPair(apf::Mesh* m, apf::MeshEntity* pair[2], int& part)
+{
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* v;
+  int n = 0;
+  while (n < 2 && (v = m->iterate(it))) {
+    if (!m->isShared(v))
+      continue;
+    apf::Copies r;
+    m->getRemotes(v, r);
+    if (!n)
+      part = r.begin()->first;
+    else if (!r.count(part))
+      continue;
+    pair[n++] = v;
+  }
+  m->end(it);
+  return n == 2;
+}
+
+void swapRemotes(apf::Mesh2* m, apf::MeshEntity* pair[2], int part)
+{
+  apf::Copies r[2];
+  for (int i = 0; i < 2; ++i)
+    m->getRemotes(pair[i], r[i]);
+  std::swap(r[0][part], r[1][part]);
+  for (int i = 0; i < 2; ++i)
+    m->setRemotes(pair[i], r[i]);
+}
+
+void checkCorruption(apf::Mesh2* m, int threads)
+{
+  apf::MeshEntity* pair[2];
+  int part = -1;
+  bool corrupt = !PCU_Comm_Self() && findSharedPair(m, pair, part);
+  PCU_ALWAYS_ASSERT(PCU_Or(corrupt));
+  if (corrupt)
+    swapRemotes(m, pair, part);
+  long failures = apf::verifyFast(m, threads, 1, false);
+  PCU_ALWAYS_ASSERT(failures > 0);
+  if (corrupt)
+    swapRemotes(m, pair, part);
+  PCU_ALWAYS_ASSERT(!apf::verifyFast(m, threads));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  lion_set_verbosity(1);
+  if (argc != 3 && argc != 4) {
+    if (!PCU_Comm_Self())
+      lion_eprint(1, "usage: %s <model> <mesh> [threads]\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() > 1);
+  int threads = (argc == 4) ? atoi(argv[3]) : 4;
+  gmi_register_mesh();
+  apf::Mesh2* m = apf::loadMdsMesh(argv[1],argv[2]);
+  apf::Field* f = apf::createFieldOn(m, "verifyFast", apf::SCALAR);
+  apf::zeroField(f);
+  apf::MeshTag* t = m->createIntTag("verifyFast", 1);
+  apf::MeshIterator* it = m->begin(0);
+  apf::MeshEntity* e;
+  while ((e = m->iterate(it))) {
+    int one = 1;
+    m->setIntTag(e, t, &one);
+  }
+  m->end(it);
+  apf::verify(m);
+  PCU_ALWAYS_ASSERT(!apf::verifyFast(m));
+  /* the threads must not be the ones to rebuild the upward adjacency */
+  apf::dropMdsUpward(m);
+  PCU_ALWAYS_ASSERT(!apf::verifyFast(m, threads));
+  PCU_ALWAYS_ASSERT(!apf::verifyFast(m, threads, 10));
+  std::vector<apf::MeshEntity*> changed;
+  it = m->begin(m->getDimension());
+  size_t i = 0;
+  while ((e = m->iterate(it)))
+    if (!(i++ % 10))
+      changed.push_back(e);
+  m->end(it);
+  PCU_ALWAYS_ASSERT(!apf::verifyEntities(m,
+        changed.empty() ? 0 : &changed[0], changed.size(), threads));
+  checkCorruption(m, threads);
+  apf::removeTagFromDimension(m, t, 0);
+  m->destroyTag(t);
+  apf::destroyField(f);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}